@@ -13,6 +13,7 @@
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
+#include "spdk/histogram_data.h"
 
 #define DATA_PATTERN 0x5a
 #define ALIGN_4K 0x1000
@@ -35,6 +36,7 @@ static int g_fail_percent_goal = 0;
 static uint8_t g_fill_pattern = 255;
 static uint32_t g_xor_src_count = 2;
 static bool g_verify = false;
+static bool g_latency = false;
 static const char *g_workload_type = NULL;
 static enum accel_opcode g_workload_selection;
 static struct worker_thread *g_workers = NULL;
@@ -165,6 +167,7 @@ usage(void)
 	printf("\t[-y verify result if this switch is on]\n");
 	printf("\t[-a tasks to allocate per core (default: same value as -q)]\n");
 	printf("\t\tCan be used to spread operations across a wider range of memory.\n");
+	printf("\t[-H report operation latency and per module statistics]\n");
 }
 
 static int
@@ -231,6 +234,9 @@ parse_args(int argc, char *argv)
 	case 'y':
 		g_verify = true;
 		break;
+	case 'H':
+		g_latency = true;
+		break;
 	case 'w':
 		g_workload_type = optarg;
 		if (!strcmp(g_workload_type, "copy")) {
@@ -265,6 +271,77 @@ parse_args(int argc, char *argv)
 }
 
 static int dump_result(void);
+
+static const double g_latency_cutoffs[] = {
+	0.50,
+	0.90,
+	0.99,
+	0.999,
+	0.9999,
+	-1,
+};
+
+static void
+check_cutoff(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+	     uint64_t total, uint64_t so_far)
+{
+	double so_far_pct;
+	const double **cutoff = ctx;
+
+	if (count == 0) {
+		return;
+	}
+
+	so_far_pct = (double)so_far / total;
+	while (so_far_pct >= **cutoff && **cutoff > 0) {
+		printf("%9.5f%% : %9.3fus\n", **cutoff * 100, (double)end * SPDK_SEC_TO_USEC / g_tsc_rate);
+		(*cutoff)++;
+	}
+}
+
+static void
+dump_accel_stats(struct spdk_accel_opcode_stats *stats, void *cb_arg, int status)
+{
+	struct spdk_accel_opcode_stats *op = &stats[g_workload_selection];
+	const double *cutoff = g_latency_cutoffs;
+	const char *module_name = NULL;
+
+	if (status != 0) {
+		fprintf(stderr, "Failed to get accel statistics: %s\n", spdk_strerror(-status));
+		goto out;
+	}
+
+	spdk_accel_get_opc_module_name(g_workload_selection, &module_name);
+	printf("\nModule %s: %" PRIu64 " operations, %" PRIu64 " failed, %" PRIu64 " MiB/s\n",
+	       module_name, op->executed, op->failed,
+	       op->num_bytes / (g_time_in_sec * 1024 * 1024));
+
+	if (op->histogram != NULL && op->executed > 0) {
+		printf("Latency summary:\n");
+		spdk_histogram_data_iterate(op->histogram, check_cutoff, &cutoff);
+	}
+out:
+	g_rc = dump_result();
+	spdk_app_stop(0);
+}
+
+static void
+accel_perf_finish(void *ctx)
+{
+	int rc;
+
+	if (g_latency) {
+		rc = spdk_accel_get_stats(dump_accel_stats, NULL);
+		if (rc == 0) {
+			return;
+		}
+		fprintf(stderr, "Failed to get accel statistics: %s\n", spdk_strerror(-rc));
+	}
+
+	g_rc = dump_result();
+	spdk_app_stop(0);
+}
+
 static void
 unregister_worker(void *arg1)
 {
@@ -277,8 +354,7 @@ unregister_worker(void *arg1)
 	assert(g_num_workers >= 1);
 	if (--g_num_workers == 0) {
 		pthread_mutex_unlock(&g_workers_lock);
-		g_rc = dump_result();
-		spdk_app_stop(0);
+		spdk_thread_send_msg(spdk_thread_get_app_thread(), accel_perf_finish, NULL);
 	} else {
 		pthread_mutex_unlock(&g_workers_lock);
 	}
@@ -838,7 +914,7 @@ error:
 }
 
 static void
-accel_perf_start(void *arg1)
+accel_perf_start_workers(void *cb_arg, int status)
 {
 	struct spdk_cpuset tmp_cpumask = {};
 	char thread_name[32];
@@ -847,6 +923,12 @@ accel_perf_start(void *arg1)
 	struct spdk_thread *thread;
 	struct display_info *display;
 
+	if (status != 0) {
+		fprintf(stderr, "Failed to enable accel histograms: %s\n", spdk_strerror(-status));
+		spdk_app_stop(-1);
+		return;
+	}
+
 	g_tsc_rate = spdk_get_ticks_hz();
 	g_tsc_end = spdk_get_ticks() + g_time_in_sec * g_tsc_rate;
 
@@ -875,6 +957,16 @@ accel_perf_start(void *arg1)
 	}
 }
 
+static void
+accel_perf_start(void *arg1)
+{
+	if (g_latency) {
+		spdk_accel_enable_histogram(true, accel_perf_start_workers, NULL);
+	} else {
+		accel_perf_start_workers(NULL, 0);
+	}
+}
+
 static void
 accel_perf_free_compress_segs(void)
 {
@@ -1123,7 +1215,7 @@ main(int argc, char **argv)
 	spdk_app_opts_init(&g_opts, sizeof(g_opts));
 	g_opts.name = "accel_perf";
 	g_opts.reactor_mask = "0x1";
-	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:P:f:T:l:x:", NULL, parse_args,
+	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:P:f:T:l:x:H", NULL, parse_args,
 				usage) != SPDK_APP_PARSE_ARGS_SUCCESS) {
 		g_rc = -1;
 		goto cleanup;
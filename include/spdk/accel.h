@@ -21,6 +21,9 @@ extern "C" {
 /** Data Encryption Key identifier */
 struct spdk_accel_crypto_key;
 
+struct spdk_dif_ctx;
+struct spdk_dif_error;
+
 struct spdk_accel_crypto_key_create_param {
 	char *cipher;	/**< Cipher to be used for crypto operations */
 	char *hex_key;	/**< Hexlified key */
@@ -40,7 +43,13 @@ enum accel_opcode {
 	ACCEL_OPC_ENCRYPT		= 8,
 	ACCEL_OPC_DECRYPT		= 9,
 	ACCEL_OPC_XOR			= 10,
-	ACCEL_OPC_LAST			= 11,
+	ACCEL_OPC_DIF_VERIFY		= 11,
+	ACCEL_OPC_DIF_GENERATE		= 12,
+	ACCEL_OPC_DIF_GENERATE_COPY	= 13,
+	ACCEL_OPC_DIF_VERIFY_COPY	= 14,
+	ACCEL_OPC_DIX_VERIFY		= 15,
+	ACCEL_OPC_DIX_GENERATE		= 16,
+	ACCEL_OPC_LAST			= 17,
 };
 
 /**
@@ -312,6 +321,128 @@ int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_i
 int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
 			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a DIF verify request for an extended LBA payload.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array describing the extended LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param err Error information of the block in which a DIF error is found.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
+				 struct iovec *iovs, uint32_t iovcnt, uint32_t num_blocks,
+				 const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a DIF generate request for an extended LBA payload.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array describing the extended LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_generate(struct spdk_io_channel *ch,
+				   struct iovec *iovs, uint32_t iovcnt, uint32_t num_blocks,
+				   const struct spdk_dif_ctx *ctx,
+				   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a request to copy an LBA payload into an extended LBA payload and generate its DIF.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array describing the extended LBA payload.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array describing the LBA payload.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_generate_copy(struct spdk_io_channel *ch,
+					struct iovec *dst_iovs, uint32_t dst_iovcnt,
+					struct iovec *src_iovs, uint32_t src_iovcnt,
+					uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+					spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a request to verify the DIF of an extended LBA payload and copy its data into an LBA
+ * payload.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param dst_iovs The io vector array describing the LBA payload.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param src_iovs The io vector array describing the extended LBA payload.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param err Error information of the block in which a DIF error is found.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_verify_copy(struct spdk_io_channel *ch,
+				      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				      struct iovec *src_iovs, uint32_t src_iovcnt,
+				      uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				      struct spdk_dif_error *err,
+				      spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a DIX verify request for an LBA payload whose metadata is kept in a separate buffer.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array describing the LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param md_iov The io vector describing the metadata buffer.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param err Error information of the block in which a DIF error is found.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dix_verify(struct spdk_io_channel *ch,
+				 struct iovec *iovs, uint32_t iovcnt, struct iovec *md_iov,
+				 uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				 struct spdk_dif_error *err,
+				 spdk_accel_completion_cb cb_fn, void *cb_arg);
+
+/**
+ * Submit a DIX generate request for an LBA payload whose metadata is kept in a separate buffer.
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array describing the LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param md_iov The io vector describing the metadata buffer.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dix_generate(struct spdk_io_channel *ch,
+				   struct iovec *iovs, uint32_t iovcnt, struct iovec *md_iov,
+				   uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
 /** Object grouping multiple accel operations to be executed at the same point in time */
 struct spdk_accel_sequence;
 
@@ -471,6 +602,167 @@ int spdk_accel_append_decrypt(struct spdk_accel_sequence **seq, struct spdk_io_c
 			      uint64_t iv, uint32_t block_size, int flags,
 			      spdk_accel_step_cb cb_fn, void *cb_arg);
 
+/**
+ * Append a CRC-32C calculation to a sequence.  If it directly follows or precedes a copy of the
+ * same data, both operations are executed as a single copy + CRC-32C operation.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param crc_dst Destination to write the CRC-32C to.  Must remain valid until the sequence
+ * completes.
+ * \param iovs The io vector array which stores the data.
+ * \param iovcnt The size of the io vectors.
+ * \param domain Memory domain to which the buffers belong.
+ * \param domain_ctx Buffer domain context.
+ * \param seed Four byte seed value.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_crc32c(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+			     uint32_t *crc_dst, struct iovec *iovs, uint32_t iovcnt,
+			     struct spdk_memory_domain *domain, void *domain_ctx,
+			     uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append an operation copying data and calculating the CRC-32C of the source to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param crc_dst Destination to write the CRC-32C to.  Must remain valid until the sequence
+ * completes.
+ * \param dst_iovs Destination I/O vector array.
+ * \param dst_iovcnt Size of the `dst_iovs` array.
+ * \param dst_domain Memory domain to which the destination buffers belong.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param src_iovs Source I/O vector array.
+ * \param src_iovcnt Size of the `src_iovs` array.
+ * \param src_domain Memory domain to which the source buffers belong.
+ * \param src_domain_ctx Source buffer domain context.
+ * \param seed Four byte seed value.
+ * \param flags Accel operation flags.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_copy_crc32c(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				  uint32_t *crc_dst, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+				  struct iovec *src_iovs, uint32_t src_iovcnt,
+				  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+				  uint32_t seed, int flags, spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a DIF verify operation to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param iovs The io vector array describing the extended LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param domain Memory domain to which the buffers belong.
+ * \param domain_ctx Buffer domain context.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the sequence completes.
+ * \param err Error information of the block in which a DIF error is found.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_verify(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				 struct iovec *iovs, uint32_t iovcnt,
+				 struct spdk_memory_domain *domain, void *domain_ctx,
+				 uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				 struct spdk_dif_error *err,
+				 spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append a DIF generate operation to a sequence.  The DIF is generated in place, so the buffers
+ * must be either local memory or buffers allocated via `spdk_accel_get_buf()`.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param iovs The io vector array describing the extended LBA payload.
+ * \param iovcnt The size of the io vectors.
+ * \param domain Memory domain to which the buffers belong.
+ * \param domain_ctx Buffer domain context.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the sequence completes.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_generate(struct spdk_accel_sequence **seq, struct spdk_io_channel *ch,
+				   struct iovec *iovs, uint32_t iovcnt,
+				   struct spdk_memory_domain *domain, void *domain_ctx,
+				   uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				   spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append an operation copying an LBA payload into an extended LBA payload and generating its DIF
+ * to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param dst_iovs The io vector array describing the extended LBA payload.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param dst_domain Memory domain to which the destination buffers belong.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param src_iovs The io vector array describing the LBA payload.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param src_domain Memory domain to which the source buffers belong.
+ * \param src_domain_ctx Source buffer domain context.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the sequence completes.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_generate_copy(struct spdk_accel_sequence **seq,
+					struct spdk_io_channel *ch,
+					struct iovec *dst_iovs, uint32_t dst_iovcnt,
+					struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+					struct iovec *src_iovs, uint32_t src_iovcnt,
+					struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+					uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+					spdk_accel_step_cb cb_fn, void *cb_arg);
+
+/**
+ * Append an operation verifying the DIF of an extended LBA payload and copying its data into an
+ * LBA payload to a sequence.
+ *
+ * \param seq Sequence object.  If NULL, a new sequence object will be created.
+ * \param ch I/O channel.
+ * \param dst_iovs The io vector array describing the LBA payload.
+ * \param dst_iovcnt The size of the destination io vectors.
+ * \param dst_domain Memory domain to which the destination buffers belong.
+ * \param dst_domain_ctx Destination buffer domain context.
+ * \param src_iovs The io vector array describing the extended LBA payload.
+ * \param src_iovcnt The size of the source io vectors.
+ * \param src_domain Memory domain to which the source buffers belong.
+ * \param src_domain_ctx Source buffer domain context.
+ * \param num_blocks Number of blocks of the payload.
+ * \param ctx DIF context.  Must remain valid until the sequence completes.
+ * \param err Error information of the block in which a DIF error is found.
+ * \param cb_fn Callback to be executed once this operation is completed.
+ * \param cb_arg Argument to be passed to `cb_fn`.
+ *
+ * \return 0 if operation was successfully added to the sequence, negative errno otherwise.
+ */
+int spdk_accel_append_dif_verify_copy(struct spdk_accel_sequence **seq,
+				      struct spdk_io_channel *ch,
+				      struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				      struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+				      struct iovec *src_iovs, uint32_t src_iovcnt,
+				      struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+				      uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				      struct spdk_dif_error *err,
+				      spdk_accel_step_cb cb_fn, void *cb_arg);
+
 /**
  * Finish a sequence and execute all its operations. After the completion callback is executed, the
  * sequence object is automatically freed.
@@ -641,6 +933,61 @@ int spdk_accel_set_driver(const char *name);
  */
 struct spdk_memory_domain *spdk_accel_get_memory_domain(void);
 
+struct spdk_histogram_data;
+
+/** Statistics of a single operation type, gathered from all accel channels. */
+struct spdk_accel_opcode_stats {
+	/** Number of completed operations, including the failed ones */
+	uint64_t			executed;
+	/** Number of operations completed with an error */
+	uint64_t			failed;
+	/** Number of bytes processed by successful operations */
+	uint64_t			num_bytes;
+	/** Latency histogram (in ticks), NULL unless histograms are enabled */
+	struct spdk_histogram_data	*histogram;
+};
+
+/**
+ * Callback used by `spdk_accel_enable_histogram()`.
+ *
+ * \param cb_arg Callback argument.
+ * \param status 0 on success, negative errno otherwise.
+ */
+typedef void (*spdk_accel_histogram_status_cb)(void *cb_arg, int status);
+
+/**
+ * Enable or disable latency histograms of all operations.  When disabled (the default), no
+ * timestamps are taken on the submission path and no bytes are counted on completion.
+ *
+ * \param enable true to enable histograms, false to disable and free them.
+ * \param cb_fn Callback executed once the histograms have been updated on all channels.
+ * \param cb_arg Argument passed to `cb_fn`.
+ */
+void spdk_accel_enable_histogram(bool enable, spdk_accel_histogram_status_cb cb_fn, void *cb_arg);
+
+/**
+ * Callback used by `spdk_accel_get_stats()`.
+ *
+ * \param stats Array of `ACCEL_OPC_LAST` statistics, indexed by opcode.  Only valid within the
+ * callback.
+ * \param cb_arg Callback argument.
+ * \param status 0 on success, negative errno otherwise.
+ */
+typedef void (*spdk_accel_get_stats_cb)(struct spdk_accel_opcode_stats *stats, void *cb_arg,
+					int status);
+
+/**
+ * Gather statistics of all operations from all accel channels.  Since each opcode is executed
+ * by a single module, these are also the statistics of the module assigned to that opcode (see
+ * `spdk_accel_get_opc_module_name()`).
+ *
+ * \param cb_fn Callback executed once the statistics have been collected.
+ * \param cb_arg Argument passed to `cb_fn`.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_accel_get_stats(spdk_accel_get_stats_cb cb_fn, void *cb_arg);
+
 #ifdef __cplusplus
 }
 #endif
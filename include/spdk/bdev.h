@@ -180,6 +180,10 @@ struct spdk_bdev_io_stat {
 	uint64_t max_copy_latency_ticks;
 	uint64_t min_copy_latency_ticks;
 	uint64_t ticks_rate;
+	/* Number of I/Os the merge stage submitted in place of several adjacent I/Os */
+	uint64_t num_merge_ops;
+	/* Number of I/Os that were combined into those merged I/Os */
+	uint64_t num_merged_ops;
 
 	/* This data structure is privately defined in the bdev library.
 	 * This data structure is only used by the bdev_get_iostat RPC now.
@@ -566,6 +570,46 @@ void spdk_bdev_get_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits);
 void spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 				   void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
 
+/**
+ * Limits of the I/O merge stage of a bdev.
+ *
+ * The merge stage combines adjacent read or write I/Os submitted on the same channel
+ * into a single I/O before passing them to the bdev module.
+ */
+struct spdk_bdev_merge_limits {
+	/** Maximum size of a merged I/O in bytes. 0 disables merging. */
+	uint32_t max_bytes;
+
+	/** Maximum number of I/Os combined into a single merged I/O. */
+	uint32_t max_ios;
+
+	/** Maximum time in microseconds an I/O waits for adjacent I/Os to be merged with. */
+	uint32_t window_us;
+};
+
+/**
+ * Get the I/O merge limits of a bdev.
+ *
+ * \param bdev Block device to query.
+ * \param limits Filled with the merge limits. limits->max_bytes is 0 if merging is disabled.
+ */
+void spdk_bdev_get_merge_limits(struct spdk_bdev *bdev, struct spdk_bdev_merge_limits *limits);
+
+/**
+ * Set the I/O merge limits of a bdev.
+ *
+ * I/Os are only merged if they are contiguous reads or writes submitted on the same
+ * channel without metadata buffers, memory domains or accel sequences.
+ *
+ * \param bdev Block device.
+ * \param limits New merge limits. Setting limits->max_bytes to 0 disables merging.
+ * \param cb_fn Callback function to be called when the limits have been updated.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_set_merge_limits(struct spdk_bdev *bdev,
+				const struct spdk_bdev_merge_limits *limits,
+				void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
 /**
  * Get minimum I/O buffer address alignment for a bdev.
  *
@@ -1989,6 +2033,44 @@ void spdk_bdev_histogram_get(struct spdk_bdev *bdev, struct spdk_histogram_data
 void spdk_bdev_channel_get_histogram(struct spdk_io_channel *ch, spdk_bdev_histogram_data_cb cb_fn,
 				     void *cb_arg);
 
+/** Number of I/O size classes tracked by the per I/O type latency histograms. */
+#define SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES	8
+
+/**
+ * Latency histograms of a bdev broken down by I/O type and I/O size class.
+ *
+ * Size class 0 covers I/Os up to 4KiB, each following class doubles the upper
+ * bound and the last class covers everything above. Histograms for
+ * (I/O type, size class) pairs that saw no I/O are NULL.
+ */
+struct spdk_bdev_io_type_histograms {
+	struct spdk_histogram_data *histogram[SPDK_BDEV_NUM_IO_TYPES][SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES];
+};
+
+typedef void (*spdk_bdev_io_type_histograms_cb)(void *cb_arg, int status,
+		const struct spdk_bdev_io_type_histograms *histograms);
+
+/**
+ * Get the upper bound, in bytes, of the I/O sizes accounted in a size class.
+ *
+ * \param size_class Size class, less than SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES.
+ * \return Largest I/O size in bytes of the class, or UINT64_MAX for the last class.
+ */
+uint64_t spdk_bdev_histogram_get_size_class_max(uint32_t size_class);
+
+/**
+ * Get the latency histograms of a bdev broken down by I/O type and size class,
+ * merged across all of its channels. Histograms have to be enabled on the bdev
+ * with spdk_bdev_histogram_enable(). The histograms passed to cb_fn are only
+ * valid during the execution of cb_fn.
+ *
+ * \param bdev Block device.
+ * \param cb_fn Callback function to be called with the merged histograms.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_io_type_histograms_get(struct spdk_bdev *bdev,
+				      spdk_bdev_io_type_histograms_cb cb_fn, void *cb_arg);
+
 /**
  * Retrieves media events.  Can only be called from the context of
  * SPDK_BDEV_EVENT_MEDIA_MANAGEMENT event callback.  These events are sent by
@@ -724,6 +724,10 @@ struct spdk_bdev {
 		bool	histogram_enabled;
 		bool	histogram_in_progress;
 
+		/** I/O merge limits, merge_limits.max_bytes is 0 if merging is disabled */
+		struct spdk_bdev_merge_limits merge_limits;
+		bool	merge_in_progress;
+
 		/** Currently locked ranges for this bdev.  Used to populate new channels. */
 		lba_range_tailq_t locked_ranges;
 
@@ -1016,7 +1020,10 @@ struct spdk_bdev_io {
 		 */
 		TAILQ_ENTRY(spdk_bdev_io) link;
 
-		/** Entry to the list need_buf of struct spdk_bdev. */
+		/**
+		 * Entry to the list need_buf of struct spdk_bdev. Also links the I/Os waiting
+		 * in or combined by the merge stage of a bdev channel.
+		 */
 		STAILQ_ENTRY(spdk_bdev_io) buf_link;
 
 		/** Entry to the list io_submitted of struct spdk_bdev_channel */
@@ -54,6 +54,17 @@ enum ftl_stats_type {
 	FTL_STATS_TYPE_MAX,
 };
 
+struct ftl_stats_l2p_cache {
+	/* Number of L2P pages found resident (or already being loaded) when pinned */
+	uint64_t hits;
+	/* Number of L2P pages which had to be paged in on demand */
+	uint64_t misses;
+	/* Number of L2P pages read ahead for sequential access streams */
+	uint64_t prefetches;
+	/* Number of read ahead L2P pages which were used afterwards */
+	uint64_t prefetch_hits;
+};
+
 struct ftl_stats {
 	/* Number of times write limits were triggered by FTL writers
 	 * (gc and compaction) dependent on number of free bands. GC starts at
@@ -69,6 +80,9 @@ struct ftl_stats {
 	uint64_t		io_activity_total;
 
 	struct ftl_stats_entry	entries[FTL_STATS_TYPE_MAX];
+
+	/* L2P cache statistics, only updated when the L2P doesn't fit in DRAM entirely */
+	struct ftl_stats_l2p_cache	l2p_cache;
 };
 
 typedef void (*spdk_ftl_stats_fn)(struct ftl_stats *stats, void *cb_arg);
@@ -52,6 +52,21 @@ typedef void (*spdk_nbd_start_cb)(void *cb_arg, struct spdk_nbd_disk *nbd,
 void spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		    spdk_nbd_start_cb cb_fn, void *cb_arg);
 
+/**
+ * Start a network block device backed by the bdev, using several connections to the kernel.
+ *
+ * The kernel maps each connection to a hardware queue of the block device, so requests
+ * submitted from different CPUs don't contend on a single socket.
+ *
+ * \param bdev_name Name of bdev exposed as a network block device.
+ * \param nbd_path Path to the registered network block device.
+ * \param num_connections Number of connections, between 1 and 16.
+ * \param cb_fn Callback to be always called.
+ * \param cb_arg Passed to cb_fn.
+ */
+void spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+			spdk_nbd_start_cb cb_fn, void *cb_arg);
+
 /**
  * Stop the running network block device safely.
  *
@@ -595,8 +595,13 @@ struct spdk_nvme_ns_cmd_ext_io_opts {
 	uint16_t apptag;
 	/** Command dword 13 specific field. */
 	uint32_t cdw13;
+	/** Handle of a buffer region registered via \ref spdk_nvme_qpair_register_buffer
+	 * containing the data and metadata payloads, or 0 if they aren't registered. */
+	uint32_t buf_handle;
+	/* Hole at bytes 52-55. */
+	uint8_t reserved52[4];
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ns_cmd_ext_io_opts) == 48, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ns_cmd_ext_io_opts) == 56, "Incorrect size");
 
 /**
  * Parse the string representation of a transport ID.
@@ -3868,6 +3873,44 @@ uint16_t spdk_nvme_qpair_get_id(struct spdk_nvme_qpair *qpair);
  */
 uint32_t spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair);
 
+/**
+ * Register a buffer region with an I/O qpair.
+ *
+ * The physical addresses of the region are resolved once, when it's registered.  I/O
+ * submitted via spdk_nvme_ns_cmd_readv_ext() or spdk_nvme_ns_cmd_writev_ext() can then pass
+ * the returned handle in spdk_nvme_ns_cmd_ext_io_opts::buf_handle to have the addresses of
+ * its payloads translated through a table lookup, instead of a memory map lookup for every
+ * page.  Payloads, or parts of them, outside of the region are translated as usual.
+ *
+ * The region must be DMA-able memory (allocated via spdk_dma_malloc() / spdk_zmalloc(), or
+ * registered via spdk_mem_register()) and it must stay that way until it's unregistered.
+ * Currently, only the PCIe transport makes use of the registered regions.
+ *
+ * This function is not thread safe and must be called from the thread owning the qpair.
+ *
+ * \param qpair I/O qpair to register the region with.
+ * \param buf Start of the region.
+ * \param len Length of the region in bytes.
+ * \param handle Output handle of the region.
+ *
+ * \return 0 on success, -EINVAL if the region isn't DMA-able, -ENOMEM if memory could not
+ * be allocated.
+ */
+int spdk_nvme_qpair_register_buffer(struct spdk_nvme_qpair *qpair, void *buf, size_t len,
+				    uint32_t *handle);
+
+/**
+ * Unregister a buffer region registered via spdk_nvme_qpair_register_buffer().
+ *
+ * The caller must make sure that no outstanding I/O refers to the region's handle.
+ *
+ * \param qpair I/O qpair the region was registered with.
+ * \param handle Handle of the region.
+ *
+ * \return 0 on success, -ENOENT if the handle doesn't refer to a registered region.
+ */
+int spdk_nvme_qpair_unregister_buffer(struct spdk_nvme_qpair *qpair, uint32_t handle);
+
 /**
  * \brief Prints (SPDK_NOTICELOG) the contents of an NVMe submission queue entry (command).
  *
@@ -15,6 +15,21 @@
 
 #define REDUCE_MAX_IOVECS	33
 
+/**
+ * Describes how chunks are laid out on the backing device.
+ */
+enum spdk_reduce_chunk_layout {
+	/** Each chunk is stored in a whole number of backing io units. */
+	SPDK_REDUCE_CHUNK_LAYOUT_IO_UNIT = 0,
+
+	/**
+	 * Each chunk is stored in a whole number of backing device blocks, so
+	 *  several compressed chunks can share a backing io unit.  Partially used
+	 *  io units are compacted in the background.
+	 */
+	SPDK_REDUCE_CHUNK_LAYOUT_PACKED = 1,
+};
+
 /**
  * Describes the parameters of an spdk_reduce_vol.
  */
@@ -54,6 +69,14 @@ struct spdk_reduce_vol_params {
 	 *  of the chunk size.
 	 */
 	uint64_t		vol_size;
+
+	/**
+	 * Layout of the chunks on the backing device, one of
+	 *  enum spdk_reduce_chunk_layout.  Persisted at initialization,
+	 *  so it does not need to be set before loading a volume.
+	 */
+	uint32_t		chunk_layout;
+	uint32_t		reserved;
 };
 
 struct spdk_reduce_vol;
@@ -124,7 +147,9 @@ const struct spdk_uuid *spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol);
  * \param backing_dev Structure describing the backing device to use for the new volume.
  * \param pm_file_dir Directory to use for creation of the persistent memory file to
  *                    use for the new volume.  This function will append the UUID as
- *		      the filename to create in this directory.
+ *		      the filename to create in this directory.  If NULL or empty, the
+ *		      metadata is kept in memory and journaled to a region at the start of
+ *		      the backing device instead.
  * \param cb_fn Callback function to signal completion of the initialization process.
  * \param cb_arg Argument to pass to the callback function.
  */
@@ -160,9 +185,9 @@ void spdk_reduce_vol_unload(struct spdk_reduce_vol *vol,
  * Destroy an existing libreduce compressed volume.
  *
  * This will zero the metadata region on the backing device and delete the associated
- * pm metadata file.  If the backing device does not contain a compressed volume, the
- * cb_fn will be called with error status without modifying the backing device nor
- * deleting a pm file.
+ * pm metadata file, if the volume uses one.  If the backing device does not contain
+ * a compressed volume, the cb_fn will be called with error status without modifying
+ * the backing device nor deleting a pm file.
  *
  * \param backing_dev Structure describing the backing device containing the compressed volume.
  * \param cb_fn Callback function to signal completion of the destruction process.
@@ -205,6 +205,38 @@ int spdk_vhost_set_coalescing(struct spdk_vhost_dev *vdev, uint32_t delay_base_u
 void spdk_vhost_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 			       uint32_t *iops_threshold);
 
+/**
+ * Set the request latency targeted by adaptive event coalescing.
+ *
+ * Instead of deriving the events delay from the IOPS alone, each virtqueue
+ * measures the latency of the requests it completes and periodically adjusts
+ * its own delay, so that the average latency including the delay stays close
+ * to the target. The delay is shrunk as soon as the latency exceeds the target
+ * and grown gradually while there is slack left. Events are never delayed while
+ * the queue's IOPS stay below the iops_threshold set by spdk_vhost_set_coalescing().
+ *
+ * Only supported by vhost-blk devices.
+ *
+ * \param vdev vhost device.
+ * \param latency_target_us Targeted request latency in microseconds. If 0,
+ * adaptive coalescing is disabled.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_vhost_set_coalescing_latency_target(struct spdk_vhost_dev *vdev,
+		uint32_t latency_target_us);
+
+/**
+ * Get the request latency targeted by adaptive event coalescing.
+ *
+ * \see spdk_vhost_set_coalescing_latency_target
+ *
+ * \param vdev vhost device.
+ *
+ * \return targeted latency in microseconds, 0 if adaptive coalescing is disabled.
+ */
+uint32_t spdk_vhost_get_coalescing_latency_target(struct spdk_vhost_dev *vdev);
+
 /**
  * Construct an empty vhost SCSI device.  This will create a
  * Unix domain socket together with a vhost-user slave server waiting
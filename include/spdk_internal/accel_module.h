@@ -99,12 +99,19 @@ struct spdk_accel_task {
 		uint32_t		*output_size;
 		uint32_t		block_size; /* for crypto op */
 	};
+	struct {
+		const struct spdk_dif_ctx	*ctx;
+		struct spdk_dif_error		*err;
+		struct iovec			*md_iov; /* DIX only */
+		uint32_t			num_blocks;
+	} dif;
 	struct {
 		struct spdk_accel_bounce_buffer s;
 		struct spdk_accel_bounce_buffer d;
 	} bounce;
 	enum accel_opcode		op_code;
 	uint64_t			iv; /* Initialization vector (tweak) for crypto op */
+	uint64_t			submit_tsc; /* Only set when histograms are enabled */
 	int				flags;
 	int				status;
 	struct iovec			aux_iovs[SPDK_ACCEL_AUX_IOV_MAX];
@@ -17,8 +17,10 @@
 #include "spdk/thread.h"
 #include "spdk/json.h"
 #include "spdk/crc32.h"
+#include "spdk/dif.h"
 #include "spdk/util.h"
 #include "spdk/hexlify.h"
+#include "spdk/histogram_data.h"
 
 /* Accelerator Framework: The following provides a top level
  * generic API for the accelerator functions defined here. Modules,
@@ -48,6 +50,8 @@ static spdk_accel_fini_cb g_fini_cb_fn = NULL;
 static void *g_fini_cb_arg = NULL;
 static bool g_modules_started = false;
 static struct spdk_memory_domain *g_accel_domain;
+static bool g_histogram_enabled = false;
+static bool g_histogram_in_progress = false;
 
 /* Global list of registered accelerator modules */
 static TAILQ_HEAD(, spdk_accel_module_if) spdk_accel_module_list =
@@ -57,6 +61,10 @@ static TAILQ_HEAD(, spdk_accel_module_if) spdk_accel_module_list =
 static TAILQ_HEAD(, spdk_accel_crypto_key) g_keyring = TAILQ_HEAD_INITIALIZER(g_keyring);
 static struct spdk_spinlock g_keyring_spin;
 
+/* Statistics of the channels that have already been destroyed */
+static struct spdk_accel_opcode_stats g_stats[ACCEL_OPC_LAST];
+static struct spdk_spinlock g_stats_lock;
+
 /* Global array mapping capabilities to modules */
 static struct accel_module g_modules_opc[ACCEL_OPC_LAST] = {};
 static char *g_modules_opc_override[ACCEL_OPC_LAST] = {};
@@ -65,7 +73,9 @@ static struct spdk_accel_driver *g_accel_driver;
 
 static const char *g_opcode_strings[ACCEL_OPC_LAST] = {
 	"copy", "fill", "dualcast", "compare", "crc32c", "copy_crc32c",
-	"compress", "decompress", "encrypt", "decrypt", "xor"
+	"compress", "decompress", "encrypt", "decrypt", "xor",
+	"dif_verify", "dif_generate", "dif_generate_copy", "dif_verify_copy",
+	"dix_verify", "dix_generate"
 };
 
 enum accel_sequence_state {
@@ -134,6 +144,8 @@ struct accel_io_channel {
 	TAILQ_HEAD(, spdk_accel_sequence)	seq_pool;
 	TAILQ_HEAD(, accel_buffer)		buf_pool;
 	struct spdk_iobuf_channel		iobuf;
+	bool					histogram_enabled;
+	struct spdk_accel_opcode_stats		stats[ACCEL_OPC_LAST];
 };
 
 TAILQ_HEAD(accel_sequence_tasks, spdk_accel_task);
@@ -240,6 +252,52 @@ spdk_accel_assign_opc(enum accel_opcode opcode, const char *name)
 	return 0;
 }
 
+static uint64_t
+accel_get_task_bytes(struct spdk_accel_task *task)
+{
+	struct iovec *iovs;
+	uint32_t i, iovcnt;
+	uint64_t result = 0;
+
+	switch (task->op_code) {
+	case ACCEL_OPC_FILL:
+	case ACCEL_OPC_XOR:
+		iovs = task->d.iovs;
+		iovcnt = task->d.iovcnt;
+		break;
+	default:
+		iovs = task->s.iovs;
+		iovcnt = task->s.iovcnt;
+		break;
+	}
+
+	for (i = 0; i < iovcnt; ++i) {
+		result += iovs[i].iov_len;
+	}
+
+	return result;
+}
+
+static inline void
+accel_update_task_stats(struct accel_io_channel *accel_ch, struct spdk_accel_task *task,
+			int status)
+{
+	struct spdk_accel_opcode_stats *stats = &accel_ch->stats[task->op_code];
+
+	stats->executed++;
+	if (spdk_unlikely(status != 0)) {
+		stats->failed++;
+		return;
+	}
+
+	stats->num_bytes += accel_get_task_bytes(task);
+	if (spdk_unlikely(accel_ch->histogram_enabled)) {
+		if (stats->histogram != NULL && task->submit_tsc != 0) {
+			spdk_histogram_data_tally(stats->histogram, spdk_get_ticks() - task->submit_tsc);
+		}
+	}
+}
+
 void
 spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 {
@@ -247,6 +305,8 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 	spdk_accel_completion_cb	cb_fn = accel_task->cb_fn;
 	void				*cb_arg = accel_task->cb_arg;
 
+	accel_update_task_stats(accel_ch, accel_task, status);
+
 	/* We should put the accel_task into the list firstly in order to avoid
 	 * the accel task list is exhausted when there is recursive call to
 	 * allocate accel_task in user's call back function (cb_fn)
@@ -275,6 +335,9 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 	accel_task->accel_ch = accel_ch;
 	accel_task->bounce.s.orig_iovs = NULL;
 	accel_task->bounce.d.orig_iovs = NULL;
+	/* Tasks are submitted right after they're allocated, except for the tasks executed as part
+	 * of a sequence, which get a new timestamp once they're actually submitted */
+	accel_task->submit_tsc = spdk_unlikely(accel_ch->histogram_enabled) ? spdk_get_ticks() : 0;
 
 	return accel_task;
 }
@@ -735,6 +798,215 @@ spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uin
 	return module->submit_tasks(module_ch, accel_task);
 }
 
+int
+spdk_accel_submit_dif_verify(struct spdk_io_channel *ch,
+			     struct iovec *iovs, uint32_t iovcnt, uint32_t num_blocks,
+			     const struct spdk_dif_ctx *ctx, struct spdk_dif_error *err,
+			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIF_VERIFY].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIF_VERIFY];
+
+	if (spdk_unlikely(!iovs || !iovcnt || !num_blocks || !ctx || !err)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = err;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_VERIFY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_generate(struct spdk_io_channel *ch,
+			       struct iovec *iovs, uint32_t iovcnt, uint32_t num_blocks,
+			       const struct spdk_dif_ctx *ctx,
+			       spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIF_GENERATE].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIF_GENERATE];
+
+	if (spdk_unlikely(!iovs || !iovcnt || !num_blocks || !ctx)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = NULL;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_GENERATE;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_generate_copy(struct spdk_io_channel *ch,
+				    struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				    struct iovec *src_iovs, uint32_t src_iovcnt,
+				    uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				    spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIF_GENERATE_COPY].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIF_GENERATE_COPY];
+
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !num_blocks ||
+			  !ctx)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = src_iovs;
+	accel_task->s.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = NULL;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_GENERATE_COPY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_verify_copy(struct spdk_io_channel *ch,
+				  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				  struct iovec *src_iovs, uint32_t src_iovcnt,
+				  uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				  struct spdk_dif_error *err,
+				  spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIF_VERIFY_COPY].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIF_VERIFY_COPY];
+
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !num_blocks ||
+			  !ctx || !err)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = src_iovs;
+	accel_task->s.iovcnt = src_iovcnt;
+	accel_task->d.iovs = dst_iovs;
+	accel_task->d.iovcnt = dst_iovcnt;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = err;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_VERIFY_COPY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dix_verify(struct spdk_io_channel *ch,
+			     struct iovec *iovs, uint32_t iovcnt, struct iovec *md_iov,
+			     uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			     struct spdk_dif_error *err,
+			     spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIX_VERIFY].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIX_VERIFY];
+
+	if (spdk_unlikely(!iovs || !iovcnt || !md_iov || !num_blocks || !ctx || !err)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.md_iov = md_iov;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = err;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIX_VERIFY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dix_generate(struct spdk_io_channel *ch,
+			       struct iovec *iovs, uint32_t iovcnt, struct iovec *md_iov,
+			       uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			       spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+	struct spdk_accel_module_if *module = g_modules_opc[ACCEL_OPC_DIX_GENERATE].module;
+	struct spdk_io_channel *module_ch = accel_ch->module_ch[ACCEL_OPC_DIX_GENERATE];
+
+	if (spdk_unlikely(!iovs || !iovcnt || !md_iov || !num_blocks || !ctx)) {
+		return -EINVAL;
+	}
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->dif.md_iov = md_iov;
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIX_GENERATE;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return module->submit_tasks(module_ch, accel_task);
+}
+
 static inline struct accel_buffer *
 accel_get_buf(struct accel_io_channel *ch, uint64_t len)
 {
@@ -899,17 +1171,326 @@ spdk_accel_append_fill(struct spdk_accel_sequence **pseq, struct spdk_io_channel
 		return -ENOMEM;
 	}
 
-	memset(&task->fill_pattern, pattern, sizeof(uint64_t));
-
-	task->d.iovs = &task->aux_iovs[SPDK_ACCEL_AUX_IOV_DST];
-	task->d.iovs[0].iov_base = buf;
-	task->d.iovs[0].iov_len = len;
-	task->d.iovcnt = 1;
-	task->src_domain = NULL;
-	task->dst_domain = domain;
-	task->dst_domain_ctx = domain_ctx;
-	task->flags = flags;
-	task->op_code = ACCEL_OPC_FILL;
+	memset(&task->fill_pattern, pattern, sizeof(uint64_t));
+
+	task->d.iovs = &task->aux_iovs[SPDK_ACCEL_AUX_IOV_DST];
+	task->d.iovs[0].iov_base = buf;
+	task->d.iovs[0].iov_len = len;
+	task->d.iovcnt = 1;
+	task->src_domain = NULL;
+	task->dst_domain = domain;
+	task->dst_domain_ctx = domain_ctx;
+	task->flags = flags;
+	task->op_code = ACCEL_OPC_FILL;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			     struct iovec *dst_iovs, size_t dst_iovcnt,
+			     struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			     struct iovec *src_iovs, size_t src_iovcnt,
+			     struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			     int flags, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	/* TODO: support output_size for chaining */
+	task->output_size = NULL;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->flags = flags;
+	task->op_code = ACCEL_OPC_DECOMPRESS;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			  uint64_t iv, uint32_t block_size, int flags,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !key ||
+			  !block_size)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->crypto_key = key;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->iv = iv;
+	task->block_size = block_size;
+	task->flags = flags;
+	task->op_code = ACCEL_OPC_ENCRYPT;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			  struct spdk_accel_crypto_key *key,
+			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			  struct iovec *src_iovs, uint32_t src_iovcnt,
+			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			  uint64_t iv, uint32_t block_size, int flags,
+			  spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !key ||
+			  !block_size)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->crypto_key = key;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->iv = iv;
+	task->block_size = block_size;
+	task->flags = flags;
+	task->op_code = ACCEL_OPC_DECRYPT;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			 uint32_t *crc_dst, struct iovec *iovs, uint32_t iovcnt,
+			 struct spdk_memory_domain *domain, void *domain_ctx,
+			 uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!crc_dst || !iovs || !iovcnt)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->dst_domain = NULL;
+	task->crc_dst = crc_dst;
+	task->seed = seed;
+	task->flags = 0;
+	task->op_code = ACCEL_OPC_CRC32C;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_copy_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			      uint32_t *crc_dst, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+			      struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+			      struct iovec *src_iovs, uint32_t src_iovcnt,
+			      struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+			      uint32_t seed, int flags, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!crc_dst || !dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->dst_domain = dst_domain;
+	task->dst_domain_ctx = dst_domain_ctx;
+	task->d.iovs = dst_iovs;
+	task->d.iovcnt = dst_iovcnt;
+	task->src_domain = src_domain;
+	task->src_domain_ctx = src_domain_ctx;
+	task->s.iovs = src_iovs;
+	task->s.iovcnt = src_iovcnt;
+	task->crc_dst = crc_dst;
+	task->seed = seed;
+	task->flags = flags;
+	task->op_code = ACCEL_OPC_COPY_CRC32C;
+
+	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
+	*pseq = seq;
+
+	return 0;
+}
+
+int
+spdk_accel_append_dif_verify(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			     struct iovec *iovs, uint32_t iovcnt,
+			     struct spdk_memory_domain *domain, void *domain_ctx,
+			     uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			     struct spdk_dif_error *err,
+			     spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *task;
+	struct spdk_accel_sequence *seq = *pseq;
+
+	if (spdk_unlikely(!iovs || !iovcnt || !num_blocks || !ctx || !err)) {
+		return -EINVAL;
+	}
+
+	if (seq == NULL) {
+		seq = accel_sequence_get(accel_ch);
+		if (spdk_unlikely(seq == NULL)) {
+			return -ENOMEM;
+		}
+	}
+
+	assert(seq->ch == accel_ch);
+	task = accel_sequence_get_task(accel_ch, seq, cb_fn, cb_arg);
+	if (spdk_unlikely(task == NULL)) {
+		if (*pseq == NULL) {
+			accel_sequence_put(seq);
+		}
+
+		return -ENOMEM;
+	}
+
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->dst_domain = NULL;
+	task->dif.ctx = ctx;
+	task->dif.err = err;
+	task->dif.num_blocks = num_blocks;
+	task->flags = 0;
+	task->op_code = ACCEL_OPC_DIF_VERIFY;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -918,17 +1499,25 @@ spdk_accel_append_fill(struct spdk_accel_sequence **pseq, struct spdk_io_channel
 }
 
 int
-spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			     struct iovec *dst_iovs, size_t dst_iovcnt,
-			     struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
-			     struct iovec *src_iovs, size_t src_iovcnt,
-			     struct spdk_memory_domain *src_domain, void *src_domain_ctx,
-			     int flags, spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_generate(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			       struct iovec *iovs, uint32_t iovcnt,
+			       struct spdk_memory_domain *domain, void *domain_ctx,
+			       uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			       spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
 	struct spdk_accel_sequence *seq = *pseq;
 
+	if (spdk_unlikely(!iovs || !iovcnt || !num_blocks || !ctx)) {
+		return -EINVAL;
+	}
+
+	/* The payload is updated in place, which cannot be done through a bounce buffer */
+	if (spdk_unlikely(domain != NULL && domain != g_accel_domain)) {
+		return -EINVAL;
+	}
+
 	if (seq == NULL) {
 		seq = accel_sequence_get(accel_ch);
 		if (spdk_unlikely(seq == NULL)) {
@@ -946,18 +1535,16 @@ spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_c
 		return -ENOMEM;
 	}
 
-	/* TODO: support output_size for chaining */
-	task->output_size = NULL;
-	task->dst_domain = dst_domain;
-	task->dst_domain_ctx = dst_domain_ctx;
-	task->d.iovs = dst_iovs;
-	task->d.iovcnt = dst_iovcnt;
-	task->src_domain = src_domain;
-	task->src_domain_ctx = src_domain_ctx;
-	task->s.iovs = src_iovs;
-	task->s.iovcnt = src_iovcnt;
-	task->flags = flags;
-	task->op_code = ACCEL_OPC_DECOMPRESS;
+	task->src_domain = domain;
+	task->src_domain_ctx = domain_ctx;
+	task->s.iovs = iovs;
+	task->s.iovcnt = iovcnt;
+	task->dst_domain = NULL;
+	task->dif.ctx = ctx;
+	task->dif.err = NULL;
+	task->dif.num_blocks = num_blocks;
+	task->flags = 0;
+	task->op_code = ACCEL_OPC_DIF_GENERATE;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -966,21 +1553,20 @@ spdk_accel_append_decompress(struct spdk_accel_sequence **pseq, struct spdk_io_c
 }
 
 int
-spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			  struct spdk_accel_crypto_key *key,
-			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
-			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
-			  struct iovec *src_iovs, uint32_t src_iovcnt,
-			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
-			  uint64_t iv, uint32_t block_size, int flags,
-			  spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_generate_copy(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+				    struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				    struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+				    struct iovec *src_iovs, uint32_t src_iovcnt,
+				    struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+				    uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				    spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
 	struct spdk_accel_sequence *seq = *pseq;
 
-	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !key ||
-			  !block_size)) {
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !num_blocks ||
+			  !ctx)) {
 		return -EINVAL;
 	}
 
@@ -1001,7 +1587,6 @@ spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 		return -ENOMEM;
 	}
 
-	task->crypto_key = key;
 	task->src_domain = src_domain;
 	task->src_domain_ctx = src_domain_ctx;
 	task->s.iovs = src_iovs;
@@ -1010,10 +1595,11 @@ spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 	task->dst_domain_ctx = dst_domain_ctx;
 	task->d.iovs = dst_iovs;
 	task->d.iovcnt = dst_iovcnt;
-	task->iv = iv;
-	task->block_size = block_size;
-	task->flags = flags;
-	task->op_code = ACCEL_OPC_ENCRYPT;
+	task->dif.ctx = ctx;
+	task->dif.err = NULL;
+	task->dif.num_blocks = num_blocks;
+	task->flags = 0;
+	task->op_code = ACCEL_OPC_DIF_GENERATE_COPY;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1022,21 +1608,21 @@ spdk_accel_append_encrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 }
 
 int
-spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
-			  struct spdk_accel_crypto_key *key,
-			  struct iovec *dst_iovs, uint32_t dst_iovcnt,
-			  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
-			  struct iovec *src_iovs, uint32_t src_iovcnt,
-			  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
-			  uint64_t iv, uint32_t block_size, int flags,
-			  spdk_accel_step_cb cb_fn, void *cb_arg)
+spdk_accel_append_dif_verify_copy(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+				  struct iovec *dst_iovs, uint32_t dst_iovcnt,
+				  struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+				  struct iovec *src_iovs, uint32_t src_iovcnt,
+				  struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+				  uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				  struct spdk_dif_error *err,
+				  spdk_accel_step_cb cb_fn, void *cb_arg)
 {
 	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *task;
 	struct spdk_accel_sequence *seq = *pseq;
 
-	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !key ||
-			  !block_size)) {
+	if (spdk_unlikely(!dst_iovs || !dst_iovcnt || !src_iovs || !src_iovcnt || !num_blocks ||
+			  !ctx || !err)) {
 		return -EINVAL;
 	}
 
@@ -1057,7 +1643,6 @@ spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 		return -ENOMEM;
 	}
 
-	task->crypto_key = key;
 	task->src_domain = src_domain;
 	task->src_domain_ctx = src_domain_ctx;
 	task->s.iovs = src_iovs;
@@ -1066,10 +1651,11 @@ spdk_accel_append_decrypt(struct spdk_accel_sequence **pseq, struct spdk_io_chan
 	task->dst_domain_ctx = dst_domain_ctx;
 	task->d.iovs = dst_iovs;
 	task->d.iovcnt = dst_iovcnt;
-	task->iv = iv;
-	task->block_size = block_size;
-	task->flags = flags;
-	task->op_code = ACCEL_OPC_DECRYPT;
+	task->dif.ctx = ctx;
+	task->dif.err = err;
+	task->dif.num_blocks = num_blocks;
+	task->flags = 0;
+	task->op_code = ACCEL_OPC_DIF_VERIFY_COPY;
 
 	TAILQ_INSERT_TAIL(&seq->tasks, task, seq_link);
 	*pseq = seq;
@@ -1561,6 +2147,10 @@ accel_process_sequence(struct spdk_accel_sequence *seq)
 			module = g_modules_opc[task->op_code].module;
 			module_ch = accel_ch->module_ch[task->op_code];
 
+			if (spdk_unlikely(accel_ch->histogram_enabled)) {
+				task->submit_tsc = spdk_get_ticks();
+			}
+
 			accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_AWAIT_TASK);
 			rc = module->submit_tasks(module_ch, task);
 			if (spdk_unlikely(rc != 0)) {
@@ -1715,6 +2305,48 @@ accel_compare_iovs(struct iovec *iova, uint32_t iovacnt, struct iovec *iovb, uin
 	return memcmp(iova, iovb, sizeof(*iova) * iovacnt) == 0;
 }
 
+static void
+accel_sequence_fuse_crc32c(struct spdk_accel_sequence *seq, struct spdk_accel_task *task,
+			   struct spdk_accel_task **next_task)
+{
+	struct spdk_accel_task *next = *next_task;
+
+	assert(task->op_code == ACCEL_OPC_COPY);
+	assert(next->op_code == ACCEL_OPC_CRC32C);
+
+	/* After the copy, the source and the destination hold the same data, so the CRC can be
+	 * calculated over either of them */
+	if ((next->src_domain != task->dst_domain ||
+	     !accel_compare_iovs(task->d.iovs, task->d.iovcnt, next->s.iovs, next->s.iovcnt)) &&
+	    (next->src_domain != task->src_domain ||
+	     !accel_compare_iovs(task->s.iovs, task->s.iovcnt, next->s.iovs, next->s.iovcnt))) {
+		return;
+	}
+
+	task->crc_dst = next->crc_dst;
+	task->seed = next->seed;
+	task->op_code = ACCEL_OPC_COPY_CRC32C;
+	*next_task = TAILQ_NEXT(next, seq_link);
+	TAILQ_REMOVE(&seq->tasks, next, seq_link);
+	TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
+}
+
+/* spdk_dif_generate_copy() and spdk_dif_verify_copy() need each element of the extended LBA
+ * payload to hold a whole number of blocks */
+static bool
+accel_dif_iovs_block_aligned(struct spdk_accel_task *task, struct iovec *iovs, uint32_t iovcnt)
+{
+	uint32_t i;
+
+	for (i = 0; i < iovcnt; ++i) {
+		if (iovs[i].iov_len % task->dif.ctx->block_size != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void
 accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_task *task,
 			   struct spdk_accel_task **next_task)
@@ -1723,6 +2355,12 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 
 	switch (task->op_code) {
 	case ACCEL_OPC_COPY:
+		/* CRC-32C doesn't modify the data, so the copy still needs to be done, but both of
+		 * them can be executed in a single pass over the buffers */
+		if (next->op_code == ACCEL_OPC_CRC32C) {
+			accel_sequence_fuse_crc32c(seq, task, next_task);
+			break;
+		}
 		/* We only allow changing src of operations that actually have a src, e.g. we never
 		 * do it for fill.  Theoretically, it is possible, but we'd have to be careful to
 		 * change the src of the operation after fill (which in turn could also be a fill).
@@ -1731,7 +2369,10 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		if (next->op_code != ACCEL_OPC_DECOMPRESS &&
 		    next->op_code != ACCEL_OPC_COPY &&
 		    next->op_code != ACCEL_OPC_ENCRYPT &&
-		    next->op_code != ACCEL_OPC_DECRYPT) {
+		    next->op_code != ACCEL_OPC_DECRYPT &&
+		    next->op_code != ACCEL_OPC_DIF_GENERATE_COPY &&
+		    next->op_code != ACCEL_OPC_DIF_VERIFY_COPY &&
+		    next->op_code != ACCEL_OPC_COPY_CRC32C) {
 			break;
 		}
 		if (task->dst_domain != next->src_domain) {
@@ -1741,6 +2382,10 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 					next->s.iovs, next->s.iovcnt)) {
 			break;
 		}
+		if (next->op_code == ACCEL_OPC_DIF_VERIFY_COPY &&
+		    !accel_dif_iovs_block_aligned(next, task->s.iovs, task->s.iovcnt)) {
+			break;
+		}
 		next->s.iovs = task->s.iovs;
 		next->s.iovcnt = task->s.iovcnt;
 		next->src_domain = task->src_domain;
@@ -1751,6 +2396,9 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 	case ACCEL_OPC_FILL:
 	case ACCEL_OPC_ENCRYPT:
 	case ACCEL_OPC_DECRYPT:
+	case ACCEL_OPC_DIF_GENERATE_COPY:
+	case ACCEL_OPC_DIF_VERIFY_COPY:
+	case ACCEL_OPC_COPY_CRC32C:
 		/* We can only merge tasks when one of them is a copy */
 		if (next->op_code != ACCEL_OPC_COPY) {
 			break;
@@ -1762,6 +2410,10 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 					next->s.iovs, next->s.iovcnt)) {
 			break;
 		}
+		if (task->op_code == ACCEL_OPC_DIF_GENERATE_COPY &&
+		    !accel_dif_iovs_block_aligned(task, next->d.iovs, next->d.iovcnt)) {
+			break;
+		}
 		task->d.iovs = next->d.iovs;
 		task->d.iovcnt = next->d.iovcnt;
 		task->dst_domain = next->dst_domain;
@@ -1771,6 +2423,34 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		TAILQ_REMOVE(&seq->tasks, next, seq_link);
 		TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
 		break;
+	case ACCEL_OPC_CRC32C:
+		/* Calculate the CRC-32C while copying the data */
+		if (next->op_code != ACCEL_OPC_COPY) {
+			break;
+		}
+		if (task->src_domain != next->src_domain) {
+			break;
+		}
+		if (!accel_compare_iovs(task->s.iovs, task->s.iovcnt,
+					next->s.iovs, next->s.iovcnt)) {
+			break;
+		}
+		task->d.iovs = next->d.iovs;
+		task->d.iovcnt = next->d.iovcnt;
+		task->dst_domain = next->dst_domain;
+		task->dst_domain_ctx = next->dst_domain_ctx;
+		task->flags = next->flags;
+		task->op_code = ACCEL_OPC_COPY_CRC32C;
+		*next_task = TAILQ_NEXT(next, seq_link);
+		TAILQ_REMOVE(&seq->tasks, next, seq_link);
+		TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
+		break;
+	case ACCEL_OPC_DIF_VERIFY:
+	case ACCEL_OPC_DIF_GENERATE:
+	case ACCEL_OPC_DIX_VERIFY:
+	case ACCEL_OPC_DIX_GENERATE:
+		/* These operate in place, there is no buffer that a copy could be folded into */
+		break;
 	default:
 		assert(0 && "bad opcode");
 		break;
@@ -2088,6 +2768,85 @@ spdk_accel_module_list_add(struct spdk_accel_module_if *accel_module)
 	}
 }
 
+/* Histograms of the channels that have already been destroyed */
+static void
+accel_global_histogram_free(void)
+{
+	struct spdk_histogram_data *histograms[ACCEL_OPC_LAST];
+	int i;
+
+	spdk_spin_lock(&g_stats_lock);
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		histograms[i] = g_stats[i].histogram;
+		g_stats[i].histogram = NULL;
+	}
+	spdk_spin_unlock(&g_stats_lock);
+
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		spdk_histogram_data_free(histograms[i]);
+	}
+}
+
+static int
+accel_global_histogram_alloc(void)
+{
+	struct spdk_histogram_data *histograms[ACCEL_OPC_LAST] = {};
+	int i;
+
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		histograms[i] = spdk_histogram_data_alloc();
+		if (histograms[i] == NULL) {
+			while (i-- > 0) {
+				spdk_histogram_data_free(histograms[i]);
+			}
+			return -ENOMEM;
+		}
+	}
+
+	spdk_spin_lock(&g_stats_lock);
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		assert(g_stats[i].histogram == NULL);
+		g_stats[i].histogram = histograms[i];
+	}
+	spdk_spin_unlock(&g_stats_lock);
+
+	return 0;
+}
+
+static void
+accel_channel_histogram_free(struct accel_io_channel *accel_ch)
+{
+	int i;
+
+	accel_ch->histogram_enabled = false;
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		if (accel_ch->stats[i].histogram != NULL) {
+			spdk_histogram_data_free(accel_ch->stats[i].histogram);
+			accel_ch->stats[i].histogram = NULL;
+		}
+	}
+}
+
+static int
+accel_channel_histogram_alloc(struct accel_io_channel *accel_ch)
+{
+	int i;
+
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		if (accel_ch->stats[i].histogram == NULL) {
+			accel_ch->stats[i].histogram = spdk_histogram_data_alloc();
+			if (accel_ch->stats[i].histogram == NULL) {
+				accel_channel_histogram_free(accel_ch);
+				return -ENOMEM;
+			}
+		}
+	}
+
+	accel_ch->histogram_enabled = true;
+
+	return 0;
+}
+
 /* Framework level channel create callback. */
 static int
 accel_create_channel(void *io_device, void *ctx_buf)
@@ -2144,6 +2903,15 @@ accel_create_channel(void *io_device, void *ctx_buf)
 		goto err;
 	}
 
+	if (g_histogram_enabled) {
+		rc = accel_channel_histogram_alloc(accel_ch);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to allocate accel histograms\n");
+			spdk_iobuf_channel_fini(&accel_ch->iobuf);
+			goto err;
+		}
+	}
+
 	return 0;
 err:
 	for (j = 0; j < i; j++) {
@@ -2164,6 +2932,20 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 
 	spdk_iobuf_channel_fini(&accel_ch->iobuf);
 
+	/* Keep this channel's latencies around, so that they're still reported after it's gone */
+	spdk_spin_lock(&g_stats_lock);
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		g_stats[i].executed += accel_ch->stats[i].executed;
+		g_stats[i].failed += accel_ch->stats[i].failed;
+		g_stats[i].num_bytes += accel_ch->stats[i].num_bytes;
+		if (g_stats[i].histogram != NULL && accel_ch->stats[i].histogram != NULL) {
+			spdk_histogram_data_merge(g_stats[i].histogram, accel_ch->stats[i].histogram);
+		}
+	}
+	spdk_spin_unlock(&g_stats_lock);
+
+	accel_channel_histogram_free(accel_ch);
+
 	for (i = 0; i < ACCEL_OPC_LAST; i++) {
 		assert(accel_ch->module_ch[i] != NULL);
 		spdk_put_io_channel(accel_ch->module_ch[i]);
@@ -2175,6 +2957,189 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 	free(accel_ch->buf_pool_base);
 }
 
+struct accel_histogram_ctx {
+	spdk_accel_histogram_status_cb	cb_fn;
+	void				*cb_arg;
+	int				status;
+};
+
+static void
+accel_histogram_disable_channel_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct accel_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	g_histogram_in_progress = false;
+	ctx->cb_fn(ctx->cb_arg, ctx->status);
+	free(ctx);
+}
+
+static void
+accel_histogram_disable_channel(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+
+	accel_channel_histogram_free(spdk_io_channel_get_ctx(ch));
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+accel_histogram_enable_channel_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct accel_histogram_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	if (status != 0) {
+		ctx->status = status;
+		g_histogram_enabled = false;
+		accel_global_histogram_free();
+		spdk_for_each_channel(&spdk_accel_module_list, accel_histogram_disable_channel, ctx,
+				      accel_histogram_disable_channel_done);
+		return;
+	}
+
+	g_histogram_in_progress = false;
+	ctx->cb_fn(ctx->cb_arg, ctx->status);
+	free(ctx);
+}
+
+static void
+accel_histogram_enable_channel(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+
+	spdk_for_each_channel_continue(i, accel_channel_histogram_alloc(spdk_io_channel_get_ctx(ch)));
+}
+
+void
+spdk_accel_enable_histogram(bool enable, spdk_accel_histogram_status_cb cb_fn, void *cb_arg)
+{
+	struct accel_histogram_ctx *ctx;
+
+	if (g_histogram_in_progress) {
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	if (enable && !g_histogram_enabled) {
+		if (accel_global_histogram_alloc() != 0) {
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+	} else if (!enable) {
+		accel_global_histogram_free();
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	g_histogram_in_progress = true;
+	g_histogram_enabled = enable;
+
+	if (enable) {
+		spdk_for_each_channel(&spdk_accel_module_list, accel_histogram_enable_channel, ctx,
+				      accel_histogram_enable_channel_done);
+	} else {
+		spdk_for_each_channel(&spdk_accel_module_list, accel_histogram_disable_channel, ctx,
+				      accel_histogram_disable_channel_done);
+	}
+}
+
+struct accel_get_stats_ctx {
+	struct spdk_accel_opcode_stats	stats[ACCEL_OPC_LAST];
+	spdk_accel_get_stats_cb		cb_fn;
+	void				*cb_arg;
+};
+
+static void
+accel_get_stats_ctx_free(struct accel_get_stats_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		spdk_histogram_data_free(ctx->stats[i].histogram);
+	}
+
+	free(ctx);
+}
+
+static void
+accel_get_channel_stats(struct spdk_io_channel_iter *i)
+{
+	struct accel_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_opcode_stats *stats, *ch_stats;
+	int opc;
+
+	for (opc = 0; opc < ACCEL_OPC_LAST; opc++) {
+		stats = &ctx->stats[opc];
+		ch_stats = &accel_ch->stats[opc];
+
+		stats->executed += ch_stats->executed;
+		stats->failed += ch_stats->failed;
+		stats->num_bytes += ch_stats->num_bytes;
+		if (stats->histogram != NULL && ch_stats->histogram != NULL) {
+			spdk_histogram_data_merge(stats->histogram, ch_stats->histogram);
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+accel_get_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct accel_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->stats, ctx->cb_arg, status);
+	accel_get_stats_ctx_free(ctx);
+}
+
+int
+spdk_accel_get_stats(spdk_accel_get_stats_cb cb_fn, void *cb_arg)
+{
+	struct accel_get_stats_ctx *ctx;
+	int i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	if (g_histogram_enabled) {
+		for (i = 0; i < ACCEL_OPC_LAST; i++) {
+			ctx->stats[i].histogram = spdk_histogram_data_alloc();
+			if (ctx->stats[i].histogram == NULL) {
+				accel_get_stats_ctx_free(ctx);
+				return -ENOMEM;
+			}
+		}
+	}
+
+	spdk_spin_lock(&g_stats_lock);
+	for (i = 0; i < ACCEL_OPC_LAST; i++) {
+		ctx->stats[i].executed = g_stats[i].executed;
+		ctx->stats[i].failed = g_stats[i].failed;
+		ctx->stats[i].num_bytes = g_stats[i].num_bytes;
+		if (ctx->stats[i].histogram != NULL && g_stats[i].histogram != NULL) {
+			spdk_histogram_data_merge(ctx->stats[i].histogram, g_stats[i].histogram);
+		}
+	}
+	spdk_spin_unlock(&g_stats_lock);
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	spdk_for_each_channel(&spdk_accel_module_list, accel_get_channel_stats, ctx,
+			      accel_get_stats_done);
+
+	return 0;
+}
+
 struct spdk_io_channel *
 spdk_accel_get_io_channel(void)
 {
@@ -2217,6 +3182,7 @@ spdk_accel_initialize(void)
 	}
 
 	spdk_spin_init(&g_keyring_spin);
+	spdk_spin_init(&g_stats_lock);
 
 	g_modules_started = true;
 	accel_module_initialize();
@@ -2400,7 +3366,9 @@ spdk_accel_module_finish(void)
 	}
 
 	if (!g_accel_module) {
+		accel_global_histogram_free();
 		spdk_spin_destroy(&g_keyring_spin);
+		spdk_spin_destroy(&g_stats_lock);
 		accel_module_finish_cb();
 		return;
 	}
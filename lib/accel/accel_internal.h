@@ -26,4 +26,16 @@ int _accel_get_opc_name(enum accel_opcode opcode, const char **opcode_name);
 void _accel_crypto_key_dump_param(struct spdk_json_write_ctx *w, struct spdk_accel_crypto_key *key);
 void _accel_crypto_keys_dump_param(struct spdk_json_write_ctx *w);
 
+struct accel_sw_opts {
+	/* Number of threads executing CPU heavy operations, 0 executes them in place */
+	uint32_t	num_workers;
+	/* Operations smaller than this are always executed in place */
+	uint32_t	offload_min_size;
+	/* Cores the worker threads can be scheduled on */
+	char		*cpumask;
+};
+
+void accel_sw_get_opts(struct accel_sw_opts *opts);
+int accel_sw_set_opts(const struct accel_sw_opts *opts);
+
 #endif
@@ -12,6 +12,8 @@
 #include "spdk/event.h"
 #include "spdk/stdinc.h"
 #include "spdk/string.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
 #include "spdk/env.h"
 #include "spdk/util.h"
 
@@ -354,3 +356,197 @@ cleanup:
 	free_rpc_accel_set_driver(&req);
 }
 SPDK_RPC_REGISTER("accel_set_driver", rpc_accel_set_driver, SPDK_RPC_STARTUP)
+
+static const struct spdk_json_object_decoder rpc_accel_sw_set_options_decoders[] = {
+	{"num_workers", offsetof(struct accel_sw_opts, num_workers), spdk_json_decode_uint32, true},
+	{"offload_min_size", offsetof(struct accel_sw_opts, offload_min_size), spdk_json_decode_uint32, true},
+	{"cpumask", offsetof(struct accel_sw_opts, cpumask), spdk_json_decode_string, true},
+};
+
+static void
+rpc_accel_sw_set_options(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct accel_sw_opts opts;
+	char *cpumask, *current;
+	int rc;
+
+	accel_sw_get_opts(&opts);
+	/* The decoder frees the previous string, so don't let it touch the current one */
+	current = opts.cpumask;
+	opts.cpumask = NULL;
+
+	if (spdk_json_decode_object(params, rpc_accel_sw_set_options_decoders,
+				    SPDK_COUNTOF(rpc_accel_sw_set_options_decoders), &opts)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		free(opts.cpumask);
+		return;
+	}
+
+	cpumask = opts.cpumask;
+	if (opts.cpumask == NULL) {
+		opts.cpumask = current;
+	}
+
+	rc = accel_sw_set_opts(&opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	} else {
+		spdk_jsonrpc_send_bool_response(request, true);
+	}
+
+	free(cpumask);
+}
+SPDK_RPC_REGISTER("accel_sw_set_options", rpc_accel_sw_set_options, SPDK_RPC_STARTUP)
+
+struct rpc_accel_enable_histogram {
+	bool enable;
+};
+
+static const struct spdk_json_object_decoder rpc_accel_enable_histogram_decoders[] = {
+	{"enable", offsetof(struct rpc_accel_enable_histogram, enable), spdk_json_decode_bool},
+};
+
+static void
+rpc_accel_histogram_status_cb(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, status, spdk_strerror(-status));
+	}
+}
+
+static void
+rpc_accel_enable_histogram(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_accel_enable_histogram req = {};
+
+	if (spdk_json_decode_object(params, rpc_accel_enable_histogram_decoders,
+				    SPDK_COUNTOF(rpc_accel_enable_histogram_decoders), &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	spdk_accel_enable_histogram(req.enable, rpc_accel_histogram_status_cb, request);
+}
+SPDK_RPC_REGISTER("accel_enable_histogram", rpc_accel_enable_histogram, SPDK_RPC_RUNTIME)
+
+static int
+rpc_accel_write_histogram(struct spdk_json_write_ctx *w, struct spdk_histogram_data *histogram)
+{
+	char *encoded;
+	size_t src_len, dst_len;
+	int rc;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded = malloc(dst_len);
+	if (encoded == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = spdk_base64_encode(encoded, histogram->bucket, src_len);
+	if (rc == 0) {
+		spdk_json_write_named_string(w, "histogram", encoded);
+		spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+	}
+
+	free(encoded);
+
+	return rc;
+}
+
+static void
+rpc_accel_get_stats_done(struct spdk_accel_opcode_stats *stats, void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct spdk_json_write_ctx *w;
+	struct {
+		const char	*name;
+		uint64_t	executed;
+		uint64_t	failed;
+		uint64_t	num_bytes;
+	} modules[ACCEL_OPC_LAST] = {};
+	const char *opcode_name, *module_name;
+	int opc, i, num_modules = 0;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(request, status, spdk_strerror(-status));
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tsc_rate", spdk_get_ticks_hz());
+
+	spdk_json_write_named_array_begin(w, "operations");
+	for (opc = 0; opc < ACCEL_OPC_LAST; opc++) {
+		if (_accel_get_opc_name(opc, &opcode_name) != 0 ||
+		    spdk_accel_get_opc_module_name(opc, &module_name) != 0) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "opcode", opcode_name);
+		spdk_json_write_named_string(w, "module_name", module_name);
+		spdk_json_write_named_uint64(w, "executed", stats[opc].executed);
+		spdk_json_write_named_uint64(w, "failed", stats[opc].failed);
+		spdk_json_write_named_uint64(w, "num_bytes", stats[opc].num_bytes);
+		if (stats[opc].histogram != NULL && stats[opc].executed > 0) {
+			rpc_accel_write_histogram(w, stats[opc].histogram);
+		}
+		spdk_json_write_object_end(w);
+
+		for (i = 0; i < num_modules; i++) {
+			if (strcmp(modules[i].name, module_name) == 0) {
+				break;
+			}
+		}
+		if (i == num_modules) {
+			modules[num_modules++].name = module_name;
+		}
+		modules[i].executed += stats[opc].executed;
+		modules[i].failed += stats[opc].failed;
+		modules[i].num_bytes += stats[opc].num_bytes;
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_named_array_begin(w, "modules");
+	for (i = 0; i < num_modules; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "module_name", modules[i].name);
+		spdk_json_write_named_uint64(w, "executed", modules[i].executed);
+		spdk_json_write_named_uint64(w, "failed", modules[i].failed);
+		spdk_json_write_named_uint64(w, "num_bytes", modules[i].num_bytes);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_accel_get_stats(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
+{
+	int rc;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "accel_get_stats requires no parameters");
+		return;
+	}
+
+	rc = spdk_accel_get_stats(rpc_accel_get_stats_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("accel_get_stats", rpc_accel_get_stats, SPDK_RPC_RUNTIME)
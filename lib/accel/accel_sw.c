@@ -17,6 +17,8 @@
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
+#include "spdk/dif.h"
+#include "spdk/string.h"
 
 #ifdef SPDK_CONFIG_ISAL
 #include "../isa-l/include/igzip_lib.h"
@@ -31,6 +33,12 @@
 /* Per the AES-XTS spec, the size of data unit cannot be bigger than 2^20 blocks, 128b each block */
 #define ACCEL_AES_XTS_MAX_BLOCK_SIZE (1 << 24)
 
+/* Offload tasks of at least this size to the worker threads by default */
+#define ACCEL_SW_OFFLOAD_MIN_SIZE_DEFAULT	(16 * 1024)
+/* Maximum number of tasks a channel can have outstanding on the worker threads */
+#define ACCEL_SW_WORKER_RING_SIZE		1024
+#define ACCEL_SW_WORKER_COMPLETION_BATCH	32
+
 struct sw_accel_io_channel {
 	/* for ISAL */
 #ifdef SPDK_CONFIG_ISAL
@@ -39,6 +47,23 @@ struct sw_accel_io_channel {
 #endif
 	struct spdk_poller		*completion_poller;
 	TAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
+	/* Tasks executed by the worker threads, drained by the completion poller */
+	struct spdk_ring		*worker_completions;
+	/* Number of tasks handed to the worker threads and not yet taken off the ring */
+	uint32_t			num_offloaded;
+	uint32_t			next_worker;
+};
+
+struct sw_accel_worker {
+	struct spdk_thread		*thread;
+	struct spdk_io_channel		*ch;
+};
+
+struct sw_accel_task {
+	struct spdk_accel_task		task;
+	/* Channel the task was submitted on, it's completed on that channel's thread */
+	struct spdk_io_channel		*ch;
+	struct sw_accel_worker		*worker;
 };
 
 typedef void (*sw_accel_crypto_op)(uint8_t *k2, uint8_t *k1, uint8_t *tweak, uint64_t lba_size,
@@ -51,6 +76,19 @@ struct sw_accel_crypto_key_data {
 
 static struct spdk_accel_module_if g_sw_module;
 
+static struct accel_sw_opts g_sw_opts = {
+	.num_workers = 0,
+	.offload_min_size = ACCEL_SW_OFFLOAD_MIN_SIZE_DEFAULT,
+	.cpumask = NULL,
+};
+
+static struct sw_accel_worker *g_sw_workers;
+/* Number of workers that tasks can be offloaded to */
+static uint32_t g_sw_num_workers;
+/* Number of worker threads that haven't exited yet */
+static uint32_t g_sw_num_running_workers;
+static struct spdk_thread *g_sw_fini_thread;
+
 static void sw_accel_crypto_key_deinit(struct spdk_accel_crypto_key *_key);
 static int sw_accel_crypto_key_init(struct spdk_accel_crypto_key *key);
 
@@ -78,6 +116,12 @@ sw_accel_supports_opcode(enum accel_opcode opc)
 	case ACCEL_OPC_ENCRYPT:
 	case ACCEL_OPC_DECRYPT:
 	case ACCEL_OPC_XOR:
+	case ACCEL_OPC_DIF_VERIFY:
+	case ACCEL_OPC_DIF_GENERATE:
+	case ACCEL_OPC_DIF_GENERATE_COPY:
+	case ACCEL_OPC_DIF_VERIFY_COPY:
+	case ACCEL_OPC_DIX_VERIFY:
+	case ACCEL_OPC_DIX_GENERATE:
 		return true;
 	default:
 		return false;
@@ -159,6 +203,34 @@ _sw_accel_crc32cv(uint32_t *crc_dst, struct iovec *iov, uint32_t iovcnt, uint32_
 	*crc_dst = spdk_crc32c_iov_update(iov, iovcnt, ~seed);
 }
 
+/* Size of the chunks in which data is copied and checksummed, small enough to stay in L1 */
+#define SW_ACCEL_COPY_CRC32C_CHUNK	4096
+
+static void
+_sw_accel_copy_crc32cv(uint32_t *crc_dst, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		       struct iovec *src_iovs, uint32_t src_iovcnt, uint32_t seed)
+{
+	struct spdk_ioviter iter;
+	void *src, *dst;
+	size_t len, chunk, off;
+	uint32_t crc = ~seed;
+
+	/* Calculate the CRC of each chunk right after it was copied, while it's still in the
+	 * cache, instead of going over the whole source buffer twice */
+	for (len = spdk_ioviter_first(&iter, src_iovs, src_iovcnt,
+				      dst_iovs, dst_iovcnt, &src, &dst);
+	     len != 0;
+	     len = spdk_ioviter_next(&iter, &src, &dst)) {
+		for (off = 0; off < len; off += chunk) {
+			chunk = spdk_min(len - off, SW_ACCEL_COPY_CRC32C_CHUNK);
+			memcpy((char *)dst + off, (char *)src + off, chunk);
+			crc = spdk_crc32c_update((char *)src + off, chunk, crc);
+		}
+	}
+
+	*crc_dst = crc;
+}
+
 static int
 _sw_accel_compress(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
 {
@@ -442,64 +514,242 @@ _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_t
 			    accel_task->d.iovs[0].iov_len);
 }
 
+/*
+ * The guard CRCs are computed by lib/util, which uses the folded (PCLMULQDQ) CRC16-T10DIF
+ * routines of ISA-L when SPDK is built with it.
+ */
+static int
+_sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_verify(accel_task->s.iovs,
+			       accel_task->s.iovcnt,
+			       accel_task->dif.num_blocks,
+			       accel_task->dif.ctx,
+			       accel_task->dif.err);
+}
+
+static int
+_sw_accel_dif_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_generate(accel_task->s.iovs,
+				 accel_task->s.iovcnt,
+				 accel_task->dif.num_blocks,
+				 accel_task->dif.ctx);
+}
+
+static int
+_sw_accel_dif_generate_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_generate_copy(accel_task->s.iovs,
+				      accel_task->s.iovcnt,
+				      accel_task->d.iovs,
+				      accel_task->d.iovcnt,
+				      accel_task->dif.num_blocks,
+				      accel_task->dif.ctx);
+}
+
+static int
+_sw_accel_dif_verify_copy(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_verify_copy(accel_task->d.iovs,
+				    accel_task->d.iovcnt,
+				    accel_task->s.iovs,
+				    accel_task->s.iovcnt,
+				    accel_task->dif.num_blocks,
+				    accel_task->dif.ctx,
+				    accel_task->dif.err);
+}
+
+static int
+_sw_accel_dix_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dix_verify(accel_task->s.iovs,
+			       accel_task->s.iovcnt,
+			       accel_task->dif.md_iov,
+			       accel_task->dif.num_blocks,
+			       accel_task->dif.ctx,
+			       accel_task->dif.err);
+}
+
+static int
+_sw_accel_dix_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dix_generate(accel_task->s.iovs,
+				 accel_task->s.iovcnt,
+				 accel_task->dif.md_iov,
+				 accel_task->dif.num_blocks,
+				 accel_task->dif.ctx);
+}
+
+static int
+_sw_accel_execute(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	int rc = 0;
+
+	switch (accel_task->op_code) {
+	case ACCEL_OPC_COPY:
+		_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
+				    accel_task->s.iovs, accel_task->s.iovcnt);
+		break;
+	case ACCEL_OPC_FILL:
+		rc = _sw_accel_fill(accel_task->d.iovs, accel_task->d.iovcnt,
+				    accel_task->fill_pattern);
+		break;
+	case ACCEL_OPC_DUALCAST:
+		rc = _sw_accel_dualcast_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
+					     accel_task->d2.iovs, accel_task->d2.iovcnt,
+					     accel_task->s.iovs, accel_task->s.iovcnt);
+		break;
+	case ACCEL_OPC_COMPARE:
+		rc = _sw_accel_compare(accel_task->s.iovs, accel_task->s.iovcnt,
+				       accel_task->s2.iovs, accel_task->s2.iovcnt);
+		break;
+	case ACCEL_OPC_CRC32C:
+		_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
+		break;
+	case ACCEL_OPC_COPY_CRC32C:
+		_sw_accel_copy_crc32cv(accel_task->crc_dst, accel_task->d.iovs, accel_task->d.iovcnt,
+				       accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
+		break;
+	case ACCEL_OPC_COMPRESS:
+		rc = _sw_accel_compress(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DECOMPRESS:
+		rc = _sw_accel_decompress(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_XOR:
+		rc = _sw_accel_xor(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_ENCRYPT:
+		rc = _sw_accel_encrypt(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DECRYPT:
+		rc = _sw_accel_decrypt(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIF_VERIFY:
+		rc = _sw_accel_dif_verify(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIF_GENERATE:
+		rc = _sw_accel_dif_generate(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIF_GENERATE_COPY:
+		rc = _sw_accel_dif_generate_copy(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIF_VERIFY_COPY:
+		rc = _sw_accel_dif_verify_copy(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIX_VERIFY:
+		rc = _sw_accel_dix_verify(sw_ch, accel_task);
+		break;
+	case ACCEL_OPC_DIX_GENERATE:
+		rc = _sw_accel_dix_generate(sw_ch, accel_task);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	return rc;
+}
+
+static uint64_t
+_sw_accel_task_size(struct spdk_accel_task *accel_task)
+{
+	uint64_t size = 0;
+	uint32_t i;
+
+	if (accel_task->op_code == ACCEL_OPC_XOR) {
+		return accel_task->d.iovs[0].iov_len;
+	}
+
+	for (i = 0; i < accel_task->s.iovcnt; i++) {
+		size += accel_task->s.iovs[i].iov_len;
+	}
+
+	return size;
+}
+
+static void
+_sw_accel_worker_execute(void *ctx)
+{
+	struct sw_accel_task *sw_task = ctx;
+	struct sw_accel_worker *worker = sw_task->worker;
+	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(sw_task->ch);
+	size_t count __attribute__((unused));
+
+	if (spdk_likely(worker->ch != NULL)) {
+		sw_task->task.status = _sw_accel_execute(spdk_io_channel_get_ctx(worker->ch),
+				       &sw_task->task);
+	} else {
+		sw_task->task.status = -ENOMEM;
+	}
+
+	/* The submitter never has more tasks offloaded than the ring can hold, so this can't
+	 * fail, unlike sending a message, which needs a free entry in the global msg mempool. */
+	count = spdk_ring_enqueue(sw_ch->worker_completions, (void **)&sw_task, 1, NULL);
+	assert(count == 1);
+}
+
+/* Hand CPU heavy operations over to one of the worker threads, so that they don't stall the
+ * submitting thread.  Returns false if the task should be executed in place. */
+static bool
+_sw_accel_offload(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task)
+{
+	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(ch);
+	struct sw_accel_task *sw_task = SPDK_CONTAINEROF(accel_task, struct sw_accel_task, task);
+	int rc;
+
+	if (spdk_likely(g_sw_num_workers == 0 || sw_ch->worker_completions == NULL)) {
+		return false;
+	}
+
+	switch (accel_task->op_code) {
+	case ACCEL_OPC_COMPRESS:
+	case ACCEL_OPC_DECOMPRESS:
+	case ACCEL_OPC_ENCRYPT:
+	case ACCEL_OPC_DECRYPT:
+	case ACCEL_OPC_XOR:
+		break;
+	default:
+		return false;
+	}
+
+	if (_sw_accel_task_size(accel_task) < g_sw_opts.offload_min_size) {
+		return false;
+	}
+
+	/* Execute in place rather than overflow the completion ring */
+	if (spdk_unlikely(sw_ch->num_offloaded >= ACCEL_SW_WORKER_RING_SIZE)) {
+		return false;
+	}
+
+	sw_task->ch = ch;
+	sw_task->worker = &g_sw_workers[sw_ch->next_worker++ % g_sw_num_workers];
+
+	rc = spdk_thread_send_msg(sw_task->worker->thread, _sw_accel_worker_execute, sw_task);
+	if (spdk_unlikely(rc != 0)) {
+		return false;
+	}
+
+	sw_ch->num_offloaded++;
+
+	return true;
+}
+
 static int
 sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task)
 {
 	struct sw_accel_io_channel *sw_ch = spdk_io_channel_get_ctx(ch);
 	struct spdk_accel_task *tmp;
-	int rc = 0;
+	int rc;
 
 	do {
-		switch (accel_task->op_code) {
-		case ACCEL_OPC_COPY:
-			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->s.iovs, accel_task->s.iovcnt);
-			break;
-		case ACCEL_OPC_FILL:
-			rc = _sw_accel_fill(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->fill_pattern);
-			break;
-		case ACCEL_OPC_DUALCAST:
-			rc = _sw_accel_dualcast_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-						     accel_task->d2.iovs, accel_task->d2.iovcnt,
-						     accel_task->s.iovs, accel_task->s.iovcnt);
-			break;
-		case ACCEL_OPC_COMPARE:
-			rc = _sw_accel_compare(accel_task->s.iovs, accel_task->s.iovcnt,
-					       accel_task->s2.iovs, accel_task->s2.iovcnt);
-			break;
-		case ACCEL_OPC_CRC32C:
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs, accel_task->s.iovcnt, accel_task->seed);
-			break;
-		case ACCEL_OPC_COPY_CRC32C:
-			_sw_accel_copy_iovs(accel_task->d.iovs, accel_task->d.iovcnt,
-					    accel_task->s.iovs, accel_task->s.iovcnt);
-			_sw_accel_crc32cv(accel_task->crc_dst, accel_task->s.iovs,
-					  accel_task->s.iovcnt, accel_task->seed);
-			break;
-		case ACCEL_OPC_COMPRESS:
-			rc = _sw_accel_compress(sw_ch, accel_task);
-			break;
-		case ACCEL_OPC_DECOMPRESS:
-			rc = _sw_accel_decompress(sw_ch, accel_task);
-			break;
-		case ACCEL_OPC_XOR:
-			rc = _sw_accel_xor(sw_ch, accel_task);
-			break;
-		case ACCEL_OPC_ENCRYPT:
-			rc = _sw_accel_encrypt(sw_ch, accel_task);
-			break;
-		case ACCEL_OPC_DECRYPT:
-			rc = _sw_accel_decrypt(sw_ch, accel_task);
-			break;
-		default:
-			assert(false);
-			break;
-		}
-
 		tmp = TAILQ_NEXT(accel_task, link);
 
-		_add_to_comp_list(sw_ch, accel_task, rc);
+		if (!_sw_accel_offload(ch, accel_task)) {
+			rc = _sw_accel_execute(sw_ch, accel_task);
+			_add_to_comp_list(sw_ch, accel_task, rc);
+		}
 
 		accel_task = tmp;
 	} while (accel_task);
@@ -511,11 +761,12 @@ static struct spdk_io_channel *sw_accel_get_io_channel(void);
 static int sw_accel_module_init(void);
 static void sw_accel_module_fini(void *ctxt);
 static size_t sw_accel_module_get_ctx_size(void);
+static void sw_accel_write_config_json(struct spdk_json_write_ctx *w);
 
 static struct spdk_accel_module_if g_sw_module = {
 	.module_init		= sw_accel_module_init,
 	.module_fini		= sw_accel_module_fini,
-	.write_config_json	= NULL,
+	.write_config_json	= sw_accel_write_config_json,
 	.get_ctx_size		= sw_accel_module_get_ctx_size,
 	.name			= "software",
 	.supports_opcode	= sw_accel_supports_opcode,
@@ -531,6 +782,19 @@ accel_comp_poll(void *arg)
 	struct sw_accel_io_channel	*sw_ch = arg;
 	TAILQ_HEAD(, spdk_accel_task)	tasks_to_complete;
 	struct spdk_accel_task		*accel_task;
+	struct sw_accel_task		*sw_tasks[ACCEL_SW_WORKER_COMPLETION_BATCH];
+	size_t				i, count;
+
+	if (sw_ch->num_offloaded > 0) {
+		count = spdk_ring_dequeue(sw_ch->worker_completions, (void **)sw_tasks,
+					  SPDK_COUNTOF(sw_tasks));
+		assert(count <= sw_ch->num_offloaded);
+		sw_ch->num_offloaded -= count;
+		for (i = 0; i < count; i++) {
+			accel_task = &sw_tasks[i]->task;
+			TAILQ_INSERT_TAIL(&sw_ch->tasks_to_complete, accel_task, link);
+		}
+	}
 
 	if (TAILQ_EMPTY(&sw_ch->tasks_to_complete)) {
 		return SPDK_POLLER_IDLE;
@@ -553,6 +817,15 @@ sw_accel_create_cb(void *io_device, void *ctx_buf)
 	struct sw_accel_io_channel *sw_ch = ctx_buf;
 
 	TAILQ_INIT(&sw_ch->tasks_to_complete);
+	if (g_sw_num_workers > 0) {
+		sw_ch->worker_completions = spdk_ring_create(SPDK_RING_TYPE_MP_SC,
+					    ACCEL_SW_WORKER_RING_SIZE,
+					    SPDK_ENV_SOCKET_ID_ANY);
+		if (sw_ch->worker_completions == NULL) {
+			/* Not fatal, tasks will simply be executed on this thread */
+			SPDK_WARNLOG("Failed to allocate accel worker completion ring\n");
+		}
+	}
 	sw_ch->completion_poller = SPDK_POLLER_REGISTER(accel_comp_poll, sw_ch, 0);
 
 #ifdef SPDK_CONFIG_ISAL
@@ -562,6 +835,8 @@ sw_accel_create_cb(void *io_device, void *ctx_buf)
 	sw_ch->stream.level_buf = calloc(1, ISAL_DEF_LVL1_DEFAULT);
 	if (sw_ch->stream.level_buf == NULL) {
 		SPDK_ERRLOG("Could not allocate isal internal buffer\n");
+		spdk_poller_unregister(&sw_ch->completion_poller);
+		spdk_ring_free(sw_ch->worker_completions);
 		return -ENOMEM;
 	}
 	sw_ch->stream.level_buf_size = ISAL_DEF_LVL1_DEFAULT;
@@ -580,6 +855,8 @@ sw_accel_destroy_cb(void *io_device, void *ctx_buf)
 	free(sw_ch->stream.level_buf);
 #endif
 
+	assert(sw_ch->num_offloaded == 0);
+	spdk_ring_free(sw_ch->worker_completions);
 	spdk_poller_unregister(&sw_ch->completion_poller);
 }
 
@@ -592,26 +869,200 @@ sw_accel_get_io_channel(void)
 static size_t
 sw_accel_module_get_ctx_size(void)
 {
-	return sizeof(struct spdk_accel_task);
+	return sizeof(struct sw_accel_task);
+}
+
+void
+accel_sw_get_opts(struct accel_sw_opts *opts)
+{
+	*opts = g_sw_opts;
+}
+
+int
+accel_sw_set_opts(const struct accel_sw_opts *opts)
+{
+	struct spdk_cpuset cpumask;
+	char *mask = NULL;
+
+	if (opts->cpumask != NULL) {
+		if (spdk_cpuset_parse(&cpumask, opts->cpumask) != 0) {
+			SPDK_ERRLOG("Invalid cpumask: %s\n", opts->cpumask);
+			return -EINVAL;
+		}
+
+		mask = strdup(opts->cpumask);
+		if (mask == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	free(g_sw_opts.cpumask);
+	g_sw_opts = *opts;
+	g_sw_opts.cpumask = mask;
+
+	return 0;
+}
+
+static void
+sw_accel_write_config_json(struct spdk_json_write_ctx *w)
+{
+	if (g_sw_opts.num_workers == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "accel_sw_set_options");
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "num_workers", g_sw_opts.num_workers);
+	spdk_json_write_named_uint32(w, "offload_min_size", g_sw_opts.offload_min_size);
+	if (g_sw_opts.cpumask != NULL) {
+		spdk_json_write_named_string(w, "cpumask", g_sw_opts.cpumask);
+	}
+	spdk_json_write_object_end(w);
+	spdk_json_write_object_end(w);
+}
+
+static void
+sw_accel_worker_start(void *ctx)
+{
+	struct sw_accel_worker *worker = ctx;
+
+	/* Each worker has its own channel to keep the ISA-L compression state */
+	worker->ch = spdk_get_io_channel(&g_sw_module);
+	if (worker->ch == NULL) {
+		SPDK_ERRLOG("Failed to get an I/O channel for accel worker\n");
+	}
+}
+
+static int
+sw_accel_workers_init(void)
+{
+	struct spdk_cpuset cpumask, *mask = NULL;
+	struct sw_accel_worker *worker;
+	char name[32];
+	uint32_t i;
+	int rc;
+
+	if (g_sw_opts.cpumask != NULL) {
+		rc = spdk_cpuset_parse(&cpumask, g_sw_opts.cpumask);
+		if (rc != 0) {
+			return -EINVAL;
+		}
+		mask = &cpumask;
+	}
+
+	g_sw_workers = calloc(g_sw_opts.num_workers, sizeof(*g_sw_workers));
+	if (g_sw_workers == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < g_sw_opts.num_workers; i++) {
+		worker = &g_sw_workers[i];
+
+		snprintf(name, sizeof(name), "accel_sw_worker_%u", i);
+		worker->thread = spdk_thread_create(name, mask);
+		if (worker->thread == NULL) {
+			SPDK_ERRLOG("Failed to create accel worker thread\n");
+			break;
+		}
+
+		/* Messages are processed in order, so the channel will be there before any task */
+		rc = spdk_thread_send_msg(worker->thread, sw_accel_worker_start, worker);
+		assert(rc == 0);
+		g_sw_num_running_workers++;
+	}
+
+	g_sw_num_workers = g_sw_num_running_workers;
+	if (g_sw_num_workers == 0) {
+		free(g_sw_workers);
+		g_sw_workers = NULL;
+		return -ENOMEM;
+	}
+
+	SPDK_NOTICELOG("Offloading software accel operations to %u worker thread(s)\n",
+		       g_sw_num_workers);
+
+	return 0;
 }
 
 static int
 sw_accel_module_init(void)
 {
+	int rc;
+
 	SPDK_NOTICELOG("Accel framework software module initialized.\n");
 	spdk_io_device_register(&g_sw_module, sw_accel_create_cb, sw_accel_destroy_cb,
 				sizeof(struct sw_accel_io_channel), "sw_accel_module");
 
+	if (g_sw_opts.num_workers > 0) {
+		rc = sw_accel_workers_init();
+		if (rc != 0) {
+			/* The operations will still be executed, just on the submitting thread */
+			SPDK_ERRLOG("Failed to start accel worker threads: %s\n", spdk_strerror(-rc));
+		}
+	}
+
 	return 0;
 }
 
 static void
-sw_accel_module_fini(void *ctxt)
+sw_accel_module_fini_done(void)
 {
+	free(g_sw_workers);
+	g_sw_workers = NULL;
+	free(g_sw_opts.cpumask);
+	g_sw_opts.cpumask = NULL;
+
 	spdk_io_device_unregister(&g_sw_module, NULL);
 	spdk_accel_module_finish();
 }
 
+static void
+sw_accel_worker_stopped(void *ctx)
+{
+	assert(g_sw_num_running_workers > 0);
+	if (--g_sw_num_running_workers == 0) {
+		sw_accel_module_fini_done();
+	}
+}
+
+static void
+sw_accel_worker_stop(void *ctx)
+{
+	struct sw_accel_worker *worker = ctx;
+	int rc __attribute__((unused));
+
+	if (worker->ch != NULL) {
+		spdk_put_io_channel(worker->ch);
+	}
+
+	spdk_thread_exit(spdk_get_thread());
+
+	rc = spdk_thread_send_msg(g_sw_fini_thread, sw_accel_worker_stopped, NULL);
+	assert(rc == 0);
+}
+
+static void
+sw_accel_module_fini(void *ctxt)
+{
+	uint32_t i;
+	int rc __attribute__((unused));
+
+	/* All channels are gone by now, so there can't be any outstanding tasks */
+	g_sw_num_workers = 0;
+	if (g_sw_num_running_workers == 0) {
+		sw_accel_module_fini_done();
+		return;
+	}
+
+	g_sw_fini_thread = spdk_get_thread();
+	for (i = 0; i < g_sw_num_running_workers; i++) {
+		rc = spdk_thread_send_msg(g_sw_workers[i].thread, sw_accel_worker_stop,
+					  &g_sw_workers[i]);
+		assert(rc == 0);
+	}
+}
+
 static int
 sw_accel_create_aes_xts(struct spdk_accel_crypto_key *key)
 {
@@ -37,6 +37,8 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 
 #define SPDK_BDEV_IO_POOL_SIZE			(64 * 1024 - 1)
 #define SPDK_BDEV_IO_CACHE_SIZE			256
+#define SPDK_BDEV_IO_CACHE_GROW_FACTOR		4
+#define SPDK_BDEV_IO_CACHE_REBALANCE_PERIOD_US	(100 * 1000)
 #define SPDK_BDEV_AUTO_EXAMINE			true
 #define BUF_SMALL_POOL_SIZE			8191
 #define BUF_LARGE_POOL_SIZE			1023
@@ -44,6 +46,13 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 #define BUF_LARGE_CACHE_SIZE			16
 #define NOMEM_THRESHOLD_COUNT			8
 
+/* Per I/O type latency histograms: the first size class covers I/Os up to 4KiB
+ * and they use a coarser bucket shift than the per bdev histogram, as many of
+ * them may be allocated for each channel.
+ */
+#define SPDK_BDEV_HISTOGRAM_SIZE_CLASS_MIN_SHIFT	12
+#define SPDK_BDEV_IO_TYPE_HISTOGRAM_BUCKET_SHIFT	5
+
 #define SPDK_BDEV_QOS_TIMESLICE_IN_USEC		1000
 #define SPDK_BDEV_QOS_MIN_IO_PER_TIMESLICE	1
 #define SPDK_BDEV_QOS_MIN_BYTE_PER_TIMESLICE	512
@@ -202,6 +211,26 @@ struct spdk_bdev_qos {
 	struct spdk_poller *poller;
 };
 
+/*
+ * Per-channel state of the I/O merge stage.  Adjacent reads or writes are held
+ *  here until a non-adjacent I/O arrives, one of the limits is reached or the
+ *  merge window expires, and are then submitted as a single I/O.
+ */
+struct bdev_io_merge {
+	/* Queued I/Os, linked through internal.buf_link, in LBA order */
+	bdev_io_stailq_t	queued;
+	uint32_t		num_queued;
+	int			iovcnt;
+	uint64_t		num_blocks;
+
+	uint64_t		max_blocks;
+	uint32_t		max_ios;
+	int			max_iovcnt;
+
+	/* Flushes the queued I/Os once per merge window */
+	struct spdk_poller	*poller;
+};
+
 struct spdk_bdev_mgmt_channel {
 	/*
 	 * Each thread keeps a cache of bdev_io - this allows
@@ -214,6 +243,21 @@ struct spdk_bdev_mgmt_channel {
 	uint32_t	per_thread_cache_count;
 	uint32_t	bdev_io_cache_size;
 
+	/*
+	 * The cache size adapts to the demand seen on this thread.  Every miss
+	 *  (an allocation that had to go to the global mempool) grows the cache
+	 *  by one entry, up to max_cache_size.  The rebalance poller gives the
+	 *  bdev_ios that stayed idle for a whole period back to the mempool,
+	 *  where other threads can pick them up, and shrinks the cache towards
+	 *  min_cache_size (the bdev_io_cache_size option).
+	 */
+	uint32_t	min_cache_size;
+	uint32_t	max_cache_size;
+	uint32_t	cache_low_watermark;
+	uint64_t	cache_hits;
+	uint64_t	cache_misses;
+	struct spdk_poller *cache_poller;
+
 	struct spdk_iobuf_channel iobuf;
 
 	TAILQ_HEAD(, spdk_bdev_shared_resource)	shared_resources;
@@ -299,6 +343,12 @@ struct spdk_bdev_channel {
 
 	struct spdk_histogram_data *histogram;
 
+	/* Latency histograms per I/O type and size class, allocated along with histogram */
+	struct spdk_bdev_io_type_histograms *io_type_histograms;
+
+	/* I/O merge stage, NULL if merging is disabled on the bdev */
+	struct bdev_io_merge	*merge;
+
 #ifdef SPDK_CONFIG_VTUNE
 	uint64_t		start_tsc;
 	uint64_t		interval_tsc;
@@ -1659,6 +1709,29 @@ bdev_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 	spdk_json_write_object_end(w);
 }
 
+static void
+bdev_merge_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_merge_limits limits;
+
+	spdk_bdev_get_merge_limits(bdev, &limits);
+	if (limits.max_bytes == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_set_merge_limits");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_uint32(w, "max_bytes", limits.max_bytes);
+	spdk_json_write_named_uint32(w, "max_ios", limits.max_ios);
+	spdk_json_write_named_uint32(w, "window_us", limits.window_us);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
 void
 spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 {
@@ -1694,6 +1767,7 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 		}
 
 		bdev_qos_config_json(bdev, w);
+		bdev_merge_config_json(bdev, w);
 	}
 
 	spdk_spin_unlock(&g_bdev_mgr.spinlock);
@@ -1712,6 +1786,7 @@ bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
 	struct spdk_bdev_io *bdev_io;
 
+	spdk_poller_unregister(&ch->cache_poller);
 	spdk_iobuf_channel_fini(&ch->iobuf);
 
 	while (!STAILQ_EMPTY(&ch->per_thread_cache)) {
@@ -1724,6 +1799,35 @@ bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 	assert(ch->per_thread_cache_count == 0);
 }
 
+static int
+bdev_mgmt_channel_rebalance_cache(void *ctx)
+{
+	struct spdk_bdev_mgmt_channel *ch = ctx;
+	struct spdk_bdev_io *bdev_io;
+	uint32_t idle, released = 0;
+
+	/*
+	 * cache_low_watermark is the number of bdev_ios that sat in the cache
+	 *  during the whole last period.  Give half of them (but never more than
+	 *  the cache has grown) back to the global mempool.
+	 */
+	idle = spdk_min(ch->cache_low_watermark, ch->bdev_io_cache_size - ch->min_cache_size);
+	idle = (idle + 1) / 2;
+
+	ch->bdev_io_cache_size -= idle;
+	while (ch->per_thread_cache_count > ch->bdev_io_cache_size) {
+		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
+		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
+		ch->per_thread_cache_count--;
+		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		released++;
+	}
+
+	ch->cache_low_watermark = ch->per_thread_cache_count;
+
+	return released > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static int
 bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 {
@@ -1740,6 +1844,10 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 
 	STAILQ_INIT(&ch->per_thread_cache);
 	ch->bdev_io_cache_size = g_bdev_opts.bdev_io_cache_size;
+	ch->min_cache_size = ch->bdev_io_cache_size;
+	ch->max_cache_size = ch->bdev_io_cache_size * SPDK_BDEV_IO_CACHE_GROW_FACTOR;
+	ch->cache_hits = 0;
+	ch->cache_misses = 0;
 
 	/* Pre-populate bdev_io cache to ensure this thread cannot be starved. */
 	ch->per_thread_cache_count = 0;
@@ -1754,10 +1862,14 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 		ch->per_thread_cache_count++;
 		STAILQ_INSERT_HEAD(&ch->per_thread_cache, bdev_io, internal.buf_link);
 	}
+	ch->cache_low_watermark = ch->per_thread_cache_count;
 
 	TAILQ_INIT(&ch->shared_resources);
 	TAILQ_INIT(&ch->io_wait_queue);
 
+	ch->cache_poller = SPDK_POLLER_REGISTER(bdev_mgmt_channel_rebalance_cache, ch,
+					       SPDK_BDEV_IO_CACHE_REBALANCE_PERIOD_US);
+
 	return 0;
 }
 
@@ -2192,6 +2304,8 @@ bdev_channel_get_io(struct spdk_bdev_channel *channel)
 		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
 		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
 		ch->per_thread_cache_count--;
+		ch->cache_low_watermark = spdk_min(ch->cache_low_watermark, ch->per_thread_cache_count);
+		ch->cache_hits++;
 	} else if (spdk_unlikely(!TAILQ_EMPTY(&ch->io_wait_queue))) {
 		/*
 		 * Don't try to look for bdev_ios in the global pool if there are
@@ -2200,6 +2314,12 @@ bdev_channel_get_io(struct spdk_bdev_channel *channel)
 		bdev_io = NULL;
 	} else {
 		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		ch->cache_low_watermark = 0;
+		ch->cache_misses++;
+		/* Grow the cache so that this bdev_io is kept on this thread once freed. */
+		if (ch->bdev_io_cache_size < ch->max_cache_size) {
+			ch->bdev_io_cache_size++;
+		}
 	}
 
 	return bdev_io;
@@ -2236,6 +2356,60 @@ spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
 	}
 }
 
+struct bdev_io_cache_stat_ctx {
+	struct spdk_json_write_ctx *w;
+	bdev_dump_io_cache_stat_cb cb_fn;
+	void *cb_arg;
+};
+
+static void
+bdev_dump_io_cache_stat_msg(struct spdk_io_channel_iter *i)
+{
+	struct bdev_io_cache_stat_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bdev_mgmt_channel *ch = __io_ch_to_bdev_mgmt_ch(_ch);
+	struct spdk_json_write_ctx *w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "thread_id", spdk_thread_get_id(spdk_get_thread()));
+	spdk_json_write_named_uint32(w, "cache_size", ch->bdev_io_cache_size);
+	spdk_json_write_named_uint32(w, "cache_count", ch->per_thread_cache_count);
+	spdk_json_write_named_uint64(w, "hits", ch->cache_hits);
+	spdk_json_write_named_uint64(w, "misses", ch->cache_misses);
+	spdk_json_write_object_end(w);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_dump_io_cache_stat_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct bdev_io_cache_stat_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+void
+bdev_dump_io_cache_stat_json(struct spdk_json_write_ctx *w, bdev_dump_io_cache_stat_cb cb_fn,
+			     void *cb_arg)
+{
+	struct bdev_io_cache_stat_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->w = w;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(&g_bdev_mgr, bdev_dump_io_cache_stat_msg, ctx,
+			      bdev_dump_io_cache_stat_done);
+}
+
 static bool
 bdev_qos_is_iops_rate_limit(enum spdk_bdev_qos_rate_limit_type limit)
 {
@@ -3240,14 +3414,252 @@ bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 	}
 }
 
+static void bdev_io_submit_unmerged(struct spdk_bdev_io *bdev_io);
+
+static void
+bdev_merge_done(struct spdk_bdev_io *merged_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *bdev_io = cb_arg, *next;
+
+	spdk_bdev_free_io(merged_io);
+
+	while (bdev_io != NULL) {
+		next = STAILQ_NEXT(bdev_io, internal.buf_link);
+
+		if (spdk_likely(success)) {
+			/* Each I/O is accounted on its own, the merged I/O itself isn't. */
+			bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+			bdev_io_complete(bdev_io);
+		} else {
+			/* Retry each I/O on its own, so that only the ones that really fail
+			 * report an error, with their own status.
+			 */
+			bdev_io_submit_unmerged(bdev_io);
+		}
+
+		bdev_io = next;
+	}
+}
+
+static void
+bdev_merge_flush(struct spdk_bdev_channel *ch)
+{
+	struct bdev_io_merge *merge = ch->merge;
+	struct spdk_bdev_io *first, *bdev_io, *merged_io;
+	int iovcnt = 0;
+
+	first = STAILQ_FIRST(&merge->queued);
+	if (first == NULL) {
+		return;
+	}
+
+	/* The queued I/Os are already on io_submitted, so a pending range lock waits for them.
+	 * Don't hold them behind a merged I/O which would be parked on io_locked.  QoS has to
+	 * see each I/O on its own too.
+	 */
+	if (merge->num_queued > 1 && TAILQ_EMPTY(&ch->locked_ranges) &&
+	    !(ch->flags & BDEV_CH_QOS_ENABLED)) {
+		merged_io = bdev_channel_get_io(ch);
+	} else {
+		merged_io = NULL;
+	}
+
+	if (merged_io == NULL) {
+		STAILQ_INIT(&merge->queued);
+		merge->num_queued = 0;
+
+		while (first != NULL) {
+			bdev_io = first;
+			first = STAILQ_NEXT(bdev_io, internal.buf_link);
+			bdev_io_submit_unmerged(bdev_io);
+		}
+		return;
+	}
+
+	STAILQ_FOREACH(bdev_io, &merge->queued, internal.buf_link) {
+		memcpy(&merged_io->child_iov[iovcnt], bdev_io->u.bdev.iovs,
+		       bdev_io->u.bdev.iovcnt * sizeof(struct iovec));
+		iovcnt += bdev_io->u.bdev.iovcnt;
+	}
+	assert(iovcnt == merge->iovcnt);
+
+	merged_io->internal.ch = ch;
+	merged_io->internal.desc = first->internal.desc;
+	merged_io->type = first->type;
+	merged_io->u.bdev.iovs = merged_io->child_iov;
+	merged_io->u.bdev.iovcnt = iovcnt;
+	merged_io->u.bdev.md_buf = NULL;
+	merged_io->u.bdev.offset_blocks = first->u.bdev.offset_blocks;
+	merged_io->u.bdev.num_blocks = merge->num_blocks;
+	merged_io->u.bdev.memory_domain = NULL;
+	merged_io->u.bdev.memory_domain_ctx = NULL;
+	merged_io->u.bdev.accel_sequence = NULL;
+	bdev_io_init(merged_io, ch->bdev, first, bdev_merge_done);
+
+	ch->stat->num_merge_ops++;
+	ch->stat->num_merged_ops += merge->num_queued;
+
+	STAILQ_INIT(&merge->queued);
+	merge->num_queued = 0;
+
+	/* The limits are checked while queueing, so the merged I/O never needs splitting. */
+	assert(!merged_io->internal.split);
+	TAILQ_INSERT_TAIL(&ch->io_submitted, merged_io, internal.ch_link);
+	merged_io->internal.submit_tsc = spdk_get_ticks();
+	bdev_io_submit_unmerged(merged_io);
+}
+
+static inline bool
+bdev_io_can_merge(struct spdk_bdev_io *bdev_io)
+{
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		break;
+	default:
+		return false;
+	}
+
+	return bdev_io->internal.cb != bdev_merge_done &&
+	       bdev_io->internal.cb != bdev_io_split_done &&
+	       bdev_io->u.bdev.md_buf == NULL &&
+	       bdev_io->u.bdev.iovs[0].iov_base != NULL &&
+	       bdev_io->internal.memory_domain == NULL &&
+	       bdev_io->internal.accel_sequence == NULL &&
+	       bdev_io->internal.orig_iovcnt == 0;
+}
+
+static bool
+bdev_merge_crosses_boundary(struct spdk_bdev_io *bdev_io, uint64_t offset_blocks,
+			    uint64_t num_blocks)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	uint32_t io_boundary;
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE && bdev->split_on_write_unit) {
+		io_boundary = bdev->write_unit_size;
+	} else if (bdev->split_on_optimal_io_boundary) {
+		io_boundary = bdev->optimal_io_boundary;
+	} else {
+		return false;
+	}
+
+	return offset_blocks / io_boundary != (offset_blocks + num_blocks - 1) / io_boundary;
+}
+
+/* Returns true if the I/O was queued by the merge stage. */
+static bool
+bdev_merge_queue_io(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_io_merge *merge = ch->merge;
+	struct spdk_bdev_io *first = STAILQ_FIRST(&merge->queued);
+
+	if (!bdev_io_can_merge(bdev_io)) {
+		/* Keep the submission order of the queued I/Os and this one. */
+		bdev_merge_flush(ch);
+		return false;
+	}
+
+	if (first != NULL &&
+	    (first->type != bdev_io->type ||
+	     first->u.bdev.offset_blocks + merge->num_blocks != bdev_io->u.bdev.offset_blocks ||
+	     merge->num_blocks + bdev_io->u.bdev.num_blocks > merge->max_blocks ||
+	     merge->iovcnt + bdev_io->u.bdev.iovcnt > merge->max_iovcnt ||
+	     bdev_merge_crosses_boundary(first, first->u.bdev.offset_blocks,
+					 merge->num_blocks + bdev_io->u.bdev.num_blocks))) {
+		bdev_merge_flush(ch);
+		first = NULL;
+	}
+
+	if (first == NULL) {
+		if (bdev_io->u.bdev.num_blocks >= merge->max_blocks ||
+		    bdev_io->u.bdev.iovcnt >= merge->max_iovcnt) {
+			return false;
+		}
+
+		merge->num_blocks = 0;
+		merge->iovcnt = 0;
+	}
+
+	STAILQ_INSERT_TAIL(&merge->queued, bdev_io, internal.buf_link);
+	merge->num_queued++;
+	merge->num_blocks += bdev_io->u.bdev.num_blocks;
+	merge->iovcnt += bdev_io->u.bdev.iovcnt;
+
+	if (merge->num_queued >= merge->max_ios || merge->num_blocks >= merge->max_blocks) {
+		bdev_merge_flush(ch);
+	}
+
+	return true;
+}
+
+static int
+bdev_merge_poll(void *ctx)
+{
+	struct spdk_bdev_channel *ch = ctx;
+
+	if (STAILQ_EMPTY(&ch->merge->queued)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	bdev_merge_flush(ch);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bdev_channel_disable_merge(struct spdk_bdev_channel *ch)
+{
+	struct bdev_io_merge *merge = ch->merge;
+
+	if (merge == NULL) {
+		return;
+	}
+
+	bdev_merge_flush(ch);
+	ch->merge = NULL;
+
+	spdk_poller_unregister(&merge->poller);
+	free(merge);
+}
+
+static int
+bdev_channel_enable_merge(struct spdk_bdev_channel *ch, const struct spdk_bdev_merge_limits *limits)
+{
+	struct spdk_bdev *bdev = ch->bdev;
+	struct bdev_io_merge *merge;
+
+	merge = calloc(1, sizeof(*merge));
+	if (merge == NULL) {
+		return -ENOMEM;
+	}
+
+	STAILQ_INIT(&merge->queued);
+	merge->max_blocks = spdk_max(limits->max_bytes / spdk_bdev_get_block_size(bdev), 1);
+	merge->max_ios = limits->max_ios;
+	merge->max_iovcnt = SPDK_BDEV_IO_NUM_CHILD_IOV;
+	if (bdev->max_num_segments) {
+		merge->max_iovcnt = spdk_min(merge->max_iovcnt, (int)bdev->max_num_segments);
+	}
+
+	merge->poller = SPDK_POLLER_REGISTER(bdev_merge_poll, ch, limits->window_us);
+	if (merge->poller == NULL) {
+		free(merge);
+		return -ENOMEM;
+	}
+
+	ch->merge = merge;
+
+	return 0;
+}
+
 void
 bdev_io_submit(struct spdk_bdev_io *bdev_io)
 {
 	struct spdk_bdev *bdev = bdev_io->bdev;
-	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
 	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
 
-	assert(thread != NULL);
+	assert(spdk_bdev_io_get_thread(bdev_io) != NULL);
 	assert(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
 
 	if (!TAILQ_EMPTY(&ch->locked_ranges)) {
@@ -3274,6 +3686,20 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 		return;
 	}
 
+	if (spdk_unlikely(ch->merge != NULL) && bdev_merge_queue_io(ch, bdev_io)) {
+		return;
+	}
+
+	bdev_io_submit_unmerged(bdev_io);
+}
+
+static void
+bdev_io_submit_unmerged(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+
 	if (ch->flags & BDEV_CH_QOS_ENABLED) {
 		if ((thread == bdev->internal.qos->thread) || !bdev->internal.qos->thread) {
 			_bdev_io_submit(bdev_io);
@@ -3487,6 +3913,23 @@ bdev_channel_poll_qos(void *arg)
 	return bdev_qos_io_submit(qos->ch, qos);
 }
 
+static void
+bdev_io_type_histograms_free(struct spdk_bdev_io_type_histograms *histograms)
+{
+	int i, j;
+
+	if (histograms == NULL) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_BDEV_NUM_IO_TYPES; i++) {
+		for (j = 0; j < SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES; j++) {
+			spdk_histogram_data_free(histograms->histogram[i][j]);
+		}
+	}
+	free(histograms);
+}
+
 static void
 bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 {
@@ -3498,6 +3941,13 @@ bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 	bdev_free_io_stat(ch->prev_stat);
 #endif
 
+	if (ch->merge != NULL) {
+		assert(STAILQ_EMPTY(&ch->merge->queued));
+		spdk_poller_unregister(&ch->merge->poller);
+		free(ch->merge);
+		ch->merge = NULL;
+	}
+
 	while (!TAILQ_EMPTY(&ch->locked_ranges)) {
 		range = TAILQ_FIRST(&ch->locked_ranges);
 		TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
@@ -3740,6 +4190,10 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 		if (ch->histogram == NULL) {
 			SPDK_ERRLOG("Could not allocate histogram\n");
 		}
+		ch->io_type_histograms = calloc(1, sizeof(*ch->io_type_histograms));
+		if (ch->io_type_histograms == NULL) {
+			SPDK_ERRLOG("Could not allocate I/O type histograms\n");
+		}
 	}
 
 	mgmt_io_ch = spdk_get_io_channel(&g_bdev_mgr);
@@ -3819,6 +4273,11 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	spdk_spin_lock(&bdev->internal.spinlock);
 	bdev_enable_qos(bdev, ch);
 
+	if (bdev->internal.merge_limits.max_bytes != 0 &&
+	    bdev_channel_enable_merge(ch, &bdev->internal.merge_limits) != 0) {
+		SPDK_ERRLOG("Could not enable I/O merging\n");
+	}
+
 	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
 		struct lba_range *new_range;
 
@@ -4027,6 +4486,8 @@ spdk_bdev_add_io_stat(struct spdk_bdev_io_stat *total, struct spdk_bdev_io_stat
 	total->num_unmap_ops += add->num_unmap_ops;
 	total->bytes_copied += add->bytes_copied;
 	total->num_copy_ops += add->num_copy_ops;
+	total->num_merge_ops += add->num_merge_ops;
+	total->num_merged_ops += add->num_merged_ops;
 	total->read_latency_ticks += add->read_latency_ticks;
 	total->write_latency_ticks += add->write_latency_ticks;
 	total->unmap_latency_ticks += add->unmap_latency_ticks;
@@ -4092,6 +4553,8 @@ spdk_bdev_reset_io_stat(struct spdk_bdev_io_stat *stat, enum spdk_bdev_reset_sta
 	stat->num_unmap_ops = 0;
 	stat->bytes_copied = 0;
 	stat->num_copy_ops = 0;
+	stat->num_merge_ops = 0;
+	stat->num_merged_ops = 0;
 	stat->read_latency_ticks = 0;
 	stat->write_latency_ticks = 0;
 	stat->unmap_latency_ticks = 0;
@@ -4169,6 +4632,8 @@ spdk_bdev_dump_io_stat_json(struct spdk_bdev_io_stat *stat, struct spdk_json_wri
 	spdk_json_write_named_uint64(w, "min_copy_latency_ticks",
 				     stat->min_copy_latency_ticks != UINT64_MAX ?
 				     stat->min_copy_latency_ticks : 0);
+	spdk_json_write_named_uint64(w, "num_merge_ops", stat->num_merge_ops);
+	spdk_json_write_named_uint64(w, "num_merged_ops", stat->num_merged_ops);
 
 	if (stat->io_error != NULL) {
 		spdk_json_write_named_object_begin(w, "io_error");
@@ -4216,6 +4681,7 @@ bdev_channel_destroy(void *io_device, void *ctx_buf)
 	if (ch->histogram) {
 		spdk_histogram_data_free(ch->histogram);
 	}
+	bdev_io_type_histograms_free(ch->io_type_histograms);
 
 	bdev_channel_destroy_resource(ch);
 }
@@ -6085,6 +6551,11 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 
 	channel->flags |= BDEV_CH_RESET_IN_PROGRESS;
 
+	if (channel->merge != NULL) {
+		/* The queued I/Os will be aborted, as the reset is now in progress. */
+		bdev_merge_flush(channel);
+	}
+
 	if ((channel->flags & BDEV_CH_QOS_ENABLED) != 0) {
 		/* The QoS object is always valid and readable while
 		 * the channel flag is set, so the lock here should not
@@ -6803,6 +7274,57 @@ _bdev_io_complete(void *ctx)
 			     bdev_io->internal.caller_ctx);
 }
 
+static uint32_t
+bdev_io_get_histogram_size_class(struct spdk_bdev_io *bdev_io)
+{
+	uint64_t num_bytes;
+	uint32_t size_class;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		num_bytes = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+		break;
+	default:
+		return 0;
+	}
+
+	if (num_bytes <= (1ULL << SPDK_BDEV_HISTOGRAM_SIZE_CLASS_MIN_SHIFT)) {
+		return 0;
+	}
+
+	size_class = spdk_u64log2(num_bytes - 1) + 1 - SPDK_BDEV_HISTOGRAM_SIZE_CLASS_MIN_SHIFT;
+
+	return spdk_min(size_class, SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES - 1);
+}
+
+static void
+bdev_io_type_histogram_tally(struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
+{
+	struct spdk_bdev_io_type_histograms *histograms = bdev_io->internal.ch->io_type_histograms;
+	struct spdk_histogram_data **histogram;
+
+	if (spdk_unlikely(histograms == NULL)) {
+		return;
+	}
+
+	histogram = &histograms->histogram[bdev_io->type][bdev_io_get_histogram_size_class(bdev_io)];
+	if (spdk_unlikely(*histogram == NULL)) {
+		/* Only allocate the histograms for the I/O types and sizes actually seen */
+		*histogram = spdk_histogram_data_alloc_sized(SPDK_BDEV_IO_TYPE_HISTOGRAM_BUCKET_SHIFT);
+		if (*histogram == NULL) {
+			return;
+		}
+	}
+
+	spdk_histogram_data_tally(*histogram, tsc_diff);
+}
+
 static inline void
 bdev_io_complete(void *ctx)
 {
@@ -6827,11 +7349,16 @@ bdev_io_complete(void *ctx)
 
 	TAILQ_REMOVE(&bdev_ch->io_submitted, bdev_io, internal.ch_link);
 
-	if (bdev_io->internal.ch->histogram) {
-		spdk_histogram_data_tally(bdev_io->internal.ch->histogram, tsc_diff);
+	/* The I/Os making up a merged I/O are accounted when they complete. */
+	if (spdk_likely(bdev_io->internal.cb != bdev_merge_done)) {
+		if (bdev_io->internal.ch->histogram) {
+			spdk_histogram_data_tally(bdev_io->internal.ch->histogram, tsc_diff);
+			bdev_io_type_histogram_tally(bdev_io, tsc_diff);
+		}
+
+		bdev_io_update_io_stat(bdev_io, tsc_diff);
 	}
 
-	bdev_io_update_io_stat(bdev_io, tsc_diff);
 	_bdev_io_complete(bdev_io);
 }
 
@@ -8745,6 +9272,8 @@ bdev_histogram_disable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bde
 		spdk_histogram_data_free(ch->histogram);
 		ch->histogram = NULL;
 	}
+	bdev_io_type_histograms_free(ch->io_type_histograms);
+	ch->io_type_histograms = NULL;
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
@@ -8780,6 +9309,12 @@ bdev_histogram_enable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev
 			status = -ENOMEM;
 		}
 	}
+	if (ch->io_type_histograms == NULL) {
+		ch->io_type_histograms = calloc(1, sizeof(*ch->io_type_histograms));
+		if (ch->io_type_histograms == NULL) {
+			status = -ENOMEM;
+		}
+	}
 
 	spdk_bdev_for_each_channel_continue(i, status);
 }
@@ -8824,6 +9359,87 @@ spdk_bdev_histogram_enable(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb
 	}
 }
 
+struct set_merge_limits_ctx {
+	void (*cb_fn)(void *cb_arg, int status);
+	void *cb_arg;
+	struct spdk_bdev_merge_limits limits;
+};
+
+static void
+bdev_set_merge_limits_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct set_merge_limits_ctx *ctx = _ctx;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev->internal.merge_in_progress = false;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+static void
+bdev_set_merge_limits_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			      struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct set_merge_limits_ctx *ctx = _ctx;
+	int status = 0;
+
+	bdev_channel_disable_merge(ch);
+	if (ctx->limits.max_bytes != 0) {
+		status = bdev_channel_enable_merge(ch, &ctx->limits);
+	}
+
+	spdk_bdev_for_each_channel_continue(i, status);
+}
+
+void
+spdk_bdev_get_merge_limits(struct spdk_bdev *bdev, struct spdk_bdev_merge_limits *limits)
+{
+	spdk_spin_lock(&bdev->internal.spinlock);
+	*limits = bdev->internal.merge_limits;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+}
+
+void
+spdk_bdev_set_merge_limits(struct spdk_bdev *bdev, const struct spdk_bdev_merge_limits *limits,
+			   void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_merge_limits_ctx *ctx;
+
+	if (limits->max_bytes != 0 &&
+	    (limits->max_bytes < spdk_bdev_get_block_size(bdev) || limits->max_ios < 2)) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->limits = *limits;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.merge_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	bdev->internal.merge_in_progress = true;
+	bdev->internal.merge_limits = *limits;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	spdk_bdev_for_each_channel(bdev, bdev_set_merge_limits_channel, ctx,
+				   bdev_set_merge_limits_done);
+}
+
 struct spdk_bdev_histogram_data_ctx {
 	spdk_bdev_histogram_data_cb cb_fn;
 	void *cb_arg;
@@ -8896,6 +9512,95 @@ spdk_bdev_channel_get_histogram(struct spdk_io_channel *ch, spdk_bdev_histogram_
 	cb_fn(cb_arg, status, bdev_ch->histogram);
 }
 
+uint64_t
+spdk_bdev_histogram_get_size_class_max(uint32_t size_class)
+{
+	if (size_class >= SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES - 1) {
+		return UINT64_MAX;
+	}
+
+	return 1ULL << (SPDK_BDEV_HISTOGRAM_SIZE_CLASS_MIN_SHIFT + size_class);
+}
+
+struct spdk_bdev_io_type_histograms_ctx {
+	spdk_bdev_io_type_histograms_cb cb_fn;
+	void *cb_arg;
+	/** merged histograms from all channels */
+	struct spdk_bdev_io_type_histograms *histograms;
+};
+
+static void
+bdev_io_type_histograms_get_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_io_type_histograms_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, status, ctx->histograms);
+	bdev_io_type_histograms_free(ctx->histograms);
+	free(ctx);
+}
+
+static void
+bdev_io_type_histograms_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				    struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct spdk_bdev_io_type_histograms_ctx *ctx = _ctx;
+	struct spdk_histogram_data *src, **dst;
+	int type, size_class, status = 0;
+
+	if (ch->io_type_histograms == NULL) {
+		spdk_bdev_for_each_channel_continue(i, -EFAULT);
+		return;
+	}
+
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES && status == 0; type++) {
+		for (size_class = 0; size_class < SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES; size_class++) {
+			src = ch->io_type_histograms->histogram[type][size_class];
+			if (src == NULL) {
+				continue;
+			}
+
+			dst = &ctx->histograms->histogram[type][size_class];
+			if (*dst == NULL) {
+				*dst = spdk_histogram_data_alloc_sized(src->bucket_shift);
+				if (*dst == NULL) {
+					status = -ENOMEM;
+					break;
+				}
+			}
+			spdk_histogram_data_merge(*dst, src);
+		}
+	}
+
+	spdk_bdev_for_each_channel_continue(i, status);
+}
+
+void
+spdk_bdev_io_type_histograms_get(struct spdk_bdev *bdev, spdk_bdev_io_type_histograms_cb cb_fn,
+				 void *cb_arg)
+{
+	struct spdk_bdev_io_type_histograms_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM, NULL);
+		return;
+	}
+
+	ctx->histograms = calloc(1, sizeof(*ctx->histograms));
+	if (ctx->histograms == NULL) {
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM, NULL);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_bdev_for_each_channel(bdev, bdev_io_type_histograms_get_channel, ctx,
+				   bdev_io_type_histograms_get_done);
+}
+
 size_t
 spdk_bdev_get_media_events(struct spdk_bdev_desc *desc, struct spdk_bdev_media_event *events,
 			   size_t max_events)
@@ -31,4 +31,12 @@ typedef void (*bdev_reset_device_stat_cb)(struct spdk_bdev *bdev, void *cb_arg,
 void bdev_reset_device_stat(struct spdk_bdev *bdev, enum spdk_bdev_reset_stat_mode mode,
 			    bdev_reset_device_stat_cb cb, void *cb_arg);
 
+struct spdk_json_write_ctx;
+
+typedef void (*bdev_dump_io_cache_stat_cb)(void *cb_arg, int rc);
+
+/* Write one object per thread describing its bdev_io cache into the current array of w. */
+void bdev_dump_io_cache_stat_json(struct spdk_json_write_ctx *w, bdev_dump_io_cache_stat_cb cb_fn,
+				  void *cb_arg);
+
 #endif /* SPDK_BDEV_INTERNAL_H */
@@ -184,6 +184,19 @@ rpc_get_iostat_started(struct rpc_get_iostat_ctx *rpc_ctx)
 	spdk_json_write_named_uint64(rpc_ctx->w, "ticks", spdk_get_ticks());
 }
 
+static void
+rpc_get_iostat_io_cache_done(void *cb_arg, int rc)
+{
+	struct rpc_get_iostat_ctx *rpc_ctx = cb_arg;
+
+	/* The response has already been started, so a failure only truncates the array. */
+	spdk_json_write_array_end(rpc_ctx->w);
+	spdk_json_write_object_end(rpc_ctx->w);
+	spdk_jsonrpc_end_result(rpc_ctx->request, rpc_ctx->w);
+
+	free(rpc_ctx);
+}
+
 static void
 rpc_get_iostat_done(struct rpc_get_iostat_ctx *rpc_ctx)
 {
@@ -193,16 +206,16 @@ rpc_get_iostat_done(struct rpc_get_iostat_ctx *rpc_ctx)
 
 	if (rpc_ctx->rc == 0) {
 		spdk_json_write_array_end(rpc_ctx->w);
-		spdk_json_write_object_end(rpc_ctx->w);
-		spdk_jsonrpc_end_result(rpc_ctx->request, rpc_ctx->w);
-	} else {
-		/* Return error response after processing all specified bdevs
-		 * completed or failed.
-		 */
-		spdk_jsonrpc_send_error_response(rpc_ctx->request, rpc_ctx->rc,
-						 spdk_strerror(-rpc_ctx->rc));
+		spdk_json_write_named_array_begin(rpc_ctx->w, "bdev_io_cache");
+		bdev_dump_io_cache_stat_json(rpc_ctx->w, rpc_get_iostat_io_cache_done, rpc_ctx);
+		return;
 	}
 
+	/* Return error response after processing all specified bdevs
+	 * completed or failed.
+	 */
+	spdk_jsonrpc_send_error_response(rpc_ctx->request, rpc_ctx->rc,
+					 spdk_strerror(-rpc_ctx->rc));
 	free(rpc_ctx);
 }
 
@@ -1065,6 +1078,88 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_set_qos_limit", rpc_bdev_set_qos_limit, SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_set_merge_limits {
+	char				*name;
+	struct spdk_bdev_merge_limits	limits;
+};
+
+static void
+free_rpc_bdev_set_merge_limits(struct rpc_bdev_set_merge_limits *r)
+{
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_set_merge_limits_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_set_merge_limits, name), spdk_json_decode_string},
+	{
+		"max_bytes", offsetof(struct rpc_bdev_set_merge_limits, limits.max_bytes),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"max_ios", offsetof(struct rpc_bdev_set_merge_limits, limits.max_ios),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"window_us", offsetof(struct rpc_bdev_set_merge_limits, limits.window_us),
+		spdk_json_decode_uint32, true
+	},
+};
+
+static void
+rpc_bdev_set_merge_limits_complete(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Failed to configure merge limits: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_bdev_set_merge_limits(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_set_merge_limits req = {
+		.limits = {
+			.max_bytes = 128 * 1024,
+			.max_ios = 32,
+			.window_us = 10,
+		},
+	};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_set_merge_limits_decoders,
+				    SPDK_COUNTOF(rpc_bdev_set_merge_limits_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_set_merge_limits(spdk_bdev_desc_get_bdev(desc), &req.limits,
+				   rpc_bdev_set_merge_limits_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_set_merge_limits(&req);
+}
+SPDK_RPC_REGISTER("bdev_set_merge_limits", rpc_bdev_set_merge_limits, SPDK_RPC_RUNTIME)
+
 /* SPDK_RPC_ENABLE_BDEV_HISTOGRAM */
 
 struct rpc_bdev_enable_histogram_request {
@@ -1233,3 +1328,160 @@ cleanup:
 }
 
 SPDK_RPC_REGISTER("bdev_get_histogram", rpc_bdev_get_histogram, SPDK_RPC_RUNTIME)
+
+/* SPDK_RPC_GET_BDEV_HISTOGRAM_PERCENTILES */
+
+static const char *const g_rpc_bdev_io_type_names[SPDK_BDEV_NUM_IO_TYPES] = {
+	[SPDK_BDEV_IO_TYPE_INVALID] = "invalid",
+	[SPDK_BDEV_IO_TYPE_READ] = "read",
+	[SPDK_BDEV_IO_TYPE_WRITE] = "write",
+	[SPDK_BDEV_IO_TYPE_UNMAP] = "unmap",
+	[SPDK_BDEV_IO_TYPE_FLUSH] = "flush",
+	[SPDK_BDEV_IO_TYPE_RESET] = "reset",
+	[SPDK_BDEV_IO_TYPE_NVME_ADMIN] = "nvme_admin",
+	[SPDK_BDEV_IO_TYPE_NVME_IO] = "nvme_io",
+	[SPDK_BDEV_IO_TYPE_NVME_IO_MD] = "nvme_io_md",
+	[SPDK_BDEV_IO_TYPE_WRITE_ZEROES] = "write_zeroes",
+	[SPDK_BDEV_IO_TYPE_ZCOPY] = "zcopy",
+	[SPDK_BDEV_IO_TYPE_GET_ZONE_INFO] = "get_zone_info",
+	[SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT] = "zone_management",
+	[SPDK_BDEV_IO_TYPE_ZONE_APPEND] = "zone_append",
+	[SPDK_BDEV_IO_TYPE_COMPARE] = "compare",
+	[SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE] = "compare_and_write",
+	[SPDK_BDEV_IO_TYPE_ABORT] = "abort",
+	[SPDK_BDEV_IO_TYPE_SEEK_HOLE] = "seek_hole",
+	[SPDK_BDEV_IO_TYPE_SEEK_DATA] = "seek_data",
+	[SPDK_BDEV_IO_TYPE_COPY] = "copy",
+	[SPDK_BDEV_IO_TYPE_KV_STORE] = "kv_store",
+	[SPDK_BDEV_IO_TYPE_KV_RETRIEVE] = "kv_retrieve",
+	[SPDK_BDEV_IO_TYPE_KV_DELETE] = "kv_delete",
+	[SPDK_BDEV_IO_TYPE_KV_EXIST] = "kv_exist",
+	[SPDK_BDEV_IO_TYPE_KV_LIST] = "kv_list",
+};
+
+static const struct {
+	const char	*name;
+	double		cutoff;
+} g_rpc_bdev_histogram_percentiles[] = {
+	{"50", 0.5},
+	{"90", 0.9},
+	{"99", 0.99},
+	{"99.9", 0.999},
+	{"99.99", 0.9999},
+};
+
+struct rpc_bdev_histogram_percentiles_ctx {
+	uint64_t	total;
+	uint64_t	value[SPDK_COUNTOF(g_rpc_bdev_histogram_percentiles)];
+	uint32_t	next;
+};
+
+static void
+rpc_bdev_histogram_percentiles_bucket(void *_ctx, uint64_t start, uint64_t end, uint64_t count,
+				      uint64_t total, uint64_t so_far)
+{
+	struct rpc_bdev_histogram_percentiles_ctx *ctx = _ctx;
+
+	ctx->total = total;
+	if (count == 0) {
+		return;
+	}
+
+	while (ctx->next < SPDK_COUNTOF(g_rpc_bdev_histogram_percentiles) &&
+	       (double)so_far >= g_rpc_bdev_histogram_percentiles[ctx->next].cutoff * total) {
+		ctx->value[ctx->next++] = end;
+	}
+}
+
+static void
+rpc_bdev_get_histogram_percentiles_cb(void *cb_arg, int status,
+				      const struct spdk_bdev_io_type_histograms *histograms)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct rpc_bdev_histogram_percentiles_ctx ctx;
+	struct spdk_histogram_data *histogram;
+	struct spdk_json_write_ctx *w;
+	uint64_t tsc_rate = spdk_get_ticks_hz();
+	uint64_t max_io_size;
+	uint32_t type, size_class, i;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tick_rate", tsc_rate);
+	spdk_json_write_named_array_begin(w, "histograms");
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (size_class = 0; size_class < SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES; size_class++) {
+			histogram = histograms->histogram[type][size_class];
+			if (histogram == NULL) {
+				continue;
+			}
+
+			memset(&ctx, 0, sizeof(ctx));
+			spdk_histogram_data_iterate(histogram, rpc_bdev_histogram_percentiles_bucket, &ctx);
+			if (ctx.total == 0) {
+				continue;
+			}
+
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_string(w, "io_type", g_rpc_bdev_io_type_names[type]);
+			spdk_json_write_named_uint64(w, "min_io_size", size_class == 0 ? 0 :
+						     spdk_bdev_histogram_get_size_class_max(size_class - 1) + 1);
+			max_io_size = spdk_bdev_histogram_get_size_class_max(size_class);
+			if (max_io_size != UINT64_MAX) {
+				spdk_json_write_named_uint64(w, "max_io_size", max_io_size);
+			}
+			spdk_json_write_named_uint64(w, "count", ctx.total);
+			spdk_json_write_named_object_begin(w, "latency_us");
+			for (i = 0; i < SPDK_COUNTOF(g_rpc_bdev_histogram_percentiles); i++) {
+				spdk_json_write_named_double(w, g_rpc_bdev_histogram_percentiles[i].name,
+							     (double)ctx.value[i] * SPDK_SEC_TO_USEC / tsc_rate);
+			}
+			spdk_json_write_object_end(w);
+			spdk_json_write_object_end(w);
+		}
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_bdev_get_histogram_percentiles(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_get_histogram_request req = {NULL};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_get_histogram_request_decoders,
+				    SPDK_COUNTOF(rpc_bdev_get_histogram_request_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_io_type_histograms_get(spdk_bdev_desc_get_bdev(desc),
+					 rpc_bdev_get_histogram_percentiles_cb, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_get_histogram_request(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_get_histogram_percentiles", rpc_bdev_get_histogram_percentiles,
+		  SPDK_RPC_RUNTIME)
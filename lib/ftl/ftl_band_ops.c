@@ -65,7 +65,7 @@ ftl_band_rq_write(struct ftl_band *band, struct ftl_rq *rq)
 	ftl_band_rq_bdev_write(rq);
 
 	band->queue_depth++;
-	dev->stats.io_activity_total += rq->num_blocks;
+	ftl_add_io_activity_blocks(dev, rq->num_blocks);
 
 	ftl_band_iter_advance(band, rq->num_blocks);
 	if (ftl_band_filled(band, band->md->iter.offset)) {
@@ -140,7 +140,7 @@ ftl_band_rq_read(struct ftl_band *band, struct ftl_rq *rq)
 
 	ftl_band_rq_bdev_read(entry);
 
-	dev->stats.io_activity_total += rq->num_blocks;
+	ftl_add_io_activity_blocks(dev, rq->num_blocks);
 	band->queue_depth++;
 }
 
@@ -196,7 +196,7 @@ ftl_band_basic_rq_write(struct ftl_band *band, struct ftl_basic_rq *brq)
 
 	ftl_band_brq_bdev_write(brq);
 
-	dev->stats.io_activity_total += brq->num_blocks;
+	ftl_add_io_activity_blocks(dev, brq->num_blocks);
 	band->queue_depth++;
 	ftl_band_iter_advance(band, brq->num_blocks);
 	if (ftl_band_filled(band, band->md->iter.offset)) {
@@ -255,7 +255,7 @@ ftl_band_basic_rq_read(struct ftl_band *band, struct ftl_basic_rq *brq)
 	ftl_band_brq_bdev_read(brq);
 
 	brq->io.band->queue_depth++;
-	dev->stats.io_activity_total += brq->num_blocks;
+	ftl_add_io_activity_blocks(dev, brq->num_blocks);
 }
 
 static void
@@ -685,21 +685,51 @@ int
 ftl_core_poller(void *ctx)
 {
 	struct spdk_ftl_dev *dev = ctx;
-	uint64_t io_activity_total_old = dev->stats.io_activity_total;
+	uint64_t io_activity_old = g_ftl_thread_io_activity;
 
 	if (dev->halt && ftl_shutdown_complete(dev)) {
+		spdk_poller_unregister(&dev->compaction_poller);
+		spdk_poller_unregister(&dev->reloc_poller);
 		spdk_poller_unregister(&dev->core_poller);
 		return SPDK_POLLER_IDLE;
 	}
 
 	ftl_process_io_queue(dev);
 	ftl_writer_run(&dev->writer_user);
-	ftl_writer_run(&dev->writer_gc);
-	ftl_reloc(dev->reloc);
-	ftl_nv_cache_process(dev);
 	ftl_l2p_process(dev);
 
-	if (io_activity_total_old != dev->stats.io_activity_total) {
+	if (io_activity_old != g_ftl_thread_io_activity) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	return SPDK_POLLER_IDLE;
+}
+
+int
+ftl_compaction_poller(void *ctx)
+{
+	struct spdk_ftl_dev *dev = ctx;
+	uint64_t io_activity_old = g_ftl_thread_io_activity;
+
+	ftl_nv_cache_process(dev);
+
+	if (io_activity_old != g_ftl_thread_io_activity) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	return SPDK_POLLER_IDLE;
+}
+
+int
+ftl_reloc_poller(void *ctx)
+{
+	struct spdk_ftl_dev *dev = ctx;
+	uint64_t io_activity_old = g_ftl_thread_io_activity;
+
+	ftl_reloc(dev->reloc);
+	ftl_writer_run(&dev->writer_gc);
+
+	if (io_activity_old != g_ftl_thread_io_activity) {
 		return SPDK_POLLER_BUSY;
 	}
 
@@ -722,6 +752,7 @@ ftl_band_get_next_free(struct spdk_ftl_dev *dev)
 
 void *g_ftl_write_buf;
 void *g_ftl_read_buf;
+__thread uint64_t g_ftl_thread_io_activity;
 
 int
 spdk_ftl_init(void)
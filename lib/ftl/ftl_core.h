@@ -149,9 +149,20 @@ struct spdk_ftl_dev {
 	/* Underlying device IO channel */
 	struct spdk_io_channel		*base_ioch;
 
-	/* Poller */
+	/*
+	 * All pollers below run on the core thread, so FTL throughput is still bound
+	 * to a single core. The L2P, band lists and NV cache chunk lists are not
+	 * thread safe and are not partitioned across cores.
+	 */
+	/* Poller handling user IO submission, user writer and L2P */
 	struct spdk_poller		*core_poller;
 
+	/* Poller driving NV cache compaction */
+	struct spdk_poller		*compaction_poller;
+
+	/* Poller driving band relocation and the GC writer */
+	struct spdk_poller		*reloc_poller;
+
 	/* Read submission queue */
 	TAILQ_HEAD(, ftl_io)		rd_sq;
 
@@ -193,6 +204,10 @@ void ftl_invalidate_addr(struct spdk_ftl_dev *dev, ftl_addr addr);
 
 int ftl_core_poller(void *ctx);
 
+int ftl_compaction_poller(void *ctx);
+
+int ftl_reloc_poller(void *ctx);
+
 int ftl_io_channel_poll(void *arg);
 
 struct ftl_io_channel *ftl_io_channel_get_ctx(struct spdk_io_channel *ioch);
@@ -233,10 +248,23 @@ ftl_get_core_thread(const struct spdk_ftl_dev *dev)
 	return dev->core_thread;
 }
 
+/*
+ * IO activity recorded on the calling thread. The FTL pollers compare it before and after
+ * doing their work to report busy/idle, so activity on other cores doesn't keep them busy.
+ */
+extern __thread uint64_t g_ftl_thread_io_activity;
+
+static inline void
+ftl_add_io_activity_blocks(struct spdk_ftl_dev *dev, uint64_t num_blocks)
+{
+	dev->stats.io_activity_total += num_blocks;
+	g_ftl_thread_io_activity += num_blocks;
+}
+
 static inline void
 ftl_add_io_activity(struct spdk_ftl_dev *dev)
 {
-	dev->stats.io_activity_total++;
+	ftl_add_io_activity_blocks(dev, 1);
 }
 
 static inline uint64_t
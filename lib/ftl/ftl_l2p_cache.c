@@ -46,6 +46,8 @@ struct ftl_l2p_page {
 	uint64_t pin_ref_cnt;
 	struct ftl_l2p_cache_page_io_ctx ctx;
 	bool on_lru_list;
+	bool hot;		/* Page was referenced again after page in, kept on the protected list */
+	bool prefetched;	/* Page was read ahead and has not been pinned yet */
 	void *page_buffer;
 	uint64_t ckpt_seq_id;
 	ftl_df_obj_id obj_id;
@@ -107,7 +109,18 @@ struct ftl_l2p_cache {
 	struct ftl_mempool *l2_ctx_pool;
 	struct ftl_md *l1_md;
 
+	/*
+	 * Pages eligible for eviction are kept on two lists (2Q-like). Pages that were paged in
+	 * (or read ahead) and not referenced since then, or touched by sequential scans only,
+	 * go to the probation list. Pages re-referenced by random accesses move to the protected
+	 * list. Eviction prefers the probation list, so large scans cannot flush the hot working set.
+	 */
 	TAILQ_HEAD(l2p_lru_list, ftl_l2p_page) lru_list;
+	TAILQ_HEAD(, ftl_l2p_page) lru_protected_list;
+	uint64_t lru_cnt;
+	uint64_t lru_protected_cnt;
+	/* Minimum size of the probation list, below it the protected list is evicted first */
+	uint64_t lru_probation_min;
 	/* TODO: A lot of / and % operations are done on this value, consider adding a shift based field and calculactions instead */
 	uint64_t lbas_in_page;
 	uint64_t num_pages;		/* num pages to hold the entire L2P */
@@ -132,6 +145,24 @@ struct ftl_l2p_cache {
 		struct ftl_l2p_pin_ctx pin_ctx;
 	} lazy_unmap;
 
+	/* Sequential stream detection for L2P page read ahead */
+	struct {
+#define FTL_L2P_PREFETCH_STREAMS	4
+#define FTL_L2P_PREFETCH_TRIGGER	2
+#define FTL_L2P_PREFETCH_DEPTH		8
+#define FTL_L2P_PREFETCH_MAX_QD		64
+		struct {
+			/* Last page pinned by the stream */
+			uint64_t last_page;
+			/* Number of times the stream advanced to the next page */
+			uint64_t seq_cnt;
+			/* Pages below this one were already read ahead */
+			uint64_t prefetched_end;
+		} stream[FTL_L2P_PREFETCH_STREAMS];
+		/* Next stream slot to be replaced */
+		uint32_t victim;
+	} prefetch;
+
 	/* This is a context for a management process */
 	struct ftl_l2p_cache_process_ctx mctx;
 
@@ -187,7 +218,13 @@ ftl_l2p_cache_lru_remove_page(struct ftl_l2p_cache *cache, struct ftl_l2p_page *
 	assert(page);
 	assert(page->on_lru_list);
 
-	TAILQ_REMOVE(&cache->lru_list, page, list_entry);
+	if (page->hot) {
+		TAILQ_REMOVE(&cache->lru_protected_list, page, list_entry);
+		cache->lru_protected_cnt--;
+	} else {
+		TAILQ_REMOVE(&cache->lru_list, page, list_entry);
+		cache->lru_cnt--;
+	}
 	page->on_lru_list = false;
 }
 
@@ -197,9 +234,29 @@ ftl_l2p_cache_lru_add_page(struct ftl_l2p_cache *cache, struct ftl_l2p_page *pag
 	assert(page);
 	assert(!page->on_lru_list);
 
-	TAILQ_INSERT_HEAD(&cache->lru_list, page, list_entry);
+	if (page->hot) {
+		TAILQ_INSERT_HEAD(&cache->lru_protected_list, page, list_entry);
+		cache->lru_protected_cnt++;
+	} else {
+		TAILQ_INSERT_HEAD(&cache->lru_list, page, list_entry);
+		cache->lru_cnt++;
+	}
 
 	page->on_lru_list = true;
+
+	/*
+	 * Keep the protected list within its share of the cache. Its coldest page goes back to
+	 * the probation list and has to be re-referenced to get protected again.
+	 */
+	if (cache->lru_protected_cnt > cache->l2_pgs_resident_max - cache->lru_probation_min) {
+		struct ftl_l2p_page *cold = TAILQ_LAST(&cache->lru_protected_list, l2p_lru_list);
+
+		TAILQ_REMOVE(&cache->lru_protected_list, cold, list_entry);
+		cache->lru_protected_cnt--;
+		cold->hot = false;
+		TAILQ_INSERT_HEAD(&cache->lru_list, cold, list_entry);
+		cache->lru_cnt++;
+	}
 }
 
 static void
@@ -239,7 +296,12 @@ ftl_l2p_cache_page_remove(struct ftl_l2p_cache *cache, struct ftl_l2p_page *page
 static inline struct ftl_l2p_page *
 ftl_l2p_cache_get_coldest_page(struct ftl_l2p_cache *cache)
 {
-	return TAILQ_LAST(&cache->lru_list, l2p_lru_list);
+	/* Evict from the probation list first, unless it got too short to absorb new pages */
+	if (cache->lru_cnt > cache->lru_probation_min || !cache->lru_protected_cnt) {
+		return TAILQ_LAST(&cache->lru_list, l2p_lru_list);
+	}
+
+	return TAILQ_LAST(&cache->lru_protected_list, l2p_lru_list);
 }
 
 static inline struct ftl_l2p_page *
@@ -383,6 +445,7 @@ _ftl_l2p_cache_init(struct spdk_ftl_dev *dev, size_t addr_size, uint64_t l2p_siz
 	struct ftl_l2p_cache *cache;
 	uint64_t l2_pages = spdk_divide_round_up(l2p_size, ftl_l2p_cache_get_l1_page_size());
 	size_t l2_size = l2_pages * sizeof(struct ftl_l2p_l1_map_entry);
+	uint32_t i;
 
 	cache = calloc(1, sizeof(struct ftl_l2p_cache));
 	if (cache == NULL) {
@@ -403,6 +466,11 @@ _ftl_l2p_cache_init(struct spdk_ftl_dev *dev, size_t addr_size, uint64_t l2p_siz
 	cache->lbas_in_page = dev->layout.l2p.lbas_in_page;
 	cache->num_pages = l2_pages;
 
+	for (i = 0; i < FTL_L2P_PREFETCH_STREAMS; i++) {
+		/* Make sure none of the streams matches any page until it's used */
+		cache->prefetch.stream[i].last_page = UINT64_MAX - 1;
+	}
+
 	return cache;
 fail_l2_md:
 	free(cache);
@@ -460,6 +528,7 @@ ftl_l2p_cache_init(struct spdk_ftl_dev *dev)
 
 	TAILQ_INIT(&cache->deferred_page_set_list);
 	TAILQ_INIT(&cache->lru_list);
+	TAILQ_INIT(&cache->lru_protected_list);
 
 	cache->l2_ctx_md = ftl_md_create(dev,
 					 spdk_divide_round_up(max_resident_pgs * SPDK_ALIGN_CEIL(sizeof(struct ftl_l2p_page), 64),
@@ -472,6 +541,8 @@ ftl_l2p_cache_init(struct spdk_ftl_dev *dev)
 	cache->l2_pgs_resident_max = max_resident_pgs;
 	cache->l2_pgs_avail = max_resident_pgs;
 	cache->l2_pgs_evicting = 0;
+#define FTL_L2P_CACHE_PROBATION_RATIO		25UL
+	cache->lru_probation_min = max_resident_pgs * FTL_L2P_CACHE_PROBATION_RATIO / 100;
 	cache->l2_ctx_pool = ftl_mempool_create_ext(ftl_md_get_buffer(cache->l2_ctx_md),
 			     max_resident_pgs, sizeof(struct ftl_l2p_page), 64);
 
@@ -819,6 +890,8 @@ l2p_shm_restore_clean(struct spdk_ftl_dev *dev)
 
 		page->pin_ref_cnt = 0;
 		page->on_lru_list = 0;
+		page->hot = false;
+		page->prefetched = false;
 		memset(&page->ctx, 0, sizeof(page->ctx));
 
 		ftl_l2p_cache_lru_add_page(cache, page);
@@ -867,6 +940,8 @@ l2p_shm_restore_dirty(struct spdk_ftl_dev *dev)
 
 		page->pin_ref_cnt = 0;
 		page->on_lru_list = 0;
+		page->hot = false;
+		page->prefetched = false;
 		memset(&page->ctx, 0, sizeof(page->ctx));
 
 		ftl_l2p_cache_lru_add_page(cache, page);
@@ -996,18 +1071,111 @@ ftl_l2p_cache_page_is_pinnable(struct ftl_l2p_page *page)
 	return page->state != L2P_CACHE_PAGE_INIT;
 }
 
-void
-ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
+static void page_allocate_and_read(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
+				   uint64_t page_no);
+
+/*
+ * Tracks sequential streams of pinned pages. Returns true if the pin continues a sequential
+ * stream, filling in the range of pages [*pf_start, *pf_end) which should be read ahead.
+ */
+static bool
+prefetch_stream_update(struct ftl_l2p_cache *cache, uint64_t start, uint64_t end,
+		       uint64_t *pf_start, uint64_t *pf_end)
+{
+	uint32_t i;
+
+	for (i = 0; i < FTL_L2P_PREFETCH_STREAMS; i++) {
+		if (start == cache->prefetch.stream[i].last_page ||
+		    start == cache->prefetch.stream[i].last_page + 1) {
+			break;
+		}
+	}
+
+	if (i == FTL_L2P_PREFETCH_STREAMS) {
+		/* Not a continuation of any known stream, start tracking a new one */
+		i = cache->prefetch.victim;
+		cache->prefetch.victim = (i + 1) % FTL_L2P_PREFETCH_STREAMS;
+		cache->prefetch.stream[i].seq_cnt = 0;
+		cache->prefetch.stream[i].prefetched_end = 0;
+	} else if (end > cache->prefetch.stream[i].last_page) {
+		cache->prefetch.stream[i].seq_cnt++;
+	}
+	cache->prefetch.stream[i].last_page = end;
+
+	if (cache->prefetch.stream[i].seq_cnt < FTL_L2P_PREFETCH_TRIGGER) {
+		return false;
+	}
+
+	*pf_start = spdk_max(end + 1, cache->prefetch.stream[i].prefetched_end);
+	*pf_end = spdk_min(end + 1 + FTL_L2P_PREFETCH_DEPTH, cache->num_pages);
+	cache->prefetch.stream[i].prefetched_end = spdk_max(*pf_start, *pf_end);
+
+	return true;
+}
+
+static bool
+prefetch_allowed(struct ftl_l2p_cache *cache)
+{
+	/*
+	 * Read ahead only with spare pages and when there are no pins waiting for them,
+	 * the regular page ins always take precedence.
+	 */
+	return TAILQ_EMPTY(&cache->deferred_page_set_list) &&
+	       cache->l2_pgs_avail > cache->evict_keep / 2 + L2P_MAX_PAGES_TO_PIN &&
+	       cache->ios_in_flight < FTL_L2P_PREFETCH_MAX_QD;
+}
+
+static void
+prefetch_pages(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache, uint64_t start,
+	       uint64_t end)
+{
+	uint64_t page_no;
+
+	for (page_no = start; page_no < end; page_no++) {
+		if (!prefetch_allowed(cache)) {
+			break;
+		}
+
+		if (get_l2p_page_by_df_id(cache, page_no)) {
+			continue;
+		}
+
+		page_allocate_and_read(dev, cache, page_no);
+	}
+}
+
+static inline void
+ftl_l2p_cache_page_reference(struct spdk_ftl_dev *dev, struct ftl_l2p_page *page, bool scan)
+{
+	dev->stats.l2p_cache.hits++;
+
+	if (page->prefetched) {
+		dev->stats.l2p_cache.prefetch_hits++;
+		page->prefetched = false;
+	} else if (!scan) {
+		/*
+		 * Page referenced again outside of a sequential scan, protect it from eviction.
+		 * The page is never on the LRU list at this point - it's either being
+		 * loaded/evicted, or has just been pinned.
+		 */
+		assert(!page->on_lru_list);
+		page->hot = true;
+	}
+}
+
+static void
+_ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx, bool scan)
 {
 	assert(dev->num_lbas >= pin_ctx->lba + pin_ctx->count);
 	struct ftl_l2p_cache *cache = (struct ftl_l2p_cache *)dev->l2p;
 	struct ftl_l2p_page_set *page_set;
-	bool defer_pin = false;
+	bool defer_pin = false, prefetch = false;
 
 	/* Calculate first and last page to pin, count of them */
 	uint64_t start = pin_ctx->lba / cache->lbas_in_page;
 	uint64_t end = (pin_ctx->lba + pin_ctx->count - 1) / cache->lbas_in_page;
 	uint64_t count = end - start + 1;
+	uint64_t pf_start = 0, pf_end = 0;
 	uint64_t i;
 
 	if (spdk_unlikely(count > L2P_MAX_PAGES_TO_PIN)) {
@@ -1024,6 +1192,12 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 	}
 	ftl_l2p_cache_init_page_set(page_set, pin_ctx);
 
+	if (!scan) {
+		prefetch = prefetch_stream_update(cache, start, end, &pf_start, &pf_end);
+		/* Pages pinned by sequential streams don't get protected from eviction */
+		scan = prefetch;
+	}
+
 	struct ftl_l2p_page_wait_ctx *entry = page_set->entry;
 	for (i = start; i <= end; i++, entry++) {
 		struct ftl_l2p_page *page;
@@ -1049,8 +1223,10 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 				ftl_l2p_page_queue_wait_ctx(page, entry);
 				entry->pg_pin_issued = true;
 			}
+			ftl_l2p_cache_page_reference(dev, page, scan);
 		} else {
 			/* The page is not in the cache, queue the page_set to page in */
+			dev->stats.l2p_cache.misses++;
 			defer_pin = true;
 		}
 	}
@@ -1062,6 +1238,16 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 		TAILQ_INSERT_TAIL(&cache->deferred_page_set_list, page_set, list_entry);
 		page_set->deferred = 1;
 	}
+
+	if (prefetch) {
+		prefetch_pages(dev, cache, pf_start, pf_end);
+	}
+}
+
+void
+ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
+{
+	_ftl_l2p_cache_pin(dev, pin_ctx, false);
 }
 
 void
@@ -1229,6 +1415,11 @@ page_in_io_complete(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 	if (spdk_unlikely(!success)) {
 		ftl_bug(page->on_lru_list);
 		ftl_l2p_cache_page_remove(cache, page);
+	} else if (!page->pin_ref_cnt && !page->on_lru_list) {
+		/* Nobody waited for the page, or the waiters already unpinned it
+		 * and put it on the LRU list, make it available for eviction.
+		 */
+		ftl_l2p_cache_lru_add_page(cache, page);
 	}
 }
 
@@ -1288,6 +1479,16 @@ page_in_io_retry(void *arg)
 	page_in_io(dev, cache, page);
 }
 
+static void
+page_allocate_and_read(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache, uint64_t page_no)
+{
+	struct ftl_l2p_page *page = page_allocate(cache, page_no);
+
+	page->prefetched = true;
+	dev->stats.l2p_cache.prefetches++;
+	page_in_io(dev, cache, page);
+}
+
 static void
 page_in(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 	struct ftl_l2p_page_set *page_set, struct ftl_l2p_page_wait_ctx *pentry)
@@ -1303,6 +1504,12 @@ page_in(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache,
 		page_in = true;
 	}
 
+	/*
+	 * The page may have been read ahead since the miss was accounted. The demand pin
+	 * consumes it, so a later reference isn't counted as a prefetch hit.
+	 */
+	page->prefetched = false;
+
 	if (ftl_l2p_cache_page_is_pinnable(page)) {
 		ftl_l2p_cache_page_pin(cache, page);
 		page_set->pinned_cnt++;
@@ -1563,7 +1770,8 @@ ftl_l2p_lazy_unmap_process(struct spdk_ftl_dev *dev)
 	pin_ctx->cb = ftl_l2p_lazy_unmap_process_cb;
 	pin_ctx->cb_ctx = pin_ctx;
 
-	ftl_l2p_cache_pin(dev, pin_ctx);
+	/* Walking the unmap map is a scan, don't let it affect eviction of other pages */
+	_ftl_l2p_cache_pin(dev, pin_ctx, true);
 }
 
 void
@@ -166,6 +166,7 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 
 		TAILQ_INSERT_TAIL(&nv_cache->compactor_list, compactor, entry);
 	}
+	nv_cache->compaction_active_target = FTL_NV_CACHE_NUM_COMPACTORS;
 
 #define FTL_MAX_OPEN_CHUNKS 2
 	nv_cache->p2l_pool = ftl_mempool_create(FTL_MAX_OPEN_CHUNKS,
@@ -760,6 +761,89 @@ compaction_process_pad(struct ftl_nv_cache_compactor *compactor)
 	}
 }
 
+/*
+ * Returns the end (exclusive) of the range of blocks to be read by a compactor, starting at
+ * a valid block. The range is extended over short gaps of invalid blocks, these are skipped
+ * after the read, when checking the blocks against L2P.
+ */
+static uint64_t
+compaction_read_range_end(struct spdk_ftl_dev *dev, uint64_t begin, uint64_t limit)
+{
+	uint64_t pos = begin, clear, next;
+
+	assert(ftl_bitmap_get(dev->valid_map, begin));
+
+	while (pos < limit) {
+		clear = ftl_bitmap_find_first_clear(dev->valid_map, pos, limit - 1);
+		if (clear == UINT64_MAX) {
+			return limit;
+		}
+
+		next = ftl_bitmap_find_first_set(dev->valid_map, clear, limit - 1);
+		if (next == UINT64_MAX || next - clear > FTL_NV_CACHE_COMPACTION_MAX_GAP) {
+			return clear;
+		}
+
+		pos = next;
+	}
+
+	return limit;
+}
+
+struct ftl_nv_cache_compactor_sort_entry {
+	uint64_t lba;
+	ftl_addr addr;
+	uint64_t seq_id;
+	void *owner;
+	void *payload;
+};
+
+static int
+compaction_sort_cmp(const void *a, const void *b)
+{
+	const struct ftl_nv_cache_compactor_sort_entry *ea = a, *eb = b;
+
+	if (ea->lba < eb->lba) {
+		return -1;
+	}
+
+	return ea->lba > eb->lba;
+}
+
+/*
+ * Order blocks of the write request by LBA, so that LBA ranges which ended up scattered
+ * across the NV cache are placed contiguously on the base device. Padding entries (with
+ * invalid LBA) end up at the tail.
+ */
+static void
+compaction_sort_wr(struct ftl_nv_cache_compactor *compactor)
+{
+	struct ftl_rq *wr = compactor->wr;
+	struct ftl_nv_cache_compactor_sort_entry *sort_entry = compactor->sort_buf;
+	struct ftl_rq_entry *entry;
+	uint64_t i;
+
+	for (i = 0, entry = wr->entries; i < wr->num_blocks; i++, entry++, sort_entry++) {
+		sort_entry->lba = entry->lba;
+		sort_entry->addr = entry->addr;
+		sort_entry->seq_id = entry->seq_id;
+		sort_entry->owner = entry->owner.priv;
+		sort_entry->payload = entry->io_payload;
+	}
+
+	qsort(compactor->sort_buf, wr->num_blocks, sizeof(*compactor->sort_buf), compaction_sort_cmp);
+
+	sort_entry = compactor->sort_buf;
+	for (i = 0, entry = wr->entries; i < wr->num_blocks; i++, entry++, sort_entry++) {
+		entry->lba = sort_entry->lba;
+		entry->addr = sort_entry->addr;
+		entry->seq_id = sort_entry->seq_id;
+		entry->owner.priv = sort_entry->owner;
+		entry->io_payload = sort_entry->payload;
+		wr->io_vec[i].iov_base = sort_entry->payload;
+	}
+}
+
 static void
 compaction_process(struct ftl_nv_cache_compactor *compactor)
 {
@@ -784,6 +868,7 @@ compaction_process(struct ftl_nv_cache_compactor *compactor)
 	if (!chunk) {
 		/* No chunks to compact, pad this request */
 		compaction_process_pad(compactor);
+		compaction_sort_wr(compactor);
 		ftl_writer_queue_rq(&dev->writer_user, compactor->wr);
 		return;
 	}
@@ -814,13 +899,10 @@ compaction_process(struct ftl_nv_cache_compactor *compactor)
 		}
 	}
 
-	end = ftl_bitmap_find_first_clear(dev->valid_map, begin + 1, begin + to_read);
-	if (end != UINT64_MAX) {
-		to_read = end - begin;
-	}
-
-	addr = begin;
 	to_read = spdk_min(to_read, compactor->rd->num_blocks);
+	end = compaction_read_range_end(dev, begin, begin + to_read);
+	to_read = end - begin;
+	addr = begin;
 
 	/* Read data and metadata from NV cache */
 	rc = compaction_submit_read(compactor, addr, to_read);
@@ -966,6 +1048,7 @@ compaction_process_finish_read(struct ftl_nv_cache_compactor *compactor)
 		/*
 		 * Request contains data to be placed on FTL, compact it
 		 */
+		compaction_sort_wr(compactor);
 		ftl_writer_queue_rq(&dev->writer_user, wr);
 	} else {
 		if (is_compaction_required(compactor->nv_cache)) {
@@ -985,6 +1068,7 @@ compactor_free(struct spdk_ftl_dev *dev, struct ftl_nv_cache_compactor *compacto
 
 	ftl_rq_del(compactor->wr);
 	ftl_rq_del(compactor->rd);
+	free(compactor->sort_buf);
 	free(compactor);
 }
 
@@ -1010,6 +1094,11 @@ compactor_alloc(struct spdk_ftl_dev *dev)
 		goto error;
 	}
 
+	compactor->sort_buf = calloc(compactor->wr->num_blocks, sizeof(*compactor->sort_buf));
+	if (!compactor->sort_buf) {
+		goto error;
+	}
+
 	compactor->nv_cache = &dev->nv_cache;
 	compactor->wr->owner.priv = compactor;
 	compactor->wr->owner.cb = compaction_process_ftl_done;
@@ -1274,12 +1363,31 @@ ftl_nv_cache_set_addr(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr addr)
 	ftl_bitmap_set(dev->valid_map, addr);
 }
 
+static void
+ftl_nv_cache_compaction_target_update(struct ftl_nv_cache *nv_cache)
+{
+	if (nv_cache->throttle.blocks_submitted >= nv_cache->throttle.blocks_submitted_limit &&
+	    nv_cache->chunk_free_count < nv_cache->chunk_free_target) {
+		/* User writes were throttled, let more compactors run to catch up */
+		if (nv_cache->compaction_active_target < FTL_NV_CACHE_NUM_COMPACTORS) {
+			nv_cache->compaction_active_target++;
+		}
+	} else if (nv_cache->chunk_free_count > nv_cache->chunk_free_target) {
+		/* Compaction is ahead, leave more of the bandwidth to user IO */
+		if (nv_cache->compaction_active_target > FTL_NV_CACHE_COMPACTORS_MIN) {
+			nv_cache->compaction_active_target--;
+		}
+	}
+}
+
 static void
 ftl_nv_cache_throttle_update(struct ftl_nv_cache *nv_cache)
 {
 	double err;
 	double modifier;
 
+	ftl_nv_cache_compaction_target_update(nv_cache);
+
 	err = ((double)nv_cache->chunk_free_count - nv_cache->chunk_free_target) / nv_cache->chunk_count;
 	modifier = FTL_NV_CACHE_THROTTLE_MODIFIER_KP * err;
 
@@ -1332,7 +1440,8 @@ ftl_nv_cache_process(struct spdk_ftl_dev *dev)
 		ftl_add_io_activity(dev);
 	}
 
-	if (is_compaction_required(nv_cache) && !TAILQ_EMPTY(&nv_cache->compactor_list)) {
+	while (is_compaction_required(nv_cache) && !TAILQ_EMPTY(&nv_cache->compactor_list) &&
+	       nv_cache->compaction_active_count < nv_cache->compaction_active_target) {
 		struct ftl_nv_cache_compactor *comp =
 			TAILQ_FIRST(&nv_cache->compactor_list);
 
@@ -1668,7 +1777,7 @@ ftl_chunk_basic_rq_write(struct ftl_nv_cache_chunk *chunk, struct ftl_basic_rq *
 	_ftl_chunk_basic_rq_write(brq);
 
 	chunk->md->write_pointer += brq->num_blocks;
-	dev->stats.io_activity_total += brq->num_blocks;
+	ftl_add_io_activity_blocks(dev, brq->num_blocks);
 }
 
 static void
@@ -1698,7 +1807,7 @@ ftl_chunk_basic_rq_read(struct ftl_nv_cache_chunk *chunk, struct ftl_basic_rq *b
 			brq->io_payload, NULL, brq->io.addr, brq->num_blocks, read_brq_end, brq);
 
 	if (spdk_likely(!rc)) {
-		dev->stats.io_activity_total += brq->num_blocks;
+		ftl_add_io_activity_blocks(dev, brq->num_blocks);
 	}
 
 	return rc;
@@ -26,7 +26,19 @@
 
 #define FTL_NVC_VERSION_CURRENT FTL_NVC_VERSION_1
 
+/*
+ * Maximum number of compactors. The number of concurrently active ones is adjusted at runtime
+ * between FTL_NV_CACHE_COMPACTORS_MIN and this value, depending on whether compaction keeps up
+ * with user writes.
+ */
 #define FTL_NV_CACHE_NUM_COMPACTORS 8
+#define FTL_NV_CACHE_COMPACTORS_MIN 2
+
+/*
+ * Compaction reads span gaps of invalid blocks up to this length, trading some read bandwidth
+ * for fewer, larger IOs to the cache device.
+ */
+#define FTL_NV_CACHE_COMPACTION_MAX_GAP 8
 
 /*
  * Parameters controlling nv cache write throttling.
@@ -121,10 +133,14 @@ struct ftl_nv_cache_chunk {
 	struct ftl_md_io_entry_ctx md_persist_entry_ctx;
 };
 
+struct ftl_nv_cache_compactor_sort_entry;
+
 struct ftl_nv_cache_compactor {
 	struct ftl_nv_cache *nv_cache;
 	struct ftl_rq *wr;
 	struct ftl_rq *rd;
+	/* Scratch buffer used for ordering write request entries by LBA */
+	struct ftl_nv_cache_compactor_sort_entry *sort_buf;
 	TAILQ_ENTRY(ftl_nv_cache_compactor) entry;
 	struct spdk_bdev_io_wait_entry bdev_io_wait;
 };
@@ -191,6 +207,8 @@ struct ftl_nv_cache {
 
 	TAILQ_HEAD(, ftl_nv_cache_compactor) compactor_list;
 	uint64_t compaction_active_count;
+	/* Maximum number of compactors allowed to be active at the same time */
+	uint64_t compaction_active_target;
 	uint64_t chunk_compaction_threshold;
 
 	struct ftl_nv_cache_chunk *chunks;
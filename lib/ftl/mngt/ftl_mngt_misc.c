@@ -208,6 +208,22 @@ ftl_mngt_start_core_poller(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mn
 		return;
 	}
 
+	/*
+	 * Background work gets its own pollers, so its cost is accounted separately
+	 * from the user IO path. They share the core thread, as L2P, band and chunk
+	 * state is only ever modified from there.
+	 */
+	dev->compaction_poller = SPDK_POLLER_REGISTER(ftl_compaction_poller, dev, 0);
+	dev->reloc_poller = SPDK_POLLER_REGISTER(ftl_reloc_poller, dev, 0);
+	if (!dev->compaction_poller || !dev->reloc_poller) {
+		FTL_ERRLOG(dev, "Unable to register background pollers\n");
+		spdk_poller_unregister(&dev->compaction_poller);
+		spdk_poller_unregister(&dev->reloc_poller);
+		spdk_poller_unregister(&dev->core_poller);
+		ftl_mngt_fail_step(mngt);
+		return;
+	}
+
 	ftl_mngt_next_step(mngt);
 }
 
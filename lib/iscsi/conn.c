@@ -6,9 +6,11 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel.h"
 #include "spdk/endian.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
+#include "spdk/pipe.h"
 #include "spdk/thread.h"
 #include "spdk/queue.h"
 #include "spdk/trace.h"
@@ -34,6 +36,17 @@
 
 #define SPDK_ISCSI_CONNECTION_STATUS(status, rnstr) case(status): return(rnstr)
 
+/* Size of the per-connection receive ring. PDU headers and short data segments
+ * are received into the ring in bulk and parsed from there, so that a single
+ * recv() can feed several PDUs.
+ */
+#define ISCSI_CONN_RECV_BUF_SIZE	(32 * 1024)
+
+/* Reads at least this large bypass the receive ring and go straight to the
+ * caller's buffer once the ring is drained.
+ */
+#define ISCSI_CONN_RECV_DIRECT_LEN	1024
+
 static struct spdk_iscsi_conn *g_conns_array = NULL;
 
 static TAILQ_HEAD(, spdk_iscsi_conn) g_free_conns = TAILQ_HEAD_INITIALIZER(g_free_conns);
@@ -75,6 +88,11 @@ _free_conn(struct spdk_iscsi_conn *conn)
 	memset(conn->portal_port, 0, sizeof(conn->portal_port));
 	conn->is_valid = 0;
 
+	spdk_pipe_destroy(conn->recv_pipe);
+	conn->recv_pipe = NULL;
+	free(conn->recv_buf);
+	conn->recv_buf = NULL;
+
 	TAILQ_INSERT_TAIL(&g_free_conns, conn, conn_link);
 }
 
@@ -200,6 +218,18 @@ iscsi_conn_construct(struct spdk_iscsi_portal *portal,
 	memcpy(conn->portal_port, portal->port, strlen(portal->port));
 	conn->sock = sock;
 
+	conn->recv_buf = malloc(ISCSI_CONN_RECV_BUF_SIZE);
+	if (conn->recv_buf == NULL) {
+		SPDK_ERRLOG("Could not allocate receive buffer.\n");
+		goto error_return;
+	}
+
+	conn->recv_pipe = spdk_pipe_create(conn->recv_buf, ISCSI_CONN_RECV_BUF_SIZE);
+	if (conn->recv_pipe == NULL) {
+		SPDK_ERRLOG("Could not create receive pipe.\n");
+		goto error_return;
+	}
+
 	conn->state = ISCSI_CONN_STATE_INVALID;
 	conn->login_phase = ISCSI_SECURITY_NEGOTIATION_PHASE;
 	conn->ttt = 0;
@@ -218,6 +248,7 @@ iscsi_conn_construct(struct spdk_iscsi_portal *portal,
 
 	TAILQ_INIT(&conn->write_pdu_list);
 	TAILQ_INIT(&conn->snack_pdu_list);
+	TAILQ_INIT(&conn->queued_write_pdu_list);
 	TAILQ_INIT(&conn->queued_r2t_tasks);
 	TAILQ_INIT(&conn->active_r2t_tasks);
 	TAILQ_INIT(&conn->queued_datain_tasks);
@@ -312,12 +343,17 @@ iscsi_conn_free_tasks(struct spdk_iscsi_conn *conn)
 	 *  and may stack some PDUs to conn->write_pdu_list.  Hence when we come here, we
 	 *  have to ensure there is no associated task in conn->queued_datain_tasks.
 	 */
+	TAILQ_INIT(&conn->queued_write_pdu_list);
 	TAILQ_FOREACH_SAFE(pdu, &conn->write_pdu_list, tailq, tmp_pdu) {
+		/* Accel still reads the data of the PDU, free it once the digest is done. */
+		if (pdu->data_digest_pending) {
+			continue;
+		}
 		TAILQ_REMOVE(&conn->write_pdu_list, pdu, tailq);
 		iscsi_conn_free_pdu(conn, pdu);
 	}
 
-	if (conn->pending_task_cnt) {
+	if (conn->pending_task_cnt || conn->data_digest_cnt) {
 		return -1;
 	}
 
@@ -1268,17 +1304,12 @@ iscsi_conn_handle_nop(struct spdk_iscsi_conn *conn)
  *
  * Otherwise returns the number of bytes successfully read.
  */
-int
-iscsi_conn_read_data(struct spdk_iscsi_conn *conn, int bytes,
-		     void *buf)
+static int
+iscsi_conn_sock_readv(struct spdk_iscsi_conn *conn, struct iovec *iov, int iovcnt)
 {
 	int ret;
 
-	if (bytes == 0) {
-		return 0;
-	}
-
-	ret = spdk_sock_recv(conn->sock, buf, bytes);
+	ret = spdk_sock_readv(conn->sock, iov, iovcnt);
 
 	if (ret > 0) {
 		spdk_trace_record(TRACE_ISCSI_READ_FROM_SOCKET_DONE, conn->id, ret, 0);
@@ -1292,10 +1323,10 @@ iscsi_conn_read_data(struct spdk_iscsi_conn *conn, int bytes,
 
 		/* For connect reset issue, do not output error log */
 		if (errno == ECONNRESET) {
-			SPDK_DEBUGLOG(iscsi, "spdk_sock_recv() failed, errno %d: %s\n",
+			SPDK_DEBUGLOG(iscsi, "spdk_sock_readv() failed, errno %d: %s\n",
 				      errno, spdk_strerror(errno));
 		} else {
-			SPDK_ERRLOG("spdk_sock_recv() failed, errno %d: %s\n",
+			SPDK_ERRLOG("spdk_sock_readv() failed, errno %d: %s\n",
 				    errno, spdk_strerror(errno));
 		}
 	}
@@ -1304,12 +1335,101 @@ iscsi_conn_read_data(struct spdk_iscsi_conn *conn, int bytes,
 	return SPDK_ISCSI_CONNECTION_FATAL;
 }
 
+/* Copy as much buffered data as possible from the receive ring into iov. */
+static int
+iscsi_conn_recv_from_ring(struct spdk_iscsi_conn *conn, struct iovec *iov, int iovcnt)
+{
+	struct iovec siov[2];
+	size_t bytes;
+
+	if (spdk_pipe_reader_get_buffer(conn->recv_pipe, ISCSI_CONN_RECV_BUF_SIZE, siov) == 0) {
+		return 0;
+	}
+
+	bytes = spdk_iovcpy(siov, 2, iov, iovcnt);
+	spdk_pipe_reader_advance(conn->recv_pipe, bytes);
+
+	return bytes;
+}
+
+/* Receive into iov while the receive ring is empty. Large reads go straight
+ * to the caller's buffer. Small ones refill the ring with everything the
+ * socket has to offer, so that subsequent PDU headers and short data segments
+ * are parsed without another trip to the socket.
+ */
+static int
+iscsi_conn_recv_to_iovs(struct spdk_iscsi_conn *conn, struct iovec *iov, int iovcnt)
+{
+	struct iovec diov[2];
+	size_t len = 0;
+	int i, rc;
+
+	assert(spdk_pipe_reader_bytes_available(conn->recv_pipe) == 0);
+
+	for (i = 0; i < iovcnt; i++) {
+		len += iov[i].iov_len;
+	}
+
+	if (len >= ISCSI_CONN_RECV_DIRECT_LEN) {
+		return iscsi_conn_sock_readv(conn, iov, iovcnt);
+	}
+
+	if (spdk_pipe_writer_get_buffer(conn->recv_pipe, ISCSI_CONN_RECV_BUF_SIZE, diov) == 0) {
+		return 0;
+	}
+
+	rc = iscsi_conn_sock_readv(conn, diov, diov[1].iov_len == 0 ? 1 : 2);
+	if (rc <= 0) {
+		return rc;
+	}
+	spdk_pipe_writer_advance(conn->recv_pipe, rc);
+
+	return iscsi_conn_recv_from_ring(conn, iov, iovcnt);
+}
+
+/* Same as iscsi_conn_sock_readv(), but data buffered in the receive ring is
+ * consumed first.
+ */
+int
+iscsi_conn_read_data(struct spdk_iscsi_conn *conn, int bytes,
+		     void *buf)
+{
+	struct iovec iov;
+	int copied, rc;
+
+	if (bytes == 0) {
+		return 0;
+	}
+
+	iov.iov_base = buf;
+	iov.iov_len = bytes;
+
+	if (conn->recv_pipe == NULL) {
+		return iscsi_conn_sock_readv(conn, &iov, 1);
+	}
+
+	copied = iscsi_conn_recv_from_ring(conn, &iov, 1);
+	if (copied == bytes) {
+		return copied;
+	}
+
+	/* The ring is drained, read the rest from the socket. */
+	iov.iov_base = (uint8_t *)buf + copied;
+	iov.iov_len = bytes - copied;
+
+	rc = iscsi_conn_recv_to_iovs(conn, &iov, 1);
+	if (rc < 0) {
+		/* Report the error on the next call if some data was already copied. */
+		return copied > 0 ? copied : rc;
+	}
+
+	return copied + rc;
+}
+
 int
 iscsi_conn_readv_data(struct spdk_iscsi_conn *conn,
 		      struct iovec *iov, int iovcnt)
 {
-	int ret;
-
 	if (iov == NULL || iovcnt == 0) {
 		return 0;
 	}
@@ -1319,30 +1439,16 @@ iscsi_conn_readv_data(struct spdk_iscsi_conn *conn,
 					    iov[0].iov_base);
 	}
 
-	ret = spdk_sock_readv(conn->sock, iov, iovcnt);
-
-	if (ret > 0) {
-		spdk_trace_record(TRACE_ISCSI_READ_FROM_SOCKET_DONE, conn->id, ret, 0);
-		return ret;
+	if (conn->recv_pipe == NULL) {
+		return iscsi_conn_sock_readv(conn, iov, iovcnt);
 	}
 
-	if (ret < 0) {
-		if (errno == EAGAIN || errno == EWOULDBLOCK) {
-			return 0;
-		}
-
-		/* For connect reset issue, do not output error log */
-		if (errno == ECONNRESET) {
-			SPDK_DEBUGLOG(iscsi, "spdk_sock_readv() failed, errno %d: %s\n",
-				      errno, spdk_strerror(errno));
-		} else {
-			SPDK_ERRLOG("spdk_sock_readv() failed, errno %d: %s\n",
-				    errno, spdk_strerror(errno));
-		}
+	/* A short read is fine here, the caller picks up the rest later. */
+	if (spdk_pipe_reader_bytes_available(conn->recv_pipe) > 0) {
+		return iscsi_conn_recv_from_ring(conn, iov, iovcnt);
 	}
 
-	/* connection closed */
-	return SPDK_ISCSI_CONNECTION_FATAL;
+	return iscsi_conn_recv_to_iovs(conn, iov, iovcnt);
 }
 
 static bool
@@ -1419,12 +1525,108 @@ iscsi_conn_pdu_generic_complete(void *cb_arg)
 {
 }
 
+static void
+_iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
+						&pdu->mapped_length);
+	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
+	pdu->sock_req.cb_arg = pdu;
+
+	spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length, (uintptr_t)pdu,
+			  pdu->sock_req.iovcnt);
+	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+}
+
+/* Hand the queued PDUs to the socket in order, up to the first one whose
+ * data digest is still being computed.
+ */
+static void
+iscsi_conn_flush_queued_write_pdus(struct spdk_iscsi_conn *conn)
+{
+	struct spdk_iscsi_pdu *pdu;
+
+	while ((pdu = TAILQ_FIRST(&conn->queued_write_pdu_list)) != NULL) {
+		if (pdu->data_digest_pending) {
+			break;
+		}
+		TAILQ_REMOVE(&conn->queued_write_pdu_list, pdu, queued_link);
+		_iscsi_conn_write_pdu(conn, pdu);
+	}
+}
+
+static void
+iscsi_conn_data_digest_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+	uint32_t crc32c;
+
+	assert(conn->data_digest_cnt > 0);
+	conn->data_digest_cnt--;
+	pdu->data_digest_pending = false;
+
+	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+		/* The PDU is freed along with the rest of write_pdu_list. */
+		return;
+	}
+
+	if (spdk_likely(status == 0)) {
+		crc32c = pdu->crc32c ^ SPDK_CRC32C_XOR;
+	} else {
+		SPDK_DEBUGLOG(iscsi, "accel failed to compute data digest, rc %d\n", status);
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+	}
+	MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+
+	iscsi_conn_flush_queued_write_pdus(conn);
+}
+
+/* Padding bytes covered by the data digest */
+static uint8_t g_data_digest_pad[ISCSI_ALIGNMENT];
+
+static int
+iscsi_conn_submit_data_digest(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	uint32_t data_len = DGET24(pdu->bhs.data_segment_len);
+	uint32_t iovcnt = 1;
+	int rc;
+
+	if (conn->pg == NULL || conn->pg->accel_channel == NULL || pdu->dif_insert_or_strip ||
+	    data_len < SPDK_ISCSI_DATA_DIGEST_OFFLOAD_MIN_LEN) {
+		return -ENOTSUP;
+	}
+
+	/* pdu->iov is not used until the PDU is handed to the socket. */
+	pdu->iov[0].iov_base = pdu->data;
+	pdu->iov[0].iov_len = data_len;
+	if (ISCSI_ALIGN(data_len) != data_len) {
+		pdu->iov[1].iov_base = g_data_digest_pad;
+		pdu->iov[1].iov_len = ISCSI_ALIGN(data_len) - data_len;
+		iovcnt = 2;
+	}
+
+	pdu->data_digest_pending = true;
+	conn->data_digest_cnt++;
+
+	/* Accel starts from the inverted seed, i.e. SPDK_CRC32C_INITIAL. */
+	rc = spdk_accel_submit_crc32cv(conn->pg->accel_channel, &pdu->crc32c, pdu->iov, iovcnt,
+				       0, iscsi_conn_data_digest_done, pdu);
+	if (spdk_unlikely(rc != 0)) {
+		pdu->data_digest_pending = false;
+		conn->data_digest_cnt--;
+	}
+
+	return rc;
+}
+
 void
 iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		     iscsi_conn_xfer_complete_cb cb_fn,
 		     void *cb_arg)
 {
 	uint32_t crc32c;
+	bool data_digest = false;
 	ssize_t rc;
 
 	if (spdk_unlikely(pdu->dif_insert_or_strip)) {
@@ -1444,10 +1646,7 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		}
 
 		/* Data Digest */
-		if (conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0) {
-			crc32c = iscsi_pdu_calc_data_digest(pdu);
-			MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
-		}
+		data_digest = conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0;
 	}
 
 	pdu->cb_fn = cb_fn;
@@ -1457,14 +1656,18 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
 		return;
 	}
-	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
-						&pdu->mapped_length);
-	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
-	pdu->sock_req.cb_arg = pdu;
 
-	spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length, (uintptr_t)pdu,
-			  pdu->sock_req.iovcnt);
-	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+	/* The data digest is offloaded to accel when possible. */
+	if (data_digest && iscsi_conn_submit_data_digest(conn, pdu) != 0) {
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+		MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+	}
+
+	if (spdk_likely(!pdu->data_digest_pending && TAILQ_EMPTY(&conn->queued_write_pdu_list))) {
+		_iscsi_conn_write_pdu(conn, pdu);
+	} else {
+		TAILQ_INSERT_TAIL(&conn->queued_write_pdu_list, pdu, queued_link);
+	}
 }
 
 static void
@@ -1487,6 +1690,36 @@ iscsi_conn_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock *s
 	}
 }
 
+/* Data left in the receive ring does not make the socket readable again, so
+ * the poll group has to keep processing it explicitly. Returns true only if
+ * this made progress, so that a partial PDU waiting for the rest of its data,
+ * or a connection that can't take more PDUs yet, doesn't keep the poller busy.
+ * Like iscsi_conn_sock_cb(), buffered data of an exiting connection is ignored.
+ */
+bool
+iscsi_conn_handle_buffered_pdus(struct spdk_iscsi_conn *conn)
+{
+	uint32_t bytes;
+	int rc;
+
+	if (conn->state >= ISCSI_CONN_STATE_EXITING || conn->recv_pipe == NULL) {
+		return false;
+	}
+
+	bytes = spdk_pipe_reader_bytes_available(conn->recv_pipe);
+	if (bytes == 0) {
+		return false;
+	}
+
+	rc = iscsi_handle_incoming_pdus(conn);
+	if (rc < 0) {
+		conn->state = ISCSI_CONN_STATE_EXITING;
+		return true;
+	}
+
+	return rc > 0 || spdk_pipe_reader_bytes_available(conn->recv_pipe) != bytes;
+}
+
 static void
 iscsi_conn_full_feature_migrate(void *arg)
 {
@@ -37,6 +37,9 @@ enum iscsi_pdu_recv_state {
 	/* Active connection waiting for payload */
 	ISCSI_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD,
 
+	/* Active connection waiting for accel to verify the data digest */
+	ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST,
+
 	/* Active connection does not wait for payload */
 	ISCSI_PDU_RECV_STATE_ERROR,
 };
@@ -69,6 +72,10 @@ struct spdk_iscsi_conn {
 	struct spdk_sock		*sock;
 	struct spdk_iscsi_sess		*sess;
 
+	/* Ring that incoming PDUs are received into, see iscsi_conn_read_data() */
+	struct spdk_pipe		*recv_pipe;
+	uint8_t				*recv_buf;
+
 	enum iscsi_connection_state	state;
 	int				login_phase;
 	bool				is_logged_out;
@@ -103,6 +110,14 @@ struct spdk_iscsi_conn {
 	TAILQ_HEAD(, spdk_iscsi_pdu) write_pdu_list;
 	TAILQ_HEAD(, spdk_iscsi_pdu) snack_pdu_list;
 
+	/* PDUs which wait for their own or a preceding PDU's data digest before
+	 * being handed to the socket, so that PDUs go out in order.
+	 */
+	TAILQ_HEAD(, spdk_iscsi_pdu) queued_write_pdu_list;
+
+	/* Number of data digests in flight on accel */
+	uint32_t data_digest_cnt;
+
 	uint32_t pending_r2t;
 
 	uint16_t cid;
@@ -196,6 +211,7 @@ int iscsi_conn_abort_queued_datain_tasks(struct spdk_iscsi_conn *conn,
 int iscsi_conn_read_data(struct spdk_iscsi_conn *conn, int len, void *buf);
 int iscsi_conn_readv_data(struct spdk_iscsi_conn *conn,
 			  struct iovec *iov, int iovcnt);
+bool iscsi_conn_handle_buffered_pdus(struct spdk_iscsi_conn *conn);
 void iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 			  iscsi_conn_xfer_complete_cb cb_fn,
 			  void *cb_arg);
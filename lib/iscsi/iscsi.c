@@ -4596,6 +4596,89 @@ iscsi_pdu_payload_handle(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pd
 	return rc;
 }
 
+static int iscsi_pdu_recv_done(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu);
+
+static void
+iscsi_pdu_data_digest_check_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+	uint32_t crc32c;
+	int rc;
+
+	assert(conn->data_digest_cnt > 0);
+	conn->data_digest_cnt--;
+
+	/* Drop the reference taken for accel. If the connection is being torn
+	 * down, this frees the PDU.
+	 */
+	iscsi_put_pdu(pdu);
+	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+		return;
+	}
+
+	assert(conn->pdu_in_progress == pdu);
+	assert(conn->pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to compute data digest (%s), rc %d\n", conn->initiator_name, status);
+		goto error;
+	}
+
+	crc32c = iscsi_pdu_calc_partial_data_digest_done(pdu);
+	if (MATCH_DIGEST_WORD(pdu->data_digest, crc32c) == 0) {
+		SPDK_ERRLOG("data digest error (%s)\n", conn->initiator_name);
+		goto error;
+	}
+
+	if (iscsi_pdu_recv_done(conn, pdu) != 0) {
+		goto error;
+	}
+
+	/* Resume reading PDUs, more may have arrived in the meantime. */
+	rc = iscsi_handle_incoming_pdus(conn);
+	if (rc < 0) {
+		conn->state = ISCSI_CONN_STATE_EXITING;
+	}
+	return;
+
+error:
+	conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
+	conn->state = ISCSI_CONN_STATE_EXITING;
+}
+
+/* Offload verification of the data digest to accel. The digest of the first
+ * data buffer, if the data segment spans two, is already accumulated in
+ * pdu->crc32c and is used as the seed.
+ */
+static int
+iscsi_pdu_submit_data_digest_check(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	int rc;
+
+	if (conn->pg == NULL || conn->pg->accel_channel == NULL || pdu->dif_insert_or_strip ||
+	    pdu->data_segment_len < SPDK_ISCSI_DATA_DIGEST_OFFLOAD_MIN_LEN) {
+		return -ENOTSUP;
+	}
+
+	/* pdu->iov is used only for sending. */
+	pdu->iov[0].iov_base = pdu->data;
+	pdu->iov[0].iov_len = pdu->data_valid_bytes - pdu->data_offset;
+
+	/* Keep the data buffers alive even if the connection is torn down meanwhile. */
+	pdu->ref++;
+	conn->data_digest_cnt++;
+
+	rc = spdk_accel_submit_crc32cv(conn->pg->accel_channel, &pdu->crc32c, pdu->iov, 1,
+				       ~pdu->crc32c, iscsi_pdu_data_digest_check_done, pdu);
+	if (spdk_unlikely(rc != 0)) {
+		pdu->ref--;
+		conn->data_digest_cnt--;
+	}
+
+	return rc;
+}
+
 /* Return zero if completed to read payload, positive number if still in progress,
  * or negative number if any error.
  */
@@ -4697,6 +4780,11 @@ iscsi_pdu_payload_read(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 
 	/* check data digest */
 	if (conn->data_digest) {
+		if (iscsi_pdu_submit_data_digest_check(conn, pdu) == 0) {
+			conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST;
+			return 1;
+		}
+
 		iscsi_pdu_calc_partial_data_digest(pdu);
 		crc32c = iscsi_pdu_calc_partial_data_digest_done(pdu);
 
@@ -4710,6 +4798,30 @@ iscsi_pdu_payload_read(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
 	return 0;
 }
 
+/* All data for this PDU has now been read from the socket and verified. */
+static int
+iscsi_pdu_recv_done(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	int rc;
+
+	spdk_trace_record(TRACE_ISCSI_READ_PDU, conn->id, pdu->data_valid_bytes,
+			  (uintptr_t)pdu, pdu->bhs.opcode);
+
+	if (!pdu->is_rejected) {
+		rc = iscsi_pdu_payload_handle(conn, pdu);
+	} else {
+		rc = 0;
+	}
+	if (rc == 0) {
+		spdk_trace_record(TRACE_ISCSI_TASK_EXECUTED, 0, 0, (uintptr_t)pdu);
+		iscsi_put_pdu(pdu);
+		conn->pdu_in_progress = NULL;
+		conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
+	}
+
+	return rc;
+}
+
 static int
 iscsi_read_pdu(struct spdk_iscsi_conn *conn)
 {
@@ -4832,25 +4944,14 @@ iscsi_read_pdu(struct spdk_iscsi_conn *conn)
 				}
 			}
 
-			/* All data for this PDU has now been read from the socket. */
-			spdk_trace_record(TRACE_ISCSI_READ_PDU, conn->id, pdu->data_valid_bytes,
-					  (uintptr_t)pdu, pdu->bhs.opcode);
-
-			if (!pdu->is_rejected) {
-				rc = iscsi_pdu_payload_handle(conn, pdu);
-			} else {
-				rc = 0;
-			}
-			if (rc == 0) {
-				spdk_trace_record(TRACE_ISCSI_TASK_EXECUTED, 0, 0, (uintptr_t)pdu);
-				iscsi_put_pdu(pdu);
-				conn->pdu_in_progress = NULL;
-				conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
+			if (iscsi_pdu_recv_done(conn, pdu) == 0) {
 				return 1;
-			} else {
-				conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
 			}
+			conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_ERROR;
 			break;
+		case ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST:
+			/* iscsi_pdu_data_digest_check_done() resumes reading. */
+			return 0;
 		case ISCSI_PDU_RECV_STATE_ERROR:
 			return SPDK_ISCSI_CONNECTION_FATAL;
 		default:
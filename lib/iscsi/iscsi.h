@@ -72,6 +72,13 @@
 #define SPDK_ISCSI_MAX_BURST_LENGTH	\
 		(SPDK_ISCSI_MAX_RECV_DATA_SEGMENT_LENGTH * MAX_DATA_OUT_PER_CONNECTION)
 
+/*
+ * Data digests of shorter data segments are calculated inline. For them, an
+ *  accel round trip costs more than the CRC32C itself, and on the receive side
+ *  the connection doesn't read further PDUs until the digest is verified.
+ */
+#define SPDK_ISCSI_DATA_DIGEST_OFFLOAD_MIN_LEN	8192
+
 /*
  * Defines default maximum amount in bytes of unsolicited data the iSCSI
  *  initiator may send to the SPDK iSCSI target during the execution of
@@ -163,6 +170,7 @@ struct spdk_iscsi_pdu {
 	uint32_t data_buf_len;
 	uint32_t data_offset;
 	uint32_t crc32c;
+	bool data_digest_pending; /* data digest is being computed by accel */
 	bool dif_insert_or_strip;
 	struct spdk_dif_ctx dif_ctx;
 	struct spdk_iscsi_conn *conn;
@@ -177,6 +185,7 @@ struct spdk_iscsi_pdu {
 	struct spdk_sock_request			sock_req;
 	struct iovec					iov[SPDK_ISCSI_MAX_SGL_DESCRIPTORS];
 	TAILQ_ENTRY(spdk_iscsi_pdu)	tailq;
+	TAILQ_ENTRY(spdk_iscsi_pdu)	queued_link;
 
 
 	/*
@@ -287,6 +296,7 @@ struct spdk_iscsi_poll_group {
 	struct spdk_poller				*nop_poller;
 	STAILQ_HEAD(connections, spdk_iscsi_conn)	connections;
 	struct spdk_sock_group				*sock_group;
+	struct spdk_io_channel				*accel_channel;
 	TAILQ_ENTRY(spdk_iscsi_poll_group)		link;
 };
 
@@ -4,6 +4,7 @@
  *   All rights reserved.
  */
 
+#include "spdk/accel.h"
 #include "spdk/string.h"
 #include "spdk/likely.h"
 
@@ -968,6 +969,8 @@ iscsi_poll_group_poll(void *ctx)
 	STAILQ_FOREACH_SAFE(conn, &group->connections, pg_link, tmp) {
 		if (conn->state == ISCSI_CONN_STATE_EXITING) {
 			iscsi_conn_destruct(conn);
+		} else if (iscsi_conn_handle_buffered_pdus(conn)) {
+			rc = 1;
 		}
 	}
 
@@ -1000,6 +1003,12 @@ iscsi_poll_group_create(void *io_device, void *ctx_buf)
 	/* set the period to 1 sec */
 	pg->nop_poller = SPDK_POLLER_REGISTER(iscsi_poll_group_handle_nop, pg, 1000000);
 
+	/* Digests are calculated inline if no accel channel is available. */
+	pg->accel_channel = spdk_accel_get_io_channel();
+	if (pg->accel_channel == NULL) {
+		SPDK_ERRLOG("Failed to get accel channel, digests will not be offloaded\n");
+	}
+
 	return 0;
 }
 
@@ -1017,6 +1026,10 @@ iscsi_poll_group_destroy(void *io_device, void *ctx_buf)
 	spdk_poller_unregister(&pg->poller);
 	spdk_poller_unregister(&pg->nop_poller);
 
+	if (pg->accel_channel != NULL) {
+		spdk_put_io_channel(pg->accel_channel);
+	}
+
 	ch = spdk_io_channel_from_ctx(pg);
 	thread = spdk_io_channel_get_thread(ch);
 
@@ -20,15 +20,24 @@
 
 #include "spdk/queue.h"
 
-#define GET_IO_LOOP_COUNT		16
 #define NBD_START_BUSY_WAITING_MS	1000
 #define NBD_STOP_BUSY_WAITING_MS	10000
 #define NBD_BUSY_POLLING_INTERVAL_US	20000
 #define NBD_IO_TIMEOUT_S		60
+#define NBD_MAX_CONNECTIONS		16
+#define NBD_RECV_BUF_SIZE		(32 * 1024)
+#define NBD_IOBUF_SMALL_CACHE_SIZE	32
+#define NBD_IOBUF_LARGE_CACHE_SIZE	8
+
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN		(1 << 8)
+#endif
 
 enum nbd_io_state_t {
 	/* Receiving or ready to receive nbd request header */
 	NBD_IO_RECV_REQ = 0,
+	/* Waiting for a payload buffer */
+	NBD_IO_GET_BUF,
 	/* Receiving write payload */
 	NBD_IO_RECV_PAYLOAD,
 	/* Transmitting or ready to transmit nbd response header */
@@ -39,11 +48,17 @@ enum nbd_io_state_t {
 
 struct nbd_io {
 	struct spdk_nbd_disk	*nbd;
+	struct nbd_conn		*conn;
 	enum nbd_io_state_t	state;
 
 	void			*payload;
 	uint32_t		payload_size;
 
+	/* Buffer taken from the iobuf pool, the payload is aligned within it */
+	void			*buf;
+	uint64_t		buf_len;
+	struct spdk_iobuf_entry	iobuf;
+
 	struct nbd_request	req;
 	struct nbd_reply	resp;
 
@@ -59,29 +74,51 @@ struct nbd_io {
 	TAILQ_ENTRY(nbd_io)	tailq;
 };
 
+/* One socket connection to the kernel, the kernel maps each of them to a hardware queue. */
+struct nbd_conn {
+	struct spdk_nbd_disk	*nbd;
+	int			kernel_sp_fd;
+	int			spdk_sp_fd;
+	struct spdk_interrupt	*intr;
+
+	/*
+	 * Data read from the socket but not consumed yet. Reading as much as is available at once
+	 * allows to parse many request headers with a single read().
+	 */
+	uint8_t			*recv_buf;
+	uint32_t		recv_buf_len;
+	uint32_t		recv_buf_offset;
+
+	struct nbd_io		*io_in_recv;
+	TAILQ_HEAD(, nbd_io)	received_io_list;
+	TAILQ_HEAD(, nbd_io)	executed_io_list;
+	TAILQ_HEAD(, nbd_io)	processing_io_list;
+};
+
 struct spdk_nbd_disk {
 	struct spdk_bdev	*bdev;
 	struct spdk_bdev_desc	*bdev_desc;
 	struct spdk_io_channel	*ch;
 	int			dev_fd;
 	char			*nbd_path;
-	int			kernel_sp_fd;
-	int			spdk_sp_fd;
 	struct spdk_poller	*nbd_poller;
-	struct spdk_interrupt	*intr;
 	bool			interrupt_mode;
 	uint32_t		buf_align;
 
+	struct nbd_conn		*conns;
+	uint32_t		num_conns;
+	/* Number of connections handed over to the kernel */
+	uint32_t		num_conns_set;
+
+	/* nbd channel of the thread serving the disk, providing payload buffers */
+	struct spdk_io_channel	*nbd_ch;
+	struct spdk_iobuf_channel *iobuf_ch;
+
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
 	/* Synchronize nbd_start_kernel pthread and nbd_stop */
 	bool			has_nbd_pthread;
 
-	struct nbd_io		*io_in_recv;
-	TAILQ_HEAD(, nbd_io)	received_io_list;
-	TAILQ_HEAD(, nbd_io)	executed_io_list;
-	TAILQ_HEAD(, nbd_io)	processing_io_list;
-
 	bool			is_started;
 	bool			is_closing;
 	/* count of nbd_io in spdk_nbd_disk */
@@ -94,6 +131,10 @@ struct spdk_nbd_disk_globals {
 	TAILQ_HEAD(, spdk_nbd_disk)	disk_head;
 };
 
+struct nbd_channel {
+	struct spdk_iobuf_channel	iobuf;
+};
+
 static struct spdk_nbd_disk_globals g_spdk_nbd;
 static spdk_nbd_fini_cb g_fini_cb_fn;
 static void *g_fini_cb_arg;
@@ -101,13 +142,42 @@ static void *g_fini_cb_arg;
 static void _nbd_fini(void *arg1);
 
 static int nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io);
-static int nbd_io_recv_internal(struct spdk_nbd_disk *nbd);
+static int nbd_io_recv_internal(struct nbd_conn *conn);
+
+static int
+nbd_channel_create_cb(void *io_device, void *ctx_buf)
+{
+	struct nbd_channel *ch = ctx_buf;
+
+	return spdk_iobuf_channel_init(&ch->iobuf, "nbd", NBD_IOBUF_SMALL_CACHE_SIZE,
+				       NBD_IOBUF_LARGE_CACHE_SIZE);
+}
+
+static void
+nbd_channel_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct nbd_channel *ch = ctx_buf;
+
+	spdk_iobuf_channel_fini(&ch->iobuf);
+}
 
 int
 spdk_nbd_init(void)
 {
+	int rc;
+
 	TAILQ_INIT(&g_spdk_nbd.disk_head);
 
+	rc = spdk_iobuf_register_module("nbd");
+	if (rc != 0 && rc != -EEXIST) {
+		SPDK_ERRLOG("could not register nbd iobuf module: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+
+	/* The disks served by the same thread share the iobuf channel of that thread */
+	spdk_io_device_register(&g_spdk_nbd, nbd_channel_create_cb, nbd_channel_destroy_cb,
+				sizeof(struct nbd_channel), "nbd");
+
 	return 0;
 }
 
@@ -124,6 +194,7 @@ _nbd_fini(void *arg1)
 
 	/* Check if all nbds closed */
 	if (!TAILQ_FIRST(&g_spdk_nbd.disk_head)) {
+		spdk_io_device_unregister(&g_spdk_nbd, NULL);
 		g_fini_cb_fn(g_fini_cb_arg);
 	} else {
 		spdk_thread_send_msg(spdk_get_thread(),
@@ -210,6 +281,12 @@ nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd)
 	return spdk_bdev_get_name(nbd->bdev);
 }
 
+uint32_t
+nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd)
+{
+	return nbd->num_conns;
+}
+
 void
 spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -225,6 +302,7 @@ spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "nbd_device",  nbd_disk_get_nbd_path(nbd));
 		spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
+		spdk_json_write_named_uint32(w, "num_connections", nbd_disk_get_num_connections(nbd));
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -245,8 +323,9 @@ nbd_disconnect(struct spdk_nbd_disk *nbd)
 }
 
 static struct nbd_io *
-nbd_get_io(struct spdk_nbd_disk *nbd)
+nbd_get_io(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
 
 	io = calloc(1, sizeof(*io));
@@ -255,6 +334,7 @@ nbd_get_io(struct spdk_nbd_disk *nbd)
 	}
 
 	io->nbd = nbd;
+	io->conn = conn;
 	to_be32(&io->resp.magic, NBD_REPLY_MAGIC);
 
 	nbd->io_count++;
@@ -265,7 +345,12 @@ nbd_get_io(struct spdk_nbd_disk *nbd)
 static void
 nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 {
-	if (io->payload) {
+	if (io->buf) {
+		spdk_iobuf_put(nbd->iobuf_ch, io->buf, io->buf_len);
+	} else if (io->buf_len != 0) {
+		/* Still waiting for a buffer */
+		spdk_iobuf_entry_abort(nbd->iobuf_ch, &io->iobuf, io->buf_len);
+	} else if (io->payload) {
 		spdk_free(io->payload);
 	}
 	free(io);
@@ -283,13 +368,20 @@ nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 static int
 nbd_cleanup_io(struct spdk_nbd_disk *nbd)
 {
-	/* Try to read the remaining nbd commands in the socket */
-	while (nbd_io_recv_internal(nbd) > 0);
+	struct nbd_conn *conn;
+	uint32_t i;
 
-	/* free io_in_recv */
-	if (nbd->io_in_recv != NULL) {
-		nbd_put_io(nbd, nbd->io_in_recv);
-		nbd->io_in_recv = NULL;
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+
+		/* Try to read the remaining nbd commands in the socket */
+		while (nbd_io_recv_internal(conn) > 0);
+
+		/* free io_in_recv */
+		if (conn->io_in_recv != NULL) {
+			nbd_put_io(nbd, conn->io_in_recv);
+			conn->io_in_recv = NULL;
+		}
 	}
 
 	/*
@@ -303,27 +395,36 @@ nbd_cleanup_io(struct spdk_nbd_disk *nbd)
 	return 0;
 }
 
+static void
+nbd_conn_close(struct nbd_conn *conn)
+{
+	if (conn->intr) {
+		spdk_interrupt_unregister(&conn->intr);
+	}
+
+	if (conn->spdk_sp_fd >= 0) {
+		close(conn->spdk_sp_fd);
+		conn->spdk_sp_fd = -1;
+	}
+
+	if (conn->kernel_sp_fd >= 0) {
+		close(conn->kernel_sp_fd);
+		conn->kernel_sp_fd = -1;
+	}
+}
+
 static int
 _nbd_stop(void *arg)
 {
 	struct spdk_nbd_disk *nbd = arg;
+	uint32_t i;
 
 	if (nbd->nbd_poller) {
 		spdk_poller_unregister(&nbd->nbd_poller);
 	}
 
-	if (nbd->intr) {
-		spdk_interrupt_unregister(&nbd->intr);
-	}
-
-	if (nbd->spdk_sp_fd >= 0) {
-		close(nbd->spdk_sp_fd);
-		nbd->spdk_sp_fd = -1;
-	}
-
-	if (nbd->kernel_sp_fd >= 0) {
-		close(nbd->kernel_sp_fd);
-		nbd->kernel_sp_fd = -1;
+	for (i = 0; i < nbd->num_conns; i++) {
+		nbd_conn_close(&nbd->conns[i]);
 	}
 
 	/* Continue the stop procedure after the exit of nbd_start_kernel pthread */
@@ -364,6 +465,19 @@ _nbd_stop(void *arg)
 		nbd->ch = NULL;
 	}
 
+	for (i = 0; i < nbd->num_conns; i++) {
+		if (nbd->conns[i].io_in_recv != NULL) {
+			nbd_put_io(nbd, nbd->conns[i].io_in_recv);
+		}
+		free(nbd->conns[i].recv_buf);
+	}
+	free(nbd->conns);
+
+	if (nbd->nbd_ch) {
+		spdk_put_io_channel(nbd->nbd_ch);
+		nbd->nbd_ch = NULL;
+	}
+
 	if (nbd->bdev_desc) {
 		spdk_bdev_close(nbd->bdev_desc);
 		nbd->bdev_desc = NULL;
@@ -431,6 +545,7 @@ static void
 nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct nbd_io	*io = cb_arg;
+	struct nbd_conn *conn = io->conn;
 	struct spdk_nbd_disk *nbd = io->nbd;
 
 	if (success) {
@@ -444,12 +559,12 @@ nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	/* When there begins to have executed_io, enable socket writable notice in order to
 	 * get it processed in nbd_io_xmit
 	 */
-	if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	if (nbd->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 	}
 
-	TAILQ_REMOVE(&nbd->processing_io_list, io, tailq);
-	TAILQ_INSERT_TAIL(&nbd->executed_io_list, io, tailq);
+	TAILQ_REMOVE(&conn->processing_io_list, io, tailq);
+	TAILQ_INSERT_TAIL(&conn->executed_io_list, io, tailq);
 
 	if (bdev_io != NULL) {
 		spdk_bdev_free_io(bdev_io);
@@ -534,16 +649,17 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 }
 
 static int
-nbd_io_exec(struct spdk_nbd_disk *nbd)
+nbd_io_exec(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io, *io_tmp;
 	int io_count = 0;
 	int ret = 0;
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 			ret = nbd_submit_bdev_io(nbd, io);
 			if (ret < 0) {
 				return ret;
@@ -556,28 +672,114 @@ nbd_io_exec(struct spdk_nbd_disk *nbd)
 	return io_count;
 }
 
+/*
+ * Read from the socket through the receive buffer of the connection. Data that doesn't fit in
+ * the buffer, i.e. large write payloads, is read directly into the destination instead.
+ */
+static int64_t
+nbd_conn_read(struct nbd_conn *conn, void *buf, size_t length)
+{
+	int64_t rc;
+	uint32_t len;
+
+	if (conn->recv_buf_offset == conn->recv_buf_len) {
+		if (length >= NBD_RECV_BUF_SIZE) {
+			return nbd_socket_rw(conn->spdk_sp_fd, buf, length, true);
+		}
+
+		rc = nbd_socket_rw(conn->spdk_sp_fd, conn->recv_buf, NBD_RECV_BUF_SIZE, true);
+		if (rc <= 0) {
+			return rc;
+		}
+		conn->recv_buf_offset = 0;
+		conn->recv_buf_len = rc;
+	}
+
+	len = spdk_min(length, conn->recv_buf_len - conn->recv_buf_offset);
+	memcpy(buf, conn->recv_buf + conn->recv_buf_offset, len);
+	conn->recv_buf_offset += len;
+
+	return len;
+}
+
+static void
+nbd_io_get_buf_cb(struct spdk_iobuf_entry *entry, void *buf)
+{
+	struct nbd_io *io = SPDK_CONTAINEROF(entry, struct nbd_io, iobuf);
+	struct spdk_nbd_disk *nbd = io->nbd;
+
+	io->buf = buf;
+	io->payload = (void *)(uintptr_t)SPDK_ALIGN_CEIL((uintptr_t)buf, nbd->buf_align);
+
+	/* Receiving on the connection is paused, make sure it is polled again */
+	if (nbd->interrupt_mode) {
+		spdk_interrupt_set_event_types(io->conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	}
+}
+
+static int
+nbd_io_get_payload(struct nbd_io *io)
+{
+	struct spdk_nbd_disk *nbd = io->nbd;
+	void *buf;
+
+	if (io->payload_size + nbd->buf_align <= nbd->iobuf_ch->large.bufsize) {
+		io->buf_len = io->payload_size + nbd->buf_align;
+		buf = spdk_iobuf_get(nbd->iobuf_ch, io->buf_len, &io->iobuf, nbd_io_get_buf_cb);
+		if (buf != NULL) {
+			nbd_io_get_buf_cb(&io->iobuf, buf);
+		}
+		return 0;
+	}
+
+	/* The kernel may send requests larger than the iobuf buffers */
+	io->payload = spdk_malloc(io->payload_size, nbd->buf_align, NULL,
+				  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (io->payload == NULL) {
+		SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+nbd_io_received(struct nbd_conn *conn, struct nbd_io *io)
+{
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	io->state = NBD_IO_XMIT_RESP;
+	if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
+		TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
+	} else {
+		TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+		nbd_io_done(NULL, false, io);
+	}
+	conn->io_in_recv = NULL;
+}
+
 static int
-nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
+nbd_io_recv_internal(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
 	int ret = 0;
 	int received = 0;
 
-	if (nbd->io_in_recv == NULL) {
-		nbd->io_in_recv = nbd_get_io(nbd);
-		if (!nbd->io_in_recv) {
+	if (conn->io_in_recv == NULL) {
+		conn->io_in_recv = nbd_get_io(conn);
+		if (!conn->io_in_recv) {
 			return -ENOMEM;
 		}
 	}
 
-	io = nbd->io_in_recv;
+	io = conn->io_in_recv;
 
 	if (io->state == NBD_IO_RECV_REQ) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->req + io->offset,
-				    sizeof(io->req) - io->offset, true);
+		ret = nbd_conn_read(conn, (char *)&io->req + io->offset, sizeof(io->req) - io->offset);
 		if (ret < 0) {
 			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -592,15 +794,15 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			if (from_be32(&io->req.magic) != NBD_REQUEST_MAGIC) {
 				SPDK_ERRLOG("invalid request magic\n");
 				nbd_put_io(nbd, io);
-				nbd->io_in_recv = NULL;
+				conn->io_in_recv = NULL;
 				return -EINVAL;
 			}
 
 			if (from_be32(&io->req.type) == NBD_CMD_DISC) {
 				nbd->is_closing = true;
-				nbd->io_in_recv = NULL;
-				if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-					spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+				conn->io_in_recv = NULL;
+				if (nbd->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+					spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 				}
 				nbd_put_io(nbd, io);
 				/* After receiving NBD_CMD_DISC, nbd will not receive any new commands */
@@ -617,39 +819,40 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 
 			/* io payload allocate */
 			if (io->payload_size) {
-				io->payload = spdk_malloc(io->payload_size, nbd->buf_align, NULL,
-							  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-				if (io->payload == NULL) {
-					SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
+				ret = nbd_io_get_payload(io);
+				if (ret < 0) {
 					nbd_put_io(nbd, io);
-					nbd->io_in_recv = NULL;
-					return -ENOMEM;
+					conn->io_in_recv = NULL;
+					return ret;
 				}
 			} else {
 				io->payload = NULL;
 			}
 
-			/* next io step */
-			if (from_be32(&io->req.type) == NBD_CMD_WRITE) {
-				io->state = NBD_IO_RECV_PAYLOAD;
-			} else {
-				io->state = NBD_IO_XMIT_RESP;
-				if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-					TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
-				} else {
-					TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-					nbd_io_done(NULL, false, io);
-				}
-				nbd->io_in_recv = NULL;
-			}
+			io->state = NBD_IO_GET_BUF;
+		}
+	}
+
+	if (io->state == NBD_IO_GET_BUF) {
+		/* Receiving on this connection resumes once a buffer is released */
+		if (io->payload_size && io->payload == NULL) {
+			return received;
+		}
+
+		/* next io step */
+		if (from_be32(&io->req.type) == NBD_CMD_WRITE) {
+			io->state = NBD_IO_RECV_PAYLOAD;
+		} else {
+			nbd_io_received(conn, io);
+			return received;
 		}
 	}
 
 	if (io->state == NBD_IO_RECV_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset, true);
+		ret = nbd_conn_read(conn, io->payload + io->offset, io->payload_size - io->offset);
 		if (ret < 0) {
 			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -659,14 +862,7 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 		/* request payload is fully received */
 		if (io->offset == io->payload_size) {
 			io->offset = 0;
-			io->state = NBD_IO_XMIT_RESP;
-			if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-				TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
-			} else {
-				TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-				nbd_io_done(NULL, false, io);
-			}
-			nbd->io_in_recv = NULL;
+			nbd_io_received(conn, io);
 		}
 
 	}
@@ -675,9 +871,10 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 }
 
 static int
-nbd_io_recv(struct spdk_nbd_disk *nbd)
+nbd_io_recv(struct nbd_conn *conn)
 {
-	int i, rc, ret = 0;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+	int rc, ret = 0;
 
 	/*
 	 * nbd server should not accept request after closing command
@@ -686,28 +883,30 @@ nbd_io_recv(struct spdk_nbd_disk *nbd)
 		return 0;
 	}
 
-	for (i = 0; i < GET_IO_LOOP_COUNT; i++) {
-		rc = nbd_io_recv_internal(nbd);
+	/*
+	 * Keep parsing until the socket is drained, so that no request is left behind in the
+	 * receive buffer without the socket being readable.
+	 */
+	do {
+		rc = nbd_io_recv_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
 		ret += rc;
-		if (nbd->is_closing) {
-			break;
-		}
-	}
+	} while (rc > 0 && !nbd->is_closing);
 
 	return ret;
 }
 
 static int
-nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
+nbd_io_xmit_internal(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
 	int ret = 0;
 	int sent = 0;
 
-	io = TAILQ_FIRST(&nbd->executed_io_list);
+	io = TAILQ_FIRST(&conn->executed_io_list);
 	if (io == NULL) {
 		return 0;
 	}
@@ -716,12 +915,12 @@ nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
 	 *  back to the head if it cannot be completed.  This approach is specifically
 	 *  taken to work around a scan-build use-after-free mischaracterization.
 	 */
-	TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
+	TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
 
 	/* resp error and handler are already set in io_done */
 
 	if (io->state == NBD_IO_XMIT_RESP) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->resp + io->offset,
+		ret = nbd_socket_rw(conn->spdk_sp_fd, (char *)&io->resp + io->offset,
 				    sizeof(io->resp) - io->offset, false);
 		if (ret <= 0) {
 			goto reinsert;
@@ -745,7 +944,7 @@ nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
 	}
 
 	if (io->state == NBD_IO_XMIT_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset,
+		ret = nbd_socket_rw(conn->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset,
 				    false);
 		if (ret <= 0) {
 			goto reinsert;
@@ -762,18 +961,18 @@ nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
 	}
 
 reinsert:
-	TAILQ_INSERT_HEAD(&nbd->executed_io_list, io, tailq);
+	TAILQ_INSERT_HEAD(&conn->executed_io_list, io, tailq);
 	return ret < 0 ? ret : sent;
 }
 
 static int
-nbd_io_xmit(struct spdk_nbd_disk *nbd)
+nbd_io_xmit(struct nbd_conn *conn)
 {
 	int ret = 0;
 	int rc;
 
-	while (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		rc = nbd_io_xmit_internal(nbd);
+	while (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		rc = nbd_io_xmit_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
@@ -782,8 +981,8 @@ nbd_io_xmit(struct spdk_nbd_disk *nbd)
 	}
 
 	/* When there begins to have no executed_io, disable socket writable notice */
-	if (nbd->interrupt_mode) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN);
+	if (conn->nbd->interrupt_mode) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN);
 	}
 
 	return ret;
@@ -795,22 +994,22 @@ nbd_io_xmit(struct spdk_nbd_disk *nbd)
  * \return 0 on success or negated errno values on error (e.g. connection closed).
  */
 static int
-_nbd_poll(struct spdk_nbd_disk *nbd)
+_nbd_poll_conn(struct nbd_conn *conn)
 {
 	int received, sent, executed;
 
 	/* transmit executed io first */
-	sent = nbd_io_xmit(nbd);
+	sent = nbd_io_xmit(conn);
 	if (sent < 0) {
 		return sent;
 	}
 
-	received = nbd_io_recv(nbd);
+	received = nbd_io_recv(conn);
 	if (received < 0) {
 		return received;
 	}
 
-	executed = nbd_io_exec(nbd);
+	executed = nbd_io_exec(conn);
 	if (executed < 0) {
 		return executed;
 	}
@@ -818,6 +1017,23 @@ _nbd_poll(struct spdk_nbd_disk *nbd)
 	return sent + received + executed;
 }
 
+static int
+_nbd_poll(struct spdk_nbd_disk *nbd)
+{
+	int rc, count = 0;
+	uint32_t i;
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		rc = _nbd_poll_conn(&nbd->conns[i]);
+		if (rc < 0) {
+			return rc;
+		}
+		count += rc;
+	}
+
+	return count;
+}
+
 static int
 nbd_poll(void *arg)
 {
@@ -856,20 +1072,25 @@ nbd_start_kernel(void *arg)
 static void
 nbd_bdev_hot_remove(struct spdk_nbd_disk *nbd)
 {
+	struct nbd_conn *conn;
 	struct nbd_io *io, *io_tmp;
+	uint32_t i;
 
 	nbd->is_closing = true;
 	nbd_cleanup_io(nbd);
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		if (!TAILQ_EMPTY(&conn->received_io_list)) {
+			TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+				TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+				TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+			}
 		}
-	}
-	if (!TAILQ_EMPTY(&nbd->processing_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->processing_io_list, tailq, io_tmp) {
-			nbd_io_done(NULL, false, io);
+		if (!TAILQ_EMPTY(&conn->processing_io_list)) {
+			TAILQ_FOREACH_SAFE(io, &conn->processing_io_list, tailq, io_tmp) {
+				nbd_io_done(NULL, false, io);
+			}
 		}
 	}
 }
@@ -908,6 +1129,7 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	int		rc;
 	pthread_t	tid;
 	unsigned long	nbd_flags = 0;
+	uint32_t	i;
 
 	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_BLKSIZE, spdk_bdev_get_block_size(ctx->nbd->bdev));
 	if (rc == -1) {
@@ -944,6 +1166,12 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		nbd_flags |= NBD_FLAG_SEND_TRIM;
 	}
 #endif
+	/* The kernel refuses to use several connections unless the server announces it.
+	 * Flushes are served by the bdev, so they cover the writes completed on any connection.
+	 */
+	if (ctx->nbd->num_conns > 1) {
+		nbd_flags |= NBD_FLAG_CAN_MULTI_CONN;
+	}
 
 	if (nbd_flags) {
 		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
@@ -971,7 +1199,10 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	}
 
 	if (spdk_interrupt_mode_is_enabled()) {
-		ctx->nbd->intr = SPDK_INTERRUPT_REGISTER(ctx->nbd->spdk_sp_fd, nbd_poll, ctx->nbd);
+		for (i = 0; i < ctx->nbd->num_conns; i++) {
+			ctx->nbd->conns[i].intr = SPDK_INTERRUPT_REGISTER(ctx->nbd->conns[i].spdk_sp_fd,
+						  nbd_poll, ctx->nbd);
+		}
 	}
 
 	ctx->nbd->nbd_poller = SPDK_POLLER_REGISTER(nbd_poll, ctx->nbd, 0);
@@ -999,10 +1230,19 @@ static int
 nbd_enable_kernel(void *arg)
 {
 	struct spdk_nbd_start_ctx *ctx = arg;
-	int rc;
+	struct spdk_nbd_disk *nbd = ctx->nbd;
+	int rc = 0;
 
-	/* Declare device setup by this process */
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->kernel_sp_fd);
+	/* Declare device setup by this process, handing over one socket per connection.
+	 * The sockets already set are kept when retrying.
+	 */
+	while (nbd->num_conns_set < nbd->num_conns) {
+		rc = ioctl(nbd->dev_fd, NBD_SET_SOCK, nbd->conns[nbd->num_conns_set].kernel_sp_fd);
+		if (rc) {
+			break;
+		}
+		nbd->num_conns_set++;
+	}
 
 	if (rc) {
 		if (errno == EBUSY) {
@@ -1044,15 +1284,73 @@ nbd_enable_kernel(void *arg)
 	return SPDK_POLLER_BUSY;
 }
 
+static int
+nbd_conns_init(struct spdk_nbd_disk *nbd, uint32_t num_conns)
+{
+	struct nbd_conn *conn;
+	uint32_t i;
+	int sp[2];
+	int rc;
+
+	nbd->conns = calloc(num_conns, sizeof(*nbd->conns));
+	if (nbd->conns == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_conns; i++) {
+		conn = &nbd->conns[i];
+		conn->nbd = nbd;
+		conn->spdk_sp_fd = -1;
+		conn->kernel_sp_fd = -1;
+		TAILQ_INIT(&conn->received_io_list);
+		TAILQ_INIT(&conn->executed_io_list);
+		TAILQ_INIT(&conn->processing_io_list);
+	}
+	nbd->num_conns = num_conns;
+
+	for (i = 0; i < num_conns; i++) {
+		conn = &nbd->conns[i];
+
+		conn->recv_buf = malloc(NBD_RECV_BUF_SIZE);
+		if (conn->recv_buf == NULL) {
+			return -ENOMEM;
+		}
+
+		rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
+		if (rc != 0) {
+			SPDK_ERRLOG("socketpair failed\n");
+			return -errno;
+		}
+
+		conn->spdk_sp_fd = sp[0];
+		conn->kernel_sp_fd = sp[1];
+	}
+
+	return 0;
+}
+
 void
 spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+{
+	spdk_nbd_start_ext(bdev_name, nbd_path, 1, cb_fn, cb_arg);
+}
+
+void
+spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+		   spdk_nbd_start_cb cb_fn, void *cb_arg)
 {
 	struct spdk_nbd_start_ctx	*ctx = NULL;
 	struct spdk_nbd_disk		*nbd = NULL;
 	struct spdk_bdev		*bdev;
+	struct nbd_channel		*nbd_ch;
 	int				rc;
-	int				sp[2];
+
+	if (num_connections == 0 || num_connections > NBD_MAX_CONNECTIONS) {
+		SPDK_ERRLOG("number of connections must be between 1 and %d\n", NBD_MAX_CONNECTIONS);
+		rc = -EINVAL;
+		goto err;
+	}
 
 	nbd = calloc(1, sizeof(*nbd));
 	if (nbd == NULL) {
@@ -1061,8 +1359,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	}
 
 	nbd->dev_fd = -1;
-	nbd->spdk_sp_fd = -1;
-	nbd->kernel_sp_fd = -1;
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1086,15 +1382,20 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	nbd->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
 	nbd->buf_align = spdk_max(spdk_bdev_get_buf_align(bdev), 64);
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
+	nbd->nbd_ch = spdk_get_io_channel(&g_spdk_nbd);
+	if (nbd->nbd_ch == NULL) {
+		SPDK_ERRLOG("could not get nbd channel\n");
+		rc = -ENOMEM;
+		goto err;
+	}
+	nbd_ch = spdk_io_channel_get_ctx(nbd->nbd_ch);
+	nbd->iobuf_ch = &nbd_ch->iobuf;
+
+	rc = nbd_conns_init(nbd, num_connections);
 	if (rc != 0) {
-		SPDK_ERRLOG("socketpair failed\n");
-		rc = -errno;
 		goto err;
 	}
 
-	nbd->spdk_sp_fd = sp[0];
-	nbd->kernel_sp_fd = sp[1];
 	nbd->nbd_path = strdup(nbd_path);
 	if (!nbd->nbd_path) {
 		SPDK_ERRLOG("strdup allocation failure\n");
@@ -1102,10 +1403,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	TAILQ_INIT(&nbd->received_io_list);
-	TAILQ_INIT(&nbd->executed_io_list);
-	TAILQ_INIT(&nbd->processing_io_list);
-
 	/* Add nbd_disk to the end of disk list */
 	rc = nbd_disk_register(ctx->nbd);
 	if (rc != 0) {
@@ -1119,8 +1416,8 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s\n",
-		     bdev_name, nbd_path);
+	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s with %u connection(s)\n",
+		     bdev_name, nbd_path, num_connections);
 
 	nbd_enable_kernel(ctx);
 	return;
@@ -19,6 +19,8 @@ const char *nbd_disk_get_nbd_path(struct spdk_nbd_disk *nbd);
 
 const char *nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd);
 
+uint32_t nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd);
+
 void nbd_disconnect(struct spdk_nbd_disk *nbd);
 
 #endif /* SPDK_NBD_INTERNAL_H */
@@ -16,6 +16,7 @@
 struct rpc_nbd_start_disk {
 	char *bdev_name;
 	char *nbd_device;
+	uint32_t num_connections;
 	/* Used to search one available nbd device */
 	int nbd_idx;
 	bool nbd_idx_specified;
@@ -33,6 +34,7 @@ free_rpc_nbd_start_disk(struct rpc_nbd_start_disk *req)
 static const struct spdk_json_object_decoder rpc_nbd_start_disk_decoders[] = {
 	{"bdev_name", offsetof(struct rpc_nbd_start_disk, bdev_name), spdk_json_decode_string},
 	{"nbd_device", offsetof(struct rpc_nbd_start_disk, nbd_device), spdk_json_decode_string, true},
+	{"num_connections", offsetof(struct rpc_nbd_start_disk, num_connections), spdk_json_decode_uint32, true},
 };
 
 /* Return 0 to indicate the nbd_device might be available,
@@ -120,8 +122,8 @@ rpc_start_nbd_done(void *cb_arg, struct spdk_nbd_disk *nbd, int rc)
 
 		req->nbd_device = find_available_nbd_disk(req->nbd_idx, &req->nbd_idx);
 		if (req->nbd_device != NULL) {
-			spdk_nbd_start(req->bdev_name, req->nbd_device,
-				       rpc_start_nbd_done, req);
+			spdk_nbd_start_ext(req->bdev_name, req->nbd_device, req->num_connections,
+					   rpc_start_nbd_done, req);
 			return;
 		}
 
@@ -155,6 +157,8 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
+	req->num_connections = 1;
+
 	if (spdk_json_decode_object(params, rpc_nbd_start_disk_decoders,
 				    SPDK_COUNTOF(rpc_nbd_start_disk_decoders),
 				    req)) {
@@ -195,8 +199,8 @@ rpc_nbd_start_disk(struct spdk_jsonrpc_request *request,
 	}
 
 	req->request = request;
-	spdk_nbd_start(req->bdev_name, req->nbd_device,
-		       rpc_start_nbd_done, req);
+	spdk_nbd_start_ext(req->bdev_name, req->nbd_device, req->num_connections,
+			   rpc_start_nbd_done, req);
 
 	return;
 
@@ -319,6 +323,8 @@ rpc_dump_nbd_info(struct spdk_json_write_ctx *w,
 
 	spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
 
+	spdk_json_write_named_uint32(w, "num_connections", nbd_disk_get_num_connections(nbd));
+
 	spdk_json_write_object_end(w);
 }
 
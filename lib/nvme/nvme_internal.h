@@ -272,6 +272,13 @@ struct nvme_error_cmd {
 };
 
 struct nvme_request {
+	/*
+	 * The command occupies the whole first cache line.  The second one holds everything the
+	 * completion path reads or writes, so that completing a request only touches a single
+	 * cache line of it.  The payload descriptor doesn't fit there: it's written by
+	 * NVME_INIT_REQUEST() and read by the transports when the request is submitted, so
+	 * allocation and submission touch the third cache line as well.
+	 */
 	struct spdk_nvme_cmd		cmd;
 
 	uint8_t				retries;
@@ -297,18 +304,19 @@ struct nvme_request {
 	uint32_t			payload_offset;
 	uint32_t			md_offset;
 
-	uint32_t			payload_size;
-
-	/**
-	 * Timeout ticks for error injection requests, can be extended in future
-	 * to support per-request timeout feature.
+	/*
+	 * All of the members above are zeroed when a request is allocated, so payload_size must
+	 * stay the first one that isn't.
 	 */
-	uint64_t			timeout_tsc;
+	uint32_t			payload_size;
+	uint32_t			md_size;
 
 	/**
-	 * Data payload for this request's command.
+	 * The active admin request can be moved to a per process pending
+	 *  list based on the saved pid to tell which process it belongs
+	 *  to.
 	 */
-	struct nvme_payload		payload;
+	pid_t				pid;
 
 	spdk_nvme_cmd_cb		cb_fn;
 	void				*cb_arg;
@@ -323,16 +331,22 @@ struct nvme_request {
 	uint64_t			submit_tick;
 
 	/**
-	 * The active admin request can be moved to a per process pending
-	 *  list based on the saved pid to tell which process it belongs
-	 *  to. The cpl saves the original completion information which
-	 *  is used in the completion callback.
-	 * NOTE: these below two fields are only used for admin request.
+	 * Data payload for this request's command.
 	 */
-	pid_t				pid;
-	struct spdk_nvme_cpl		cpl;
+	struct nvme_payload		payload;
 
-	uint32_t			md_size;
+	/**
+	 * Timeout ticks for error injection requests, can be extended in future
+	 * to support per-request timeout feature.
+	 */
+	uint64_t			timeout_tsc;
+
+	/**
+	 * The cpl saves the original completion information of an admin request
+	 *  completed on behalf of another process.  It is used in the completion
+	 *  callback.
+	 */
+	struct spdk_nvme_cpl		cpl;
 
 	/**
 	 * The following members should not be reordered with members
@@ -377,6 +391,18 @@ struct nvme_request {
 	void				*user_cb_arg;
 	void				*user_buffer;
 };
+SPDK_STATIC_ASSERT(offsetof(struct nvme_request, retries) == 64,
+		   "nvme_request's command must fill the first cache line");
+SPDK_STATIC_ASSERT(offsetof(struct nvme_request, submit_tick) + sizeof(uint64_t) <= 128,
+		   "nvme_request's completion fields must fit in its second cache line");
+
+/* Buffer region registered with a qpair to speed up its address translation */
+struct nvme_buf_region {
+	uintptr_t	vaddr;
+	size_t		len;
+	/* Physical address of each 2MB page spanned by the region, NULL if the slot is free */
+	uint64_t	*phys;
+};
 
 struct nvme_completion_poll_status {
 	struct spdk_nvme_cpl	cpl;
@@ -479,6 +505,10 @@ struct spdk_nvme_qpair {
 	STAILQ_HEAD(, nvme_request)		aborting_queued_req;
 
 	void					*req_buf;
+
+	/* Buffer regions registered via spdk_nvme_qpair_register_buffer(), indexed by handle - 1 */
+	struct nvme_buf_region			*buf_regions;
+	uint32_t				num_buf_regions;
 };
 
 struct spdk_nvme_poll_group {
@@ -1405,6 +1435,64 @@ nvme_qpair_free_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
 	req->qpair->num_outstanding_reqs--;
 }
 
+/*
+ * Returns the registered buffer region referred to by the request's extended I/O options, or
+ * NULL if there's none.
+ */
+static inline const struct nvme_buf_region *
+nvme_request_get_buf_region(const struct nvme_request *req)
+{
+	const struct spdk_nvme_ns_cmd_ext_io_opts *opts = req->payload.opts;
+	const struct nvme_buf_region *region;
+	uint32_t handle;
+
+	if (spdk_likely(opts == NULL) ||
+	    opts->size < offsetof(struct spdk_nvme_ns_cmd_ext_io_opts, buf_handle) +
+	    sizeof(opts->buf_handle)) {
+		return NULL;
+	}
+
+	handle = opts->buf_handle;
+	if (handle == 0 || handle > req->qpair->num_buf_regions) {
+		return NULL;
+	}
+
+	region = &req->qpair->buf_regions[handle - 1];
+
+	return region->phys != NULL ? region : NULL;
+}
+
+/*
+ * Translates an address within a registered buffer region.  Returns SPDK_VTOPHYS_ERROR if the
+ * address is outside of the region.  Like spdk_vtophys(), if size is not NULL, it's updated to
+ * the number of physically contiguous bytes (up to its original value) starting at the address.
+ */
+static inline uint64_t
+nvme_buf_region_translate(const struct nvme_buf_region *region, const void *buf, uint64_t *size)
+{
+	uintptr_t vaddr = (uintptr_t)buf;
+	uint64_t len, remaining;
+	size_t page, i;
+
+	if (vaddr < region->vaddr || vaddr - region->vaddr >= region->len) {
+		return SPDK_VTOPHYS_ERROR;
+	}
+
+	page = (vaddr >> SHIFT_2MB) - (region->vaddr >> SHIFT_2MB);
+	if (size != NULL) {
+		remaining = region->vaddr + region->len - vaddr;
+		len = VALUE_2MB - _2MB_OFFSET(vaddr);
+		for (i = page; len < *size && len < remaining; i++, len += VALUE_2MB) {
+			if (region->phys[i + 1] != region->phys[i] + VALUE_2MB) {
+				break;
+			}
+		}
+		*size = spdk_min(*size, spdk_min(len, remaining));
+	}
+
+	return region->phys[page] + _2MB_OFFSET(vaddr);
+}
+
 static inline void
 nvme_request_remove_child(struct nvme_request *parent, struct nvme_request *child)
 {
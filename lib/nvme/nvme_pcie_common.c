@@ -35,6 +35,26 @@ nvme_pcie_vtophys(struct spdk_nvme_ctrlr *ctrlr, const void *buf, uint64_t *size
 	}
 }
 
+/*
+ * Translate a payload address, using the request's registered buffer region if there's one and
+ * falling back to the memory map for addresses outside of it.
+ */
+static inline uint64_t
+nvme_pcie_payload_vtophys(struct spdk_nvme_ctrlr *ctrlr, const struct nvme_buf_region *region,
+			  const void *buf, uint64_t *size)
+{
+	uint64_t phys_addr;
+
+	if (region != NULL && spdk_likely(ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_PCIE)) {
+		phys_addr = nvme_buf_region_translate(region, buf, size);
+		if (spdk_likely(phys_addr != SPDK_VTOPHYS_ERROR)) {
+			return phys_addr;
+		}
+	}
+
+	return nvme_pcie_vtophys(ctrlr, buf, size);
+}
+
 int
 nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 {
@@ -43,6 +63,7 @@ nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 
 	/* all head/tail vals are set to 0 */
 	pqpair->last_sq_tail = pqpair->sq_tail = pqpair->sq_head = pqpair->cq_head = 0;
+	pqpair->flags.cq_doorbell_pending = 0;
 
 	/*
 	 * First time through the completion queue, HW will set phase
@@ -661,6 +682,11 @@ nvme_pcie_qpair_submit_tracker(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 		SPDK_ERRLOG("sq_tail is passing sq_head!\n");
 	}
 
+	if (nvme_pcie_qpair_defer_doorbells(qpair)) {
+		/* The doorbell is rung once the poll group is done processing completions */
+		return;
+	}
+
 	if (!pqpair->flags.delay_cmd_submit) {
 		nvme_pcie_qpair_ring_sq_doorbell(qpair);
 	}
@@ -946,15 +972,19 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 
 	if (num_completions > 0) {
 		pqpair->stat->completions += num_completions;
-		nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		if (nvme_pcie_qpair_defer_doorbells(qpair)) {
+			pqpair->flags.cq_doorbell_pending = 1;
+		} else {
+			nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		}
 	} else {
 		pqpair->stat->idle_polls++;
 	}
 
 	if (pqpair->flags.delay_cmd_submit) {
-		if (pqpair->last_sq_tail != pqpair->sq_tail) {
+		if (pqpair->last_sq_tail != pqpair->sq_tail &&
+		    !nvme_pcie_qpair_defer_doorbells(qpair)) {
 			nvme_pcie_qpair_ring_sq_doorbell(qpair);
-			pqpair->last_sq_tail = pqpair->sq_tail;
 		}
 	}
 
@@ -1200,6 +1230,7 @@ nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr
 			  uint32_t page_size)
 {
 	struct spdk_nvme_cmd *cmd = &tr->req->cmd;
+	const struct nvme_buf_region *region = nvme_request_get_buf_region(tr->req);
 	uintptr_t page_mask = page_size - 1;
 	uint64_t phys_addr;
 	uint32_t i;
@@ -1225,7 +1256,7 @@ nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr
 			return -EFAULT;
 		}
 
-		phys_addr = nvme_pcie_vtophys(ctrlr, virt_addr, NULL);
+		phys_addr = nvme_pcie_payload_vtophys(ctrlr, region, virt_addr, NULL);
 		if (spdk_unlikely(phys_addr == SPDK_VTOPHYS_ERROR)) {
 			SPDK_ERRLOG("vtophys(%p) failed\n", virt_addr);
 			return -EFAULT;
@@ -1310,6 +1341,7 @@ nvme_pcie_qpair_build_contig_hw_sgl_request(struct spdk_nvme_qpair *qpair, struc
 	uint64_t phys_addr, mapping_length;
 	uint32_t length;
 	struct spdk_nvme_sgl_descriptor *sgl;
+	const struct nvme_buf_region *region = nvme_request_get_buf_region(req);
 	uint32_t nseg = 0;
 
 	assert(req->payload_size != 0);
@@ -1335,7 +1367,7 @@ nvme_pcie_qpair_build_contig_hw_sgl_request(struct spdk_nvme_qpair *qpair, struc
 		}
 
 		mapping_length = length;
-		phys_addr = nvme_pcie_vtophys(qpair->ctrlr, virt_addr, &mapping_length);
+		phys_addr = nvme_pcie_payload_vtophys(qpair->ctrlr, region, virt_addr, &mapping_length);
 		if (phys_addr == SPDK_VTOPHYS_ERROR) {
 			nvme_pcie_fail_request_bad_vtophys(qpair, tr);
 			return -EFAULT;
@@ -1389,6 +1421,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	uint64_t phys_addr, mapping_length;
 	uint32_t remaining_transfer_len, remaining_user_sge_len, length;
 	struct spdk_nvme_sgl_descriptor *sgl;
+	const struct nvme_buf_region *region = nvme_request_get_buf_region(req);
 	uint32_t nseg = 0;
 
 	/*
@@ -1459,7 +1492,8 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 			}
 
 			mapping_length = remaining_user_sge_len;
-			phys_addr = nvme_pcie_vtophys(qpair->ctrlr, virt_addr, &mapping_length);
+			phys_addr = nvme_pcie_payload_vtophys(qpair->ctrlr, region, virt_addr,
+							      &mapping_length);
 			if (phys_addr == SPDK_VTOPHYS_ERROR) {
 				goto exit;
 			}
@@ -1587,6 +1621,7 @@ nvme_pcie_qpair_build_metadata(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 {
 	void *md_payload;
 	struct nvme_request *req = tr->req;
+	const struct nvme_buf_region *region;
 	uint64_t mapping_length;
 
 	if (req->payload.md) {
@@ -1597,11 +1632,13 @@ nvme_pcie_qpair_build_metadata(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 		}
 
 		mapping_length = req->md_size;
+		region = nvme_request_get_buf_region(req);
 		if (sgl_supported && dword_aligned) {
 			assert(req->cmd.psdt == SPDK_NVME_PSDT_SGL_MPTR_CONTIG);
 			req->cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_SGL;
 
-			tr->meta_sgl.address = nvme_pcie_vtophys(qpair->ctrlr, md_payload, &mapping_length);
+			tr->meta_sgl.address = nvme_pcie_payload_vtophys(qpair->ctrlr, region, md_payload,
+					       &mapping_length);
 			if (tr->meta_sgl.address == SPDK_VTOPHYS_ERROR || mapping_length != req->md_size) {
 				goto exit;
 			}
@@ -1610,7 +1647,8 @@ nvme_pcie_qpair_build_metadata(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 			tr->meta_sgl.unkeyed.subtype = 0;
 			req->cmd.mptr = tr->prp_sgl_bus_addr - sizeof(struct spdk_nvme_sgl_descriptor);
 		} else {
-			req->cmd.mptr = nvme_pcie_vtophys(qpair->ctrlr, md_payload, &mapping_length);
+			req->cmd.mptr = nvme_pcie_payload_vtophys(qpair->ctrlr, region, md_payload,
+					&mapping_length);
 			if (req->cmd.mptr == SPDK_VTOPHYS_ERROR || mapping_length != req->md_size) {
 				goto exit;
 			}
@@ -1715,9 +1753,45 @@ nvme_pcie_poll_group_create(void)
 		return NULL;
 	}
 
+	STAILQ_INIT(&group->doorbell_qpairs);
+
 	return &group->group;
 }
 
+static void
+nvme_pcie_poll_group_cancel_doorbells(struct spdk_nvme_transport_poll_group *tgroup,
+				      struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_poll_group *group = nvme_pcie_poll_group(tgroup);
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+
+	if (pqpair->flags.doorbell_pending) {
+		STAILQ_REMOVE(&group->doorbell_qpairs, pqpair, nvme_pcie_qpair, doorbell_stailq);
+		pqpair->flags.doorbell_pending = 0;
+		pqpair->flags.cq_doorbell_pending = 0;
+	}
+}
+
+static void
+nvme_pcie_poll_group_ring_doorbells(struct nvme_pcie_poll_group *group)
+{
+	struct nvme_pcie_qpair *pqpair;
+
+	while ((pqpair = STAILQ_FIRST(&group->doorbell_qpairs)) != NULL) {
+		STAILQ_REMOVE_HEAD(&group->doorbell_qpairs, doorbell_stailq);
+		pqpair->flags.doorbell_pending = 0;
+
+		if (pqpair->flags.cq_doorbell_pending) {
+			pqpair->flags.cq_doorbell_pending = 0;
+			nvme_pcie_qpair_ring_cq_doorbell(&pqpair->qpair);
+		}
+
+		if (pqpair->last_sq_tail != pqpair->sq_tail) {
+			nvme_pcie_qpair_ring_sq_doorbell(&pqpair->qpair);
+		}
+	}
+}
+
 int
 nvme_pcie_poll_group_connect_qpair(struct spdk_nvme_qpair *qpair)
 {
@@ -1727,6 +1801,9 @@ nvme_pcie_poll_group_connect_qpair(struct spdk_nvme_qpair *qpair)
 int
 nvme_pcie_poll_group_disconnect_qpair(struct spdk_nvme_qpair *qpair)
 {
+	/* Don't ring the doorbells of a queue that is being deleted */
+	nvme_pcie_poll_group_cancel_doorbells(qpair->poll_group, qpair);
+
 	return 0;
 }
 
@@ -1743,6 +1820,7 @@ nvme_pcie_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
 {
 	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
 
+	nvme_pcie_poll_group_cancel_doorbells(tgroup, qpair);
 	pqpair->stat = &g_dummy_stat;
 	return 0;
 }
@@ -1751,6 +1829,7 @@ int64_t
 nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *tgroup,
 		uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
 {
+	struct nvme_pcie_poll_group *group = nvme_pcie_poll_group(tgroup);
 	struct spdk_nvme_qpair *qpair, *tmp_qpair;
 	int32_t local_completions = 0;
 	int64_t total_completions = 0;
@@ -1759,6 +1838,14 @@ nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 		disconnected_qpair_cb(qpair, tgroup->group->ctx);
 	}
 
+	/*
+	 * Defer the doorbell writes until all qpairs are polled.  This way, each CQ head doorbell
+	 * is written once and the commands submitted from the completion callbacks, including the
+	 * ones targeting qpairs that have already been polled, are covered by a single SQ tail
+	 * doorbell write.
+	 */
+	group->batch_doorbells = true;
+
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
 		local_completions = spdk_nvme_qpair_process_completions(qpair, completions_per_qpair);
 		if (spdk_unlikely(local_completions < 0)) {
@@ -1769,6 +1856,9 @@ nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 		}
 	}
 
+	group->batch_doorbells = false;
+	nvme_pcie_poll_group_ring_doorbells(group);
+
 	return total_completions;
 }
 
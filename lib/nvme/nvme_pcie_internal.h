@@ -112,6 +112,15 @@ SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, meta_sgl) & 7) == 0, "SGL must
 struct nvme_pcie_poll_group {
 	struct spdk_nvme_transport_poll_group group;
 	struct spdk_nvme_pcie_stat stats;
+
+	/*
+	 * Set while the group processes completions.  Doorbell writes of its qpairs are deferred
+	 * until all of them have been polled and are then issued once per qpair.
+	 */
+	bool batch_doorbells;
+
+	/* Qpairs with deferred doorbell writes */
+	STAILQ_HEAD(, nvme_pcie_qpair) doorbell_qpairs;
 };
 
 enum nvme_pcie_qpair_state {
@@ -162,8 +171,12 @@ struct nvme_pcie_qpair {
 		uint8_t has_shadow_doorbell	: 1;
 		uint8_t has_pending_vtophys_failures : 1;
 		uint8_t defer_destruction	: 1;
+		uint8_t doorbell_pending	: 1;
+		uint8_t cq_doorbell_pending	: 1;
 	} flags;
 
+	STAILQ_ENTRY(nvme_pcie_qpair) doorbell_stailq;
+
 	/*
 	 * Base qpair structure.
 	 * This is located after the hot data in this structure so that the important parts of
@@ -211,6 +224,39 @@ nvme_pcie_ctrlr(struct spdk_nvme_ctrlr *ctrlr)
 	return SPDK_CONTAINEROF(ctrlr, struct nvme_pcie_ctrlr, ctrlr);
 }
 
+static inline struct nvme_pcie_poll_group *
+nvme_pcie_poll_group(struct spdk_nvme_transport_poll_group *tgroup)
+{
+	return SPDK_CONTAINEROF(tgroup, struct nvme_pcie_poll_group, group);
+}
+
+/*
+ * Returns true if the qpair's doorbell writes should be deferred until its poll group is done
+ * processing completions.  In that case, the qpair is queued on the group's doorbell list.
+ */
+static inline bool
+nvme_pcie_qpair_defer_doorbells(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_qpair		*pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_pcie_poll_group	*group;
+
+	if (qpair->poll_group == NULL) {
+		return false;
+	}
+
+	group = nvme_pcie_poll_group(qpair->poll_group);
+	if (!group->batch_doorbells) {
+		return false;
+	}
+
+	if (!pqpair->flags.doorbell_pending) {
+		pqpair->flags.doorbell_pending = 1;
+		STAILQ_INSERT_TAIL(&group->doorbell_qpairs, pqpair, doorbell_stailq);
+	}
+
+	return true;
+}
+
 static inline int
 nvme_pcie_qpair_need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old)
 {
@@ -269,6 +315,8 @@ nvme_pcie_qpair_ring_sq_doorbell(struct spdk_nvme_qpair *qpair)
 		spdk_mmio_write_4(pqpair->sq_tdbl, pqpair->sq_tail);
 		g_thread_mmio_ctrlr = NULL;
 	}
+
+	pqpair->last_sq_tail = pqpair->sq_tail;
 }
 
 static inline void
@@ -914,6 +914,7 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 {
 	size_t req_size_padded;
 	uint32_t i;
+	int socket_id;
 
 	qpair->id = id;
 	qpair->qprio = qprio;
@@ -928,6 +929,8 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 	qpair->async = async;
 	qpair->poll_status = NULL;
 	qpair->num_outstanding_reqs = 0;
+	qpair->buf_regions = NULL;
+	qpair->num_buf_regions = 0;
 
 	STAILQ_INIT(&qpair->free_req);
 	STAILQ_INIT(&qpair->queued_req);
@@ -940,8 +943,18 @@ nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 	/* Add one for the reserved_req */
 	num_requests++;
 
+	/*
+	 * The requests are only accessed by the CPU, so allocate them on the NUMA node of the
+	 * calling core, which is usually the one polling the qpair.  Fall back to any node if
+	 * that's not possible.
+	 */
+	socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
 	qpair->req_buf = spdk_zmalloc(req_size_padded * num_requests, 64, NULL,
-				      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+				      socket_id, SPDK_MALLOC_SHARE);
+	if (qpair->req_buf == NULL && socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		qpair->req_buf = spdk_zmalloc(req_size_padded * num_requests, 64, NULL,
+					      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	}
 	if (qpair->req_buf == NULL) {
 		SPDK_ERRLOG("no memory to allocate qpair(cntlid:0x%x sqid:%d) req_buf with %d request\n",
 			    ctrlr->cntlid, qpair->id, num_requests);
@@ -980,6 +993,7 @@ void
 nvme_qpair_deinit(struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_error_cmd *cmd, *entry;
+	uint32_t i;
 
 	nvme_qpair_abort_queued_reqs(qpair, 0);
 	_nvme_qpair_complete_abort_queued_reqs(qpair);
@@ -991,6 +1005,13 @@ nvme_qpair_deinit(struct spdk_nvme_qpair *qpair)
 	}
 
 	spdk_free(qpair->req_buf);
+
+	for (i = 0; i < qpair->num_buf_regions; i++) {
+		free(qpair->buf_regions[i].phys);
+	}
+	free(qpair->buf_regions);
+	qpair->buf_regions = NULL;
+	qpair->num_buf_regions = 0;
 }
 
 static inline int
@@ -1279,3 +1300,80 @@ spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair)
 {
 	return qpair->num_outstanding_reqs;
 }
+
+int
+spdk_nvme_qpair_register_buffer(struct spdk_nvme_qpair *qpair, void *buf, size_t len,
+				uint32_t *handle)
+{
+	struct nvme_buf_region *region = NULL, *regions;
+	uint64_t *phys;
+	uintptr_t vaddr = (uintptr_t)buf;
+	size_t num_pages, i;
+	uint32_t index;
+
+	if (len == 0) {
+		return -EINVAL;
+	}
+
+	num_pages = ((vaddr + len - 1) >> SHIFT_2MB) - (vaddr >> SHIFT_2MB) + 1;
+	phys = calloc(num_pages, sizeof(*phys));
+	if (phys == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_pages; i++) {
+		phys[i] = spdk_vtophys((void *)(_2MB_PAGE(vaddr) + i * VALUE_2MB), NULL);
+		if (phys[i] == SPDK_VTOPHYS_ERROR) {
+			SPDK_ERRLOG("Buffer region %p (len %zu) is not DMA-able\n", buf, len);
+			free(phys);
+			return -EINVAL;
+		}
+	}
+
+	/* Reuse a slot left by an unregistered region, if there's one */
+	for (index = 0; index < qpair->num_buf_regions; index++) {
+		if (qpair->buf_regions[index].phys == NULL) {
+			region = &qpair->buf_regions[index];
+			break;
+		}
+	}
+
+	if (region == NULL) {
+		regions = realloc(qpair->buf_regions, (qpair->num_buf_regions + 1) * sizeof(*regions));
+		if (regions == NULL) {
+			free(phys);
+			return -ENOMEM;
+		}
+
+		qpair->buf_regions = regions;
+		index = qpair->num_buf_regions++;
+		region = &regions[index];
+	}
+
+	region->vaddr = vaddr;
+	region->len = len;
+	region->phys = phys;
+	*handle = index + 1;
+
+	return 0;
+}
+
+int
+spdk_nvme_qpair_unregister_buffer(struct spdk_nvme_qpair *qpair, uint32_t handle)
+{
+	struct nvme_buf_region *region;
+
+	if (handle == 0 || handle > qpair->num_buf_regions) {
+		return -ENOENT;
+	}
+
+	region = &qpair->buf_regions[handle - 1];
+	if (region->phys == NULL) {
+		return -ENOENT;
+	}
+
+	free(region->phys);
+	memset(region, 0, sizeof(*region));
+
+	return 0;
+}
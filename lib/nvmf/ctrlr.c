@@ -3960,20 +3960,119 @@ nvmf_ctrlr_reservation_notice_log(struct spdk_nvmf_ctrlr *ctrlr,
 	spdk_thread_send_msg(ctrlr->thread, _nvmf_ctrlr_add_reservation_log, log);
 }
 
-/* Check from subsystem poll group's namespace information data structure */
-static bool
-nvmf_ns_info_ctrlr_is_registrant(struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
-				 struct spdk_nvmf_ctrlr *ctrlr)
+static inline uint32_t
+nvmf_resv_hostid_hash(const struct spdk_uuid *hostid)
 {
-	uint32_t i;
+	uint64_t lo, hi;
 
-	for (i = 0; i < SPDK_NVMF_MAX_NUM_REGISTRANTS; i++) {
-		if (!spdk_uuid_compare(&ns_info->reg_hostid[i], &ctrlr->hostid)) {
-			return true;
+	memcpy(&lo, hostid, sizeof(lo));
+	memcpy(&hi, (const uint8_t *)hostid + sizeof(lo), sizeof(hi));
+
+	return (uint32_t)(((lo ^ hi) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static inline const struct spdk_uuid *
+nvmf_ns_info_resv_hostid(const struct spdk_nvmf_subsystem_pg_ns_info *ns_info, uint32_t idx)
+{
+	return idx < SPDK_NVMF_MAX_NUM_REGISTRANTS ? &ns_info->reg_hostid[idx] : &ns_info->holder_id;
+}
+
+/* Return the index of hostid in resv_access, or -1 and the empty slot of resv_hash to use */
+static int
+nvmf_ns_info_resv_lookup(const struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
+			 const struct spdk_uuid *hostid, uint32_t *slot)
+{
+	uint32_t i, idx;
+
+	i = nvmf_resv_hostid_hash(hostid) & (NVMF_RESV_ACCESS_HASH_SIZE - 1);
+	while ((idx = ns_info->resv_hash[i]) != 0) {
+		if (!spdk_uuid_compare(nvmf_ns_info_resv_hostid(ns_info, idx - 1), hostid)) {
+			return idx - 1;
 		}
+		i = (i + 1) & (NVMF_RESV_ACCESS_HASH_SIZE - 1);
 	}
 
-	return false;
+	if (slot != NULL) {
+		*slot = i;
+	}
+	return -1;
+}
+
+static uint8_t
+nvmf_resv_calc_access(enum spdk_nvme_reservation_type rtype, bool is_registrant, bool is_holder)
+{
+	uint8_t access = is_registrant ? NVMF_RESV_ACCESS_REGISTERED : 0;
+
+	/* All registrants type and current ctrlr is a valid registrant */
+	if (is_holder || (is_registrant && (rtype == SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_ALL_REGS ||
+					    rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_ALL_REGS))) {
+		return access | NVMF_RESV_ACCESS_HOLDER | NVMF_RESV_ACCESS_READ | NVMF_RESV_ACCESS_WRITE;
+	}
+
+	if (rtype != SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS &&
+	    (is_registrant || (rtype != SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_REG_ONLY &&
+			       rtype != SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_ALL_REGS))) {
+		access |= NVMF_RESV_ACCESS_READ;
+	}
+
+	if (rtype != SPDK_NVME_RESERVE_WRITE_EXCLUSIVE && rtype != SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS &&
+	    is_registrant) {
+		access |= NVMF_RESV_ACCESS_WRITE;
+	}
+
+	return access;
+}
+
+/*
+ * Precompute the access rights of the registrants and the holder, so that
+ * checking a command does not have to scan the registrants. Must be called
+ * whenever the reservation information of ns_info changes.
+ */
+void
+nvmf_ns_info_update_reservation_access(struct spdk_nvmf_subsystem_pg_ns_info *ns_info)
+{
+	bool is_registrant[SPDK_NVMF_MAX_NUM_REGISTRANTS + 1] = {};
+	bool is_holder[SPDK_NVMF_MAX_NUM_REGISTRANTS + 1] = {};
+	uint32_t i, slot;
+	int idx;
+
+	memset(ns_info->resv_hash, 0, sizeof(ns_info->resv_hash));
+	memset(ns_info->resv_access, 0, sizeof(ns_info->resv_access));
+
+	/* A host ID may show up several times, e.g. the holder is a registrant as well. */
+	for (i = 0; i <= SPDK_NVMF_MAX_NUM_REGISTRANTS; i++) {
+		idx = nvmf_ns_info_resv_lookup(ns_info, nvmf_ns_info_resv_hostid(ns_info, i), &slot);
+		if (idx < 0) {
+			ns_info->resv_hash[slot] = i + 1;
+			idx = i;
+		}
+		if (i < SPDK_NVMF_MAX_NUM_REGISTRANTS) {
+			is_registrant[idx] = true;
+		} else {
+			is_holder[idx] = true;
+		}
+	}
+
+	for (i = 0; i < NVMF_RESV_ACCESS_HASH_SIZE; i++) {
+		if (ns_info->resv_hash[i] != 0) {
+			idx = ns_info->resv_hash[i] - 1;
+			ns_info->resv_access[idx] = nvmf_resv_calc_access(ns_info->rtype, is_registrant[idx],
+						    is_holder[idx]);
+		}
+	}
+
+	ns_info->resv_default_access = nvmf_resv_calc_access(ns_info->rtype, false, false);
+}
+
+static inline uint8_t
+nvmf_ns_info_get_reservation_access(const struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
+				    const struct spdk_uuid *hostid)
+{
+	int idx;
+
+	idx = nvmf_ns_info_resv_lookup(ns_info, hostid, NULL);
+
+	return idx < 0 ? ns_info->resv_default_access : ns_info->resv_access[idx];
 }
 
 /*
@@ -3985,22 +4084,16 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 				  struct spdk_nvmf_request *req)
 {
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
-	enum spdk_nvme_reservation_type rtype = ns_info->rtype;
 	uint8_t status = SPDK_NVME_SC_SUCCESS;
-	uint8_t racqa;
-	bool is_registrant;
+	uint8_t racqa, access;
 
 	/* No valid reservation */
-	if (!rtype) {
+	if (!ns_info->rtype) {
 		return 0;
 	}
 
-	is_registrant = nvmf_ns_info_ctrlr_is_registrant(ns_info, ctrlr);
-	/* All registrants type and current ctrlr is a valid registrant */
-	if ((rtype == SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_ALL_REGS ||
-	     rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_ALL_REGS) && is_registrant) {
-		return 0;
-	} else if (!spdk_uuid_compare(&ns_info->holder_id, &ctrlr->hostid)) {
+	access = nvmf_ns_info_get_reservation_access(ns_info, &ctrlr->hostid);
+	if (access & NVMF_RESV_ACCESS_HOLDER) {
 		return 0;
 	}
 
@@ -4008,12 +4101,7 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 	switch (cmd->opc) {
 	case SPDK_NVME_OPC_READ:
 	case SPDK_NVME_OPC_COMPARE:
-		if (rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS) {
-			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
-			goto exit;
-		}
-		if ((rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_REG_ONLY ||
-		     rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_ALL_REGS) && !is_registrant) {
+		if (!(access & NVMF_RESV_ACCESS_READ)) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 		}
 		break;
@@ -4022,12 +4110,7 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 	case SPDK_NVME_OPC_WRITE_UNCORRECTABLE:
 	case SPDK_NVME_OPC_WRITE_ZEROES:
 	case SPDK_NVME_OPC_DATASET_MANAGEMENT:
-		if (rtype == SPDK_NVME_RESERVE_WRITE_EXCLUSIVE ||
-		    rtype == SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS) {
-			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
-			goto exit;
-		}
-		if (!is_registrant) {
+		if (!(access & NVMF_RESV_ACCESS_WRITE)) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 		}
 		break;
@@ -4037,12 +4120,12 @@ nvmf_ns_reservation_request_check(struct spdk_nvmf_subsystem_pg_ns_info *ns_info
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 			goto exit;
 		}
-		if (!is_registrant) {
+		if (!(access & NVMF_RESV_ACCESS_REGISTERED)) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 		}
 		break;
 	case SPDK_NVME_OPC_RESERVATION_RELEASE:
-		if (!is_registrant) {
+		if (!(access & NVMF_RESV_ACCESS_REGISTERED)) {
 			status = SPDK_NVME_SC_RESERVATION_CONFLICT;
 		}
 		break;
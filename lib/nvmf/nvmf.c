@@ -1472,6 +1472,7 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 				}
 				ns_info->reg_hostid[j++] = reg->hostid;
 			}
+			nvmf_ns_info_update_reservation_access(ns_info);
 		}
 	}
 
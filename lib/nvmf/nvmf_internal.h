@@ -109,6 +109,15 @@ struct spdk_nvmf_reservation_info {
 	struct spdk_nvmf_registrant_info	registrants[SPDK_NVMF_MAX_NUM_REGISTRANTS];
 };
 
+/* Size of the hash of host IDs in struct spdk_nvmf_subsystem_pg_ns_info, keeps it at most half full */
+#define NVMF_RESV_ACCESS_HASH_SIZE		64
+
+/* Access rights of a host while a reservation is held */
+#define NVMF_RESV_ACCESS_READ			0x01U
+#define NVMF_RESV_ACCESS_WRITE			0x02U
+#define NVMF_RESV_ACCESS_REGISTERED		0x04U
+#define NVMF_RESV_ACCESS_HOLDER			0x08U
+
 struct spdk_nvmf_subsystem_pg_ns_info {
 	struct spdk_io_channel		*channel;
 	struct spdk_uuid		uuid;
@@ -120,6 +129,14 @@ struct spdk_nvmf_subsystem_pg_ns_info {
 	struct spdk_uuid		holder_id;
 	/* Host ID for the registrants with the namespace */
 	struct spdk_uuid		reg_hostid[SPDK_NVMF_MAX_NUM_REGISTRANTS];
+	/* Access rights of the hosts, precomputed by nvmf_ns_info_update_reservation_access().
+	 * resv_hash maps a host ID to 1 + its index in resv_access, index
+	 * SPDK_NVMF_MAX_NUM_REGISTRANTS stands for holder_id. Hosts which are not found
+	 * have resv_default_access.
+	 */
+	uint8_t				resv_hash[NVMF_RESV_ACCESS_HASH_SIZE];
+	uint8_t				resv_access[SPDK_NVMF_MAX_NUM_REGISTRANTS + 1];
+	uint8_t				resv_default_access;
 	uint64_t			num_blocks;
 
 	/* I/O outstanding to this namespace */
@@ -151,6 +168,8 @@ struct spdk_nvmf_registrant {
 	uint64_t rkey;
 };
 
+struct nvmf_ns_ptpl_queue;
+
 typedef int (*spdk_nvmf_process_io_cmd)(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 					struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
 
@@ -177,6 +196,8 @@ struct spdk_nvmf_ns {
 	char *ptpl_file;
 	/* Persist Through Power Loss feature is enabled */
 	bool ptpl_activated;
+	/* Outstanding Persist Through Power Loss file writes */
+	struct nvmf_ns_ptpl_queue *ptpl_queue;
 	/* ZCOPY supported on bdev device */
 	bool zcopy;
 	/* KV operations supported on bdev device */
@@ -437,6 +458,7 @@ void nvmf_ctrlr_async_event_reservation_notification(struct spdk_nvmf_ctrlr *ctr
 int nvmf_ctrlr_async_event_error_event(struct spdk_nvmf_ctrlr *ctrlr,
 				       union spdk_nvme_async_event_completion event);
 void nvmf_ns_reservation_request(void *ctx);
+void nvmf_ns_info_update_reservation_access(struct spdk_nvmf_subsystem_pg_ns_info *ns_info);
 void nvmf_ctrlr_reservation_notice_log(struct spdk_nvmf_ctrlr *ctrlr,
 				       struct spdk_nvmf_ns *ns,
 				       enum spdk_nvme_reservation_notification_log_page_type type);
@@ -1299,6 +1299,7 @@ nvmf_subsystem_ns_changed(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 }
 
 static uint32_t nvmf_ns_reservation_clear_all_registrants(struct spdk_nvmf_ns *ns);
+static void nvmf_ns_ptpl_queue_release(struct spdk_nvmf_ns *ns);
 
 int
 spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
@@ -1329,6 +1330,7 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 	subsystem->ana_group[ns->anagrpid - 1]--;
 
 	free(ns->ptpl_file);
+	nvmf_ns_ptpl_queue_release(ns);
 	nvmf_ns_reservation_clear_all_registrants(ns);
 	spdk_bdev_module_release_bdev(ns->bdev);
 	spdk_bdev_close(ns->desc);
@@ -2274,13 +2276,14 @@ nvmf_ns_json_write_cb(void *cb_ctx, const void *data, size_t size)
 }
 
 static int
-nvmf_ns_reservation_update(const char *file, struct spdk_nvmf_reservation_info *info)
+nvmf_ns_reservation_update(struct spdk_nvmf_reservation_info *info, spdk_json_write_cb write_cb,
+			   void *cb_ctx)
 {
 	struct spdk_json_write_ctx *w;
 	uint32_t i;
 	int rc = 0;
 
-	w = spdk_json_write_begin(nvmf_ns_json_write_cb, (void *)file, 0);
+	w = spdk_json_write_begin(write_cb, cb_ctx, 0);
 	if (w == NULL) {
 		return -ENOMEM;
 	}
@@ -2311,12 +2314,157 @@ exit:
 	return rc;
 }
 
+/*
+ * Persist Through Power Loss file updates. The reservation information is
+ * serialized on the subsystem thread, and the file is written by a separate
+ * pthread so that the subsystem thread never blocks on file I/O. Writes of a
+ * namespace are queued and issued one at a time, so the file always ends up
+ * with the latest state.
+ */
+typedef void (*nvmf_ns_ptpl_write_cb)(void *cb_arg, int status);
+
+struct nvmf_ns_ptpl_write {
+	struct nvmf_ns_ptpl_queue		*queue;
+	struct spdk_thread			*thread;
+	char					*file;
+	char					*buf;
+	size_t					len;
+	int					rc;
+	nvmf_ns_ptpl_write_cb			cb_fn;
+	void					*cb_arg;
+	TAILQ_ENTRY(nvmf_ns_ptpl_write)		link;
+};
+
+struct nvmf_ns_ptpl_queue {
+	TAILQ_HEAD(, nvmf_ns_ptpl_write)	writes;
+	/* The namespace was removed, free the queue once it is empty */
+	bool					orphaned;
+};
+
+static int
+nvmf_ns_ptpl_buf_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	struct nvmf_ns_ptpl_write *write = cb_ctx;
+	char *buf;
+
+	if (size == 0) {
+		return 0;
+	}
+
+	buf = realloc(write->buf, write->len + size);
+	if (buf == NULL) {
+		return -ENOMEM;
+	}
+	memcpy(buf + write->len, data, size);
+	write->buf = buf;
+	write->len += size;
+
+	return 0;
+}
+
+static void
+nvmf_ns_ptpl_write_free(struct nvmf_ns_ptpl_write *write)
+{
+	free(write->file);
+	free(write->buf);
+	free(write);
+}
+
+static void nvmf_ns_ptpl_write_start(struct nvmf_ns_ptpl_write *write);
+
+static void
+nvmf_ns_ptpl_write_done(void *ctx)
+{
+	struct nvmf_ns_ptpl_write *write = ctx;
+	struct nvmf_ns_ptpl_queue *queue = write->queue;
+	struct nvmf_ns_ptpl_write *next;
+
+	assert(TAILQ_FIRST(&queue->writes) == write);
+	TAILQ_REMOVE(&queue->writes, write, link);
+
+	next = TAILQ_FIRST(&queue->writes);
+	if (next != NULL) {
+		nvmf_ns_ptpl_write_start(next);
+	} else if (queue->orphaned) {
+		free(queue);
+	}
+
+	if (write->rc != 0) {
+		SPDK_ERRLOG("Failed to update reservation file %s\n", write->file);
+	}
+	if (write->cb_fn) {
+		write->cb_fn(write->cb_arg, write->rc);
+	}
+	nvmf_ns_ptpl_write_free(write);
+}
+
+static void *
+nvmf_ns_ptpl_write_thread(void *arg)
+{
+	struct nvmf_ns_ptpl_write *write = arg;
+
+	spdk_unaffinitize_thread();
+
+	write->rc = nvmf_ns_json_write_cb(write->file, write->buf, write->len);
+	spdk_thread_send_msg(write->thread, nvmf_ns_ptpl_write_done, write);
+
+	return NULL;
+}
+
+static void
+nvmf_ns_ptpl_write_start(struct nvmf_ns_ptpl_write *write)
+{
+	pthread_attr_t attr;
+	pthread_t tid;
+	int rc;
+
+	rc = pthread_attr_init(&attr);
+	if (rc == 0) {
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		rc = pthread_create(&tid, &attr, nvmf_ns_ptpl_write_thread, write);
+		pthread_attr_destroy(&attr);
+	}
+
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to create thread for reservation file update (%d), "
+			    "writing it inline\n", rc);
+		write->rc = nvmf_ns_json_write_cb(write->file, write->buf, write->len);
+		spdk_thread_send_msg(write->thread, nvmf_ns_ptpl_write_done, write);
+	}
+}
+
+static void
+nvmf_ns_ptpl_queue_release(struct spdk_nvmf_ns *ns)
+{
+	struct nvmf_ns_ptpl_queue *queue = ns->ptpl_queue;
+
+	if (queue == NULL) {
+		return;
+	}
+
+	ns->ptpl_queue = NULL;
+	if (TAILQ_EMPTY(&queue->writes)) {
+		free(queue);
+	} else {
+		/* Outstanding writes still complete, the last one frees the queue. */
+		queue->orphaned = true;
+	}
+}
+
+/*
+ * Save the reservation information of ns to its Persist Through Power Loss file.
+ * cb_fn is called on the current thread once the file is written. Returns 0 if
+ * ns has no such file, cb_fn is not called then.
+ */
 static int
-nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
+nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns, nvmf_ns_ptpl_write_cb cb_fn,
+				void *cb_arg)
 {
 	struct spdk_nvmf_reservation_info info;
 	struct spdk_nvmf_registrant *reg, *tmp;
+	struct nvmf_ns_ptpl_write *write;
 	uint32_t i = 0;
+	int rc;
 
 	assert(ns != NULL);
 
@@ -2324,6 +2472,14 @@ nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
 		return 0;
 	}
 
+	if (ns->ptpl_queue == NULL) {
+		ns->ptpl_queue = calloc(1, sizeof(*ns->ptpl_queue));
+		if (ns->ptpl_queue == NULL) {
+			return -ENOMEM;
+		}
+		TAILQ_INIT(&ns->ptpl_queue->writes);
+	}
+
 	memset(&info, 0, sizeof(info));
 	spdk_uuid_fmt_lower(info.bdev_uuid, sizeof(info.bdev_uuid), spdk_bdev_get_uuid(ns->bdev));
 
@@ -2345,7 +2501,32 @@ nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
 	info.num_regs = i;
 	info.ptpl_activated = ns->ptpl_activated;
 
-	return nvmf_ns_reservation_update(ns->ptpl_file, &info);
+	write = calloc(1, sizeof(*write));
+	if (write == NULL) {
+		return -ENOMEM;
+	}
+	write->queue = ns->ptpl_queue;
+	write->thread = spdk_get_thread();
+	write->cb_fn = cb_fn;
+	write->cb_arg = cb_arg;
+	write->file = strdup(ns->ptpl_file);
+	if (write->file == NULL) {
+		nvmf_ns_ptpl_write_free(write);
+		return -ENOMEM;
+	}
+
+	rc = nvmf_ns_reservation_update(&info, nvmf_ns_ptpl_buf_write_cb, write);
+	if (rc != 0) {
+		nvmf_ns_ptpl_write_free(write);
+		return rc;
+	}
+
+	TAILQ_INSERT_TAIL(&ns->ptpl_queue->writes, write, link);
+	if (TAILQ_FIRST(&ns->ptpl_queue->writes) == write) {
+		nvmf_ns_ptpl_write_start(write);
+	}
+
+	return 0;
 }
 
 static struct spdk_nvmf_registrant *
@@ -2728,12 +2909,6 @@ nvmf_ns_reservation_register(struct spdk_nvmf_ns *ns,
 	}
 
 exit:
-	if (update_sgroup) {
-		rc = nvmf_ns_update_reservation_info(ns);
-		if (rc != 0) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -2898,11 +3073,6 @@ exit:
 
 		}
 	}
-	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -3005,11 +3175,6 @@ nvmf_ns_reservation_release(struct spdk_nvmf_ns *ns,
 	}
 
 exit:
-	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -3097,16 +3262,47 @@ nvmf_ns_reservation_complete(void *ctx)
 	spdk_nvmf_request_complete(req);
 }
 
+/* Tracks the poll group update and the PTPL file update of a reservation command */
+struct nvmf_ns_reservation_update_ctx {
+	struct spdk_nvmf_request	*req;
+	uint32_t			outstanding;
+};
+
 static void
-_nvmf_ns_reservation_update_done(struct spdk_nvmf_subsystem *subsystem,
-				 void *cb_arg, int status)
+nvmf_ns_reservation_update_put(struct nvmf_ns_reservation_update_ctx *ctx)
 {
-	struct spdk_nvmf_request *req = (struct spdk_nvmf_request *)cb_arg;
+	struct spdk_nvmf_request *req = ctx->req;
 	struct spdk_nvmf_poll_group *group = req->qpair->group;
 
+	assert(ctx->outstanding > 0);
+	if (--ctx->outstanding > 0) {
+		return;
+	}
+
+	free(ctx);
 	spdk_thread_send_msg(group->thread, nvmf_ns_reservation_complete, req);
 }
 
+static void
+_nvmf_ns_reservation_update_done(struct spdk_nvmf_subsystem *subsystem,
+				 void *cb_arg, int status)
+{
+	nvmf_ns_reservation_update_put(cb_arg);
+}
+
+static void
+nvmf_ns_reservation_ptpl_done(void *cb_arg, int status)
+{
+	struct nvmf_ns_reservation_update_ctx *ctx = cb_arg;
+
+	if (status != 0) {
+		ctx->req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		ctx->req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	}
+
+	nvmf_ns_reservation_update_put(ctx);
+}
+
 void
 nvmf_ns_reservation_request(void *ctx)
 {
@@ -3114,9 +3310,12 @@ nvmf_ns_reservation_request(void *ctx)
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
 	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
 	struct subsystem_update_ns_ctx *update_ctx;
+	struct nvmf_ns_reservation_update_ctx *resv_ctx;
 	uint32_t nsid;
 	struct spdk_nvmf_ns *ns;
 	bool update_sgroup = false;
+	bool update_ptpl = false;
+	int rc;
 
 	nsid = cmd->nsid;
 	ns = _nvmf_subsystem_get_ns(ctrlr->subsys, nsid);
@@ -3125,12 +3324,16 @@ nvmf_ns_reservation_request(void *ctx)
 	switch (cmd->opc) {
 	case SPDK_NVME_OPC_RESERVATION_REGISTER:
 		update_sgroup = nvmf_ns_reservation_register(ns, ctrlr, req);
+		/* Registration may change the PTPL state, so always save it */
+		update_ptpl = update_sgroup;
 		break;
 	case SPDK_NVME_OPC_RESERVATION_ACQUIRE:
 		update_sgroup = nvmf_ns_reservation_acquire(ns, ctrlr, req);
+		update_ptpl = update_sgroup && ns->ptpl_activated;
 		break;
 	case SPDK_NVME_OPC_RESERVATION_RELEASE:
 		update_sgroup = nvmf_ns_reservation_release(ns, ctrlr, req);
+		update_ptpl = update_sgroup && ns->ptpl_activated;
 		break;
 	case SPDK_NVME_OPC_RESERVATION_REPORT:
 		nvmf_ns_reservation_report(ns, ctrlr, req);
@@ -3139,23 +3342,48 @@ nvmf_ns_reservation_request(void *ctx)
 		break;
 	}
 
-	/* update reservation information to subsystem's poll group */
-	if (update_sgroup) {
-		update_ctx = calloc(1, sizeof(*update_ctx));
-		if (update_ctx == NULL) {
-			SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
-			goto update_done;
+	if (!update_sgroup) {
+		goto complete;
+	}
+
+	resv_ctx = calloc(1, sizeof(*resv_ctx));
+	if (resv_ctx == NULL) {
+		SPDK_ERRLOG("Can't alloc reservation update context\n");
+		goto complete;
+	}
+	resv_ctx->req = req;
+	/* Hold a reference until both updates are issued */
+	resv_ctx->outstanding = 1;
+
+	/* The PTPL file is written off the subsystem thread, in parallel with the
+	 * poll group update.
+	 */
+	if (update_ptpl && ns->ptpl_file != NULL) {
+		resv_ctx->outstanding++;
+		rc = nvmf_ns_update_reservation_info(ns, nvmf_ns_reservation_ptpl_done, resv_ctx);
+		if (rc != 0) {
+			resv_ctx->outstanding--;
+			req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+			req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
 		}
-		update_ctx->subsystem = ctrlr->subsys;
-		update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
-		update_ctx->cb_arg = req;
+	}
 
-		nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+	/* update reservation information to subsystem's poll group */
+	update_ctx = calloc(1, sizeof(*update_ctx));
+	if (update_ctx == NULL) {
+		SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
+		nvmf_ns_reservation_update_put(resv_ctx);
 		return;
 	}
+	update_ctx->subsystem = ctrlr->subsys;
+	update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
+	update_ctx->cb_arg = resv_ctx;
+
+	nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+	return;
 
-update_done:
-	_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
+complete:
+	spdk_thread_send_msg(req->qpair->group->thread, nvmf_ns_reservation_complete, req);
 }
 
 int
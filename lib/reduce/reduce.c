@@ -5,6 +5,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/config.h"
 
 #include "spdk/reduce.h"
 #include "spdk/env.h"
@@ -13,8 +14,11 @@
 #include "spdk/util.h"
 #include "spdk/log.h"
 #include "spdk/memory.h"
+#include "spdk/crc32.h"
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 #include "libpmem.h"
+#endif
 
 /* Always round up the size of the PM region to the nearest cacheline. */
 #define REDUCE_PM_SIZE_ALIGNMENT	64
@@ -30,7 +34,9 @@
 struct spdk_reduce_vol_superblock {
 	uint8_t				signature[8];
 	struct spdk_reduce_vol_params	params;
-	uint8_t				reserved[4048];
+	/* Only used by the copy held in backing device metadata. */
+	uint64_t			md_journal_gen;
+	uint8_t				reserved[4032];
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_reduce_vol_superblock) == 4096, "size incorrect");
 
@@ -43,6 +49,37 @@ SPDK_STATIC_ASSERT(sizeof(SPDK_REDUCE_SIGNATURE) - 1 ==
 
 #define REDUCE_ZERO_BUF_SIZE 0x100000
 
+/*
+ * When no pm file directory is given, the metadata (a copy of the superblock, the logical
+ *  map and the chunk maps) is kept in memory and written back to a region of the backing
+ *  device that starts right after the path.  Map updates are first appended to a journal
+ *  that follows the metadata image, and dirty metadata pages are written back in batches
+ *  whenever the journal wraps or the volume is unloaded.  The image itself is not DMA
+ *  memory, pages are copied through a bounce buffer that only holds what can be in flight
+ *  at once.
+ */
+#define REDUCE_BACKING_DEV_MD_OFFSET	(REDUCE_BACKING_DEV_PATH_OFFSET + REDUCE_PATH_MAX)
+#define REDUCE_MD_PAGE_SIZE		4096
+#define REDUCE_MD_JOURNAL_NUM_BLOCKS	256
+#define REDUCE_MD_WRITEBACK_QD		16
+#define REDUCE_MD_WRITEBACK_MAX_PAGES	32
+#define REDUCE_MD_IO_BUF_MAX_SIZE	(REDUCE_MD_WRITEBACK_QD * REDUCE_MD_WRITEBACK_MAX_PAGES * \
+					 REDUCE_MD_PAGE_SIZE)
+
+#define SPDK_REDUCE_MD_JOURNAL_SIGNATURE "SPDKRDJL"
+
+struct reduce_md_journal_header {
+	uint8_t			signature[8];
+	struct spdk_uuid	uuid;
+	uint64_t		generation;
+	uint32_t		seq;
+	uint32_t		num_entries;
+	uint32_t		crc;
+	uint32_t		reserved;
+};
+SPDK_STATIC_ASSERT(sizeof(SPDK_REDUCE_MD_JOURNAL_SIGNATURE) - 1 ==
+		   SPDK_SIZEOF_MEMBER(struct reduce_md_journal_header, signature), "size incorrect");
+
 /**
  * Describes a persistent memory file used to hold metadata associated with a
  *  compressed volume.
@@ -56,6 +93,15 @@ struct spdk_reduce_pm_file {
 
 #define REDUCE_IO_READV		1
 #define REDUCE_IO_WRITEV	2
+#define REDUCE_IO_COMPACT	3
+
+/*
+ * Background compaction for the packed layout starts once this many backing io units are
+ *  at most half used, and examines up to REDUCE_COMPACT_SCAN_CHUNKS logical map entries
+ *  each time a request completes.
+ */
+#define REDUCE_COMPACT_SPARSE_IO_UNITS	16
+#define REDUCE_COMPACT_SCAN_CHUNKS	64
 
 struct spdk_reduce_chunk_map {
 	uint32_t		compressed_size;
@@ -63,6 +109,12 @@ struct spdk_reduce_chunk_map {
 	uint64_t		io_unit_index[0];
 };
 
+struct reduce_md_journal_entry {
+	uint64_t			logical_map_index;
+	uint64_t			chunk_map_index;
+	struct spdk_reduce_chunk_map	chunk;
+};
+
 struct spdk_reduce_vol_request {
 	/**
 	 *  Scratch buffer used for uncompressed chunk.  This is used for:
@@ -109,15 +161,69 @@ struct spdk_reduce_vol_request {
 	spdk_reduce_vol_op_complete		cb_fn;
 	void					*cb_arg;
 	TAILQ_ENTRY(spdk_reduce_vol_request)	tailq;
+	TAILQ_ENTRY(spdk_reduce_vol_request)	md_tailq;
+	struct spdk_reduce_vol_cb_args		backing_cb_args;
+};
+
+struct reduce_md_writer {
+	struct spdk_reduce_vol			*vol;
+	/* Part of the bounce buffer owned by this writer and offset of the pages in it. */
+	uint8_t					*buf;
+	uint64_t				offset;
+	struct iovec				iov;
 	struct spdk_reduce_vol_cb_args		backing_cb_args;
 };
 
+/**
+ * Describes the metadata region on the backing device, used instead of a persistent memory
+ *  file.  The pm_file buffer then points to the in-memory metadata image.
+ */
+struct spdk_reduce_backing_md {
+	bool					enabled;
+	uint64_t				image_size;
+	uint64_t				journal_offset;
+	uint32_t				journal_block_size;
+	uint32_t				entry_size;
+	uint32_t				entries_per_block;
+	struct spdk_bit_array			*dirty_pages;
+
+	/* DMA bounce buffer for metadata image I/O, split between the write-back writers. */
+	uint8_t					*io_buf;
+	uint64_t				io_buf_size;
+	uint32_t				writer_max_pages;
+	uint32_t				num_writers;
+
+	/* Journal block being filled and journal block being written. */
+	uint8_t					*open_block;
+	uint8_t					*flush_block;
+	uint32_t				open_entries;
+	uint32_t				next_seq;
+	bool					flush_in_progress;
+	struct iovec				flush_iov;
+	struct spdk_reduce_vol_cb_args		flush_cb_args;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	open_requests;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	flush_requests;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	waiting_requests;
+
+	/* Write-back of dirty metadata pages. */
+	bool					writeback_in_progress;
+	uint32_t				writeback_outstanding;
+	uint32_t				writeback_next_page;
+	int					writeback_errno;
+	struct reduce_md_writer			writers[REDUCE_MD_WRITEBACK_QD];
+	spdk_reduce_vol_op_complete		writeback_cb_fn;
+	void					*writeback_cb_arg;
+	spdk_reduce_vol_op_complete		unload_cb_fn;
+	void					*unload_cb_arg;
+};
+
 struct spdk_reduce_vol {
 	struct spdk_reduce_vol_params		params;
 	uint32_t				backing_io_units_per_chunk;
 	uint32_t				backing_lba_per_io_unit;
 	uint32_t				logical_blocks_per_chunk;
 	struct spdk_reduce_pm_file		pm_file;
+	struct spdk_reduce_backing_md		backing_md;
 	struct spdk_reduce_backing_dev		*backing_dev;
 	struct spdk_reduce_vol_superblock	*backing_super;
 	struct spdk_reduce_vol_superblock	*pm_super;
@@ -125,8 +231,24 @@ struct spdk_reduce_vol {
 	uint64_t				*pm_chunk_maps;
 
 	struct spdk_bit_array			*allocated_chunk_maps;
+	/* One bit per backing io unit, or per backing device block for the packed layout. */
 	struct spdk_bit_array			*allocated_backing_io_units;
 
+	/* Packed layout only. */
+	struct {
+		/* Number of backing device blocks in use in each backing io unit. */
+		uint16_t			*io_unit_used_blocks;
+		uint64_t			num_io_units;
+		uint64_t			sparse_io_units;
+		uint32_t			alloc_cursor;
+		uint64_t			compact_cursor;
+		bool				compact_in_progress;
+		uint64_t			compacted_chunks;
+		/* Unload requested while a compaction was running. */
+		spdk_reduce_vol_op_complete	unload_cb_fn;
+		void				*unload_cb_arg;
+	} pack;
+
 	struct spdk_reduce_vol_request		*request_mem;
 	TAILQ_HEAD(, spdk_reduce_vol_request)	free_requests;
 	TAILQ_HEAD(, spdk_reduce_vol_request)	executing_requests;
@@ -139,6 +261,9 @@ struct spdk_reduce_vol {
 
 static void _start_readv_request(struct spdk_reduce_vol_request *req);
 static void _start_writev_request(struct spdk_reduce_vol_request *req);
+static void _reduce_vol_maybe_compact(struct spdk_reduce_vol *vol);
+static void _reduce_md_writeback(struct spdk_reduce_vol *vol, spdk_reduce_vol_op_complete cb_fn,
+				 void *cb_arg);
 static uint8_t *g_zero_buf;
 static int g_vol_count = 0;
 
@@ -150,15 +275,60 @@ static int g_vol_count = 0;
  */
 #define REDUCE_NUM_EXTRA_CHUNKS 128
 
+/*
+ * Persistent memory file accessors. Without libpmem only volumes keeping their metadata on
+ *  the backing device are supported.
+ */
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
+static void *
+_reduce_pm_map_file(struct spdk_reduce_vol *vol, bool create, size_t *mapped_len)
+{
+	if (create) {
+		return pmem_map_file(vol->pm_file.path, vol->pm_file.size,
+				     PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
+				     mapped_len, &vol->pm_file.pm_is_pmem);
+	}
+
+	return pmem_map_file(vol->pm_file.path, 0, 0, 0, mapped_len, &vol->pm_file.pm_is_pmem);
+}
+
+static void
+_reduce_pm_unmap_file(struct spdk_reduce_vol *vol)
+{
+	pmem_unmap(vol->pm_file.pm_buf, vol->pm_file.size);
+}
+
 static void
 _reduce_persist(struct spdk_reduce_vol *vol, const void *addr, size_t len)
 {
+	assert(!vol->backing_md.enabled);
 	if (vol->pm_file.pm_is_pmem) {
 		pmem_persist(addr, len);
 	} else {
 		pmem_msync(addr, len);
 	}
 }
+#else
+static void *
+_reduce_pm_map_file(struct spdk_reduce_vol *vol, bool create, size_t *mapped_len)
+{
+	SPDK_ERRLOG("libreduce was built without libpmem, persistent memory files are not supported\n");
+	errno = ENOTSUP;
+	return NULL;
+}
+
+static void
+_reduce_pm_unmap_file(struct spdk_reduce_vol *vol)
+{
+	assert(false);
+}
+
+static void
+_reduce_persist(struct spdk_reduce_vol *vol, const void *addr, size_t len)
+{
+	assert(false);
+}
+#endif
 
 static uint64_t
 _get_pm_logical_map_size(uint64_t vol_size, uint64_t chunk_size)
@@ -218,6 +388,122 @@ _reduce_vol_get_chunk_map(struct spdk_reduce_vol *vol, uint64_t chunk_map_index)
 	return (struct spdk_reduce_chunk_map *)chunk_map_addr;
 }
 
+static inline bool
+_reduce_vol_is_packed(struct spdk_reduce_vol *vol)
+{
+	return vol->params.chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED;
+}
+
+/* Number of bytes a chunk takes on the backing device, before rounding up to whole units. */
+static inline uint32_t
+_reduce_vol_chunk_stored_size(struct spdk_reduce_vol *vol, uint32_t compressed_size)
+{
+	if (_reduce_vol_is_packed(vol)) {
+		return spdk_divide_round_up(compressed_size, vol->backing_dev->blocklen) *
+		       vol->backing_dev->blocklen;
+	}
+
+	return spdk_divide_round_up(compressed_size, vol->params.backing_io_unit_size) *
+	       vol->params.backing_io_unit_size;
+}
+
+static inline bool
+_reduce_vol_chunk_is_compressed(struct spdk_reduce_vol *vol, uint32_t compressed_size)
+{
+	return _reduce_vol_chunk_stored_size(vol, compressed_size) < vol->params.chunk_size;
+}
+
+/*
+ * For the packed layout, io_unit_index[] of a chunk map holds the first backing device block
+ *  of each piece of the chunk.  Every piece is backing_io_unit_size long, except the last
+ *  one which may be shorter.
+ */
+static inline uint32_t
+_reduce_vol_pack_piece_blocks(struct spdk_reduce_vol *vol, uint32_t stored_size, uint32_t piece)
+{
+	return spdk_min(stored_size - piece * vol->params.backing_io_unit_size,
+			vol->params.backing_io_unit_size) / vol->backing_dev->blocklen;
+}
+
+static inline bool
+_reduce_vol_pack_io_unit_is_sparse(struct spdk_reduce_vol *vol, uint16_t used_blocks)
+{
+	return used_blocks > 0 && used_blocks <= vol->backing_lba_per_io_unit / 2;
+}
+
+static void
+_reduce_vol_pack_set_blocks(struct spdk_reduce_vol *vol, uint64_t block, uint32_t num_blocks,
+			    bool used)
+{
+	uint64_t io_unit;
+	uint16_t *used_blocks;
+	bool was_sparse;
+	uint32_t i;
+
+	for (i = 0; i < num_blocks; i++, block++) {
+		io_unit = block / vol->backing_lba_per_io_unit;
+		used_blocks = &vol->pack.io_unit_used_blocks[io_unit];
+		was_sparse = _reduce_vol_pack_io_unit_is_sparse(vol, *used_blocks);
+		if (used) {
+			assert(spdk_bit_array_get(vol->allocated_backing_io_units, block) == false);
+			spdk_bit_array_set(vol->allocated_backing_io_units, block);
+			(*used_blocks)++;
+		} else {
+			assert(spdk_bit_array_get(vol->allocated_backing_io_units, block) == true);
+			spdk_bit_array_clear(vol->allocated_backing_io_units, block);
+			(*used_blocks)--;
+		}
+
+		if (was_sparse != _reduce_vol_pack_io_unit_is_sparse(vol, *used_blocks)) {
+			if (was_sparse) {
+				vol->pack.sparse_io_units--;
+			} else {
+				vol->pack.sparse_io_units++;
+			}
+		}
+	}
+}
+
+/*
+ * Find num_blocks free contiguous backing device blocks.  The search continues where the
+ *  previous one ended, so new data is appended to the same io units and the holes left
+ *  behind are only reused once the search wraps around.
+ */
+static uint32_t
+_reduce_vol_pack_alloc_blocks(struct spdk_reduce_vol *vol, uint32_t num_blocks)
+{
+	struct spdk_bit_array *blocks = vol->allocated_backing_io_units;
+	uint32_t capacity = spdk_bit_array_capacity(blocks);
+	uint32_t start, next_used, cursor = vol->pack.alloc_cursor;
+	bool wrapped = false;
+
+	while (true) {
+		start = spdk_bit_array_find_first_clear(blocks, cursor);
+		if (start == UINT32_MAX || start + num_blocks > capacity) {
+			if (wrapped) {
+				return UINT32_MAX;
+			}
+			wrapped = true;
+			cursor = 0;
+			continue;
+		}
+
+		if (wrapped && start >= vol->pack.alloc_cursor) {
+			return UINT32_MAX;
+		}
+
+		next_used = spdk_bit_array_find_first_set(blocks, start);
+		if (next_used == UINT32_MAX || next_used >= start + num_blocks) {
+			break;
+		}
+		cursor = next_used;
+	}
+
+	_reduce_vol_pack_set_blocks(vol, start, num_blocks, true);
+	vol->pack.alloc_cursor = start + num_blocks;
+	return start;
+}
+
 static int
 _validate_vol_params(struct spdk_reduce_vol_params *params)
 {
@@ -244,6 +530,11 @@ _validate_vol_params(struct spdk_reduce_vol_params *params)
 		return -1;
 	}
 
+	if (params->chunk_layout != SPDK_REDUCE_CHUNK_LAYOUT_IO_UNIT &&
+	    params->chunk_layout != SPDK_REDUCE_CHUNK_LAYOUT_PACKED) {
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -273,6 +564,41 @@ _get_pm_file_size(struct spdk_reduce_vol_params *params)
 	return total_pm_size;
 }
 
+static uint32_t
+_get_md_journal_entry_size(uint64_t backing_io_units_per_chunk)
+{
+	return sizeof(struct reduce_md_journal_entry) +
+	       sizeof(uint64_t) * backing_io_units_per_chunk;
+}
+
+static uint32_t
+_get_md_journal_block_size(struct spdk_reduce_vol_params *params)
+{
+	uint32_t entry_size;
+
+	/* Each journal block has to hold at least one entry. */
+	entry_size = _get_md_journal_entry_size(params->chunk_size / params->backing_io_unit_size);
+	return spdk_divide_round_up(sizeof(struct reduce_md_journal_header) + entry_size,
+				    REDUCE_MD_PAGE_SIZE) * REDUCE_MD_PAGE_SIZE;
+}
+
+static uint64_t
+_get_md_image_size(struct spdk_reduce_vol_params *params)
+{
+	return spdk_divide_round_up(_get_pm_file_size(params), REDUCE_MD_PAGE_SIZE) *
+	       REDUCE_MD_PAGE_SIZE;
+}
+
+/* Size of everything at the start of the backing device that is not data when the metadata
+ *  is kept on the backing device.
+ */
+static uint64_t
+_get_backing_md_size(struct spdk_reduce_vol_params *params)
+{
+	return REDUCE_BACKING_DEV_MD_OFFSET + _get_md_image_size(params) +
+	       (uint64_t)REDUCE_MD_JOURNAL_NUM_BLOCKS * _get_md_journal_block_size(params);
+}
+
 const struct spdk_uuid *
 spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol)
 {
@@ -295,6 +621,144 @@ _initialize_vol_pm_pointers(struct spdk_reduce_vol *vol)
 	vol->pm_chunk_maps = (uint64_t *)((uint8_t *)vol->pm_logical_map + logical_map_size);
 }
 
+static int
+_allocate_backing_md(struct spdk_reduce_vol *vol)
+{
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint32_t i;
+
+	TAILQ_INIT(&md->open_requests);
+	TAILQ_INIT(&md->flush_requests);
+	TAILQ_INIT(&md->waiting_requests);
+
+	md->image_size = _get_md_image_size(&vol->params);
+	md->journal_offset = REDUCE_BACKING_DEV_MD_OFFSET + md->image_size;
+	md->entry_size = _get_md_journal_entry_size(vol->backing_io_units_per_chunk);
+	md->journal_block_size = _get_md_journal_block_size(&vol->params);
+	md->entries_per_block = (md->journal_block_size - sizeof(struct reduce_md_journal_header)) /
+				md->entry_size;
+
+	md->io_buf_size = spdk_min(md->image_size, REDUCE_MD_IO_BUF_MAX_SIZE);
+	md->writer_max_pages = spdk_min(REDUCE_MD_WRITEBACK_MAX_PAGES,
+					md->io_buf_size / REDUCE_MD_PAGE_SIZE);
+	md->num_writers = md->io_buf_size / REDUCE_MD_PAGE_SIZE / md->writer_max_pages;
+
+	vol->pm_file.size = _get_pm_file_size(&vol->params);
+	vol->pm_file.pm_buf = calloc(1, md->image_size);
+	md->io_buf = spdk_zmalloc(md->io_buf_size, REDUCE_MD_PAGE_SIZE, NULL,
+				  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	md->open_block = spdk_zmalloc(md->journal_block_size, REDUCE_MD_PAGE_SIZE, NULL,
+				      SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	md->flush_block = spdk_zmalloc(md->journal_block_size, REDUCE_MD_PAGE_SIZE, NULL,
+				       SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	md->dirty_pages = spdk_bit_array_create(md->image_size / REDUCE_MD_PAGE_SIZE);
+	if (vol->pm_file.pm_buf == NULL || md->io_buf == NULL || md->open_block == NULL ||
+	    md->flush_block == NULL || md->dirty_pages == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < md->num_writers; i++) {
+		md->writers[i].buf = md->io_buf + (uint64_t)i * md->writer_max_pages * REDUCE_MD_PAGE_SIZE;
+	}
+
+	return 0;
+}
+
+static void
+_free_backing_md(struct spdk_reduce_vol *vol)
+{
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+
+	free(vol->pm_file.pm_buf);
+	spdk_free(md->io_buf);
+	spdk_free(md->open_block);
+	spdk_free(md->flush_block);
+	spdk_bit_array_free(&md->dirty_pages);
+	vol->pm_file.pm_buf = NULL;
+	md->io_buf = NULL;
+	md->open_block = NULL;
+	md->flush_block = NULL;
+}
+
+static void
+_reduce_md_mark_dirty(struct spdk_reduce_vol *vol, const void *addr, size_t len)
+{
+	uint64_t offset;
+	uint32_t page, last_page;
+
+	offset = (uintptr_t)addr - (uintptr_t)vol->pm_file.pm_buf;
+	last_page = (offset + len - 1) / REDUCE_MD_PAGE_SIZE;
+	for (page = offset / REDUCE_MD_PAGE_SIZE; page <= last_page; page++) {
+		spdk_bit_array_set(vol->backing_md.dirty_pages, page);
+	}
+}
+
+static uint32_t
+_reduce_md_journal_crc(struct spdk_reduce_vol *vol, uint8_t *block)
+{
+	return spdk_crc32c_update(block, vol->backing_md.journal_block_size, ~0u) ^ ~0u;
+}
+
+/*
+ * Apply journal blocks written since the last metadata write-back to the in-memory image.
+ *  Replay stops at the first block that does not belong to the current journal generation
+ *  or that was torn by a crash.  New journal blocks are appended right after it.
+ */
+static int
+_reduce_md_replay_journal(struct spdk_reduce_vol *vol, uint8_t *journal)
+{
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct reduce_md_journal_header *hdr;
+	struct reduce_md_journal_entry *entry;
+	struct spdk_reduce_chunk_map *chunk;
+	uint64_t num_chunks, total_chunks;
+	uint32_t seq, i, crc, chunk_struct_size;
+	uint8_t *block;
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	total_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
+	chunk_struct_size = _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk);
+
+	for (seq = 0; seq < REDUCE_MD_JOURNAL_NUM_BLOCKS; seq++) {
+		block = journal + (uint64_t)seq * md->journal_block_size;
+		hdr = (struct reduce_md_journal_header *)block;
+		if (memcmp(hdr->signature, SPDK_REDUCE_MD_JOURNAL_SIGNATURE,
+			   sizeof(hdr->signature)) != 0 ||
+		    spdk_uuid_compare(&hdr->uuid, &vol->params.uuid) != 0 ||
+		    hdr->generation != vol->pm_super->md_journal_gen || hdr->seq != seq ||
+		    hdr->num_entries > md->entries_per_block) {
+			break;
+		}
+
+		crc = hdr->crc;
+		hdr->crc = 0;
+		if (_reduce_md_journal_crc(vol, block) != crc) {
+			break;
+		}
+
+		for (i = 0; i < hdr->num_entries; i++) {
+			entry = (struct reduce_md_journal_entry *)(block + sizeof(*hdr) +
+					i * md->entry_size);
+			if (entry->logical_map_index >= num_chunks ||
+			    entry->chunk_map_index >= total_chunks) {
+				SPDK_ERRLOG("invalid metadata journal entry (seq=%" PRIu32 ")\n",
+					    seq);
+				return -EILSEQ;
+			}
+
+			chunk = _reduce_vol_get_chunk_map(vol, entry->chunk_map_index);
+			memcpy(chunk, &entry->chunk, chunk_struct_size);
+			_reduce_md_mark_dirty(vol, chunk, chunk_struct_size);
+			vol->pm_logical_map[entry->logical_map_index] = entry->chunk_map_index;
+			_reduce_md_mark_dirty(vol, &vol->pm_logical_map[entry->logical_map_index],
+					      sizeof(uint64_t));
+		}
+	}
+
+	md->next_seq = seq;
+	return 0;
+}
+
 /* We need 2 iovs during load - one for the superblock, another for the path */
 #define LOAD_IOV_COUNT	2
 
@@ -305,6 +769,9 @@ struct reduce_init_load_ctx {
 	void					*cb_arg;
 	struct iovec				iov[LOAD_IOV_COUNT];
 	void					*path;
+	void					*md_journal;
+	/* Offset of the next part of the metadata image to copy through the bounce buffer. */
+	uint64_t				md_offset;
 };
 
 static inline bool
@@ -432,17 +899,21 @@ _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx
 {
 	if (ctx != NULL) {
 		spdk_free(ctx->path);
+		spdk_free(ctx->md_journal);
 		free(ctx);
 	}
 
 	if (vol != NULL) {
-		if (vol->pm_file.pm_buf != NULL) {
-			pmem_unmap(vol->pm_file.pm_buf, vol->pm_file.size);
+		if (vol->backing_md.enabled) {
+			_free_backing_md(vol);
+		} else if (vol->pm_file.pm_buf != NULL) {
+			_reduce_pm_unmap_file(vol);
 		}
 
 		spdk_free(vol->backing_super);
 		spdk_bit_array_free(&vol->allocated_chunk_maps);
 		spdk_bit_array_free(&vol->allocated_backing_io_units);
+		free(vol->pack.io_unit_used_blocks);
 		free(vol->request_mem);
 		free(vol->buf_iov_mem);
 		spdk_free(vol->buf_mem);
@@ -512,24 +983,165 @@ _init_write_path_cpl(void *cb_arg, int reduce_errno)
 				 &init_ctx->backing_cb_args);
 }
 
+static void
+_init_write_path(struct reduce_init_load_ctx *init_ctx)
+{
+	struct spdk_reduce_vol *vol = init_ctx->vol;
+
+	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
+	init_ctx->iov[0].iov_base = init_ctx->path;
+	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
+	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
+	init_ctx->backing_cb_args.cb_arg = init_ctx;
+	/* Write path to offset 4K on backing device - just after where the super
+	 *  block will be written.  We wait until this is committed before writing the
+	 *  super block to guarantee we don't get the super block written without the
+	 *  the path if the system crashed in the middle of a write operation.
+	 */
+	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
+				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
+				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
+				 &init_ctx->backing_cb_args);
+}
+
+static void _init_write_md(struct reduce_init_load_ctx *init_ctx);
+
+static void
+_init_write_md_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *init_ctx = cb_arg;
+
+	if (reduce_errno != 0) {
+		init_ctx->cb_fn(init_ctx->cb_arg, NULL, reduce_errno);
+		_init_load_cleanup(init_ctx->vol, init_ctx);
+		return;
+	}
+
+	init_ctx->md_offset += init_ctx->iov[0].iov_len;
+	if (init_ctx->md_offset < init_ctx->vol->backing_md.image_size) {
+		_init_write_md(init_ctx);
+		return;
+	}
+
+	_init_write_path(init_ctx);
+}
+
+static void
+_init_write_md(struct reduce_init_load_ctx *init_ctx)
+{
+	struct spdk_reduce_vol *vol = init_ctx->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint64_t len;
+
+	/* The metadata image has to be on the backing device before the path and the super
+	 *  block, otherwise a crash could leave a super block pointing to garbage metadata.
+	 */
+	len = spdk_min(md->image_size - init_ctx->md_offset, md->io_buf_size);
+	memcpy(md->io_buf, (uint8_t *)vol->pm_file.pm_buf + init_ctx->md_offset, len);
+	init_ctx->iov[0].iov_base = md->io_buf;
+	init_ctx->iov[0].iov_len = len;
+	init_ctx->backing_cb_args.cb_fn = _init_write_md_cpl;
+	init_ctx->backing_cb_args.cb_arg = init_ctx;
+	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
+				 (REDUCE_BACKING_DEV_MD_OFFSET + init_ctx->md_offset) /
+				 vol->backing_dev->blocklen,
+				 len / vol->backing_dev->blocklen, &init_ctx->backing_cb_args);
+}
+
+static uint32_t
+_get_num_metadata_io_units(struct spdk_reduce_vol_params *params, uint32_t blocklen,
+			   bool backing_md)
+{
+	if (params->chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED) {
+		return spdk_divide_round_up(backing_md ? _get_backing_md_size(params) :
+					    sizeof(struct spdk_reduce_vol_superblock) + REDUCE_PATH_MAX,
+					    params->backing_io_unit_size);
+	} else if (backing_md) {
+		/* The volume size already excludes the metadata region, so the backing io units
+		 *  holding it are in addition to the ones used for data.
+		 */
+		return spdk_divide_round_up(_get_backing_md_size(params), params->backing_io_unit_size);
+	}
+
+	return (sizeof(struct spdk_reduce_vol_superblock) + REDUCE_PATH_MAX) / blocklen;
+}
+
+/*
+ * Bit arrays and the packed block allocator use 32-bit indices, reject volumes that need more
+ *  bits than that: one per backing io unit, or one per backing device block for the packed layout.
+ */
+static int
+_check_backing_bit_count(struct spdk_reduce_vol_params *params, uint32_t blocklen,
+			 bool backing_md)
+{
+	uint64_t total_chunks, total_bits;
+
+	total_chunks = _get_total_chunks(params->vol_size, params->chunk_size);
+	total_bits = total_chunks * (params->chunk_size / params->backing_io_unit_size);
+	if (backing_md) {
+		total_bits += _get_num_metadata_io_units(params, blocklen, backing_md);
+	}
+	if (params->chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED) {
+		total_bits *= params->backing_io_unit_size / blocklen;
+	}
+
+	if (total_chunks > UINT32_MAX || total_bits > UINT32_MAX) {
+		SPDK_ERRLOG("volume too large: %" PRIu64 " backing %s exceed the supported maximum\n",
+			    total_bits, params->chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED ?
+			    "blocks" : "io units");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int
 _allocate_bit_arrays(struct spdk_reduce_vol *vol)
 {
 	uint64_t total_chunks, total_backing_io_units;
 	uint32_t i, num_metadata_io_units;
+	int rc;
+
+	rc = _check_backing_bit_count(&vol->params, vol->backing_dev->blocklen,
+				      vol->backing_md.enabled);
+	if (rc != 0) {
+		return rc;
+	}
+
+	/* Set backing io unit bits associated with metadata. */
+	num_metadata_io_units = _get_num_metadata_io_units(&vol->params, vol->backing_dev->blocklen,
+				vol->backing_md.enabled);
 
 	total_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
-	vol->allocated_chunk_maps = spdk_bit_array_create(total_chunks);
 	total_backing_io_units = total_chunks * (vol->params.chunk_size / vol->params.backing_io_unit_size);
-	vol->allocated_backing_io_units = spdk_bit_array_create(total_backing_io_units);
+	if (vol->backing_md.enabled) {
+		total_backing_io_units += num_metadata_io_units;
+	}
+
+	vol->allocated_chunk_maps = spdk_bit_array_create(total_chunks);
+	if (_reduce_vol_is_packed(vol)) {
+		vol->pack.num_io_units = total_backing_io_units;
+		vol->pack.io_unit_used_blocks = calloc(total_backing_io_units, sizeof(uint16_t));
+		vol->allocated_backing_io_units = spdk_bit_array_create(total_backing_io_units *
+						  vol->backing_lba_per_io_unit);
+		if (vol->pack.io_unit_used_blocks == NULL) {
+			return -ENOMEM;
+		}
+	} else {
+		vol->allocated_backing_io_units = spdk_bit_array_create(total_backing_io_units);
+	}
 
 	if (vol->allocated_chunk_maps == NULL || vol->allocated_backing_io_units == NULL) {
 		return -ENOMEM;
 	}
 
-	/* Set backing io unit bits associated with metadata. */
-	num_metadata_io_units = (sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
-				vol->backing_dev->blocklen;
+	if (_reduce_vol_is_packed(vol)) {
+		_reduce_vol_pack_set_blocks(vol, 0, num_metadata_io_units * vol->backing_lba_per_io_unit,
+					    true);
+		vol->pack.alloc_cursor = num_metadata_io_units * vol->backing_lba_per_io_unit;
+		return 0;
+	}
+
 	for (i = 0; i < num_metadata_io_units; i++) {
 		spdk_bit_array_set(vol->allocated_backing_io_units, i);
 	}
@@ -548,27 +1160,30 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 {
 	struct spdk_reduce_vol *vol;
 	struct reduce_init_load_ctx *init_ctx;
-	uint64_t backing_dev_size;
+	uint64_t backing_dev_size, backing_md_size;
 	size_t mapped_len;
-	int dir_len, max_dir_len, rc;
+	int dir_len = 0, max_dir_len, rc;
+	bool md_on_backing_dev = (pm_file_dir == NULL || pm_file_dir[0] == '\0');
 
-	SPDK_LOG_DEPRECATED(libreduce_pm_file);
+	if (!md_on_backing_dev) {
+		SPDK_LOG_DEPRECATED(libreduce_pm_file);
 
-	/* We need to append a path separator and the UUID to the supplied
-	 * path.
-	 */
-	max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
-	dir_len = strnlen(pm_file_dir, max_dir_len);
-	/* Strip trailing slash if the user provided one - we will add it back
-	 * later when appending the filename.
-	 */
-	if (pm_file_dir[dir_len - 1] == '/') {
-		dir_len--;
-	}
-	if (dir_len == max_dir_len) {
-		SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
-		cb_fn(cb_arg, NULL, -EINVAL);
-		return;
+		/* We need to append a path separator and the UUID to the supplied
+		 * path.
+		 */
+		max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
+		dir_len = strnlen(pm_file_dir, max_dir_len);
+		/* Strip trailing slash if the user provided one - we will add it back
+		 * later when appending the filename.
+		 */
+		if (pm_file_dir[dir_len - 1] == '/') {
+			dir_len--;
+		}
+		if (dir_len == max_dir_len) {
+			SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
+			cb_fn(cb_arg, NULL, -EINVAL);
+			return;
+		}
 	}
 
 	rc = _validate_vol_params(params);
@@ -578,14 +1193,50 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 		return;
 	}
 
+	if (params->chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED &&
+	    (params->backing_io_unit_size % backing_dev->blocklen != 0 ||
+	     params->backing_io_unit_size / backing_dev->blocklen > UINT16_MAX)) {
+		SPDK_ERRLOG("backing io unit size %" PRIu32 " not supported for packed chunks\n",
+			    params->backing_io_unit_size);
+		cb_fn(cb_arg, NULL, -EINVAL);
+		return;
+	}
+
 	backing_dev_size = backing_dev->blockcnt * backing_dev->blocklen;
 	params->vol_size = _get_vol_size(params->chunk_size, backing_dev_size);
+	if (params->vol_size != 0 && md_on_backing_dev) {
+		if (REDUCE_MD_PAGE_SIZE % backing_dev->blocklen != 0) {
+			SPDK_ERRLOG("backing device block size %" PRIu32
+				    " not supported for metadata\n", backing_dev->blocklen);
+			cb_fn(cb_arg, NULL, -EINVAL);
+			return;
+		}
+
+		/* The metadata size computed from the upper bound of the volume size is never
+		 *  smaller than the one computed from the final volume size.
+		 */
+		backing_md_size = spdk_divide_round_up(_get_backing_md_size(params),
+						       params->backing_io_unit_size);
+		backing_md_size *= params->backing_io_unit_size;
+		if (backing_md_size < backing_dev_size) {
+			params->vol_size = _get_vol_size(params->chunk_size,
+							 backing_dev_size - backing_md_size);
+		} else {
+			params->vol_size = 0;
+		}
+	}
 	if (params->vol_size == 0) {
 		SPDK_ERRLOG("backing device is too small\n");
 		cb_fn(cb_arg, NULL, -EINVAL);
 		return;
 	}
 
+	rc = _check_backing_bit_count(params, backing_dev->blocklen, md_on_backing_dev);
+	if (rc != 0) {
+		cb_fn(cb_arg, NULL, rc);
+		return;
+	}
+
 	if (backing_dev->readv == NULL || backing_dev->writev == NULL ||
 	    backing_dev->unmap == NULL) {
 		SPDK_ERRLOG("backing_dev function pointer not specified\n");
@@ -630,30 +1281,6 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 		spdk_uuid_generate(&params->uuid);
 	}
 
-	memcpy(vol->pm_file.path, pm_file_dir, dir_len);
-	vol->pm_file.path[dir_len] = '/';
-	spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
-			    &params->uuid);
-	vol->pm_file.size = _get_pm_file_size(params);
-	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, vol->pm_file.size,
-					    PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
-					    &mapped_len, &vol->pm_file.pm_is_pmem);
-	if (vol->pm_file.pm_buf == NULL) {
-		SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
-			    vol->pm_file.path, strerror(errno));
-		cb_fn(cb_arg, NULL, -errno);
-		_init_load_cleanup(vol, init_ctx);
-		return;
-	}
-
-	if (vol->pm_file.size != mapped_len) {
-		SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
-			    vol->pm_file.size, mapped_len);
-		cb_fn(cb_arg, NULL, -ENOMEM);
-		_init_load_cleanup(vol, init_ctx);
-		return;
-	}
-
 	vol->backing_io_units_per_chunk = params->chunk_size / params->backing_io_unit_size;
 	vol->logical_blocks_per_chunk = params->chunk_size / params->logical_block_size;
 	vol->backing_lba_per_io_unit = params->backing_io_unit_size / backing_dev->blocklen;
@@ -661,6 +1288,39 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 
 	vol->backing_dev = backing_dev;
 
+	if (md_on_backing_dev) {
+		/* An empty path on the backing device means the metadata lives on it too. */
+		vol->backing_md.enabled = true;
+		rc = _allocate_backing_md(vol);
+		if (rc != 0) {
+			cb_fn(cb_arg, NULL, rc);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+	} else {
+		memcpy(vol->pm_file.path, pm_file_dir, dir_len);
+		vol->pm_file.path[dir_len] = '/';
+		spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
+				    &params->uuid);
+		vol->pm_file.size = _get_pm_file_size(params);
+		vol->pm_file.pm_buf = _reduce_pm_map_file(vol, true, &mapped_len);
+		if (vol->pm_file.pm_buf == NULL) {
+			SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
+				    vol->pm_file.path, strerror(errno));
+			cb_fn(cb_arg, NULL, -errno);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+
+		if (vol->pm_file.size != mapped_len) {
+			SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
+				    vol->pm_file.size, mapped_len);
+			cb_fn(cb_arg, NULL, -ENOMEM);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+	}
+
 	rc = _allocate_bit_arrays(vol);
 	if (rc != 0) {
 		cb_fn(cb_arg, NULL, rc);
@@ -679,40 +1339,158 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 	 * Note that this writes 0xFF to not just the logical map but the chunk maps as well.
 	 */
 	memset(vol->pm_logical_map, 0xFF, vol->pm_file.size - sizeof(*vol->backing_super));
-	_reduce_persist(vol, vol->pm_file.pm_buf, vol->pm_file.size);
 
 	init_ctx->vol = vol;
 	init_ctx->cb_fn = cb_fn;
 	init_ctx->cb_arg = cb_arg;
 
-	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
-	init_ctx->iov[0].iov_base = init_ctx->path;
-	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
-	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
-	init_ctx->backing_cb_args.cb_arg = init_ctx;
-	/* Write path to offset 4K on backing device - just after where the super
-	 *  block will be written.  We wait until this is committed before writing the
-	 *  super block to guarantee we don't get the super block written without the
-	 *  the path if the system crashed in the middle of a write operation.
-	 */
-	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
-				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
-				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
-				 &init_ctx->backing_cb_args);
+	if (vol->backing_md.enabled) {
+		/* Start from an arbitrary journal generation, so that journal blocks left over
+		 *  from a previous volume on the same backing device are never replayed.
+		 */
+		vol->pm_super->md_journal_gen = spdk_get_ticks();
+		_init_write_md(init_ctx);
+		return;
+	}
+
+	_reduce_persist(vol, vol->pm_file.pm_buf, vol->pm_file.size);
+	_init_write_path(init_ctx);
 }
 
 static void destroy_load_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno);
 
+static void
+_load_allocated_maps(struct spdk_reduce_vol *vol)
+{
+	struct spdk_reduce_chunk_map *chunk;
+	uint64_t i, num_chunks, logical_map_index;
+	uint32_t j, stored_size;
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	for (i = 0; i < num_chunks; i++) {
+		logical_map_index = vol->pm_logical_map[i];
+		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
+			continue;
+		}
+		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
+		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
+		stored_size = _reduce_vol_chunk_stored_size(vol, chunk->compressed_size);
+		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
+			if (chunk->io_unit_index[j] == REDUCE_EMPTY_MAP_ENTRY) {
+				continue;
+			}
+			if (_reduce_vol_is_packed(vol)) {
+				_reduce_vol_pack_set_blocks(vol, chunk->io_unit_index[j],
+							    _reduce_vol_pack_piece_blocks(vol, stored_size, j), true);
+			} else {
+				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
+			}
+		}
+	}
+}
+
+static void
+_load_read_md_journal_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	int rc = reduce_errno;
+
+	if (rc == 0) {
+		rc = _reduce_md_replay_journal(vol, load_ctx->md_journal);
+	}
+
+	if (rc != 0) {
+		load_ctx->cb_fn(load_ctx->cb_arg, NULL, rc);
+		_init_load_cleanup(vol, load_ctx);
+		return;
+	}
+
+	_load_allocated_maps(vol);
+
+	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
+	_init_load_cleanup(NULL, load_ctx);
+}
+
+static void _load_read_md_image(struct reduce_init_load_ctx *load_ctx);
+
+static void
+_load_read_md_image_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint64_t journal_size;
+	int rc = reduce_errno;
+
+	if (rc != 0) {
+		goto error;
+	}
+
+	memcpy((uint8_t *)vol->pm_file.pm_buf + load_ctx->md_offset, md->io_buf,
+	       load_ctx->iov[0].iov_len);
+	load_ctx->md_offset += load_ctx->iov[0].iov_len;
+	if (load_ctx->md_offset < md->image_size) {
+		_load_read_md_image(load_ctx);
+		return;
+	}
+
+	if (memcmp(vol->pm_super->signature, SPDK_REDUCE_SIGNATURE,
+		   sizeof(vol->pm_super->signature)) != 0 ||
+	    memcmp(&vol->pm_super->params, &vol->params, sizeof(vol->params)) != 0) {
+		SPDK_ERRLOG("metadata on backing device does not match the super block\n");
+		rc = -EILSEQ;
+		goto error;
+	}
+
+	journal_size = (uint64_t)REDUCE_MD_JOURNAL_NUM_BLOCKS * md->journal_block_size;
+	load_ctx->md_journal = spdk_zmalloc(journal_size, REDUCE_MD_PAGE_SIZE, NULL,
+					    SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (load_ctx->md_journal == NULL) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	load_ctx->iov[0].iov_base = load_ctx->md_journal;
+	load_ctx->iov[0].iov_len = journal_size;
+	load_ctx->backing_cb_args.cb_fn = _load_read_md_journal_cpl;
+	load_ctx->backing_cb_args.cb_arg = load_ctx;
+	vol->backing_dev->readv(vol->backing_dev, load_ctx->iov, 1,
+				md->journal_offset / vol->backing_dev->blocklen,
+				journal_size / vol->backing_dev->blocklen,
+				&load_ctx->backing_cb_args);
+	return;
+
+error:
+	load_ctx->cb_fn(load_ctx->cb_arg, NULL, rc);
+	_init_load_cleanup(vol, load_ctx);
+}
+
+static void
+_load_read_md_image(struct reduce_init_load_ctx *load_ctx)
+{
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint64_t len;
+
+	len = spdk_min(md->image_size - load_ctx->md_offset, md->io_buf_size);
+	load_ctx->iov[0].iov_base = md->io_buf;
+	load_ctx->iov[0].iov_len = len;
+	load_ctx->backing_cb_args.cb_fn = _load_read_md_image_cpl;
+	load_ctx->backing_cb_args.cb_arg = load_ctx;
+	vol->backing_dev->readv(vol->backing_dev, load_ctx->iov, 1,
+				(REDUCE_BACKING_DEV_MD_OFFSET + load_ctx->md_offset) /
+				vol->backing_dev->blocklen,
+				len / vol->backing_dev->blocklen, &load_ctx->backing_cb_args);
+}
+
 static void
 _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 {
 	struct reduce_init_load_ctx *load_ctx = cb_arg;
 	struct spdk_reduce_vol *vol = load_ctx->vol;
 	uint64_t backing_dev_size;
-	uint64_t i, num_chunks, logical_map_index;
-	struct spdk_reduce_chunk_map *chunk;
 	size_t mapped_len;
-	uint32_t j;
 	int rc;
 
 	rc = _alloc_zero_buff();
@@ -744,6 +1522,7 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 	vol->backing_io_units_per_chunk = vol->params.chunk_size / vol->params.backing_io_unit_size;
 	vol->logical_blocks_per_chunk = vol->params.chunk_size / vol->params.logical_block_size;
 	vol->backing_lba_per_io_unit = vol->params.backing_io_unit_size / vol->backing_dev->blocklen;
+	vol->backing_md.enabled = (vol->pm_file.path[0] == '\0');
 
 	rc = _allocate_bit_arrays(vol);
 	if (rc != 0) {
@@ -758,9 +1537,24 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 		goto error;
 	}
 
+	if (vol->backing_md.enabled) {
+		rc = _allocate_backing_md(vol);
+		if (rc != 0) {
+			goto error;
+		}
+
+		rc = _allocate_vol_requests(vol);
+		if (rc != 0) {
+			goto error;
+		}
+
+		_initialize_vol_pm_pointers(vol);
+		_load_read_md_image(load_ctx);
+		return;
+	}
+
 	vol->pm_file.size = _get_pm_file_size(&vol->params);
-	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, 0, 0, 0, &mapped_len,
-					    &vol->pm_file.pm_is_pmem);
+	vol->pm_file.pm_buf = _reduce_pm_map_file(vol, false, &mapped_len);
 	if (vol->pm_file.pm_buf == NULL) {
 		SPDK_ERRLOG("could not pmem_map_file(%s): %s\n", vol->pm_file.path, strerror(errno));
 		rc = -errno;
@@ -780,21 +1574,7 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 	}
 
 	_initialize_vol_pm_pointers(vol);
-
-	num_chunks = vol->params.vol_size / vol->params.chunk_size;
-	for (i = 0; i < num_chunks; i++) {
-		logical_map_index = vol->pm_logical_map[i];
-		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
-			continue;
-		}
-		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
-		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
-		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
-			if (chunk->io_unit_index[j] != REDUCE_EMPTY_MAP_ENTRY) {
-				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
-			}
-		}
-	}
+	_load_allocated_maps(vol);
 
 	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
 	/* Only clean up the ctx - the vol has been passed to the application
@@ -857,166 +1637,576 @@ spdk_reduce_vol_load(struct spdk_reduce_backing_dev *backing_dev,
 		return;
 	}
 
-	load_ctx->vol = vol;
-	load_ctx->cb_fn = cb_fn;
-	load_ctx->cb_arg = cb_arg;
+	load_ctx->vol = vol;
+	load_ctx->cb_fn = cb_fn;
+	load_ctx->cb_arg = cb_arg;
+
+	load_ctx->iov[0].iov_base = vol->backing_super;
+	load_ctx->iov[0].iov_len = sizeof(*vol->backing_super);
+	load_ctx->iov[1].iov_base = load_ctx->path;
+	load_ctx->iov[1].iov_len = REDUCE_PATH_MAX;
+	load_ctx->backing_cb_args.cb_fn = _load_read_super_and_path_cpl;
+	load_ctx->backing_cb_args.cb_arg = load_ctx;
+	vol->backing_dev->readv(vol->backing_dev, load_ctx->iov, LOAD_IOV_COUNT, 0,
+				(sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
+				vol->backing_dev->blocklen,
+				&load_ctx->backing_cb_args);
+}
+
+static void
+_reduce_vol_unload(struct spdk_reduce_vol *vol, spdk_reduce_vol_op_complete cb_fn, void *cb_arg,
+		   int reduce_errno)
+{
+	if (--g_vol_count == 0) {
+		spdk_free(g_zero_buf);
+	}
+	assert(g_vol_count >= 0);
+	_init_load_cleanup(vol, NULL);
+	cb_fn(cb_arg, reduce_errno);
+}
+
+static void
+_unload_md_writeback_cpl(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+
+	_reduce_vol_unload(vol, vol->backing_md.unload_cb_fn, vol->backing_md.unload_cb_arg,
+			   reduce_errno);
+}
+
+void
+spdk_reduce_vol_unload(struct spdk_reduce_vol *vol,
+		       spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+{
+	if (vol == NULL) {
+		/* This indicates a programming error. */
+		assert(false);
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	if (vol->pack.compact_in_progress) {
+		/* Compaction is internal to the volume, let it finish before tearing down. */
+		vol->pack.unload_cb_fn = cb_fn;
+		vol->pack.unload_cb_arg = cb_arg;
+		return;
+	}
+
+	/* Write back the metadata pages updated since the last write-back, so that the
+	 *  next load does not need to replay the journal.
+	 */
+	if (vol->backing_md.enabled && vol->backing_md.next_seq > 0) {
+		assert(!vol->backing_md.flush_in_progress);
+		assert(!vol->backing_md.writeback_in_progress);
+		vol->backing_md.unload_cb_fn = cb_fn;
+		vol->backing_md.unload_cb_arg = cb_arg;
+		_reduce_md_writeback(vol, _unload_md_writeback_cpl, vol);
+		return;
+	}
+
+	_reduce_vol_unload(vol, cb_fn, cb_arg, 0);
+}
+
+struct reduce_destroy_ctx {
+	spdk_reduce_vol_op_complete		cb_fn;
+	void					*cb_arg;
+	struct spdk_reduce_vol			*vol;
+	struct spdk_reduce_vol_superblock	*super;
+	struct iovec				iov;
+	struct spdk_reduce_vol_cb_args		backing_cb_args;
+	int					reduce_errno;
+	char					pm_path[REDUCE_PATH_MAX];
+};
+
+static void
+destroy_unload_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
+
+	/* There is no pm file to delete when the metadata lived on the backing device. */
+	if (destroy_ctx->reduce_errno == 0 && destroy_ctx->pm_path[0] != '\0') {
+		if (unlink(destroy_ctx->pm_path)) {
+			SPDK_ERRLOG("%s could not be unlinked: %s\n",
+				    destroy_ctx->pm_path, strerror(errno));
+		}
+	}
+
+	/* Even if the unload somehow failed, we still pass the destroy_ctx
+	 * reduce_errno since that indicates whether or not the volume was
+	 * actually destroyed.
+	 */
+	destroy_ctx->cb_fn(destroy_ctx->cb_arg, destroy_ctx->reduce_errno);
+	spdk_free(destroy_ctx->super);
+	free(destroy_ctx);
+}
+
+static void
+_destroy_zero_super_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = destroy_ctx->vol;
+
+	destroy_ctx->reduce_errno = reduce_errno;
+	spdk_reduce_vol_unload(vol, destroy_unload_cpl, destroy_ctx);
+}
+
+static void
+destroy_load_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno)
+{
+	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
+
+	if (reduce_errno != 0) {
+		destroy_ctx->cb_fn(destroy_ctx->cb_arg, reduce_errno);
+		spdk_free(destroy_ctx->super);
+		free(destroy_ctx);
+		return;
+	}
+
+	destroy_ctx->vol = vol;
+	memcpy(destroy_ctx->pm_path, vol->pm_file.path, sizeof(destroy_ctx->pm_path));
+	destroy_ctx->iov.iov_base = destroy_ctx->super;
+	destroy_ctx->iov.iov_len = sizeof(*destroy_ctx->super);
+	destroy_ctx->backing_cb_args.cb_fn = _destroy_zero_super_cpl;
+	destroy_ctx->backing_cb_args.cb_arg = destroy_ctx;
+	vol->backing_dev->writev(vol->backing_dev, &destroy_ctx->iov, 1, 0,
+				 sizeof(*destroy_ctx->super) / vol->backing_dev->blocklen,
+				 &destroy_ctx->backing_cb_args);
+}
+
+void
+spdk_reduce_vol_destroy(struct spdk_reduce_backing_dev *backing_dev,
+			spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+{
+	struct reduce_destroy_ctx *destroy_ctx;
+
+	destroy_ctx = calloc(1, sizeof(*destroy_ctx));
+	if (destroy_ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	destroy_ctx->super = spdk_zmalloc(sizeof(*destroy_ctx->super), 64, NULL,
+					  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (destroy_ctx->super == NULL) {
+		free(destroy_ctx);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	destroy_ctx->cb_fn = cb_fn;
+	destroy_ctx->cb_arg = cb_arg;
+	spdk_reduce_vol_load(backing_dev, destroy_load_cb, destroy_ctx);
+}
+
+static bool
+_request_spans_chunk_boundary(struct spdk_reduce_vol *vol, uint64_t offset, uint64_t length)
+{
+	uint64_t start_chunk, end_chunk;
+
+	start_chunk = offset / vol->logical_blocks_per_chunk;
+	end_chunk = (offset + length - 1) / vol->logical_blocks_per_chunk;
+
+	return (start_chunk != end_chunk);
+}
+
+typedef void (*reduce_request_fn)(void *_req, int reduce_errno);
+
+static void
+_reduce_vol_complete_req(struct spdk_reduce_vol_request *req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *next_req;
+	struct spdk_reduce_vol *vol = req->vol;
+
+	req->cb_fn(req->cb_arg, reduce_errno);
+	TAILQ_REMOVE(&vol->executing_requests, req, tailq);
+
+	TAILQ_FOREACH(next_req, &vol->queued_requests, tailq) {
+		if (next_req->logical_map_index == req->logical_map_index) {
+			TAILQ_REMOVE(&vol->queued_requests, next_req, tailq);
+			if (next_req->type == REDUCE_IO_READV) {
+				_start_readv_request(next_req);
+			} else {
+				assert(next_req->type == REDUCE_IO_WRITEV);
+				_start_writev_request(next_req);
+			}
+			break;
+		}
+	}
+
+	TAILQ_INSERT_HEAD(&vol->free_requests, req, tailq);
+
+	if (req->type == REDUCE_IO_COMPACT && vol->pack.unload_cb_fn != NULL) {
+		/* Nothing may touch the volume after this, it is freed by the unload. */
+		spdk_reduce_vol_unload(vol, vol->pack.unload_cb_fn, vol->pack.unload_cb_arg);
+		return;
+	}
+
+	_reduce_vol_maybe_compact(vol);
+}
+
+static void
+_reduce_vol_release_chunk(struct spdk_reduce_vol *vol, uint64_t chunk_map_index)
+{
+	struct spdk_reduce_chunk_map *chunk;
+	uint32_t i, stored_size;
+
+	chunk = _reduce_vol_get_chunk_map(vol, chunk_map_index);
+	stored_size = _reduce_vol_chunk_stored_size(vol, chunk->compressed_size);
+	for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
+		if (chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
+			break;
+		}
+		if (_reduce_vol_is_packed(vol)) {
+			_reduce_vol_pack_set_blocks(vol, chunk->io_unit_index[i],
+						    _reduce_vol_pack_piece_blocks(vol, stored_size, i), false);
+		} else {
+			assert(spdk_bit_array_get(vol->allocated_backing_io_units,
+						  chunk->io_unit_index[i]) == true);
+			spdk_bit_array_clear(vol->allocated_backing_io_units, chunk->io_unit_index[i]);
+		}
+		chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
+	}
+	spdk_bit_array_clear(vol->allocated_chunk_maps, chunk_map_index);
+}
+
+/*
+ * Make the new chunk map of a journaled write visible.  This only happens once its journal
+ *  entry is on the backing device, so the io units of the old chunk cannot be reused (and
+ *  overwritten) while the on-disk metadata may still reference them.
+ */
+static void
+_reduce_md_commit_req(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	uint64_t old_chunk_map_index;
+
+	old_chunk_map_index = vol->pm_logical_map[req->logical_map_index];
+	if (old_chunk_map_index != REDUCE_EMPTY_MAP_ENTRY) {
+		_reduce_vol_release_chunk(vol, old_chunk_map_index);
+	}
+
+	vol->pm_logical_map[req->logical_map_index] = req->chunk_map_index;
+	_reduce_md_mark_dirty(vol, &vol->pm_logical_map[req->logical_map_index], sizeof(uint64_t));
+	_reduce_md_mark_dirty(vol, req->chunk,
+			      _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk));
+}
+
+static void _reduce_md_journal_flush(struct spdk_reduce_vol *vol);
+
+static void
+_reduce_md_journal_add_entry(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct reduce_md_journal_entry *entry;
+
+	assert(md->open_entries < md->entries_per_block);
+	entry = (struct reduce_md_journal_entry *)(md->open_block +
+			sizeof(struct reduce_md_journal_header) + md->open_entries * md->entry_size);
+	entry->logical_map_index = req->logical_map_index;
+	entry->chunk_map_index = req->chunk_map_index;
+	memcpy(&entry->chunk, req->chunk,
+	       _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk));
+	md->open_entries++;
+	TAILQ_INSERT_TAIL(&md->open_requests, req, md_tailq);
+}
+
+static void
+_reduce_md_journal_resume(struct spdk_reduce_vol *vol)
+{
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct spdk_reduce_vol_request *req;
+
+	while (!TAILQ_EMPTY(&md->waiting_requests) && md->open_entries < md->entries_per_block) {
+		req = TAILQ_FIRST(&md->waiting_requests);
+		TAILQ_REMOVE(&md->waiting_requests, req, md_tailq);
+		_reduce_md_journal_add_entry(req);
+	}
+
+	_reduce_md_journal_flush(vol);
+}
+
+static void
+_reduce_md_journal_append(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_backing_md *md = &req->vol->backing_md;
+
+	if (!TAILQ_EMPTY(&md->waiting_requests) || md->open_entries == md->entries_per_block) {
+		TAILQ_INSERT_TAIL(&md->waiting_requests, req, md_tailq);
+		return;
+	}
+
+	_reduce_md_journal_add_entry(req);
+	_reduce_md_journal_flush(req->vol);
+}
+
+static void
+_reduce_md_fail_requests(struct spdk_reduce_vol *vol, int reduce_errno)
+{
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct spdk_reduce_vol_request *req;
+
+	TAILQ_HEAD(, spdk_reduce_vol_request) requests = TAILQ_HEAD_INITIALIZER(requests);
+
+	TAILQ_SWAP(&requests, &md->open_requests, spdk_reduce_vol_request, md_tailq);
+	md->open_entries = 0;
+	while (!TAILQ_EMPTY(&md->waiting_requests)) {
+		req = TAILQ_FIRST(&md->waiting_requests);
+		TAILQ_REMOVE(&md->waiting_requests, req, md_tailq);
+		TAILQ_INSERT_TAIL(&requests, req, md_tailq);
+	}
+
+	while (!TAILQ_EMPTY(&requests)) {
+		req = TAILQ_FIRST(&requests);
+		TAILQ_REMOVE(&requests, req, md_tailq);
+		_reduce_vol_release_chunk(vol, req->chunk_map_index);
+		_reduce_vol_complete_req(req, reduce_errno);
+	}
+}
+
+static void
+_reduce_md_journal_flush_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct spdk_reduce_vol_request *req;
+	TAILQ_HEAD(, spdk_reduce_vol_request) requests = TAILQ_HEAD_INITIALIZER(requests);
+
+	TAILQ_SWAP(&requests, &md->flush_requests, spdk_reduce_vol_request, md_tailq);
+	md->flush_in_progress = false;
+	if (reduce_errno != 0) {
+		/* Reuse the journal block, replay must not stop in front of later blocks. */
+		md->next_seq--;
+	}
+
+	TAILQ_FOREACH(req, &requests, md_tailq) {
+		if (reduce_errno == 0) {
+			_reduce_md_commit_req(req);
+		} else {
+			_reduce_vol_release_chunk(vol, req->chunk_map_index);
+		}
+	}
+
+	/* Resume before completing, the last completion may unload the volume. */
+	_reduce_md_journal_resume(vol);
 
-	load_ctx->iov[0].iov_base = vol->backing_super;
-	load_ctx->iov[0].iov_len = sizeof(*vol->backing_super);
-	load_ctx->iov[1].iov_base = load_ctx->path;
-	load_ctx->iov[1].iov_len = REDUCE_PATH_MAX;
-	load_ctx->backing_cb_args.cb_fn = _load_read_super_and_path_cpl;
-	load_ctx->backing_cb_args.cb_arg = load_ctx;
-	vol->backing_dev->readv(vol->backing_dev, load_ctx->iov, LOAD_IOV_COUNT, 0,
-				(sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
-				vol->backing_dev->blocklen,
-				&load_ctx->backing_cb_args);
+	while (!TAILQ_EMPTY(&requests)) {
+		req = TAILQ_FIRST(&requests);
+		TAILQ_REMOVE(&requests, req, md_tailq);
+		_reduce_vol_complete_req(req, reduce_errno);
+	}
 }
 
-void
-spdk_reduce_vol_unload(struct spdk_reduce_vol *vol,
-		       spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+/*
+ * Write out the open journal block.  Only one journal block is written at a time, entries
+ *  appended in the meantime are batched into the next one.
+ */
+static void
+_reduce_md_journal_flush(struct spdk_reduce_vol *vol)
 {
-	if (vol == NULL) {
-		/* This indicates a programming error. */
-		assert(false);
-		cb_fn(cb_arg, -EINVAL);
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct reduce_md_journal_header *hdr;
+	uint64_t offset;
+	uint8_t *block;
+
+	if (md->flush_in_progress || md->writeback_in_progress || md->open_entries == 0) {
 		return;
 	}
 
-	if (--g_vol_count == 0) {
-		spdk_free(g_zero_buf);
+	if (md->next_seq == REDUCE_MD_JOURNAL_NUM_BLOCKS) {
+		/* The journal is full - write back the metadata so that it can be reused. */
+		_reduce_md_writeback(vol, NULL, NULL);
+		return;
 	}
-	assert(g_vol_count >= 0);
-	_init_load_cleanup(vol, NULL);
-	cb_fn(cb_arg, 0);
-}
 
-struct reduce_destroy_ctx {
-	spdk_reduce_vol_op_complete		cb_fn;
-	void					*cb_arg;
-	struct spdk_reduce_vol			*vol;
-	struct spdk_reduce_vol_superblock	*super;
-	struct iovec				iov;
-	struct spdk_reduce_vol_cb_args		backing_cb_args;
-	int					reduce_errno;
-	char					pm_path[REDUCE_PATH_MAX];
-};
+	block = md->open_block;
+	hdr = (struct reduce_md_journal_header *)block;
+	memcpy(hdr->signature, SPDK_REDUCE_MD_JOURNAL_SIGNATURE, sizeof(hdr->signature));
+	hdr->uuid = vol->params.uuid;
+	hdr->generation = vol->pm_super->md_journal_gen;
+	hdr->seq = md->next_seq;
+	hdr->num_entries = md->open_entries;
+	hdr->reserved = 0;
+	hdr->crc = 0;
+	hdr->crc = _reduce_md_journal_crc(vol, block);
+
+	md->open_block = md->flush_block;
+	md->flush_block = block;
+	md->open_entries = 0;
+	TAILQ_SWAP(&md->flush_requests, &md->open_requests, spdk_reduce_vol_request, md_tailq);
+	md->flush_in_progress = true;
+
+	md->flush_iov.iov_base = block;
+	md->flush_iov.iov_len = md->journal_block_size;
+	md->flush_cb_args.cb_fn = _reduce_md_journal_flush_done;
+	md->flush_cb_args.cb_arg = vol;
+	offset = md->journal_offset + (uint64_t)md->next_seq * md->journal_block_size;
+	vol->backing_dev->writev(vol->backing_dev, &md->flush_iov, 1,
+				 offset / vol->backing_dev->blocklen,
+				 md->journal_block_size / vol->backing_dev->blocklen,
+				 &md->flush_cb_args);
+	md->next_seq++;
+}
 
 static void
-destroy_unload_cpl(void *cb_arg, int reduce_errno)
+_reduce_md_writeback_finish(struct spdk_reduce_vol *vol, int reduce_errno)
 {
-	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	spdk_reduce_vol_op_complete cb_fn = md->writeback_cb_fn;
+	void *cb_arg = md->writeback_cb_arg;
 
-	if (destroy_ctx->reduce_errno == 0) {
-		if (unlink(destroy_ctx->pm_path)) {
-			SPDK_ERRLOG("%s could not be unlinked: %s\n",
-				    destroy_ctx->pm_path, strerror(errno));
-		}
+	md->writeback_in_progress = false;
+	md->writeback_cb_fn = NULL;
+	md->writeback_cb_arg = NULL;
+
+	if (cb_fn != NULL) {
+		cb_fn(cb_arg, reduce_errno);
+		return;
 	}
 
-	/* Even if the unload somehow failed, we still pass the destroy_ctx
-	 * reduce_errno since that indicates whether or not the volume was
-	 * actually destroyed.
-	 */
-	destroy_ctx->cb_fn(destroy_ctx->cb_arg, destroy_ctx->reduce_errno);
-	spdk_free(destroy_ctx->super);
-	free(destroy_ctx);
+	if (reduce_errno != 0) {
+		/* The journal is still full, so nothing waiting on it can make progress. */
+		SPDK_ERRLOG("metadata write-back failed: %s\n", spdk_strerror(-reduce_errno));
+		_reduce_md_fail_requests(vol, reduce_errno);
+		return;
+	}
+
+	_reduce_md_journal_resume(vol);
 }
 
 static void
-_destroy_zero_super_cpl(void *cb_arg, int reduce_errno)
+_reduce_md_writeback_header_done(void *cb_arg, int reduce_errno)
 {
-	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
-	struct spdk_reduce_vol *vol = destroy_ctx->vol;
+	struct reduce_md_writer *writer = cb_arg;
+	struct spdk_reduce_vol *vol = writer->vol;
 
-	destroy_ctx->reduce_errno = reduce_errno;
-	spdk_reduce_vol_unload(vol, destroy_unload_cpl, destroy_ctx);
+	if (reduce_errno != 0) {
+		/* Keep the journal blocks of the current generation valid. */
+		vol->pm_super->md_journal_gen--;
+	} else {
+		vol->backing_md.next_seq = 0;
+	}
+
+	_reduce_md_writeback_finish(vol, reduce_errno);
 }
 
 static void
-destroy_load_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno)
+_reduce_md_writeback_put(struct spdk_reduce_vol *vol)
 {
-	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	struct reduce_md_writer *writer = &md->writers[0];
 
-	if (reduce_errno != 0) {
-		destroy_ctx->cb_fn(destroy_ctx->cb_arg, reduce_errno);
-		spdk_free(destroy_ctx->super);
-		free(destroy_ctx);
+	assert(md->writeback_outstanding > 0);
+	if (--md->writeback_outstanding > 0) {
 		return;
 	}
 
-	destroy_ctx->vol = vol;
-	memcpy(destroy_ctx->pm_path, vol->pm_file.path, sizeof(destroy_ctx->pm_path));
-	destroy_ctx->iov.iov_base = destroy_ctx->super;
-	destroy_ctx->iov.iov_len = sizeof(*destroy_ctx->super);
-	destroy_ctx->backing_cb_args.cb_fn = _destroy_zero_super_cpl;
-	destroy_ctx->backing_cb_args.cb_arg = destroy_ctx;
-	vol->backing_dev->writev(vol->backing_dev, &destroy_ctx->iov, 1, 0,
-				 sizeof(*destroy_ctx->super) / vol->backing_dev->blocklen,
-				 &destroy_ctx->backing_cb_args);
+	if (md->writeback_errno != 0) {
+		_reduce_md_writeback_finish(vol, md->writeback_errno);
+		return;
+	}
+
+	/* All metadata pages are on the backing device, so bumping the journal generation
+	 *  in the header page invalidates every journal block written so far.
+	 */
+	vol->pm_super->md_journal_gen++;
+	memcpy(writer->buf, vol->pm_super, REDUCE_MD_PAGE_SIZE);
+	writer->offset = 0;
+	writer->iov.iov_base = writer->buf;
+	writer->iov.iov_len = REDUCE_MD_PAGE_SIZE;
+	writer->backing_cb_args.cb_fn = _reduce_md_writeback_header_done;
+	writer->backing_cb_args.cb_arg = writer;
+	vol->backing_dev->writev(vol->backing_dev, &writer->iov, 1,
+				 REDUCE_BACKING_DEV_MD_OFFSET / vol->backing_dev->blocklen,
+				 REDUCE_MD_PAGE_SIZE / vol->backing_dev->blocklen,
+				 &writer->backing_cb_args);
 }
 
-void
-spdk_reduce_vol_destroy(struct spdk_reduce_backing_dev *backing_dev,
-			spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+static bool _reduce_md_writeback_next(struct reduce_md_writer *writer);
+
+static void
+_reduce_md_writeback_done(void *cb_arg, int reduce_errno)
 {
-	struct reduce_destroy_ctx *destroy_ctx;
+	struct reduce_md_writer *writer = cb_arg;
+	struct spdk_reduce_vol *vol = writer->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
 
-	destroy_ctx = calloc(1, sizeof(*destroy_ctx));
-	if (destroy_ctx == NULL) {
-		cb_fn(cb_arg, -ENOMEM);
-		return;
+	if (reduce_errno != 0) {
+		md->writeback_errno = reduce_errno;
+		_reduce_md_mark_dirty(vol, (uint8_t *)vol->pm_file.pm_buf + writer->offset,
+				      writer->iov.iov_len);
 	}
 
-	destroy_ctx->super = spdk_zmalloc(sizeof(*destroy_ctx->super), 64, NULL,
-					  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	if (destroy_ctx->super == NULL) {
-		free(destroy_ctx);
-		cb_fn(cb_arg, -ENOMEM);
-		return;
+	if (md->writeback_errno == 0) {
+		_reduce_md_writeback_next(writer);
 	}
-	destroy_ctx->cb_fn = cb_fn;
-	destroy_ctx->cb_arg = cb_arg;
-	spdk_reduce_vol_load(backing_dev, destroy_load_cb, destroy_ctx);
+
+	_reduce_md_writeback_put(vol);
 }
 
 static bool
-_request_spans_chunk_boundary(struct spdk_reduce_vol *vol, uint64_t offset, uint64_t length)
+_reduce_md_writeback_next(struct reduce_md_writer *writer)
 {
-	uint64_t start_chunk, end_chunk;
+	struct spdk_reduce_vol *vol = writer->vol;
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint32_t first_page, num_pages = 0;
+	uint64_t offset;
 
-	start_chunk = offset / vol->logical_blocks_per_chunk;
-	end_chunk = (offset + length - 1) / vol->logical_blocks_per_chunk;
+	first_page = spdk_bit_array_find_first_set(md->dirty_pages, md->writeback_next_page);
+	if (first_page == UINT32_MAX) {
+		return false;
+	}
 
-	return (start_chunk != end_chunk);
+	/* Write back runs of contiguous dirty pages with a single I/O. */
+	while (num_pages < md->writer_max_pages &&
+	       spdk_bit_array_get(md->dirty_pages, first_page + num_pages)) {
+		spdk_bit_array_clear(md->dirty_pages, first_page + num_pages);
+		num_pages++;
+	}
+	md->writeback_next_page = first_page + num_pages;
+	md->writeback_outstanding++;
+
+	offset = (uint64_t)first_page * REDUCE_MD_PAGE_SIZE;
+	memcpy(writer->buf, (uint8_t *)vol->pm_file.pm_buf + offset, num_pages * REDUCE_MD_PAGE_SIZE);
+	writer->offset = offset;
+	writer->iov.iov_base = writer->buf;
+	writer->iov.iov_len = num_pages * REDUCE_MD_PAGE_SIZE;
+	writer->backing_cb_args.cb_fn = _reduce_md_writeback_done;
+	writer->backing_cb_args.cb_arg = writer;
+	vol->backing_dev->writev(vol->backing_dev, &writer->iov, 1,
+				 (REDUCE_BACKING_DEV_MD_OFFSET + offset) / vol->backing_dev->blocklen,
+				 writer->iov.iov_len / vol->backing_dev->blocklen,
+				 &writer->backing_cb_args);
+	return true;
 }
 
-typedef void (*reduce_request_fn)(void *_req, int reduce_errno);
-
+/*
+ * Write all dirty metadata pages back to the backing device and start a new journal
+ *  generation.  New journal blocks are not written until this completes.
+ */
 static void
-_reduce_vol_complete_req(struct spdk_reduce_vol_request *req, int reduce_errno)
+_reduce_md_writeback(struct spdk_reduce_vol *vol, spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
 {
-	struct spdk_reduce_vol_request *next_req;
-	struct spdk_reduce_vol *vol = req->vol;
-
-	req->cb_fn(req->cb_arg, reduce_errno);
-	TAILQ_REMOVE(&vol->executing_requests, req, tailq);
+	struct spdk_reduce_backing_md *md = &vol->backing_md;
+	uint32_t i;
 
-	TAILQ_FOREACH(next_req, &vol->queued_requests, tailq) {
-		if (next_req->logical_map_index == req->logical_map_index) {
-			TAILQ_REMOVE(&vol->queued_requests, next_req, tailq);
-			if (next_req->type == REDUCE_IO_READV) {
-				_start_readv_request(next_req);
-			} else {
-				assert(next_req->type == REDUCE_IO_WRITEV);
-				_start_writev_request(next_req);
-			}
+	assert(!md->flush_in_progress && !md->writeback_in_progress);
+	md->writeback_in_progress = true;
+	md->writeback_cb_fn = cb_fn;
+	md->writeback_cb_arg = cb_arg;
+	md->writeback_errno = 0;
+	/* The header page goes last, see _reduce_md_writeback_put(). */
+	md->writeback_next_page = 1;
+
+	/* Hold a reference while the writers are started, completions may be immediate. */
+	md->writeback_outstanding = 1;
+	for (i = 0; i < md->num_writers; i++) {
+		md->writers[i].vol = vol;
+		if (!_reduce_md_writeback_next(&md->writers[i])) {
 			break;
 		}
 	}
 
-	TAILQ_INSERT_HEAD(&vol->free_requests, req, tailq);
+	_reduce_md_writeback_put(vol);
 }
 
 static void
@@ -1025,8 +2215,6 @@ _write_write_done(void *_req, int reduce_errno)
 	struct spdk_reduce_vol_request *req = _req;
 	struct spdk_reduce_vol *vol = req->vol;
 	uint64_t old_chunk_map_index;
-	struct spdk_reduce_chunk_map *old_chunk;
-	uint32_t i;
 
 	if (reduce_errno != 0) {
 		req->reduce_errno = reduce_errno;
@@ -1042,18 +2230,14 @@ _write_write_done(void *_req, int reduce_errno)
 		return;
 	}
 
+	if (vol->backing_md.enabled) {
+		_reduce_md_journal_append(req);
+		return;
+	}
+
 	old_chunk_map_index = vol->pm_logical_map[req->logical_map_index];
 	if (old_chunk_map_index != REDUCE_EMPTY_MAP_ENTRY) {
-		old_chunk = _reduce_vol_get_chunk_map(vol, old_chunk_map_index);
-		for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
-			if (old_chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
-				break;
-			}
-			assert(spdk_bit_array_get(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]) == true);
-			spdk_bit_array_clear(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]);
-			old_chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
-		}
-		spdk_bit_array_clear(vol->allocated_chunk_maps, old_chunk_map_index);
+		_reduce_vol_release_chunk(vol, old_chunk_map_index);
 	}
 
 	/*
@@ -1073,6 +2257,64 @@ _write_write_done(void *_req, int reduce_errno)
 	_reduce_vol_complete_req(req, 0);
 }
 
+/*
+ * Pieces of a packed chunk that are adjacent on the backing device are read or written with
+ *  a single I/O.  Returns the number of pieces starting at 'piece' covered by the I/O.
+ */
+static uint32_t
+_packed_backing_op(struct spdk_reduce_vol_request *req, uint32_t stored_size, uint32_t piece,
+		   uint32_t *lba_count)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	uint32_t num_pieces = 0, num_blocks;
+
+	*lba_count = 0;
+	do {
+		num_blocks = _reduce_vol_pack_piece_blocks(vol, stored_size, piece + num_pieces);
+		*lba_count += num_blocks;
+		num_pieces++;
+	} while (piece + num_pieces < req->num_io_units &&
+		 req->chunk->io_unit_index[piece + num_pieces] ==
+		 req->chunk->io_unit_index[piece] + *lba_count);
+
+	return num_pieces;
+}
+
+static void
+_issue_packed_backing_ops(struct spdk_reduce_vol_request *req, struct spdk_reduce_vol *vol,
+			  struct iovec *iov, uint8_t *buf, reduce_request_fn next_fn, bool is_write)
+{
+	uint32_t i, num_pieces, num_ops = 0, lba_count, stored_size;
+	uint64_t lba;
+
+	stored_size = _reduce_vol_chunk_stored_size(vol, req->chunk->compressed_size);
+
+	/* Count the I/Os first, completions may be immediate. */
+	for (i = 0; i < req->num_io_units; i += num_pieces) {
+		num_pieces = _packed_backing_op(req, stored_size, i, &lba_count);
+		num_ops++;
+	}
+
+	req->num_backing_ops = num_ops;
+	req->backing_cb_args.cb_fn = next_fn;
+	req->backing_cb_args.cb_arg = req;
+	/* req must not be touched after the last I/O is issued, it may have completed already. */
+	for (i = 0; num_ops > 0; num_ops--, i += num_pieces) {
+		num_pieces = _packed_backing_op(req, stored_size, i, &lba_count);
+		lba = req->chunk->io_unit_index[i];
+		iov->iov_base = buf + i * vol->params.backing_io_unit_size;
+		iov->iov_len = lba_count * vol->backing_dev->blocklen;
+		if (is_write) {
+			vol->backing_dev->writev(vol->backing_dev, iov, 1, lba, lba_count,
+						 &req->backing_cb_args);
+		} else {
+			vol->backing_dev->readv(vol->backing_dev, iov, 1, lba, lba_count,
+						&req->backing_cb_args);
+		}
+		iov++;
+	}
+}
+
 static void
 _issue_backing_ops(struct spdk_reduce_vol_request *req, struct spdk_reduce_vol *vol,
 		   reduce_request_fn next_fn, bool is_write)
@@ -1089,6 +2331,11 @@ _issue_backing_ops(struct spdk_reduce_vol_request *req, struct spdk_reduce_vol *
 		buf = req->decomp_buf;
 	}
 
+	if (_reduce_vol_is_packed(vol)) {
+		_issue_packed_backing_ops(req, vol, iov, buf, next_fn, is_write);
+		return;
+	}
+
 	req->num_backing_ops = req->num_io_units;
 	req->backing_cb_args.cb_fn = next_fn;
 	req->backing_cb_args.cb_arg = req;
@@ -1112,7 +2359,7 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 			uint32_t compressed_size)
 {
 	struct spdk_reduce_vol *vol = req->vol;
-	uint32_t i;
+	uint32_t i, stored_size;
 	uint64_t chunk_offset, remainder, total_len = 0;
 	uint8_t *buf;
 	int j;
@@ -1126,11 +2373,11 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 	spdk_bit_array_set(vol->allocated_chunk_maps, req->chunk_map_index);
 
 	req->chunk = _reduce_vol_get_chunk_map(vol, req->chunk_map_index);
-	req->num_io_units = spdk_divide_round_up(compressed_size,
-			    vol->params.backing_io_unit_size);
-	req->chunk_is_compressed = (req->num_io_units != vol->backing_io_units_per_chunk);
+	req->chunk_is_compressed = _reduce_vol_chunk_is_compressed(vol, compressed_size);
 	req->chunk->compressed_size =
 		req->chunk_is_compressed ? compressed_size : vol->params.chunk_size;
+	req->num_io_units = spdk_divide_round_up(req->chunk->compressed_size,
+			    vol->params.backing_io_unit_size);
 
 	/* if the chunk is uncompressed we need to copy the data from the host buffers. */
 	if (req->chunk_is_compressed == false) {
@@ -1160,6 +2407,24 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 		assert(total_len == vol->params.chunk_size);
 	}
 
+	if (_reduce_vol_is_packed(vol)) {
+		stored_size = _reduce_vol_chunk_stored_size(vol, req->chunk->compressed_size);
+		for (i = 0; i < req->num_io_units; i++) {
+			req->chunk->io_unit_index[i] = _reduce_vol_pack_alloc_blocks(vol,
+						       _reduce_vol_pack_piece_blocks(vol, stored_size, i));
+			if (req->chunk->io_unit_index[i] == UINT32_MAX) {
+				/* Fragmented beyond repair, give back what was taken so far. */
+				req->chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
+				_reduce_vol_release_chunk(vol, req->chunk_map_index);
+				_reduce_vol_complete_req(req, -ENOSPC);
+				return;
+			}
+		}
+
+		_issue_backing_ops(req, vol, next_fn, true /* write */);
+		return;
+	}
+
 	for (i = 0; i < req->num_io_units; i++) {
 		req->chunk->io_unit_index[i] = spdk_bit_array_find_first_clear(vol->allocated_backing_io_units, 0);
 		/* TODO: fail if no backing block found - but really this should also not
@@ -1520,7 +2785,7 @@ _reduce_vol_read_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn ne
 	req->chunk = _reduce_vol_get_chunk_map(vol, req->chunk_map_index);
 	req->num_io_units = spdk_divide_round_up(req->chunk->compressed_size,
 			    vol->params.backing_io_unit_size);
-	req->chunk_is_compressed = (req->num_io_units != vol->backing_io_units_per_chunk);
+	req->chunk_is_compressed = _reduce_vol_chunk_is_compressed(vol, req->chunk->compressed_size);
 
 	_issue_backing_ops(req, vol, next_fn, false /* read */);
 }
@@ -1557,6 +2822,133 @@ _check_overlap(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
 	return false;
 }
 
+/*
+ * A chunk is worth relocating if one of its pieces sits in a sparsely used io unit.  The io
+ *  unit currently being filled by the allocator is skipped, it is sparse only temporarily.
+ */
+static bool
+_reduce_vol_compact_candidate(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
+{
+	struct spdk_reduce_chunk_map *chunk;
+	uint64_t chunk_map_index, io_unit, cursor_io_unit;
+	uint32_t i;
+
+	chunk_map_index = vol->pm_logical_map[logical_map_index];
+	if (chunk_map_index == REDUCE_EMPTY_MAP_ENTRY) {
+		return false;
+	}
+
+	/* Only compressed chunks are moved, their data can be copied without decompressing it. */
+	chunk = _reduce_vol_get_chunk_map(vol, chunk_map_index);
+	if (!_reduce_vol_chunk_is_compressed(vol, chunk->compressed_size)) {
+		return false;
+	}
+
+	cursor_io_unit = vol->pack.alloc_cursor / vol->backing_lba_per_io_unit;
+	for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
+		if (chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
+			break;
+		}
+		io_unit = chunk->io_unit_index[i] / vol->backing_lba_per_io_unit;
+		if (io_unit != cursor_io_unit &&
+		    _reduce_vol_pack_io_unit_is_sparse(vol, vol->pack.io_unit_used_blocks[io_unit])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+_reduce_vol_compact_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+
+	vol->pack.compact_in_progress = false;
+	if (reduce_errno == 0) {
+		vol->pack.compacted_chunks++;
+	}
+}
+
+static void
+_compact_read_done(void *_req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = _req;
+
+	if (reduce_errno != 0) {
+		req->reduce_errno = reduce_errno;
+	}
+
+	assert(req->num_backing_ops > 0);
+	if (--req->num_backing_ops > 0) {
+		return;
+	}
+
+	if (req->reduce_errno != 0) {
+		_reduce_vol_complete_req(req, req->reduce_errno);
+		return;
+	}
+
+	/* Write the compressed data as is to newly allocated blocks, the old ones are released
+	 *  once the new chunk map is persisted.
+	 */
+	_reduce_vol_write_chunk(req, _write_write_done, req->chunk->compressed_size);
+}
+
+/*
+ * Relocate one chunk out of sparsely used io units of a packed volume, so that the free
+ *  blocks left behind by overwritten chunks can be allocated again.  libreduce has no
+ *  poller of its own, so this runs from request completion, one chunk at a time and only
+ *  when no user requests are waiting.
+ */
+static void
+_reduce_vol_maybe_compact(struct spdk_reduce_vol *vol)
+{
+	struct spdk_reduce_vol_request *req;
+	uint64_t num_chunks, logical_map_index = 0;
+	uint32_t i;
+
+	if (!_reduce_vol_is_packed(vol) || vol->pack.compact_in_progress ||
+	    vol->pack.unload_cb_fn != NULL ||
+	    vol->pack.sparse_io_units < REDUCE_COMPACT_SPARSE_IO_UNITS ||
+	    !TAILQ_EMPTY(&vol->queued_requests) || TAILQ_EMPTY(&vol->free_requests)) {
+		return;
+	}
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	for (i = 0; i < REDUCE_COMPACT_SCAN_CHUNKS; i++) {
+		logical_map_index = vol->pack.compact_cursor;
+		vol->pack.compact_cursor = (vol->pack.compact_cursor + 1) % num_chunks;
+		if (_reduce_vol_compact_candidate(vol, logical_map_index) &&
+		    !_check_overlap(vol, logical_map_index)) {
+			break;
+		}
+	}
+
+	if (i == REDUCE_COMPACT_SCAN_CHUNKS) {
+		return;
+	}
+
+	req = TAILQ_FIRST(&vol->free_requests);
+	TAILQ_REMOVE(&vol->free_requests, req, tailq);
+	req->type = REDUCE_IO_COMPACT;
+	req->vol = vol;
+	req->iov = NULL;
+	req->iovcnt = 0;
+	req->offset = logical_map_index * vol->logical_blocks_per_chunk;
+	req->logical_map_index = logical_map_index;
+	req->length = vol->logical_blocks_per_chunk;
+	req->rmw = false;
+	req->copy_after_decompress = false;
+	req->reduce_errno = 0;
+	req->cb_fn = _reduce_vol_compact_done;
+	req->cb_arg = vol;
+
+	vol->pack.compact_in_progress = true;
+	TAILQ_INSERT_TAIL(&vol->executing_requests, req, tailq);
+	_reduce_vol_read_chunk(req, _compact_read_done);
+}
+
 static void
 _start_readv_request(struct spdk_reduce_vol_request *req)
 {
@@ -1733,6 +3125,27 @@ spdk_reduce_vol_print_info(struct spdk_reduce_vol *vol)
 	struct_size = _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk);
 	SPDK_NOTICELOG("\tchunk_struct_size = 0x%x\n", struct_size);
 
+	if (vol->backing_md.enabled) {
+		SPDK_NOTICELOG("backing device metadata info:\n");
+		SPDK_NOTICELOG("\tvol->backing_md.image_size = 0x%" PRIx64 "\n",
+			       vol->backing_md.image_size);
+		SPDK_NOTICELOG("\tvol->backing_md.journal_offset = 0x%" PRIx64 "\n",
+			       vol->backing_md.journal_offset);
+		SPDK_NOTICELOG("\tvol->backing_md.journal_block_size = 0x%x\n",
+			       vol->backing_md.journal_block_size);
+		SPDK_NOTICELOG("\tvol->backing_md.entries_per_block = %u\n",
+			       vol->backing_md.entries_per_block);
+	}
+
+	if (_reduce_vol_is_packed(vol)) {
+		SPDK_NOTICELOG("packed chunk layout info:\n");
+		SPDK_NOTICELOG("\tvol->pack.num_io_units = 0x%" PRIx64 "\n", vol->pack.num_io_units);
+		SPDK_NOTICELOG("\tvol->pack.sparse_io_units = 0x%" PRIx64 "\n",
+			       vol->pack.sparse_io_units);
+		SPDK_NOTICELOG("\tvol->pack.compacted_chunks = 0x%" PRIx64 "\n",
+			       vol->pack.compacted_chunks);
+	}
+
 	SPDK_NOTICELOG("pmem info:\n");
 	SPDK_NOTICELOG("\tvol->pm_file.size = 0x%" PRIx64 "\n", vol->pm_file.size);
 	SPDK_NOTICELOG("\tvol->pm_file.pm_buf = %p\n", (void *)vol->pm_file.pm_buf);
@@ -279,6 +279,7 @@ scsi_lun_remove(struct spdk_scsi_lun *lun)
 		TAILQ_REMOVE(&lun->reg_head, reg, link);
 		free(reg);
 	}
+	scsi_pr_free_access(lun);
 
 	spdk_thread_exec_msg(lun->thread, _scsi_lun_remove, lun);
 }
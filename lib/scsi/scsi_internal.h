@@ -57,6 +57,33 @@ struct spdk_scsi_pr_reservation {
 	uint64_t				crkey;
 };
 
+/* Access rights of an I_T nexus while a persistent reservation is held */
+#define SCSI_PR_ACCESS_READ			0x01U
+#define SCSI_PR_ACCESS_WRITE			0x02U
+#define SCSI_PR_ACCESS_REGISTERED		0x04U
+#define SCSI_PR_ACCESS_HOLDER			0x08U
+
+struct spdk_scsi_pr_access_entry {
+	const struct spdk_scsi_port		*initiator_port;
+	const struct spdk_scsi_port		*target_port;
+	/* Zero for an empty slot, registrants always have SCSI_PR_ACCESS_REGISTERED */
+	uint8_t					access;
+};
+
+/* Access rights of all registered I_T nexuses, hashed by their ports. It is
+ * rebuilt whenever a PERSISTENT RESERVE OUT command changes the reservation
+ * state, so that checking an I/O does not have to walk the registrants.
+ */
+struct spdk_scsi_pr_access_table {
+	struct spdk_scsi_pr_access_table	*retired;
+	uint32_t				mask;
+	/* Longest probe sequence of any registrant, lookups stop after it */
+	uint32_t				max_probes;
+	/* Access rights of I_T nexuses which are not registered */
+	uint8_t					default_access;
+	struct spdk_scsi_pr_access_entry	entries[];
+};
+
 struct spdk_scsi_dev {
 	int					id;
 	int					is_allocated;
@@ -129,6 +156,10 @@ struct spdk_scsi_lun {
 	struct spdk_scsi_pr_reservation reservation;
 	/** Reservation holder for SPC2 RESERVE(6) and RESERVE(10) */
 	struct spdk_scsi_pr_registrant scsi2_holder;
+	/** Access rights of I_T nexuses, see scsi_pr_check() */
+	struct spdk_scsi_pr_access_table *pr_access;
+	/** Replaced access tables which could not be freed yet, see scsi_pr_retire_access() */
+	struct spdk_scsi_pr_access_table *pr_access_retired;
 
 	/** List of open descriptors for this LUN. */
 	TAILQ_HEAD(, spdk_scsi_lun_desc) open_descs;
@@ -188,6 +219,7 @@ bool bdev_scsi_get_dif_ctx(struct spdk_bdev *bdev, struct spdk_scsi_task *task,
 int scsi_pr_out(struct spdk_scsi_task *task, uint8_t *cdb, uint8_t *data, uint16_t data_len);
 int scsi_pr_in(struct spdk_scsi_task *task, uint8_t *cdb, uint8_t *data, uint16_t data_len);
 int scsi_pr_check(struct spdk_scsi_task *task);
+void scsi_pr_free_access(struct spdk_scsi_lun *lun);
 
 int scsi2_reserve(struct spdk_scsi_task *task, uint8_t *cdb);
 int scsi2_release(struct spdk_scsi_task *task);
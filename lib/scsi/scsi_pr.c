@@ -6,6 +6,9 @@
 #include "scsi_internal.h"
 
 #include "spdk/endian.h"
+#include "spdk/likely.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
 
 /* Get registrant by I_T nexus */
 static struct spdk_scsi_pr_registrant *
@@ -69,6 +72,187 @@ scsi_pr_has_reservation(struct spdk_scsi_lun *lun)
 	return !(lun->reservation.holder == NULL);
 }
 
+/* Access rights of the I_T nexus of reg, or of unregistered I_T nexuses if reg is NULL */
+static uint8_t
+scsi_pr_calc_access(struct spdk_scsi_lun *lun, struct spdk_scsi_pr_registrant *reg)
+{
+	uint8_t access = reg ? SCSI_PR_ACCESS_REGISTERED : 0;
+
+	if (scsi_pr_registrant_is_holder(lun, reg)) {
+		return access | SCSI_PR_ACCESS_HOLDER | SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE;
+	}
+
+	switch (lun->reservation.rtype) {
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE:
+		access |= SCSI_PR_ACCESS_READ;
+		break;
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS:
+		break;
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_REGS_ONLY:
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_ALL_REGS:
+		access |= SCSI_PR_ACCESS_READ;
+		if (reg) {
+			access |= SCSI_PR_ACCESS_WRITE;
+		}
+		break;
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_REGS_ONLY:
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_ALL_REGS:
+		if (reg) {
+			access |= SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE;
+		}
+		break;
+	default:
+		access |= SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE;
+		break;
+	}
+
+	return access;
+}
+
+#define SCSI_PR_ACCESS_TABLE_MIN_SIZE	8
+
+static inline uint32_t
+scsi_pr_access_hash(const struct spdk_scsi_port *initiator_port,
+		    const struct spdk_scsi_port *target_port)
+{
+	uint64_t key = (uintptr_t)initiator_port ^ ((uint64_t)(uintptr_t)target_port << 1);
+
+	return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static void
+scsi_pr_fill_access_table(struct spdk_scsi_lun *lun, struct spdk_scsi_pr_access_table *table)
+{
+	struct spdk_scsi_pr_registrant *reg;
+	struct spdk_scsi_pr_access_entry *entry;
+	uint32_t i, num_probes;
+
+	table->default_access = scsi_pr_calc_access(lun, NULL);
+
+	TAILQ_FOREACH(reg, &lun->reg_head, link) {
+		i = scsi_pr_access_hash(reg->initiator_port, reg->target_port) & table->mask;
+		for (num_probes = 1; table->entries[i].access != 0; num_probes++) {
+			i = (i + 1) & table->mask;
+		}
+		entry = &table->entries[i];
+		entry->initiator_port = reg->initiator_port;
+		entry->target_port = reg->target_port;
+		entry->access = scsi_pr_calc_access(lun, reg);
+		table->max_probes = spdk_max(table->max_probes, num_probes);
+	}
+}
+
+static void
+scsi_pr_free_access_tables(void *ctx)
+{
+	struct spdk_scsi_pr_access_table *table, *retired;
+
+	for (table = ctx; table != NULL; table = retired) {
+		retired = table->retired;
+		free(table);
+	}
+}
+
+/* Free a replaced access table once no reader can be looking at it anymore.
+ * All I/O of a LUN is checked on the thread of its I/O channel, so a message
+ * sent to that thread runs only after every lookup which may have loaded the
+ * old table has completed. Tables which can't be handed over that way are
+ * kept and handed over with the next replaced one.
+ */
+static void
+scsi_pr_retire_access(struct spdk_scsi_lun *lun, struct spdk_scsi_pr_access_table *table)
+{
+	table->retired = lun->pr_access_retired;
+	lun->pr_access_retired = NULL;
+
+	if (lun->io_channel == NULL) {
+		scsi_pr_free_access_tables(table);
+		return;
+	}
+
+	if (spdk_thread_send_msg(spdk_io_channel_get_thread(lun->io_channel),
+				 scsi_pr_free_access_tables, table) != 0) {
+		lun->pr_access_retired = table;
+	}
+}
+
+/* Rebuild the access table after the reservation or the registrants changed.
+ * A fresh table is filled and then published with a release store, so readers
+ * never see a partially built table and do not take any lock. If the new
+ * table can't be allocated, readers walk the registrants instead.
+ */
+static void
+scsi_pr_update_access(struct spdk_scsi_lun *lun)
+{
+	struct spdk_scsi_pr_access_table *table, *old_table = lun->pr_access;
+	struct spdk_scsi_pr_registrant *reg;
+	uint32_t num_regs = 0, size = SCSI_PR_ACCESS_TABLE_MIN_SIZE;
+
+	TAILQ_FOREACH(reg, &lun->reg_head, link) {
+		num_regs++;
+	}
+	/* Keep the table at most half full to keep probe sequences short. */
+	while (size < num_regs * 2) {
+		size *= 2;
+	}
+
+	table = calloc(1, sizeof(*table) + size * sizeof(table->entries[0]));
+	if (table == NULL) {
+		SPDK_ERRLOG("Failed to allocate reservation access table\n");
+	} else {
+		table->mask = size - 1;
+		scsi_pr_fill_access_table(lun, table);
+	}
+
+	__atomic_store_n(&lun->pr_access, table, __ATOMIC_RELEASE);
+
+	if (old_table != NULL) {
+		scsi_pr_retire_access(lun, old_table);
+	}
+}
+
+static uint8_t
+scsi_pr_get_access(struct spdk_scsi_lun *lun,
+		   struct spdk_scsi_port *initiator_port,
+		   struct spdk_scsi_port *target_port)
+{
+	const struct spdk_scsi_pr_access_table *table;
+	const struct spdk_scsi_pr_access_entry *entry;
+	struct spdk_scsi_pr_registrant *reg;
+	uint32_t i, num_probes;
+
+	table = __atomic_load_n(&lun->pr_access, __ATOMIC_ACQUIRE);
+	if (spdk_unlikely(table == NULL)) {
+		reg = scsi_pr_get_registrant(lun, initiator_port, target_port);
+		return scsi_pr_calc_access(lun, reg);
+	}
+
+	i = scsi_pr_access_hash(initiator_port, target_port) & table->mask;
+	for (num_probes = 0; num_probes < table->max_probes; num_probes++) {
+		entry = &table->entries[i];
+		if (entry->access == 0) {
+			break;
+		}
+		if (entry->initiator_port == initiator_port &&
+		    entry->target_port == target_port) {
+			return entry->access;
+		}
+		i = (i + 1) & table->mask;
+	}
+
+	return table->default_access;
+}
+
+void
+scsi_pr_free_access(struct spdk_scsi_lun *lun)
+{
+	free(lun->pr_access);
+	lun->pr_access = NULL;
+
+	scsi_pr_free_access_tables(lun->pr_access_retired);
+	lun->pr_access_retired = NULL;
+}
+
 static int
 scsi_pr_register_registrant(struct spdk_scsi_lun *lun,
 			    struct spdk_scsi_port *initiator_port,
@@ -212,6 +396,7 @@ scsi_pr_out_reserve(struct spdk_scsi_task *task,
 	} else {
 		/* current I_T nexus is the first reservation holder */
 		scsi_pr_reserve_reservation(lun, rtype, rkey, reg);
+		scsi_pr_update_access(lun);
 	}
 
 	return 0;
@@ -232,7 +417,7 @@ scsi_pr_out_register(struct spdk_scsi_task *task,
 {
 	struct spdk_scsi_lun *lun = task->lun;
 	struct spdk_scsi_pr_registrant *reg;
-	int sc, sk, asc;
+	int sc, sk, asc, rc;
 
 	SPDK_DEBUGLOG(scsi, "PR OUT REGISTER: rkey 0x%"PRIx64", "
 		      "sa_key 0x%"PRIx64", reservation type %u\n", rkey, sa_rkey, lun->reservation.rtype);
@@ -264,8 +449,11 @@ scsi_pr_out_register(struct spdk_scsi_task *task,
 			return 0;
 		}
 		/* Add a new registrant for the I_T nexus */
-		return scsi_pr_register_registrant(lun, task->initiator_port,
-						   task->target_port, sa_rkey);
+		rc = scsi_pr_register_registrant(lun, task->initiator_port,
+						 task->target_port, sa_rkey);
+		if (rc != 0) {
+			return rc;
+		}
 	} else {
 		/* a registered I_T nexus */
 		if (rkey != reg->rkey && action == SPDK_SCSI_PR_OUT_REGISTER) {
@@ -286,6 +474,7 @@ scsi_pr_out_register(struct spdk_scsi_task *task,
 		}
 	}
 
+	scsi_pr_update_access(lun);
 	return 0;
 
 error_exit:
@@ -331,6 +520,7 @@ scsi_pr_out_release(struct spdk_scsi_task *task,
 	}
 
 	scsi_pr_release_reservation(lun, reg);
+	scsi_pr_update_access(lun);
 
 	return 0;
 
@@ -370,6 +560,7 @@ scsi_pr_out_clear(struct spdk_scsi_task *task, uint64_t rkey)
 	TAILQ_FOREACH_SAFE(reg, &lun->reg_head, link, tmp) {
 		scsi_pr_unregister_registrant(lun, reg);
 	}
+	scsi_pr_update_access(lun);
 
 	return 0;
 
@@ -485,6 +676,7 @@ scsi_pr_out_preempt(struct spdk_scsi_task *task,
 
 exit:
 	lun->pr_generation++;
+	scsi_pr_update_access(lun);
 	return 0;
 
 conflict:
@@ -735,22 +927,17 @@ scsi_pr_check(struct spdk_scsi_task *task)
 {
 	struct spdk_scsi_lun *lun = task->lun;
 	uint8_t *cdb = task->cdb;
-	enum spdk_scsi_pr_type_code rtype;
 	enum spdk_scsi_pr_out_service_action_code action;
-	struct spdk_scsi_pr_registrant *reg;
-	bool dma_to_device = false;
+	uint8_t access, required;
 
 	/* no reservation holders */
 	if (!scsi_pr_has_reservation(lun)) {
 		return 0;
 	}
 
-	rtype = lun->reservation.rtype;
-	assert(rtype != 0);
-
-	reg = scsi_pr_get_registrant(lun, task->initiator_port, task->target_port);
+	access = scsi_pr_get_access(lun, task->initiator_port, task->target_port);
 	/* current I_T nexus hold the reservation */
-	if (scsi_pr_registrant_is_holder(lun, reg)) {
+	if (access & SCSI_PR_ACCESS_HOLDER) {
 		return 0;
 	}
 
@@ -778,7 +965,7 @@ scsi_pr_check(struct spdk_scsi_task *task)
 	case SPDK_SPC_MODE_SENSE_10:
 	case SPDK_SPC_LOG_SELECT:
 		/* I_T nexus is registrant but not holder */
-		if (!reg) {
+		if (!(access & SCSI_PR_ACCESS_REGISTERED)) {
 			SPDK_DEBUGLOG(scsi, "CHECK: current I_T nexus "
 				      "is not registered, cdb 0x%x\n", cdb[0]);
 			goto conflict;
@@ -792,7 +979,7 @@ scsi_pr_check(struct spdk_scsi_task *task)
 		case SPDK_SCSI_PR_OUT_CLEAR:
 		case SPDK_SCSI_PR_OUT_PREEMPT:
 		case SPDK_SCSI_PR_OUT_PREEMPT_AND_ABORT:
-			if (!reg) {
+			if (!(access & SCSI_PR_ACCESS_REGISTERED)) {
 				SPDK_ERRLOG("CHECK: PR OUT action %u\n", action);
 				goto conflict;
 			}
@@ -818,6 +1005,7 @@ scsi_pr_check(struct spdk_scsi_task *task)
 	case SPDK_SBC_READ_10:
 	case SPDK_SBC_READ_12:
 	case SPDK_SBC_READ_16:
+		required = SCSI_PR_ACCESS_READ;
 		break;
 	case SPDK_SBC_WRITE_6:
 	case SPDK_SBC_WRITE_10:
@@ -826,43 +1014,17 @@ scsi_pr_check(struct spdk_scsi_task *task)
 	case SPDK_SBC_UNMAP:
 	case SPDK_SBC_SYNCHRONIZE_CACHE_10:
 	case SPDK_SBC_SYNCHRONIZE_CACHE_16:
-		dma_to_device = true;
+		required = SCSI_PR_ACCESS_WRITE;
 		break;
 	default:
 		SPDK_ERRLOG("CHECK: unsupported SCSI command cdb 0x%x\n", cdb[0]);
 		goto conflict;
 	}
 
-	switch (rtype) {
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE:
-		if (dma_to_device) {
-			SPDK_ERRLOG("CHECK: Write Exclusive reservation type "
-				    "rejects command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS:
-		SPDK_ERRLOG("CHECK: Exclusive Access reservation type "
-			    "rejects command 0x%x\n", cdb[0]);
+	if (!(access & required)) {
+		SPDK_ERRLOG("CHECK: reservation type %u rejects command 0x%x\n",
+			    lun->reservation.rtype, cdb[0]);
 		goto conflict;
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_REGS_ONLY:
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_ALL_REGS:
-		if (!reg && dma_to_device) {
-			SPDK_ERRLOG("CHECK: Registrants only reservation "
-				    "type  reject command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_REGS_ONLY:
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_ALL_REGS:
-		if (!reg) {
-			SPDK_ERRLOG("CHECK: All Registrants reservation "
-				    "type  reject command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	default:
-		break;
 	}
 
 	return 0;
@@ -5,6 +5,7 @@
 
 #include <linux/ublk_cmd.h>
 #include <liburing.h>
+#include <sys/eventfd.h>
 
 #include "spdk/stdinc.h"
 #include "spdk/string.h"
@@ -30,9 +31,26 @@
 #define UBLK_IO_MAX_BYTES		SPDK_BDEV_LARGE_BUF_MAX_SIZE
 #define UBLK_DEV_MAX_QUEUES		32
 #define UBLK_DEV_MAX_QUEUE_DEPTH	1024
-#define UBLK_QUEUE_REQUEST		32
+#define UBLK_THREAD_MAX_QUEUES		128
+#define UBLK_THREAD_RING_DEPTH		1024
+#define UBLK_THREAD_CQ_DEPTH		(UBLK_THREAD_RING_DEPTH * 16)
+#define UBLK_THREAD_MAX_CQES		256
 #define UBLK_STOP_BUSY_WAITING_MS	10000
 #define UBLK_BUSY_POLLING_INTERVAL_US	20000
+#define UBLK_IOBUF_SMALL_CACHE_SIZE	128
+#define UBLK_IOBUF_LARGE_CACHE_SIZE	32
+
+/* User copy definitions, for building against kernel headers older than 6.5 */
+#ifndef UBLK_F_USER_COPY
+#define UBLK_F_USER_COPY		(1ULL << 7)
+#endif
+#ifndef UBLK_U_CMD_GET_FEATURES
+#define UBLK_U_CMD_GET_FEATURES		_IOR('u', 0x13, struct ublksrv_ctrl_cmd)
+#endif
+#ifndef UBLK_TAG_OFF
+#define UBLK_TAG_OFF			25
+#define UBLK_QID_OFF			41
+#endif
 
 #define UBLK_DEBUGLOG(ublk, format, ...) \
 	SPDK_DEBUGLOG(ublk, "ublk%d: " format, ublk->ublk_id, ##__VA_ARGS__);
@@ -73,8 +91,13 @@ struct ublk_io {
 	struct ublk_queue	*q;
 	/* for bdev io_wait */
 	struct spdk_bdev_io_wait_entry bdev_io_wait;
+	/* for waiting on a payload buffer in user copy mode */
+	struct spdk_iobuf_entry	iobuf;
+	/* Direction of a user copy waiting for a free SQE */
+	uint8_t			user_copy_op;
 
 	TAILQ_ENTRY(ublk_io)	tailq;
+	TAILQ_ENTRY(ublk_io)	sqe_wait_tailq;
 };
 
 struct ublk_queue {
@@ -83,10 +106,13 @@ struct ublk_queue {
 	struct ublk_io		*ios;
 	TAILQ_HEAD(, ublk_io)	completed_io_list;
 	TAILQ_HEAD(, ublk_io)	inflight_io_list;
+	/* In flight I/Os whose user copy couldn't get an SQE, still on inflight_io_list */
+	TAILQ_HEAD(, ublk_io)	user_copy_wait_list;
 	uint32_t		cmd_inflight;
 	struct ublksrv_io_desc	*io_cmd_buf;
-	/* ring depth == dev_info->queue_depth. */
-	struct io_uring		ring;
+	/* Index of the queue in the thread ring, also its fixed file index if registered */
+	uint16_t		ring_idx;
+	bool			fixed_file;
 	struct spdk_ublk_dev	*dev;
 	struct ublk_thread_ctx	*thread_ctx;
 
@@ -107,8 +133,10 @@ struct spdk_ublk_dev {
 	uint32_t		num_queues;
 	uint32_t		queue_depth;
 
+	/* Per-tag payload buffers, not used in user copy mode */
 	struct spdk_mempool	*io_buf_pool;
 	struct ublk_queue	queues[UBLK_DEV_MAX_QUEUES];
+	bool			user_copy;
 
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
@@ -128,6 +156,22 @@ struct spdk_ublk_dev {
 struct ublk_thread_ctx {
 	struct spdk_thread		*ublk_thread;
 	struct spdk_poller		*ublk_poller;
+	struct spdk_iobuf_channel	iobuf_ch;
+	/* Set by the ublk thread once iobuf_ch is usable, only such threads serve user copy queues */
+	bool				iobuf_ch_ready;
+	/* Ring shared by all the queues handled by the thread */
+	struct io_uring			ring;
+	/* Number of SQEs prepared but not submitted yet */
+	uint32_t			sqe_pending;
+	struct ublk_queue		*queues[UBLK_THREAD_MAX_QUEUES];
+	/* Number of queues assigned to the thread, only accessed on the app thread */
+	uint32_t			queues_assigned;
+	/* Sum of the depths of these queues, bounded by the CQ size */
+	uint32_t			tags_assigned;
+	/* eventfd signaled by the ring in interrupt mode */
+	int				efd;
+	struct spdk_interrupt		*intr;
+	bool				interrupt_mode;
 	TAILQ_HEAD(, ublk_queue)	queue_list;
 };
 
@@ -135,6 +179,8 @@ struct ublk_tgt {
 	int			ctrl_fd;
 	bool			active;
 	bool			is_destroying;
+	/* Kernel supports UBLK_F_USER_COPY and all the ublk threads got an iobuf channel */
+	bool			user_copy;
 	spdk_ublk_fini_cb	cb_fn;
 	void			*cb_arg;
 	struct io_uring		ctrl_ring;
@@ -149,23 +195,16 @@ static struct ublk_tgt g_ublk_tgt;
 
 /* helpers for using io_uring */
 static inline int
-ublk_setup_ring(uint32_t depth, struct io_uring *r, unsigned flags)
+ublk_setup_ring(uint32_t depth, uint32_t cq_depth, struct io_uring *r, unsigned flags)
 {
 	struct io_uring_params p = {};
 
 	p.flags = flags | IORING_SETUP_CQSIZE;
-	p.cq_entries = depth;
+	p.cq_entries = cq_depth;
 
 	return io_uring_queue_init_params(depth, r, &p);
 }
 
-static inline struct io_uring_sqe *
-ublk_uring_get_sqe(struct io_uring *r, uint32_t idx)
-{
-	/* Need to update the idx since we set IORING_SETUP_SQE128 parameter in ublk_setup_ring */
-	return &r->sq.sqes[idx << 1];
-}
-
 static inline void *
 ublk_get_sqe_cmd(struct io_uring_sqe *sqe)
 {
@@ -179,11 +218,17 @@ ublk_set_sqe_cmd_op(struct io_uring_sqe *sqe, uint32_t cmd_op)
 }
 
 static inline uint64_t
-build_user_data(uint16_t tag, uint8_t op)
+build_user_data(uint16_t ring_idx, uint16_t tag, uint8_t op)
 {
 	assert(!(tag >> 16) && !(op >> 8));
 
-	return tag | (op << 16);
+	return tag | (op << 16) | ((uint64_t)ring_idx << 32);
+}
+
+static inline uint16_t
+user_data_to_ring_idx(uint64_t user_data)
+{
+	return (user_data >> 32) & 0xffff;
 }
 
 static inline uint16_t
@@ -198,6 +243,13 @@ user_data_to_op(uint64_t user_data)
 	return (user_data >> 16) & 0xff;
 }
 
+static inline uint64_t
+ublk_user_copy_pos(uint16_t q_id, uint16_t tag)
+{
+	return (uint64_t)UBLKSRV_IO_BUF_OFFSET +
+	       (((uint64_t)q_id << UBLK_QID_OFF) | ((uint64_t)tag << UBLK_TAG_OFF));
+}
+
 void
 spdk_ublk_init(void)
 {
@@ -211,6 +263,10 @@ spdk_ublk_init(void)
 	}
 	g_ublk_tgt.ctrl_fd = -1;
 	g_ublk_tgt.ctrl_ring.ring_fd = -1;
+
+	if (spdk_iobuf_register_module("ublk") != 0) {
+		SPDK_ERRLOG("Failed to register ublk iobuf module\n");
+	}
 }
 
 static int
@@ -333,9 +389,53 @@ ublk_queue_cmd_buf_sz(uint32_t q_depth)
 	return (size + page_sz - 1) & ~(page_sz - 1);
 }
 
+/* Query the features of the ublk driver. The control ring is idle at this point,
+ * so the command is submitted and reaped synchronously.
+ */
+static int
+ublk_ctrl_get_features(uint64_t *features)
+{
+	struct io_uring *ring = &g_ublk_tgt.ctrl_ring;
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+	struct ublksrv_ctrl_cmd *cmd;
+	int rc;
+
+	sqe = io_uring_get_sqe(ring);
+	if (sqe == NULL) {
+		return -EAGAIN;
+	}
+
+	cmd = (struct ublksrv_ctrl_cmd *)ublk_get_sqe_cmd(sqe);
+	memset(cmd, 0, sizeof(*cmd));
+	sqe->fd = g_ublk_tgt.ctrl_fd;
+	sqe->opcode = IORING_OP_URING_CMD;
+	sqe->ioprio = 0;
+	cmd->dev_id = -1;
+	cmd->queue_id = -1;
+	cmd->addr = (__u64)(uintptr_t)features;
+	cmd->len = sizeof(*features);
+	ublk_set_sqe_cmd_op(sqe, UBLK_U_CMD_GET_FEATURES);
+
+	rc = io_uring_submit(ring);
+	if (rc < 0) {
+		return rc;
+	}
+
+	rc = io_uring_wait_cqe(ring, &cqe);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = cqe->res;
+	io_uring_cqe_seen(ring, cqe);
+
+	return rc;
+}
+
 static int
 ublk_open(void)
 {
+	uint64_t features = 0;
 	int rc;
 
 	g_ublk_tgt.ctrl_fd = open(UBLK_CTRL_DEV, O_RDWR);
@@ -348,7 +448,7 @@ ublk_open(void)
 	/* We need to set SQPOLL for kernels 6.1 and earlier, since they would not defer ublk ctrl
 	 * ring processing to a workqueue.  Ctrl ring processing is minimal, so SQPOLL is fine.
 	 */
-	rc = ublk_setup_ring(UBLK_CTRL_RING_DEPTH, &g_ublk_tgt.ctrl_ring,
+	rc = ublk_setup_ring(UBLK_CTRL_RING_DEPTH, UBLK_CTRL_RING_DEPTH, &g_ublk_tgt.ctrl_ring,
 			     IORING_SETUP_SQE128 | IORING_SETUP_SQPOLL);
 	if (rc < 0) {
 		SPDK_ERRLOG("UBLK ctrl queue_init: %s\n", spdk_strerror(-rc));
@@ -357,6 +457,15 @@ ublk_open(void)
 		return rc;
 	}
 
+	/* Kernels that cannot report their features do not support user copy either */
+	rc = ublk_ctrl_get_features(&features);
+	if (rc != 0) {
+		SPDK_DEBUGLOG(ublk, "Can't get ublk features: %s\n", spdk_strerror(-rc));
+		features = 0;
+	}
+	g_ublk_tgt.user_copy = !!(features & UBLK_F_USER_COPY);
+	SPDK_NOTICELOG("ublk user copy %s\n", g_ublk_tgt.user_copy ? "enabled" : "not supported");
+
 	return 0;
 }
 
@@ -398,21 +507,160 @@ ublk_parse_core_mask(const char *mask, struct spdk_cpuset *cpumask)
 	return 0;
 }
 
+static int
+ublk_thread_ring_init(struct ublk_thread_ctx *thread_ctx)
+{
+	int rc;
+
+	thread_ctx->sqe_pending = 0;
+	thread_ctx->queues_assigned = 0;
+	thread_ctx->tags_assigned = 0;
+	thread_ctx->interrupt_mode = false;
+	thread_ctx->efd = -1;
+	memset(thread_ctx->queues, 0, sizeof(thread_ctx->queues));
+
+	/* The CQ is sized for the fetch commands of many queues, as each of them stays
+	 * outstanding until the kernel has a request for its tag. A tag never has more than
+	 * one command or user copy in flight, and queues are only assigned to a thread as long
+	 * as their total depth fits the CQ, so it can't overflow.
+	 */
+	rc = ublk_setup_ring(UBLK_THREAD_RING_DEPTH, UBLK_THREAD_CQ_DEPTH, &thread_ctx->ring,
+			     IORING_SETUP_SQE128);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed at setup uring: %s\n", spdk_strerror(-rc));
+		thread_ctx->ring.ring_fd = -1;
+		return rc;
+	}
+
+	/* The char devices of the queues are registered in their slots when the queues start */
+	rc = io_uring_register_files_sparse(&thread_ctx->ring, UBLK_THREAD_MAX_QUEUES);
+	if (rc != 0) {
+		SPDK_NOTICELOG("Can't register sparse files, not using fixed files: %s\n",
+			       spdk_strerror(-rc));
+	}
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		thread_ctx->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (thread_ctx->efd < 0) {
+			rc = -errno;
+			goto err;
+		}
+		rc = io_uring_register_eventfd(&thread_ctx->ring, thread_ctx->efd);
+		if (rc != 0) {
+			goto err;
+		}
+		/* Only signal completions through the eventfd in interrupt mode */
+		io_uring_cq_eventfd_toggle(&thread_ctx->ring, false);
+	}
+
+	return 0;
+err:
+	SPDK_ERRLOG("Failed to prepare ublk ring interrupt: %s\n", spdk_strerror(-rc));
+	if (thread_ctx->efd >= 0) {
+		close(thread_ctx->efd);
+		thread_ctx->efd = -1;
+	}
+	io_uring_queue_exit(&thread_ctx->ring);
+	thread_ctx->ring.ring_fd = -1;
+	return rc;
+}
+
+static void
+ublk_thread_ring_fini(struct ublk_thread_ctx *thread_ctx)
+{
+	if (thread_ctx->ring.ring_fd >= 0) {
+		io_uring_queue_exit(&thread_ctx->ring);
+		thread_ctx->ring.ring_fd = -1;
+	}
+	if (thread_ctx->efd >= 0) {
+		close(thread_ctx->efd);
+		thread_ctx->efd = -1;
+	}
+}
+
+static int
+ublk_interrupt(void *arg)
+{
+	struct ublk_thread_ctx *thread_ctx = arg;
+	uint64_t num_events;
+	int rc;
+
+	rc = read(thread_ctx->efd, &num_events, sizeof(num_events));
+	if (rc < 0 && errno != EAGAIN) {
+		SPDK_ERRLOG("failed to acknowledge ublk ring: %s.\n", spdk_strerror(errno));
+		return -errno;
+	}
+
+	return ublk_poll(thread_ctx);
+}
+
+/* Wake the thread up when work was queued outside of its poller in interrupt mode */
+static inline void
+ublk_thread_notify(struct ublk_thread_ctx *thread_ctx)
+{
+	uint64_t notify = 1;
+	int rc __attribute__((unused));
+
+	if (spdk_unlikely(thread_ctx->interrupt_mode)) {
+		rc = write(thread_ctx->efd, &notify, sizeof(notify));
+	}
+}
+
+static void
+ublk_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
+{
+	struct ublk_thread_ctx *thread_ctx = cb_arg;
+
+	if (thread_ctx->efd < 0) {
+		return;
+	}
+
+	/* Busy polling reaps the completions itself, avoid the cost of signaling the eventfd */
+	thread_ctx->interrupt_mode = interrupt_mode;
+	io_uring_cq_eventfd_toggle(&thread_ctx->ring, interrupt_mode);
+	if (interrupt_mode) {
+		/* Pick up completions posted while the eventfd was disabled */
+		ublk_thread_notify(thread_ctx);
+	}
+}
+
 static void
 ublk_poller_register(void *args)
 {
 	struct ublk_thread_ctx *thread_ctx = args;
+	int rc;
 
 	assert(spdk_get_thread() == thread_ctx->ublk_thread);
 	TAILQ_INIT(&thread_ctx->queue_list);
+	if (__atomic_load_n(&g_ublk_tgt.user_copy, __ATOMIC_RELAXED)) {
+		rc = spdk_iobuf_channel_init(&thread_ctx->iobuf_ch, "ublk", UBLK_IOBUF_SMALL_CACHE_SIZE,
+					     UBLK_IOBUF_LARGE_CACHE_SIZE);
+		if (rc == 0) {
+			__atomic_store_n(&thread_ctx->iobuf_ch_ready, true, __ATOMIC_RELEASE);
+		} else {
+			/* Devices started from now on preallocate their buffers instead */
+			SPDK_ERRLOG("Failed to initialize ublk iobuf channel, disabling user copy: %s\n",
+				    spdk_strerror(-rc));
+			__atomic_store_n(&g_ublk_tgt.user_copy, false, __ATOMIC_RELAXED);
+		}
+	}
 	thread_ctx->ublk_poller = SPDK_POLLER_REGISTER(ublk_poll, thread_ctx, 0);
+	if (thread_ctx->efd >= 0) {
+		thread_ctx->intr = SPDK_INTERRUPT_REGISTER(thread_ctx->efd, ublk_interrupt, thread_ctx);
+		if (thread_ctx->intr == NULL) {
+			SPDK_ERRLOG("Failed to register ublk interrupt\n");
+			return;
+		}
+		spdk_poller_register_interrupt(thread_ctx->ublk_poller, ublk_poller_set_interrupt_mode,
+					       thread_ctx);
+	}
 }
 
 int
 ublk_create_target(const char *cpumask_str)
 {
 	int rc;
-	uint32_t i;
+	uint32_t i, num_threads;
 	char thread_name[32];
 	struct spdk_cpuset cpuset = {};
 	struct spdk_cpuset thd_cpuset = {};
@@ -436,6 +684,18 @@ ublk_create_target(const char *cpumask_str)
 		return rc;
 	}
 
+	/* Set up the rings first, so that failing doesn't leave any thread behind */
+	num_threads = 0;
+	SPDK_ENV_FOREACH_CORE(i) {
+		if (spdk_cpuset_get_cpu(&cpuset, i)) {
+			rc = ublk_thread_ring_init(&g_ublk_tgt.thread_ctx[num_threads]);
+			if (rc != 0) {
+				goto err;
+			}
+			num_threads++;
+		}
+	}
+
 	SPDK_ENV_FOREACH_CORE(i) {
 		if (spdk_cpuset_get_cpu(&cpuset, i)) {
 			spdk_cpuset_zero(&thd_cpuset);
@@ -451,6 +711,16 @@ ublk_create_target(const char *cpumask_str)
 	SPDK_NOTICELOG("UBLK target created successfully\n");
 
 	return 0;
+
+err:
+	while (num_threads > 0) {
+		ublk_thread_ring_fini(&g_ublk_tgt.thread_ctx[--num_threads]);
+	}
+	io_uring_queue_exit(&g_ublk_tgt.ctrl_ring);
+	g_ublk_tgt.ctrl_ring.ring_fd = -1;
+	close(g_ublk_tgt.ctrl_fd);
+	g_ublk_tgt.ctrl_fd = -1;
+	return rc;
 }
 
 static void
@@ -461,6 +731,7 @@ _ublk_fini_done(void *args)
 	g_queue_thread_id = 0;
 	g_ublk_tgt.is_destroying = false;
 	g_ublk_tgt.active = false;
+	g_ublk_tgt.user_copy = false;
 	if (g_ublk_tgt.cb_fn) {
 		g_ublk_tgt.cb_fn(g_ublk_tgt.cb_arg);
 		g_ublk_tgt.cb_fn = NULL;
@@ -477,6 +748,12 @@ ublk_thread_exit(void *args)
 	for (i = 0; i < g_num_ublk_threads; i++) {
 		if (g_ublk_tgt.thread_ctx[i].ublk_thread == ublk_thread) {
 			spdk_poller_unregister(&g_ublk_tgt.thread_ctx[i].ublk_poller);
+			spdk_interrupt_unregister(&g_ublk_tgt.thread_ctx[i].intr);
+			ublk_thread_ring_fini(&g_ublk_tgt.thread_ctx[i]);
+			if (g_ublk_tgt.thread_ctx[i].iobuf_ch_ready) {
+				spdk_iobuf_channel_fini(&g_ublk_tgt.thread_ctx[i].iobuf_ch);
+				g_ublk_tgt.thread_ctx[i].iobuf_ch_ready = false;
+			}
 			spdk_thread_exit(ublk_thread);
 		}
 	}
@@ -602,6 +879,12 @@ ublk_dev_get_num_queues(struct spdk_ublk_dev *ublk)
 	return ublk->num_queues;
 }
 
+bool
+ublk_dev_get_user_copy(struct spdk_ublk_dev *ublk)
+{
+	return ublk->user_copy;
+}
+
 const char *
 ublk_dev_get_bdev_name(struct spdk_ublk_dev *ublk)
 {
@@ -671,12 +954,20 @@ static void
 ublk_delete_dev(void *arg)
 {
 	struct spdk_ublk_dev *ublk = arg;
+	struct ublk_queue *q;
 	int rc = 0;
 	uint32_t q_idx;
 
 	assert(spdk_get_thread() == ublk->app_thread);
 	for (q_idx = 0; q_idx < ublk->num_queues; q_idx++) {
-		ublk_dev_queue_fini(&ublk->queues[q_idx]);
+		q = &ublk->queues[q_idx];
+		ublk_dev_queue_fini(q);
+		/* Release the slot reserved on the ring of the ublk thread */
+		if (q->thread_ctx != NULL) {
+			q->thread_ctx->queues_assigned--;
+			q->thread_ctx->tags_assigned -= q->q_depth;
+			q->thread_ctx = NULL;
+		}
 	}
 
 	if (ublk->cdev_fd >= 0) {
@@ -748,6 +1039,8 @@ static void
 ublk_try_close_queue(struct ublk_queue *q)
 {
 	struct spdk_ublk_dev *ublk = q->dev;
+	struct ublk_thread_ctx *thread_ctx = q->thread_ctx;
+	int fd = -1;
 
 	/* Close queue until no I/O is submitted to bdev in flight,
 	 * no I/O is waiting to commit result, and all I/Os are aborted back.
@@ -761,6 +1054,12 @@ ublk_try_close_queue(struct ublk_queue *q)
 	spdk_put_io_channel(ublk->ch[q->q_id]);
 	ublk->ch[q->q_id] = NULL;
 
+	thread_ctx->queues[q->ring_idx] = NULL;
+	if (q->fixed_file) {
+		io_uring_register_files_update(&thread_ctx->ring, q->ring_idx, &fd, 1);
+		q->fixed_file = false;
+	}
+
 	spdk_thread_send_msg(ublk->app_thread, ublk_try_close_dev, ublk);
 }
 
@@ -784,6 +1083,69 @@ ublk_stop_disk(uint32_t ublk_id, ublk_del_cb del_cb, void *cb_arg)
 	return ublk_close_dev(ublk);
 }
 
+static int
+ublk_thread_submit(struct ublk_thread_ctx *thread_ctx)
+{
+	int rc;
+
+	if (thread_ctx->sqe_pending == 0) {
+		return 0;
+	}
+
+	rc = io_uring_submit(&thread_ctx->ring);
+	if (spdk_unlikely(rc < 0)) {
+		/* Nothing was consumed, the SQEs stay in the ring for the next attempt */
+		if (rc != -EAGAIN && rc != -EBUSY && rc != -EINTR) {
+			SPDK_ERRLOG("could not submit commands: %s\n", spdk_strerror(-rc));
+		}
+		ublk_thread_notify(thread_ctx);
+		return 0;
+	}
+
+	/* The kernel stops early if it runs out of resources, the rest is submitted later */
+	assert((uint32_t)rc <= thread_ctx->sqe_pending);
+	thread_ctx->sqe_pending -= rc;
+	if (spdk_unlikely(thread_ctx->sqe_pending > 0)) {
+		ublk_thread_notify(thread_ctx);
+	}
+
+	return rc;
+}
+
+/* Get an SQE of the thread ring. The SQEs of all the queues of the thread are submitted
+ * together once per poll, unless the SQ fills up before. Returns NULL if the kernel couldn't
+ * take any of them, the caller has to retry on a later poll.
+ */
+static struct io_uring_sqe *
+ublk_queue_get_sqe(struct ublk_queue *q)
+{
+	struct ublk_thread_ctx *thread_ctx = q->thread_ctx;
+	struct io_uring_sqe *sqe;
+
+	sqe = io_uring_get_sqe(&thread_ctx->ring);
+	if (spdk_unlikely(sqe == NULL)) {
+		ublk_thread_submit(thread_ctx);
+		sqe = io_uring_get_sqe(&thread_ctx->ring);
+		if (sqe == NULL) {
+			return NULL;
+		}
+	}
+	thread_ctx->sqe_pending++;
+
+	return sqe;
+}
+
+static inline void
+ublk_queue_set_sqe_file(struct ublk_queue *q, struct io_uring_sqe *sqe)
+{
+	if (q->fixed_file) {
+		sqe->fd = q->ring_idx;
+		sqe->flags |= IOSQE_FIXED_FILE;
+	} else {
+		sqe->fd = q->dev->cdev_fd;
+	}
+}
+
 static inline void
 ublk_mark_io_get_data(struct ublk_io *io)
 {
@@ -804,16 +1166,14 @@ ublk_mark_io_done(struct ublk_io *io, int res)
 }
 
 static void
-ublk_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+ublk_io_complete(struct ublk_io *io, int res)
 {
-	struct ublk_io	*io = cb_arg;
 	struct ublk_queue *q = io->q;
-	int res;
 
-	if (success) {
-		res = io->result;
-	} else {
-		res = -EIO;
+	/* The buffer has to be released before committing, as user copy requires a NULL address */
+	if (q->dev->user_copy && io->payload != NULL) {
+		spdk_iobuf_put(&q->thread_ctx->iobuf_ch, io->payload, io->payload_size);
+		io->payload = NULL;
 	}
 
 	ublk_mark_io_done(io, res);
@@ -822,10 +1182,135 @@ ublk_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 		      q->q_id, (int)(io - q->ios), res);
 	TAILQ_REMOVE(&q->inflight_io_list, io, tailq);
 	TAILQ_INSERT_TAIL(&q->completed_io_list, io, tailq);
+	ublk_thread_notify(q->thread_ctx);
+}
+
+/* Copy request data between the payload buffer and the kernel request pages. The data of
+ * write requests is read from the ublk char device, the data of read requests is written
+ * to it. The copy is submitted together with the next batch of io commands.
+ */
+static bool
+ublk_user_copy_submit(struct ublk_io *io, uint8_t ublk_op)
+{
+	struct ublk_queue *q = io->q;
+	uint16_t tag = io - q->ios;
+	struct io_uring_sqe *sqe;
+
+	sqe = ublk_queue_get_sqe(q);
+	if (spdk_unlikely(sqe == NULL)) {
+		return false;
+	}
+	io_uring_prep_rw(ublk_op == UBLK_IO_OP_READ ? IORING_OP_WRITE : IORING_OP_READ, sqe,
+			 0, io->payload, io->payload_size, ublk_user_copy_pos(q->q_id, tag));
+	ublk_queue_set_sqe_file(q, sqe);
+	io_uring_sqe_set_data64(sqe, build_user_data(q->ring_idx, tag, ublk_op));
+
+	q->cmd_inflight += 1;
+	ublk_thread_notify(q->thread_ctx);
+
+	return true;
+}
+
+static void
+ublk_user_copy(struct ublk_io *io, uint8_t ublk_op)
+{
+	struct ublk_queue *q = io->q;
+
+	if (spdk_unlikely(!TAILQ_EMPTY(&q->user_copy_wait_list) ||
+			  !ublk_user_copy_submit(io, ublk_op))) {
+		io->user_copy_op = ublk_op;
+		TAILQ_INSERT_TAIL(&q->user_copy_wait_list, io, sqe_wait_tailq);
+		ublk_thread_notify(q->thread_ctx);
+	}
+}
+
+static void
+ublk_user_copy_done(struct ublk_io *io, uint8_t ublk_op, int res)
+{
+	if (spdk_unlikely(res != (int)io->payload_size)) {
+		SPDK_ERRLOG("ublk user copy failed: res %d qid %d tag %d\n",
+			    res, io->q->q_id, (int)(io - io->q->ios));
+		ublk_io_complete(io, -EIO);
+		return;
+	}
+
+	if (ublk_op == UBLK_IO_OP_WRITE) {
+		ublk_submit_bdev_io(io->q, io - io->q->ios);
+	} else {
+		ublk_io_complete(io, io->result);
+	}
+}
+
+static void
+ublk_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct ublk_io	*io = cb_arg;
+	struct ublk_queue *q = io->q;
+	int res;
 
 	if (bdev_io != NULL) {
 		spdk_bdev_free_io(bdev_io);
 	}
+
+	if (success) {
+		res = io->result;
+	} else {
+		res = -EIO;
+	}
+
+	if (q->dev->user_copy && success && io->payload != NULL &&
+	    ublksrv_get_op(&q->io_cmd_buf[io - q->ios]) == UBLK_IO_OP_READ) {
+		ublk_user_copy(io, UBLK_IO_OP_READ);
+		return;
+	}
+
+	ublk_io_complete(io, res);
+}
+
+static void
+ublk_io_buffer_ready(struct ublk_io *io)
+{
+	struct ublk_queue *q = io->q;
+	uint16_t tag = io - q->ios;
+
+	if (ublksrv_get_op(&q->io_cmd_buf[tag]) == UBLK_IO_OP_WRITE) {
+		ublk_user_copy(io, UBLK_IO_OP_WRITE);
+	} else {
+		ublk_submit_bdev_io(q, tag);
+	}
+}
+
+static void
+ublk_io_get_buffer_done(struct spdk_iobuf_entry *iobuf, void *buf)
+{
+	struct ublk_io *io = SPDK_CONTAINEROF(iobuf, struct ublk_io, iobuf);
+
+	io->payload = buf;
+	ublk_io_buffer_ready(io);
+}
+
+/* Start processing a request fetched from the kernel. In user copy mode, read and write
+ * requests get a payload buffer from the iobuf pool only for the duration of the request.
+ */
+static void
+ublk_submit_io(struct ublk_queue *q, uint16_t tag)
+{
+	struct ublk_io *io = &q->ios[tag];
+	const struct ublksrv_io_desc *iod = &q->io_cmd_buf[tag];
+	uint8_t ublk_op = ublksrv_get_op(iod);
+
+	if (!q->dev->user_copy || (ublk_op != UBLK_IO_OP_READ && ublk_op != UBLK_IO_OP_WRITE)) {
+		ublk_submit_bdev_io(q, tag);
+		return;
+	}
+
+	assert(io->payload == NULL);
+	io->payload_size = iod->nr_sectors << LINUX_SECTOR_SHIFT;
+	io->payload = spdk_iobuf_get(&q->thread_ctx->iobuf_ch, io->payload_size, &io->iobuf,
+				     ublk_io_get_buffer_done);
+	if (io->payload != NULL) {
+		ublk_io_buffer_ready(io);
+	}
 }
 
 static void
@@ -874,7 +1359,7 @@ ublk_submit_bdev_io(struct ublk_queue *q, uint16_t tag)
 	sector_per_block_shift = spdk_u32log2(sector_per_block);
 	offset_blocks = iod->start_sector >> sector_per_block_shift;
 	num_blocks = iod->nr_sectors >> sector_per_block_shift;
-	payload = (void *)iod->addr;
+	payload = ublk->user_copy ? io->payload : (void *)iod->addr;
 
 	io->result = num_blocks * spdk_bdev_get_data_block_size(ublk->bdev);
 	switch (ublk_op) {
@@ -908,7 +1393,7 @@ ublk_submit_bdev_io(struct ublk_queue *q, uint16_t tag)
 	}
 }
 
-static inline void
+static inline bool
 ublksrv_queue_io_cmd(struct ublk_queue *q,
 		     struct ublk_io *io, unsigned tag)
 {
@@ -923,26 +1408,29 @@ ublksrv_queue_io_cmd(struct ublk_queue *q,
 	       (io->cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ));
 	cmd_op = io->cmd_op;
 
-	sqe = io_uring_get_sqe(&q->ring);
-	assert(sqe);
+	/* The SQEs of the shared ring are used by different queues and operations,
+	 * so the command is always fully initialized.
+	 */
+	sqe = ublk_queue_get_sqe(q);
+	if (spdk_unlikely(sqe == NULL)) {
+		return false;
+	}
+	memset(sqe, 0, sizeof(*sqe));
 
 	cmd = (struct ublksrv_io_cmd *)ublk_get_sqe_cmd(sqe);
 	if (cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ) {
 		cmd->result = io->result;
 	}
 
-	/* These fields should be written once, never change */
 	ublk_set_sqe_cmd_op(sqe, cmd_op);
-	/* dev->cdev_fd */
-	sqe->fd		= 0;
 	sqe->opcode	= IORING_OP_URING_CMD;
-	sqe->flags	= IOSQE_FIXED_FILE;
-	sqe->rw_flags	= 0;
+	ublk_queue_set_sqe_file(q, sqe);
 	cmd->tag	= tag;
-	cmd->addr	= (__u64)(uintptr_t)(io->payload);
+	/* The kernel copies the data to/from the payload, unless it is copied by user */
+	cmd->addr	= q->dev->user_copy ? 0 : (__u64)(uintptr_t)(io->payload);
 	cmd->q_id	= q->q_id;
 
-	user_data = build_user_data(tag, cmd_op);
+	user_data = build_user_data(q->ring_idx, tag, cmd_op);
 	io_uring_sqe_set_data64(sqe, user_data);
 
 	io->cmd_op = 0;
@@ -951,16 +1439,28 @@ ublksrv_queue_io_cmd(struct ublk_queue *q,
 	SPDK_DEBUGLOG(ublk_io, "(qid %d tag %u cmd_op %u) iof %x stopping %d\n",
 		      q->q_id, tag, cmd_op,
 		      io->cmd_op, q->dev->is_closing);
+
+	return true;
 }
 
 static int
 ublk_io_xmit(struct ublk_queue *q)
 {
-	int rc = 0, count = 0, tag;
+	int count = 0, tag;
 	struct ublk_io *io;
 
+	/* User copies that couldn't get an SQE go first, as their requests started earlier */
+	while (!TAILQ_EMPTY(&q->user_copy_wait_list)) {
+		io = TAILQ_FIRST(&q->user_copy_wait_list);
+		if (!ublk_user_copy_submit(io, io->user_copy_op)) {
+			return count;
+		}
+		TAILQ_REMOVE(&q->user_copy_wait_list, io, sqe_wait_tailq);
+		count++;
+	}
+
 	if (TAILQ_EMPTY(&q->completed_io_list)) {
-		return 0;
+		return count;
 	}
 
 	while (!TAILQ_EMPTY(&q->completed_io_list)) {
@@ -973,34 +1473,33 @@ ublk_io_xmit(struct ublk_queue *q)
 		 * taken to work around a scan-build use-after-free mischaracterization.
 		 */
 		TAILQ_REMOVE(&q->completed_io_list, io, tailq);
-		ublksrv_queue_io_cmd(q, io, tag);
+		if (spdk_unlikely(!ublksrv_queue_io_cmd(q, io, tag))) {
+			/* The SQ is full, retry on the next poll */
+			TAILQ_INSERT_HEAD(&q->completed_io_list, io, tailq);
+			ublk_thread_notify(q->thread_ctx);
+			break;
+		}
 		count++;
 	}
 
-	rc = io_uring_submit(&q->ring);
-	if (rc != count) {
-		SPDK_ERRLOG("could not submit all commands\n");
-		assert(false);
-	}
-
-	return rc;
+	return count;
 }
 
 static int
-ublk_io_recv(struct ublk_queue *q)
+ublk_io_recv(struct ublk_thread_ctx *thread_ctx)
 {
 	struct io_uring_cqe *cqe;
 	unsigned head, tag;
 	int fetch, count = 0;
 	struct ublk_io *io;
-	struct spdk_ublk_dev *dev = q->dev;
-	unsigned __attribute__((unused)) cmd_op;
-
-	if (q->cmd_inflight == 0) {
-		return 0;
-	}
+	struct ublk_queue *q;
+	struct spdk_ublk_dev *dev;
+	unsigned cmd_op;
 
-	io_uring_for_each_cqe(&q->ring, head, cqe) {
+	io_uring_for_each_cqe(&thread_ctx->ring, head, cqe) {
+		q = thread_ctx->queues[user_data_to_ring_idx(cqe->user_data)];
+		assert(q != NULL);
+		dev = q->dev;
 		tag = user_data_to_tag(cqe->user_data);
 		cmd_op = user_data_to_op(cqe->user_data);
 		fetch = (cqe->res != UBLK_IO_RES_ABORT) && !dev->is_closing;
@@ -1011,6 +1510,12 @@ ublk_io_recv(struct ublk_queue *q)
 		q->cmd_inflight--;
 		io = &q->ios[tag];
 
+		/* Completion of a user copy, the request stays on the inflight list */
+		if (cmd_op == UBLK_IO_OP_READ || cmd_op == UBLK_IO_OP_WRITE) {
+			ublk_user_copy_done(io, cmd_op, cqe->res);
+			goto next;
+		}
+
 		if (!fetch) {
 			dev->is_closing = true;
 			if (io->cmd_op == UBLK_IO_FETCH_REQ) {
@@ -1020,7 +1525,7 @@ ublk_io_recv(struct ublk_queue *q)
 
 		TAILQ_INSERT_TAIL(&q->inflight_io_list, io, tailq);
 		if (cqe->res == UBLK_IO_RES_OK) {
-			ublk_submit_bdev_io(q, tag);
+			ublk_submit_io(q, tag);
 		} else if (cqe->res == UBLK_IO_RES_NEED_GET_DATA) {
 			ublk_mark_io_get_data(io);
 			TAILQ_REMOVE(&q->inflight_io_list, io, tailq);
@@ -1034,12 +1539,13 @@ ublk_io_recv(struct ublk_queue *q)
 			io->io_free = true;
 			TAILQ_REMOVE(&q->inflight_io_list, io, tailq);
 		}
+next:
 		count += 1;
-		if (count == UBLK_QUEUE_REQUEST) {
+		if (count == UBLK_THREAD_MAX_CQES) {
 			break;
 		}
 	}
-	io_uring_cq_advance(&q->ring, count);
+	io_uring_cq_advance(&thread_ctx->ring, count);
 
 	return count;
 }
@@ -1050,17 +1556,22 @@ ublk_poll(void *arg)
 	struct ublk_thread_ctx *thread_ctx = arg;
 	struct ublk_queue *q, *q_tmp;
 	struct spdk_ublk_dev *ublk;
-	int sent, received, count = 0;
+	int sent = 0, received, count;
+
+	TAILQ_FOREACH(q, &thread_ctx->queue_list, tailq) {
+		sent += ublk_io_xmit(q);
+	}
+	ublk_thread_submit(thread_ctx);
+	received = ublk_io_recv(thread_ctx);
 
 	TAILQ_FOREACH_SAFE(q, &thread_ctx->queue_list, tailq, q_tmp) {
-		sent = ublk_io_xmit(q);
-		received = ublk_io_recv(q);
 		ublk = q->dev;
 		if (spdk_unlikely(ublk->is_closing)) {
 			ublk_try_close_queue(q);
 		}
-		count += sent + received;
 	}
+
+	count = sent + received;
 	if (count > 0) {
 		return SPDK_POLLER_BUSY;
 	} else {
@@ -1088,23 +1599,6 @@ ublk_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
 	}
 }
 
-static void
-ublk_dev_init_io_cmds(struct io_uring *r, uint32_t q_depth)
-{
-	struct io_uring_sqe *sqe;
-	uint32_t i;
-
-	for (i = 0; i < q_depth; i++) {
-		sqe = ublk_uring_get_sqe(r, i);
-
-		/* These fields should be written once, never change */
-		sqe->flags = IOSQE_FIXED_FILE;
-		sqe->rw_flags = 0;
-		sqe->ioprio = 0;
-		sqe->off = 0;
-	}
-}
-
 static int
 ublk_dev_queue_init(struct ublk_queue *q)
 {
@@ -1130,26 +1624,6 @@ ublk_dev_queue_init(struct ublk_queue *q)
 		q->ios[j].io_free = true;
 	}
 
-	rc = ublk_setup_ring(q->q_depth, &q->ring, IORING_SETUP_SQE128);
-	if (rc < 0) {
-		SPDK_ERRLOG("Failed at setup uring: %s\n", spdk_strerror(-rc));
-		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
-		q->io_cmd_buf = NULL;
-		goto err;
-	}
-
-	rc = io_uring_register_files(&q->ring, &ublk->cdev_fd, 1);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed at uring register files: %s\n", spdk_strerror(-rc));
-		io_uring_queue_exit(&q->ring);
-		q->ring.ring_fd = -1;
-		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
-		q->io_cmd_buf = NULL;
-		goto err;
-	}
-
-	ublk_dev_init_io_cmds(&q->ring, q->q_depth);
-
 	return 0;
 err:
 	return rc;
@@ -1158,11 +1632,6 @@ err:
 static void
 ublk_dev_queue_fini(struct ublk_queue *q)
 {
-	if (q->ring.ring_fd >= 0) {
-		io_uring_unregister_files(&q->ring);
-		io_uring_queue_exit(&q->ring);
-		q->ring.ring_fd = -1;
-	}
 	if (q->io_cmd_buf) {
 		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
 	}
@@ -1172,15 +1641,15 @@ static void
 ublk_dev_queue_io_init(struct ublk_queue *q)
 {
 	uint32_t i;
-	int rc __attribute__((unused));
 
-	/* submit all io commands to ublk driver */
+	/* submit all io commands to ublk driver, the ones not fitting the SQ are sent by the poller */
 	for (i = 0; i < q->q_depth; i++) {
-		ublksrv_queue_io_cmd(q, &q->ios[i], i);
+		if (!ublksrv_queue_io_cmd(q, &q->ios[i], i)) {
+			TAILQ_INSERT_TAIL(&q->completed_io_list, &q->ios[i], tailq);
+		}
 	}
 
-	rc = io_uring_submit(&q->ring);
-	assert(rc == (int)q->q_depth);
+	ublk_thread_submit(q->thread_ctx);
 }
 
 static void
@@ -1243,6 +1712,11 @@ ublk_info_param_init(struct spdk_ublk_dev *ublk)
 		}
 	}
 
+	ublk->user_copy = __atomic_load_n(&g_ublk_tgt.user_copy, __ATOMIC_RELAXED);
+	if (ublk->user_copy) {
+		uinfo.flags |= UBLK_F_USER_COPY;
+	}
+
 	ublk->dev_info = uinfo;
 	ublk->dev_params = uparams;
 }
@@ -1261,7 +1735,7 @@ ublk_ios_fini(struct spdk_ublk_dev *ublk)
 			continue;
 		}
 
-		for (i = 0; i < q->q_depth; i++) {
+		for (i = 0; i < q->q_depth && !ublk->user_copy; i++) {
 			if (q->ios[i].payload) {
 				spdk_mempool_put(ublk->io_buf_pool, q->ios[i].mpool_entry);
 			}
@@ -1281,18 +1755,23 @@ ublk_ios_init(struct spdk_ublk_dev *ublk)
 	uint32_t i, j;
 	struct ublk_queue *q;
 
-	snprintf(mempool_name, sizeof(mempool_name), "ublk_io_buf_pool_%d", ublk->ublk_id);
-
-	/* Create a mempool to allocate buf for each io */
-	ublk->io_buf_pool = spdk_mempool_create(mempool_name,
-						ublk->num_queues * ublk->queue_depth,
-						UBLK_IO_MAX_BYTES + 4096,
-						SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
-						SPDK_ENV_SOCKET_ID_ANY);
-	if (ublk->io_buf_pool == NULL) {
-		rc = -ENOMEM;
-		SPDK_ERRLOG("could not allocate ublk_io_buf pool\n");
-		return rc;
+	/* In user copy mode, the buffers are only taken from the iobuf pool while an I/O is
+	 * in progress, so no buffer needs to be reserved for each tag.
+	 */
+	if (!ublk->user_copy) {
+		snprintf(mempool_name, sizeof(mempool_name), "ublk_io_buf_pool_%d", ublk->ublk_id);
+
+		/* Create a mempool to allocate buf for each io */
+		ublk->io_buf_pool = spdk_mempool_create(mempool_name,
+							ublk->num_queues * ublk->queue_depth,
+							UBLK_IO_MAX_BYTES + 4096,
+							SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+							SPDK_ENV_SOCKET_ID_ANY);
+		if (ublk->io_buf_pool == NULL) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate ublk_io_buf pool\n");
+			return rc;
+		}
 	}
 
 	for (i = 0; i < ublk->num_queues; i++) {
@@ -1300,6 +1779,7 @@ ublk_ios_init(struct spdk_ublk_dev *ublk)
 
 		TAILQ_INIT(&q->completed_io_list);
 		TAILQ_INIT(&q->inflight_io_list);
+		TAILQ_INIT(&q->user_copy_wait_list);
 		q->dev = ublk;
 		q->q_id = i;
 		q->q_depth = ublk->queue_depth;
@@ -1311,6 +1791,9 @@ ublk_ios_init(struct spdk_ublk_dev *ublk)
 		}
 		for (j = 0; j < q->q_depth; j++) {
 			q->ios[j].q = q;
+			if (ublk->user_copy) {
+				continue;
+			}
 			q->ios[j].mpool_entry = spdk_mempool_get(ublk->io_buf_pool);
 			q->ios[j].payload = (void *)(uintptr_t)SPDK_ALIGN_CEIL((uint64_t)(uintptr_t)q->ios[j].mpool_entry,
 					    4096ULL);
@@ -1330,8 +1813,25 @@ ublk_queue_run(void *arg1)
 	struct ublk_queue	*q = arg1;
 	struct spdk_ublk_dev *ublk = q->dev;
 	struct ublk_thread_ctx *thread_ctx = q->thread_ctx;
+	uint32_t idx;
+	int rc;
 
 	assert(spdk_get_thread() == thread_ctx->ublk_thread);
+
+	/* A slot was reserved by ublk_finish_start(), so one must be free */
+	for (idx = 0; idx < UBLK_THREAD_MAX_QUEUES; idx++) {
+		if (thread_ctx->queues[idx] == NULL) {
+			break;
+		}
+	}
+	assert(idx < UBLK_THREAD_MAX_QUEUES);
+	thread_ctx->queues[idx] = q;
+	q->ring_idx = idx;
+
+	/* Use the char device as fixed file at the slot index, if the ring supports it */
+	rc = io_uring_register_files_update(&thread_ctx->ring, idx, &ublk->cdev_fd, 1);
+	q->fixed_file = (rc == 1);
+
 	/* Queues must be filled with IO in the io pthread */
 	ublk_dev_queue_io_init(q);
 
@@ -1345,7 +1845,6 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 		ublk_start_cb start_cb, void *cb_arg)
 {
 	int			rc;
-	uint32_t		i;
 	struct spdk_bdev	*bdev;
 	struct spdk_ublk_dev	*ublk = NULL;
 
@@ -1394,9 +1893,6 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 			     ublk->num_queues, ublk->ublk_id, UBLK_DEV_MAX_QUEUES);
 		ublk->num_queues = UBLK_DEV_MAX_QUEUES;
 	}
-	for (i = 0; i < ublk->num_queues; i++) {
-		ublk->queues[i].ring.ring_fd = -1;
-	}
 
 	/* Add ublk_dev to the end of disk list */
 	rc = ublk_dev_list_register(ublk);
@@ -1428,8 +1924,8 @@ static void
 ublk_finish_start(struct spdk_ublk_dev *ublk)
 {
 	int			rc;
-	uint32_t		q_id;
-	struct spdk_thread	*ublk_thread;
+	uint32_t		q_id, i;
+	struct ublk_thread_ctx	*thread_ctx;
 	char			buf[64];
 
 	snprintf(buf, 64, "%s%d", UBLK_BLK_CDEV, ublk->ublk_id);
@@ -1447,6 +1943,36 @@ ublk_finish_start(struct spdk_ublk_dev *ublk)
 		}
 	}
 
+	/* Assign queues to different spdk_threads for load balance. The queues of a
+	 * thread share its ring, so each thread serves a limited number of queues.
+	 */
+	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
+		for (i = 0; i < g_num_ublk_threads; i++) {
+			thread_ctx = &g_ublk_tgt.thread_ctx[g_queue_thread_id];
+			g_queue_thread_id++;
+			if (g_queue_thread_id == g_num_ublk_threads) {
+				g_queue_thread_id = 0;
+			}
+			/* A thread without an iobuf channel can't get buffers for user copy */
+			if (ublk->user_copy &&
+			    !__atomic_load_n(&thread_ctx->iobuf_ch_ready, __ATOMIC_ACQUIRE)) {
+				continue;
+			}
+			if (thread_ctx->queues_assigned < UBLK_THREAD_MAX_QUEUES &&
+			    thread_ctx->tags_assigned + ublk->queue_depth <= UBLK_THREAD_CQ_DEPTH) {
+				break;
+			}
+		}
+		if (i == g_num_ublk_threads) {
+			SPDK_ERRLOG("no ublk thread can serve more queues\n");
+			rc = -ENOSPC;
+			goto err;
+		}
+		thread_ctx->queues_assigned++;
+		thread_ctx->tags_assigned += ublk->queue_depth;
+		ublk->queues[q_id].thread_ctx = thread_ctx;
+	}
+
 	rc = ublk_ctrl_cmd(ublk, UBLK_CMD_START_DEV);
 	if (rc < 0) {
 		SPDK_ERRLOG("start dev %d failed, rc %s\n", ublk->ublk_id,
@@ -1454,15 +1980,9 @@ ublk_finish_start(struct spdk_ublk_dev *ublk)
 		goto err;
 	}
 
-	/* Send queue to different spdk_threads for load balance */
 	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
-		ublk->queues[q_id].thread_ctx = &g_ublk_tgt.thread_ctx[g_queue_thread_id];
-		ublk_thread = g_ublk_tgt.thread_ctx[g_queue_thread_id].ublk_thread;
-		spdk_thread_send_msg(ublk_thread, ublk_queue_run, &ublk->queues[q_id]);
-		g_queue_thread_id++;
-		if (g_queue_thread_id == g_num_ublk_threads) {
-			g_queue_thread_id = 0;
-		}
+		thread_ctx = ublk->queues[q_id].thread_ctx;
+		spdk_thread_send_msg(thread_ctx->ublk_thread, ublk_queue_run, &ublk->queues[q_id]);
 	}
 
 	goto out;
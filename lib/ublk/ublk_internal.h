@@ -33,6 +33,7 @@ struct spdk_ublk_dev *ublk_dev_first(void);
 struct spdk_ublk_dev *ublk_dev_next(struct spdk_ublk_dev *prev);
 uint32_t ublk_dev_get_queue_depth(struct spdk_ublk_dev *ublk);
 uint32_t ublk_dev_get_num_queues(struct spdk_ublk_dev *ublk);
+bool ublk_dev_get_user_copy(struct spdk_ublk_dev *ublk);
 
 #ifdef __cplusplus
 }
@@ -362,6 +362,7 @@ vhost_vq_used_signal(struct spdk_vhost_session *vsession,
 		/* interrupt signalled */
 		virtqueue->req_cnt += virtqueue->used_req_cnt;
 		virtqueue->used_req_cnt = 0;
+		virtqueue->coalescing.irq_cnt++;
 		return 1;
 	} else {
 		/* interrupt not signalled */
@@ -394,14 +395,65 @@ static void
 check_session_vq_io_stats(struct spdk_vhost_session *vsession,
 			  struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
 {
-	if (now < vsession->next_stats_check_time) {
+	if (now < virtqueue->next_stats_check_time) {
 		return;
 	}
 
-	vsession->next_stats_check_time = now + vsession->stats_check_interval;
+	virtqueue->next_stats_check_time = now + vsession->stats_check_interval;
 	session_vq_io_stats_update(vsession, virtqueue, now);
 }
 
+/*
+ * Adaptive coalescing: once per stats check interval, compare the average
+ * latency of the requests completed on this virtqueue with the session's
+ * latency target. The slack left below the target is the budget for delaying
+ * interrupts. The delay shrinks to the budget immediately, but grows towards it
+ * only gradually, so that a single quiet interval doesn't cause a latency spike.
+ * Below the IOPS threshold interrupts are not delayed at all.
+ */
+static void
+check_vq_adaptive_coalescing(struct spdk_vhost_session *vsession,
+			     struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
+{
+	uint64_t elapsed = now - virtqueue->coalescing.last_check_time;
+	uint64_t target = vsession->coalescing_latency_target;
+	uint64_t delay = virtqueue->irq_delay_time;
+	uint64_t budget = 0;
+	uint32_t cnt;
+
+	if (elapsed < vsession->stats_check_interval) {
+		return;
+	}
+
+	cnt = virtqueue->coalescing.lat_cnt;
+	virtqueue->coalescing.iops = cnt * spdk_get_ticks_hz() / elapsed;
+	virtqueue->coalescing.avg_lat = cnt != 0 ? virtqueue->coalescing.lat_sum / cnt : 0;
+	virtqueue->coalescing.lat_sum = 0;
+	virtqueue->coalescing.lat_cnt = 0;
+	virtqueue->coalescing.last_check_time = now;
+
+	/* coalescing_io_rate_threshold is expressed per stats check interval */
+	if ((uint64_t)cnt * vsession->stats_check_interval >=
+	    (uint64_t)vsession->coalescing_io_rate_threshold * elapsed &&
+	    virtqueue->coalescing.avg_lat < target) {
+		budget = target - virtqueue->coalescing.avg_lat;
+	}
+
+	if (budget < delay) {
+		delay = budget;
+		virtqueue->coalescing.delay_decreases++;
+	} else if (budget > delay) {
+		delay += spdk_max((budget - delay) / 4, 1);
+		virtqueue->coalescing.delay_increases++;
+	} else {
+		return;
+	}
+
+	virtqueue->irq_delay_time = (uint32_t)spdk_min(delay, UINT32_MAX);
+	virtqueue->next_event_time = spdk_min(virtqueue->next_event_time,
+					      now + virtqueue->irq_delay_time);
+}
+
 static inline bool
 vhost_vq_event_is_suppressed(struct spdk_vhost_virtqueue *vq)
 {
@@ -424,7 +476,7 @@ vhost_session_vq_used_signal(struct spdk_vhost_virtqueue *virtqueue)
 	struct spdk_vhost_session *vsession = virtqueue->vsession;
 	uint64_t now;
 
-	if (vsession->coalescing_delay_time_base == 0) {
+	if (vsession->coalescing_delay_time_base == 0 && vsession->coalescing_latency_target == 0) {
 		if (virtqueue->vring.desc == NULL) {
 			return;
 		}
@@ -436,7 +488,11 @@ vhost_session_vq_used_signal(struct spdk_vhost_virtqueue *virtqueue)
 		vhost_vq_used_signal(vsession, virtqueue);
 	} else {
 		now = spdk_get_ticks();
-		check_session_vq_io_stats(vsession, virtqueue, now);
+		if (vsession->coalescing_latency_target != 0) {
+			check_vq_adaptive_coalescing(vsession, virtqueue, now);
+		} else {
+			check_session_vq_io_stats(vsession, virtqueue, now);
+		}
 
 		/* No need for event right now */
 		if (now < virtqueue->next_event_time) {
@@ -966,7 +1022,6 @@ new_connection(int vid)
 		return -1;
 	}
 	vsession->started = false;
-	vsession->next_stats_check_time = 0;
 	vsession->stats_check_interval = SPDK_VHOST_STATS_CHECK_INTERVAL_MS *
 					 spdk_get_ticks_hz() / 1000UL;
 	TAILQ_INSERT_TAIL(&user_dev->vsessions, vsession, tailq);
@@ -1697,6 +1752,8 @@ vhost_user_session_set_coalescing(struct spdk_vhost_dev *vdev,
 		to_user_dev(vdev)->coalescing_delay_us * spdk_get_ticks_hz() / 1000000ULL;
 	vsession->coalescing_io_rate_threshold =
 		to_user_dev(vdev)->coalescing_iops_threshold * SPDK_VHOST_STATS_CHECK_INTERVAL_MS / 1000U;
+	vsession->coalescing_latency_target =
+		to_user_dev(vdev)->coalescing_latency_target_us * spdk_get_ticks_hz() / 1000000ULL;
 	return 0;
 }
 
@@ -1731,6 +1788,28 @@ vhost_user_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 	}
 }
 
+int
+vhost_user_set_coalescing_latency_target(struct spdk_vhost_dev *vdev, uint32_t latency_target_us)
+{
+	uint64_t latency_target = latency_target_us * spdk_get_ticks_hz() / 1000000ULL;
+
+	if (latency_target >= UINT32_MAX) {
+		SPDK_ERRLOG("Latency target of %"PRIu32" is to big\n", latency_target_us);
+		return -EINVAL;
+	}
+
+	to_user_dev(vdev)->coalescing_latency_target_us = latency_target_us;
+	vhost_user_dev_foreach_session(vdev, vhost_user_session_set_coalescing, NULL, NULL);
+
+	return 0;
+}
+
+uint32_t
+vhost_user_get_coalescing_latency_target(struct spdk_vhost_dev *vdev)
+{
+	return to_user_dev(vdev)->coalescing_latency_target_us;
+}
+
 int
 spdk_vhost_set_socket_path(const char *basename)
 {
@@ -1962,6 +2041,9 @@ vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 {
 	struct spdk_vhost_session *vsession;
 	struct spdk_vhost_user_dev *user_dev;
+	struct spdk_vhost_virtqueue *vq;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint16_t i;
 
 	user_dev = to_user_dev(vdev);
 	pthread_mutex_lock(&user_dev->lock);
@@ -1973,6 +2055,27 @@ vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_named_bool(w, "started", vsession->started);
 		spdk_json_write_named_uint32(w, "max_queues", vsession->max_queues);
 		spdk_json_write_named_uint32(w, "inflight_task_cnt", vsession->task_cnt);
+		if (vsession->coalescing_latency_target != 0) {
+			spdk_json_write_named_array_begin(w, "coalescing_stats");
+			for (i = 0; i < vsession->max_queues; i++) {
+				vq = &vsession->virtqueue[i];
+				if (vq->vring.desc == NULL) {
+					continue;
+				}
+
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "queue", i);
+				spdk_json_write_named_uint64(w, "irq_delay_us", vq->irq_delay_time * SPDK_SEC_TO_USEC / ticks_hz);
+				spdk_json_write_named_uint64(w, "avg_latency_us",
+							     vq->coalescing.avg_lat * SPDK_SEC_TO_USEC / ticks_hz);
+				spdk_json_write_named_uint64(w, "iops", vq->coalescing.iops);
+				spdk_json_write_named_uint64(w, "irq_count", vq->coalescing.irq_cnt);
+				spdk_json_write_named_uint64(w, "delay_increases", vq->coalescing.delay_increases);
+				spdk_json_write_named_uint64(w, "delay_decreases", vq->coalescing.delay_decreases);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
 		spdk_json_write_object_end(w);
 	}
 	pthread_mutex_unlock(&user_dev->lock);
@@ -232,6 +232,26 @@ spdk_vhost_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 	vdev->backend->get_coalescing(vdev, delay_base_us, iops_threshold);
 }
 
+int
+spdk_vhost_set_coalescing_latency_target(struct spdk_vhost_dev *vdev, uint32_t latency_target_us)
+{
+	if (vdev->backend->set_coalescing_latency_target == NULL) {
+		return -ENOTSUP;
+	}
+
+	return vdev->backend->set_coalescing_latency_target(vdev, latency_target_us);
+}
+
+uint32_t
+spdk_vhost_get_coalescing_latency_target(struct spdk_vhost_dev *vdev)
+{
+	if (vdev->backend->get_coalescing_latency_target == NULL) {
+		return 0;
+	}
+
+	return vdev->backend->get_coalescing_latency_target(vdev);
+}
+
 void
 spdk_vhost_lock(void)
 {
@@ -343,11 +363,13 @@ vhost_user_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *
 {
 	uint32_t delay_base_us;
 	uint32_t iops_threshold;
+	uint32_t latency_target_us;
 
 	vdev->backend->write_config_json(vdev, w);
 
 	spdk_vhost_get_coalescing(vdev, &delay_base_us, &iops_threshold);
-	if (delay_base_us) {
+	latency_target_us = spdk_vhost_get_coalescing_latency_target(vdev);
+	if (delay_base_us || latency_target_us) {
 		spdk_json_write_object_begin(w);
 		spdk_json_write_named_string(w, "method", "vhost_controller_set_coalescing");
 
@@ -355,6 +377,9 @@ vhost_user_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *
 		spdk_json_write_named_string(w, "ctrlr", vdev->name);
 		spdk_json_write_named_uint32(w, "delay_base_us", delay_base_us);
 		spdk_json_write_named_uint32(w, "iops_threshold", iops_threshold);
+		if (latency_target_us) {
+			spdk_json_write_named_uint32(w, "latency_target_us", latency_target_us);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -37,16 +37,24 @@
 
 #define VIRTIO_BLK_DEFAULT_TRANSPORT "vhost_user_blk"
 
+/* Maximum number of SPDK threads the virtqueues of one controller can be spread across */
+#define SPDK_VHOST_BLK_MAX_VQ_THREADS 64
+
 struct spdk_vhost_user_blk_task {
 	struct spdk_vhost_blk_task blk_task;
 	struct spdk_vhost_blk_session *bvsession;
 	struct spdk_vhost_virtqueue *vq;
+	/* Poll group of the virtqueue, set while the task is used for I/O processing. */
+	struct vhost_blk_poll_group *pg;
 
 	uint16_t req_idx;
 	uint16_t num_descs;
 	uint16_t buffer_id;
 	uint16_t inflight_head;
 
+	/* Tick count at which the request was fetched, 0 if latency isn't tracked. */
+	uint64_t submit_tsc;
+
 	/* If set, the task is currently used for I/O processing. */
 	bool used;
 };
@@ -60,15 +68,48 @@ struct spdk_vhost_blk_dev {
 	/* dummy_io_channel is used to hold a bdev reference */
 	struct spdk_io_channel *dummy_io_channel;
 	bool readonly;
+
+	/* Threads the virtqueues of each session are spread across. The first one
+	 * is always the controller's own thread (vdev.thread), the other ones are
+	 * created together with the controller.
+	 */
+	struct spdk_thread *vq_threads[SPDK_VHOST_BLK_MAX_VQ_THREADS];
+	uint16_t num_vq_threads;
+
+	/* Hot-remove of the bdev completes once all poll groups stopped using it. */
+	bdev_event_cb_complete remove_cpl_fn;
+	void *remove_cpl_arg;
+	struct spdk_thread *remove_thread;
+	uint32_t remove_pending;
+};
+
+/*
+ * Set of virtqueues of a session polled by a single thread, with its own bdev
+ * io_channel. Virtqueue i is handled by poll group i % num_poll_groups. The
+ * first poll group runs on the session's thread.
+ */
+struct vhost_blk_poll_group {
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_thread *thread;
+	struct spdk_poller *requestq_poller;
+	struct spdk_poller *stop_poller;
+	struct spdk_io_channel *io_channel;
+	/* Points to vsession.task_cnt for the first poll group, to local_task_cnt otherwise */
+	int *task_cnt;
+	int local_task_cnt;
+	uint16_t idx;
 };
 
 struct spdk_vhost_blk_session {
 	/* The parent session must be the very first field in this struct */
 	struct spdk_vhost_session vsession;
 	struct spdk_vhost_blk_dev *bvdev;
-	struct spdk_poller *requestq_poller;
-	struct spdk_io_channel *io_channel;
 	struct spdk_poller *stop_poller;
+
+	struct vhost_blk_poll_group poll_groups[SPDK_VHOST_BLK_MAX_VQ_THREADS];
+	uint16_t num_poll_groups;
+	/* Number of poll groups, other than the first one, that are not stopped yet */
+	uint16_t active_poll_groups;
 };
 
 /* forward declaration */
@@ -83,7 +124,7 @@ vhost_user_process_blk_request(struct spdk_vhost_user_blk_task *user_task)
 	struct spdk_vhost_blk_session *bvsession = user_task->bvsession;
 	struct spdk_vhost_dev *vdev = &bvsession->bvdev->vdev;
 
-	return virtio_blk_process_request(vdev, bvsession->io_channel, &user_task->blk_task,
+	return virtio_blk_process_request(vdev, user_task->pg->io_channel, &user_task->blk_task,
 					  vhost_user_blk_request_finish, NULL);
 }
 
@@ -119,11 +160,26 @@ to_blk_session(struct spdk_vhost_session *vsession)
 	return (struct spdk_vhost_blk_session *)vsession;
 }
 
+static inline struct vhost_blk_poll_group *
+blk_vq_get_poll_group(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue *vq)
+{
+	uint16_t q_idx = vq - bvsession->vsession.virtqueue;
+
+	return &bvsession->poll_groups[q_idx % bvsession->num_poll_groups];
+}
+
+static void
+blk_task_get(struct spdk_vhost_user_blk_task *task)
+{
+	task->pg = blk_vq_get_poll_group(task->bvsession, task->vq);
+	(*task->pg->task_cnt)++;
+}
+
 static void
 blk_task_finish(struct spdk_vhost_user_blk_task *task)
 {
-	assert(task->bvsession->vsession.task_cnt > 0);
-	task->bvsession->vsession.task_cnt--;
+	assert(*task->pg->task_cnt > 0);
+	(*task->pg->task_cnt)--;
 	task->used = false;
 }
 
@@ -133,6 +189,7 @@ blk_task_init(struct spdk_vhost_user_blk_task *task)
 	struct spdk_vhost_blk_task *blk_task = &task->blk_task;
 
 	task->used = true;
+	task->submit_tsc = task->bvsession->vsession.coalescing_latency_target != 0 ? spdk_get_ticks() : 0;
 	blk_task->iovcnt = SPDK_COUNTOF(blk_task->iovs);
 	blk_task->status = NULL;
 	blk_task->used_len = 0;
@@ -160,6 +217,10 @@ vhost_user_blk_request_finish(uint8_t status, struct spdk_vhost_blk_task *task,
 
 	user_task = SPDK_CONTAINEROF(task, struct spdk_vhost_user_blk_task, blk_task);
 
+	if (user_task->submit_tsc != 0) {
+		vhost_vq_coalescing_record_latency(user_task->vq, user_task->submit_tsc);
+	}
+
 	blk_task_enqueue(user_task);
 
 	SPDK_DEBUGLOG(vhost_blk, "Finished task (%p) req_idx=%d\n status: %" PRIu8"\n",
@@ -652,7 +713,7 @@ process_blk_task(struct spdk_vhost_virtqueue *vq, uint16_t req_idx)
 		return;
 	}
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -717,7 +778,7 @@ process_packed_blk_task(struct spdk_vhost_virtqueue *vq, uint16_t req_idx)
 					   req_idx, (req_idx + num_descs - 1) % vq->vring.size,
 					   &task->inflight_head);
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -778,7 +839,7 @@ process_packed_inflight_blk_task(struct spdk_vhost_virtqueue *vq,
 	/* It's for cleaning inflight entries */
 	task->inflight_head = req_idx;
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -928,12 +989,13 @@ vdev_vq_worker(void *arg)
 static int
 vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 	int rc = 0;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = pg->idx; q_idx < vsession->max_queues; q_idx += bvsession->num_poll_groups) {
 		rc += _vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
@@ -1009,6 +1071,7 @@ _no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 {
 	struct spdk_vhost_session *vsession = vq->vsession;
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct vhost_blk_poll_group *pg = blk_vq_get_poll_group(bvsession, vq);
 	bool packed_ring;
 
 	packed_ring = vq->packed.packed_ring;
@@ -1020,9 +1083,9 @@ _no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 
 	vhost_session_vq_used_signal(vq);
 
-	if (vsession->task_cnt == 0 && bvsession->io_channel) {
-		vhost_blk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (*pg->task_cnt == 0 && pg->io_channel) {
+		vhost_blk_put_io_channel(pg->io_channel);
+		pg->io_channel = NULL;
 	}
 
 	return SPDK_POLLER_BUSY;
@@ -1039,11 +1102,12 @@ no_bdev_vdev_vq_worker(void *arg)
 static int
 no_bdev_vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = pg->idx; q_idx < vsession->max_queues; q_idx += bvsession->num_poll_groups) {
 		_no_bdev_vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
 
@@ -1102,9 +1166,9 @@ err:
 static void
 vhost_blk_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
 {
-	struct spdk_vhost_blk_session *bvsession = cb_arg;
+	struct vhost_blk_poll_group *pg = cb_arg;
 
-	vhost_user_session_set_interrupt_mode(&bvsession->vsession, interrupt_mode);
+	vhost_user_session_set_interrupt_mode(&pg->bvsession->vsession, interrupt_mode);
 }
 
 static void
@@ -1146,17 +1210,53 @@ vhost_user_blk_resize_cb(struct spdk_vhost_dev *vdev, bdev_event_cb_complete cb,
 				       cb, cb_arg);
 }
 
+static void
+vhost_user_bdev_remove_put(struct spdk_vhost_blk_dev *bvdev)
+{
+	assert(spdk_get_thread() == bvdev->remove_thread);
+
+	if (__atomic_sub_fetch(&bvdev->remove_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+		bvdev->remove_cpl_fn(&bvdev->vdev, bvdev->remove_cpl_arg);
+	}
+}
+
+static void
+vhost_user_poll_group_bdev_remove_done(void *arg)
+{
+	struct spdk_vhost_blk_dev *bvdev = arg;
+
+	vhost_user_bdev_remove_put(bvdev);
+}
+
+static void
+vhost_user_poll_group_bdev_remove(void *arg)
+{
+	struct vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_dev *bvdev = pg->bvsession->bvdev;
+
+	/* The poll group might have been stopped in the meantime */
+	if (pg->requestq_poller) {
+		spdk_poller_unregister(&pg->requestq_poller);
+		pg->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, pg, 0);
+	}
+
+	spdk_thread_send_msg(bvdev->remove_thread, vhost_user_poll_group_bdev_remove_done, bvdev);
+}
+
 static int
 vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 				  struct spdk_vhost_session *vsession,
 				  void *ctx)
 {
 	struct spdk_vhost_blk_session *bvsession;
+	struct vhost_blk_poll_group *pg;
+	uint16_t i;
 	int rc;
 
 	bvsession = to_blk_session(vsession);
-	if (bvsession->requestq_poller) {
-		spdk_poller_unregister(&bvsession->requestq_poller);
+	pg = &bvsession->poll_groups[0];
+	if (pg->requestq_poller) {
+		spdk_poller_unregister(&pg->requestq_poller);
 		if (vsession->virtqueue[0].intr) {
 			vhost_blk_session_unregister_interrupts(bvsession);
 			rc = vhost_blk_session_register_interrupts(bvsession, no_bdev_vdev_vq_worker,
@@ -1167,22 +1267,43 @@ vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 			}
 		}
 
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, bvsession, 0);
-		spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
-					       bvsession);
+		pg->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, pg, 0);
+		spdk_poller_register_interrupt(pg->requestq_poller, vhost_blk_poller_set_interrupt_mode,
+					       pg);
+
+		/* The other poll groups have to stop using the bdev before it gets closed */
+		for (i = 1; i < bvsession->num_poll_groups; i++) {
+			__atomic_add_fetch(&bvsession->bvdev->remove_pending, 1, __ATOMIC_ACQ_REL);
+			spdk_thread_send_msg(bvsession->poll_groups[i].thread,
+					     vhost_user_poll_group_bdev_remove,
+					     &bvsession->poll_groups[i]);
+		}
 	}
 
 	return 0;
 }
 
+static void
+vhost_user_bdev_remove_cpl(struct spdk_vhost_dev *vdev, void *ctx)
+{
+	vhost_user_bdev_remove_put(to_blk_dev(vdev));
+}
+
 static void
 vhost_user_bdev_remove_cb(struct spdk_vhost_dev *vdev, bdev_event_cb_complete cb, void *cb_arg)
 {
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+
 	SPDK_WARNLOG("%s: hot-removing bdev - all further requests will fail.\n",
 		     vdev->name);
 
+	bvdev->remove_cpl_fn = cb;
+	bvdev->remove_cpl_arg = cb_arg;
+	bvdev->remove_thread = spdk_get_thread();
+	bvdev->remove_pending = 1;
+
 	vhost_user_dev_foreach_session(vdev, vhost_user_session_bdev_remove_cb,
-				       cb, cb_arg);
+				       vhost_user_bdev_remove_cpl, NULL);
 }
 
 static void
@@ -1286,16 +1407,43 @@ alloc_vq_task_pool(struct spdk_vhost_session *vsession, uint16_t qid)
 	return 0;
 }
 
+static void
+vhost_blk_poll_group_start(void *arg)
+{
+	struct vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+
+	if (bvdev->bdev) {
+		pg->io_channel = vhost_blk_get_io_channel(&bvdev->vdev);
+		if (!pg->io_channel) {
+			SPDK_ERRLOG("%s: I/O channel allocation failed for poll group %"PRIu16", "
+				    "requests of its virtqueues will fail\n",
+				    bvsession->vsession.name, pg->idx);
+		}
+	}
+
+	if (pg->io_channel) {
+		pg->requestq_poller = SPDK_POLLER_REGISTER(vdev_worker, pg, 0);
+	} else {
+		pg->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, pg, 0);
+	}
+	SPDK_INFOLOG(vhost, "%s: started poller %"PRIu16" on lcore %d\n",
+		     bvsession->vsession.name, pg->idx, spdk_env_get_current_core());
+}
+
 static int
 vhost_blk_start(struct spdk_vhost_dev *vdev,
 		struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
 	struct spdk_vhost_blk_dev *bvdev;
+	struct vhost_blk_poll_group *pg;
+	uint16_t num_poll_groups;
 	int i, rc = 0;
 
 	/* return if start is already in progress */
-	if (bvsession->requestq_poller) {
+	if (bvsession->poll_groups[0].requestq_poller) {
 		SPDK_INFOLOG(vhost, "%s: start in progress\n", vsession->name);
 		return -EINPROGRESS;
 	}
@@ -1315,9 +1463,26 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	assert(bvdev != NULL);
 	bvsession->bvdev = bvdev;
 
+	/* Virtqueue kick interrupts are all registered on the session's thread */
+	num_poll_groups = spdk_min(bvdev->num_vq_threads, vsession->max_queues);
+	if (num_poll_groups == 0 || spdk_interrupt_mode_is_enabled()) {
+		num_poll_groups = 1;
+	}
+
+	bvsession->num_poll_groups = num_poll_groups;
+	for (i = 0; i < num_poll_groups; i++) {
+		pg = &bvsession->poll_groups[i];
+		pg->bvsession = bvsession;
+		pg->idx = i;
+		pg->thread = i == 0 ? spdk_get_thread() : bvdev->vq_threads[i];
+		pg->task_cnt = i == 0 ? &vsession->task_cnt : &pg->local_task_cnt;
+		pg->local_task_cnt = 0;
+	}
+
+	pg = &bvsession->poll_groups[0];
 	if (bvdev->bdev) {
-		bvsession->io_channel = vhost_blk_get_io_channel(vdev);
-		if (!bvsession->io_channel) {
+		pg->io_channel = vhost_blk_get_io_channel(vdev);
+		if (!pg->io_channel) {
 			free_task_pool(bvsession);
 			SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
 			return -1;
@@ -1342,33 +1507,79 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	}
 
 	if (bvdev->bdev) {
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(vdev_worker, bvsession, 0);
+		pg->requestq_poller = SPDK_POLLER_REGISTER(vdev_worker, pg, 0);
 	} else {
-		bvsession->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, bvsession, 0);
+		pg->requestq_poller = SPDK_POLLER_REGISTER(no_bdev_vdev_worker, pg, 0);
 	}
 	SPDK_INFOLOG(vhost, "%s: started poller on lcore %d\n",
 		     vsession->name, spdk_env_get_current_core());
 
-	spdk_poller_register_interrupt(bvsession->requestq_poller, vhost_blk_poller_set_interrupt_mode,
-				       bvsession);
+	spdk_poller_register_interrupt(pg->requestq_poller, vhost_blk_poller_set_interrupt_mode,
+				       pg);
+
+	bvsession->active_poll_groups = num_poll_groups - 1;
+	for (i = 1; i < num_poll_groups; i++) {
+		pg = &bvsession->poll_groups[i];
+		spdk_thread_send_msg(pg->thread, vhost_blk_poll_group_start, pg);
+	}
 
 	return 0;
 }
 
+static void
+vhost_blk_poll_group_stopped(void *arg)
+{
+	struct vhost_blk_poll_group *pg = arg;
+
+	assert(pg->bvsession->active_poll_groups > 0);
+	pg->bvsession->active_poll_groups--;
+}
+
+static int
+vhost_blk_poll_group_stop_poller_cb(void *arg)
+{
+	struct vhost_blk_poll_group *pg = arg;
+
+	if (*pg->task_cnt > 0) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	if (pg->io_channel) {
+		vhost_blk_put_io_channel(pg->io_channel);
+		pg->io_channel = NULL;
+	}
+
+	spdk_poller_unregister(&pg->stop_poller);
+	spdk_thread_send_msg(pg->bvsession->vsession.vdev->thread, vhost_blk_poll_group_stopped, pg);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+vhost_blk_poll_group_stop(void *arg)
+{
+	struct vhost_blk_poll_group *pg = arg;
+
+	spdk_poller_unregister(&pg->requestq_poller);
+	pg->stop_poller = SPDK_POLLER_REGISTER(vhost_blk_poll_group_stop_poller_cb, pg, 1000);
+}
+
 static int
 destroy_session_poller_cb(void *arg)
 {
 	struct spdk_vhost_blk_session *bvsession = arg;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	struct spdk_vhost_user_dev *user_dev = to_user_dev(vsession->vdev);
+	struct vhost_blk_poll_group *pg = &bvsession->poll_groups[0];
 	int i;
 
-	if (vsession->task_cnt > 0 || (pthread_mutex_trylock(&user_dev->lock) != 0)) {
+	if (vsession->task_cnt > 0 || bvsession->active_poll_groups > 0 ||
+	    (pthread_mutex_trylock(&user_dev->lock) != 0)) {
 		assert(vsession->stop_retry_count > 0);
 		vsession->stop_retry_count--;
 		if (vsession->stop_retry_count == 0) {
-			SPDK_ERRLOG("%s: Timedout when destroy session (task_cnt %d)\n", vsession->name,
-				    vsession->task_cnt);
+			SPDK_ERRLOG("%s: Timedout when destroy session (task_cnt %d, active poll groups %"PRIu16")\n",
+				    vsession->name, vsession->task_cnt, bvsession->active_poll_groups);
 			spdk_poller_unregister(&bvsession->stop_poller);
 			vhost_user_session_stop_done(vsession, -ETIMEDOUT);
 		}
@@ -1384,9 +1595,9 @@ destroy_session_poller_cb(void *arg)
 	SPDK_INFOLOG(vhost, "%s: stopping poller on lcore %d\n",
 		     vsession->name, spdk_env_get_current_core());
 
-	if (bvsession->io_channel) {
-		vhost_blk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (pg->io_channel) {
+		vhost_blk_put_io_channel(pg->io_channel);
+		pg->io_channel = NULL;
 	}
 
 	free_task_pool(bvsession);
@@ -1402,18 +1613,24 @@ vhost_blk_stop(struct spdk_vhost_dev *vdev,
 	       struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	uint16_t i;
 
 	/* return if stop is already in progress */
 	if (bvsession->stop_poller) {
 		return -EINPROGRESS;
 	}
 
-	spdk_poller_unregister(&bvsession->requestq_poller);
+	spdk_poller_unregister(&bvsession->poll_groups[0].requestq_poller);
 
 	if (vsession->virtqueue[0].intr) {
 		vhost_blk_session_unregister_interrupts(bvsession);
 	}
 
+	for (i = 1; i < bvsession->num_poll_groups; i++) {
+		spdk_thread_send_msg(bvsession->poll_groups[i].thread, vhost_blk_poll_group_stop,
+				     &bvsession->poll_groups[i]);
+	}
+
 	/* vhost_user_session_send_event timeout is 3 seconds, here set retry within 4 seconds */
 	bvsession->vsession.stop_retry_count = 4000;
 	bvsession->stop_poller = SPDK_POLLER_REGISTER(destroy_session_poller_cb,
@@ -1440,6 +1657,7 @@ vhost_blk_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_null(w);
 	}
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	spdk_json_write_named_uint32(w, "num_vq_threads", bvdev->num_vq_threads);
 
 	spdk_json_write_object_end(w);
 }
@@ -1466,6 +1684,9 @@ vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	if (bvdev->num_vq_threads > 1) {
+		spdk_json_write_named_uint32(w, "num_vq_threads", bvdev->num_vq_threads);
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1553,6 +1774,30 @@ vhost_blk_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 	bvdev->ops->get_coalescing(vdev, delay_base_us, iops_threshold);
 }
 
+static int
+vhost_blk_set_coalescing_latency_target(struct spdk_vhost_dev *vdev, uint32_t latency_target_us)
+{
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+
+	if (bvdev->ops->set_coalescing_latency_target == NULL) {
+		return -ENOTSUP;
+	}
+
+	return bvdev->ops->set_coalescing_latency_target(vdev, latency_target_us);
+}
+
+static uint32_t
+vhost_blk_get_coalescing_latency_target(struct spdk_vhost_dev *vdev)
+{
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+
+	if (bvdev->ops->get_coalescing_latency_target == NULL) {
+		return 0;
+	}
+
+	return bvdev->ops->get_coalescing_latency_target(vdev);
+}
+
 static const struct spdk_vhost_user_dev_backend vhost_blk_user_device_backend = {
 	.session_ctx_size = sizeof(struct spdk_vhost_blk_session) - sizeof(struct spdk_vhost_session),
 	.start_session =  vhost_blk_start,
@@ -1568,6 +1813,8 @@ static const struct spdk_vhost_dev_backend vhost_blk_device_backend = {
 	.remove_device = vhost_blk_destroy,
 	.set_coalescing = vhost_blk_set_coalescing,
 	.get_coalescing = vhost_blk_get_coalescing,
+	.set_coalescing_latency_target = vhost_blk_set_coalescing_latency_target,
+	.get_coalescing_latency_target = vhost_blk_get_coalescing_latency_target,
 };
 
 int
@@ -1645,6 +1892,7 @@ spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_
 
 	bvdev->bdev = bdev;
 	bvdev->readonly = false;
+	bvdev->num_vq_threads = 1;
 	ret = vhost_dev_register(vdev, name, cpumask, params, &vhost_blk_device_backend,
 				 &vhost_blk_user_device_backend);
 	if (ret != 0) {
@@ -1744,20 +1992,72 @@ struct rpc_vhost_blk {
 	bool readonly;
 	bool packed_ring;
 	bool packed_ring_recovery;
+	uint32_t num_vq_threads;
 };
 
 static const struct spdk_json_object_decoder rpc_construct_vhost_blk[] = {
 	{"readonly", offsetof(struct rpc_vhost_blk, readonly), spdk_json_decode_bool, true},
 	{"packed_ring", offsetof(struct rpc_vhost_blk, packed_ring), spdk_json_decode_bool, true},
 	{"packed_ring_recovery", offsetof(struct rpc_vhost_blk, packed_ring_recovery), spdk_json_decode_bool, true},
+	{"num_vq_threads", offsetof(struct rpc_vhost_blk, num_vq_threads), spdk_json_decode_uint32, true},
 };
 
+static void
+vhost_blk_vq_thread_exit(void *arg1)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+vhost_user_blk_destroy_vq_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	uint16_t i;
+
+	for (i = 1; i < bvdev->num_vq_threads; i++) {
+		if (bvdev->vq_threads[i] != NULL) {
+			spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_thread_exit, NULL);
+			bvdev->vq_threads[i] = NULL;
+		}
+	}
+}
+
+static int
+vhost_user_blk_create_vq_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	struct spdk_vhost_dev *vdev = &bvdev->vdev;
+	char *name;
+	uint16_t i;
+
+	bvdev->vq_threads[0] = vdev->thread;
+	for (i = 1; i < bvdev->num_vq_threads; i++) {
+		name = spdk_sprintf_alloc("%s.vq%"PRIu16, vdev->name, i);
+		if (name == NULL) {
+			goto err;
+		}
+
+		bvdev->vq_threads[i] = spdk_thread_create(name, spdk_thread_get_cpumask(vdev->thread));
+		free(name);
+		if (bvdev->vq_threads[i] == NULL) {
+			goto err;
+		}
+	}
+
+	return 0;
+
+err:
+	SPDK_ERRLOG("Failed to create virtqueue thread %"PRIu16" for vhost controller %s.\n",
+		    i, vdev->name);
+	vhost_user_blk_destroy_vq_threads(bvdev);
+	return -EIO;
+}
+
 static int
 vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpumask,
 			    const char *address, const struct spdk_json_val *params, void *custom_opts)
 {
 	struct rpc_vhost_blk req = {0};
 	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
 
 	if (spdk_json_decode_object_relaxed(params, rpc_construct_vhost_blk,
 					    SPDK_COUNTOF(rpc_construct_vhost_blk),
@@ -1766,6 +2066,13 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		return -EINVAL;
 	}
 
+	if (req.num_vq_threads > SPDK_VHOST_BLK_MAX_VQ_THREADS) {
+		SPDK_ERRLOG("%s: num_vq_threads %"PRIu32" exceeds the maximum of %d\n",
+			    vdev->name, req.num_vq_threads, SPDK_VHOST_BLK_MAX_VQ_THREADS);
+		return -EINVAL;
+	}
+	bvdev->num_vq_threads = spdk_max(req.num_vq_threads, 1);
+
 	vdev->packed_ring_recovery = false;
 
 	if (req.packed_ring) {
@@ -1777,13 +2084,32 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		bvdev->readonly = req.readonly;
 	}
 
-	return vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	rc = vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = vhost_user_blk_create_vq_threads(bvdev);
+	if (rc != 0) {
+		vhost_user_dev_unregister(vdev);
+		return rc;
+	}
+
+	return 0;
 }
 
 static int
 vhost_user_blk_destroy_ctrlr(struct spdk_vhost_dev *vdev)
 {
-	return vhost_user_dev_unregister(vdev);
+	int rc;
+
+	rc = vhost_user_dev_unregister(vdev);
+	if (rc != 0) {
+		return rc;
+	}
+
+	vhost_user_blk_destroy_vq_threads(to_blk_dev(vdev));
+	return 0;
 }
 
 static void
@@ -1808,6 +2134,8 @@ static const struct spdk_virtio_blk_transport_ops vhost_user_blk = {
 	.bdev_event = vhost_user_bdev_event_cb,
 	.set_coalescing = vhost_user_set_coalescing,
 	.get_coalescing = vhost_user_get_coalescing,
+	.set_coalescing_latency_target = vhost_user_set_coalescing_latency_target,
+	.get_coalescing_latency_target = vhost_user_get_coalescing_latency_target,
 };
 
 SPDK_VIRTIO_BLK_TRANSPORT_REGISTER(vhost_user_blk, &vhost_user_blk);
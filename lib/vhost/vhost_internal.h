@@ -13,6 +13,7 @@
 
 #include "spdk_internal/vhost_user.h"
 #include "spdk/bdev.h"
+#include "spdk/env.h"
 #include "spdk/log.h"
 #include "spdk/util.h"
 #include "spdk/rpc.h"
@@ -95,6 +96,24 @@ struct spdk_vhost_virtqueue {
 	/* Next time when we need to send event */
 	uint64_t next_event_time;
 
+	/* Next time when stats for event coalescing will be checked */
+	uint64_t next_stats_check_time;
+
+	/* Adaptive interrupt coalescing, used when a latency target is set */
+	struct {
+		/* Latency of the requests completed since the last check */
+		uint64_t lat_sum;
+		uint32_t lat_cnt;
+		uint64_t last_check_time;
+
+		/* Results of the last check and decisions taken, exported as stats */
+		uint64_t avg_lat;
+		uint64_t iops;
+		uint64_t irq_cnt;
+		uint64_t delay_increases;
+		uint64_t delay_decreases;
+	} coalescing;
+
 	/* Associated vhost_virtqueue in the virtio device's virtqueue list */
 	uint32_t vring_idx;
 
@@ -128,9 +147,8 @@ struct spdk_vhost_session {
 	/* Local copy of device coalescing settings. */
 	uint32_t coalescing_delay_time_base;
 	uint32_t coalescing_io_rate_threshold;
-
-	/* Next time when stats for event coalescing will be checked. */
-	uint64_t next_stats_check_time;
+	/* Request latency targeted by adaptive coalescing in ticks, 0 if disabled. */
+	uint64_t coalescing_latency_target;
 
 	/* Interval used for event coalescing checking. */
 	uint64_t stats_check_interval;
@@ -153,6 +171,7 @@ struct spdk_vhost_user_dev {
 	 */
 	uint32_t coalescing_delay_us;
 	uint32_t coalescing_iops_threshold;
+	uint32_t coalescing_latency_target_us;
 
 	bool registered;
 
@@ -245,6 +264,8 @@ struct spdk_vhost_dev_backend {
 			      uint32_t iops_threshold);
 	void (*get_coalescing)(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 			       uint32_t *iops_threshold);
+	int (*set_coalescing_latency_target)(struct spdk_vhost_dev *vdev, uint32_t latency_target_us);
+	uint32_t (*get_coalescing_latency_target)(struct spdk_vhost_dev *vdev);
 };
 
 void *vhost_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t addr, uint64_t len);
@@ -315,6 +336,19 @@ int vhost_vq_used_signal(struct spdk_vhost_session *vsession, struct spdk_vhost_
  */
 void vhost_session_vq_used_signal(struct spdk_vhost_virtqueue *virtqueue);
 
+/**
+ * Account the latency of a request completed on the given virtqueue for
+ * adaptive interrupt coalescing.
+ * \param vq virtqueue
+ * \param submit_tsc tick count at which the request was fetched from the queue
+ */
+static inline void
+vhost_vq_coalescing_record_latency(struct spdk_vhost_virtqueue *vq, uint64_t submit_tsc)
+{
+	vq->coalescing.lat_sum += spdk_get_ticks() - submit_tsc;
+	vq->coalescing.lat_cnt++;
+}
+
 void vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 				struct spdk_vhost_virtqueue *vq,
 				uint16_t id, uint32_t len);
@@ -480,6 +514,9 @@ int vhost_user_set_coalescing(struct spdk_vhost_dev *vdev, uint32_t delay_base_u
 			      uint32_t iops_threshold);
 void vhost_user_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 			       uint32_t *iops_threshold);
+int vhost_user_set_coalescing_latency_target(struct spdk_vhost_dev *vdev,
+		uint32_t latency_target_us);
+uint32_t vhost_user_get_coalescing_latency_target(struct spdk_vhost_dev *vdev);
 
 int virtio_blk_construct_ctrlr(struct spdk_vhost_dev *vdev, const char *address,
 			       struct spdk_cpuset *cpumask, const struct spdk_json_val *params,
@@ -570,6 +607,16 @@ struct spdk_virtio_blk_transport_ops {
 	 */
 	void (*get_coalescing)(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 			       uint32_t *iops_threshold);
+
+	/**
+	 * Set the request latency targeted by adaptive coalescing.
+	 */
+	int (*set_coalescing_latency_target)(struct spdk_vhost_dev *vdev, uint32_t latency_target_us);
+
+	/**
+	 * Get the request latency targeted by adaptive coalescing.
+	 */
+	uint32_t (*get_coalescing_latency_target)(struct spdk_vhost_dev *vdev);
 };
 
 struct spdk_virtio_blk_transport {
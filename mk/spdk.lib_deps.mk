@@ -78,7 +78,7 @@ DEPDIRS-mlx5 = log rdma util
 endif
 DEPDIRS-scsi := log util thread $(JSON_LIBS) trace bdev
 
-DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi
+DEPDIRS-iscsi := accel log sock util conf thread $(JSON_LIBS) trace scsi
 DEPDIRS-vhost = log util thread $(JSON_LIBS) bdev scsi
 
 # ------------------------------------------------------------------------
@@ -37,7 +37,9 @@ endif
 
 ifeq ($(CONFIG_VBDEV_COMPRESS),y)
 BLOCKDEV_MODULES_LIST += bdev_compress reduce
+ifeq ($(CONFIG_HAVE_LIBPMEM),y)
 BLOCKDEV_MODULES_PRIVATE_LIBS += -lpmem
+endif
 ifeq ($(CONFIG_VBDEV_COMPRESS_MLX5),y)
 BLOCKDEV_MODULES_PRIVATE_LIBS += -lmlx5 -libverbs
 endif
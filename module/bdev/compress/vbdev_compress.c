@@ -756,7 +756,7 @@ _prepare_for_load_init(struct spdk_bdev_desc *bdev_desc, uint32_t lb_size)
 
 /* Call reducelib to initialize a new volume */
 static int
-vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size)
+vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size, bool packed)
 {
 	struct spdk_bdev_desc *bdev_desc = NULL;
 	struct vbdev_compress *meta_ctx;
@@ -775,6 +775,10 @@ vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size)
 		return -EINVAL;
 	}
 
+	if (packed) {
+		meta_ctx->params.chunk_layout = SPDK_REDUCE_CHUNK_LAYOUT_PACKED;
+	}
+
 	/* Save the thread where the base device is opened */
 	meta_ctx->thread = spdk_get_thread();
 
@@ -861,7 +865,8 @@ comp_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 
 /* RPC entry point for compression vbdev creation. */
 int
-create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size)
+create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size,
+		     bool packed)
 {
 	struct vbdev_compress *comp_bdev = NULL;
 
@@ -876,7 +881,7 @@ create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_siz
 			return -EBUSY;
 		}
 	}
-	return vbdev_init_reduce(bdev_name, pm_path, lb_size);
+	return vbdev_init_reduce(bdev_name, pm_path, lb_size, packed);
 }
 
 static int
@@ -53,9 +53,12 @@ typedef void (*spdk_delete_compress_complete)(void *cb_arg, int bdeverrno);
  * \param bdev_name Bdev on which compression bdev will be created.
  * \param pm_path Path to persistent memory.
  * \param lb_size Logical block size for the compressed volume in bytes. Must be 4K or 512.
+ * \param packed Store compressed chunks at backing device block granularity instead of
+ *  whole backing io units.
  * \return 0 on success, other on failure.
  */
-int create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size);
+int create_compress_bdev(const char *bdev_name, const char *pm_path, uint32_t lb_size,
+			 bool packed);
 
 /**
  * Delete compress bdev.
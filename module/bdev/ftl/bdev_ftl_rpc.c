@@ -287,6 +287,13 @@ _rpc_bdev_ftl_get_stats(void *cntx)
 		spdk_json_write_object_end(w);
 	}
 
+	spdk_json_write_named_object_begin(w, "l2p_cache");
+	spdk_json_write_named_uint64(w, "hits", stats->l2p_cache.hits);
+	spdk_json_write_named_uint64(w, "misses", stats->l2p_cache.misses);
+	spdk_json_write_named_uint64(w, "prefetches", stats->l2p_cache.prefetches);
+	spdk_json_write_named_uint64(w, "prefetch_hits", stats->l2p_cache.prefetch_hits);
+	spdk_json_write_object_end(w);
+
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 
@@ -88,3 +88,37 @@ def accel_set_driver(client, name):
         name: name of the driver
     """
     return client.call('accel_set_driver', {'name': name})
+
+
+def accel_sw_set_options(client, num_workers=None, offload_min_size=None, cpumask=None):
+    """Set options of the software accel module.
+
+    Args:
+        num_workers: number of threads executing CPU heavy operations (0 executes them in place)
+        offload_min_size: smallest operation (in bytes) handed over to the worker threads
+        cpumask: cores the worker threads can be scheduled on
+    """
+    params = {}
+
+    if num_workers is not None:
+        params['num_workers'] = num_workers
+    if offload_min_size is not None:
+        params['offload_min_size'] = offload_min_size
+    if cpumask is not None:
+        params['cpumask'] = cpumask
+
+    return client.call('accel_sw_set_options', params)
+
+
+def accel_enable_histogram(client, enable):
+    """Enable or disable latency histograms of accel operations.
+
+    Args:
+        enable: True to enable, False to disable
+    """
+    return client.call('accel_enable_histogram', {'enable': enable})
+
+
+def accel_get_stats(client):
+    """Get statistics of accel operations."""
+    return client.call('accel_get_stats')
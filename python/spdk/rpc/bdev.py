@@ -49,22 +49,29 @@ def bdev_wait_for_examine(client):
     return client.call('bdev_wait_for_examine')
 
 
-def bdev_compress_create(client, base_bdev_name, pm_path, lb_size):
+def bdev_compress_create(client, base_bdev_name, pm_path=None, lb_size=None, packed=None):
     """Construct a compress virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
-        pm_path: path to persistent memory
+        pm_path: path to persistent memory (optional, metadata is kept on the base bdev if not set)
         lb_size: logical block size for the compressed vol in bytes.  Must be 4K or 512.
+        packed: store compressed chunks at base bdev block granularity (optional)
 
     Returns:
         Name of created virtual block device.
     """
-    params = {'base_bdev_name': base_bdev_name, 'pm_path': pm_path}
+    params = {'base_bdev_name': base_bdev_name}
+
+    if pm_path:
+        params['pm_path'] = pm_path
 
     if lb_size:
         params['lb_size'] = lb_size
 
+    if packed:
+        params['packed'] = packed
+
     return client.call('bdev_compress_create', params)
 
 
@@ -1613,6 +1620,16 @@ def bdev_get_histogram(client, name):
     return client.call('bdev_get_histogram', params)
 
 
+def bdev_get_histogram_percentiles(client, name):
+    """Get latency percentiles per I/O type and size class for specified bdev.
+
+    Args:
+        name: name of bdev
+    """
+    params = {'name': name}
+    return client.call('bdev_get_histogram_percentiles', params)
+
+
 def bdev_error_inject_error(client, name, io_type, error_type, num,
                             corrupt_offset, corrupt_value):
     """Inject an error via an error bdev.
@@ -1684,6 +1701,25 @@ def bdev_set_qos_limit(
     return client.call('bdev_set_qos_limit', params)
 
 
+def bdev_set_merge_limits(client, name, max_bytes=None, max_ios=None, window_us=None):
+    """Set I/O merge limits on a block device.
+
+    Args:
+        name: name of block device
+        max_bytes: maximum size of a merged I/O in bytes (default: 131072). 0 disables merging.
+        max_ios: maximum number of I/Os combined into one merged I/O (default: 32)
+        window_us: maximum time in microseconds an I/O waits to be merged (default: 10)
+    """
+    params = {'name': name}
+    if max_bytes is not None:
+        params['max_bytes'] = max_bytes
+    if max_ios is not None:
+        params['max_ios'] = max_ios
+    if window_us is not None:
+        params['window_us'] = window_us
+    return client.call('bdev_set_merge_limits', params)
+
+
 def bdev_nvme_apply_firmware(client, bdev_name, filename):
     """Download and commit firmware to NVMe device.
 
@@ -5,18 +5,21 @@
 from .cmd_parser import *
 
 
-def vhost_controller_set_coalescing(client, ctrlr, delay_base_us, iops_threshold):
+def vhost_controller_set_coalescing(client, ctrlr, delay_base_us, iops_threshold, latency_target_us=None):
     """Set coalescing for vhost controller.
     Args:
         ctrlr: controller name
         delay_base_us: base delay time
         iops_threshold: IOPS threshold when coalescing is enabled
+        latency_target_us: request latency targeted by adaptive coalescing (optional)
     """
     params = {
         'ctrlr': ctrlr,
         'delay_base_us': delay_base_us,
         'iops_threshold': iops_threshold,
     }
+    if latency_target_us is not None:
+        params['latency_target_us'] = latency_target_us
     return client.call('vhost_controller_set_coalescing', params)
 
 
@@ -100,6 +103,7 @@ def vhost_create_blk_controller(client, **params):
         readonly: set controller as read-only
         packed_ring: support controller packed_ring
         packed_ring_recovery: enable packed ring live recovery
+        num_vq_threads: number of threads to spread the virtqueues of each session across
     """
     strip_globals(params)
     remove_null(params)
@@ -239,12 +239,14 @@ if __name__ == "__main__":
         print_json(rpc.bdev.bdev_compress_create(args.client,
                                                  base_bdev_name=args.base_bdev_name,
                                                  pm_path=args.pm_path,
-                                                 lb_size=args.lb_size))
+                                                 lb_size=args.lb_size,
+                                                 packed=args.packed))
 
     p = subparsers.add_parser('bdev_compress_create', help='Add a compress vbdev')
     p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev")
-    p.add_argument('-p', '--pm-path', help="Path to persistent memory")
+    p.add_argument('-p', '--pm-path', help="Path to persistent memory (optional, metadata is kept on the base bdev if not set)")
     p.add_argument('-l', '--lb-size', help="Compressed vol logical block size (optional, if used must be 512 or 4096)", type=int)
+    p.add_argument('--packed', help="Store compressed chunks at base bdev block granularity", action='store_true')
     p.set_defaults(func=bdev_compress_create)
 
     def bdev_compress_delete(args):
@@ -1204,6 +1206,14 @@ if __name__ == "__main__":
     p.add_argument('name', help='bdev name')
     p.set_defaults(func=bdev_get_histogram)
 
+    def bdev_get_histogram_percentiles(args):
+        print_dict(rpc.bdev.bdev_get_histogram_percentiles(args.client, name=args.name))
+
+    p = subparsers.add_parser('bdev_get_histogram_percentiles',
+                              help='Get latency percentiles per I/O type and size for specified bdev')
+    p.add_argument('name', help='bdev name')
+    p.set_defaults(func=bdev_get_histogram_percentiles)
+
     def bdev_set_qd_sampling_period(args):
         rpc.bdev.bdev_set_qd_sampling_period(args.client,
                                              name=args.name,
@@ -1242,6 +1252,27 @@ if __name__ == "__main__":
                    type=int, required=False)
     p.set_defaults(func=bdev_set_qos_limit)
 
+    def bdev_set_merge_limits(args):
+        rpc.bdev.bdev_set_merge_limits(args.client,
+                                       name=args.name,
+                                       max_bytes=args.max_bytes,
+                                       max_ios=args.max_ios,
+                                       window_us=args.window_us)
+
+    p = subparsers.add_parser('bdev_set_merge_limits',
+                              help='Set I/O merge limits on a blockdev')
+    p.add_argument('name', help='Blockdev name to set merge limits. Example: Malloc0')
+    p.add_argument('-b', '--max-bytes',
+                   help='Maximum size of a merged I/O in bytes (default: 131072). 0 disables merging.',
+                   type=int, required=False)
+    p.add_argument('-n', '--max-ios',
+                   help='Maximum number of I/Os combined into one merged I/O (default: 32)',
+                   type=int, required=False)
+    p.add_argument('-w', '--window-us',
+                   help='Maximum time in microseconds an I/O waits to be merged (default: 10)',
+                   type=int, required=False)
+    p.set_defaults(func=bdev_set_merge_limits)
+
     def bdev_error_inject_error(args):
         rpc.bdev.bdev_error_inject_error(args.client,
                                          name=args.name,
@@ -2278,12 +2309,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def nbd_start_disk(args):
         print(rpc.nbd.nbd_start_disk(args.client,
                                      bdev_name=args.bdev_name,
-                                     nbd_device=args.nbd_device))
+                                     nbd_device=args.nbd_device,
+                                     num_connections=args.num_connections))
 
     p = subparsers.add_parser('nbd_start_disk',
                               help='Export a bdev as an nbd disk')
     p.add_argument('bdev_name', help='Blockdev name to be exported. Example: Malloc0.')
     p.add_argument('nbd_device', help='Nbd device name to be assigned. Example: /dev/nbd0.', nargs='?')
+    p.add_argument('-c', '--num-connections', help='Number of connections to the kernel, each served as a separate hardware queue (1-16). Default: 1.',
+                   type=int)
     p.set_defaults(func=nbd_start_disk)
 
     def nbd_stop_disk(args):
@@ -2620,12 +2654,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         rpc.vhost.vhost_controller_set_coalescing(args.client,
                                                   ctrlr=args.ctrlr,
                                                   delay_base_us=args.delay_base_us,
-                                                  iops_threshold=args.iops_threshold)
+                                                  iops_threshold=args.iops_threshold,
+                                                  latency_target_us=args.latency_target_us)
 
     p = subparsers.add_parser('vhost_controller_set_coalescing', help='Set vhost controller coalescing')
     p.add_argument('ctrlr', help='controller name')
     p.add_argument('delay_base_us', help='Base delay time', type=int)
     p.add_argument('iops_threshold', help='IOPS threshold when coalescing is enabled', type=int)
+    p.add_argument('-l', '--latency-target-us', help="""Request latency targeted by adaptive coalescing in microseconds.
+    0 disables adaptive coalescing. Only supported by vhost-blk controllers.""", type=int)
     p.set_defaults(func=vhost_controller_set_coalescing)
 
     def virtio_blk_create_transport(args):
@@ -2687,6 +2724,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument("-r", "--readonly", action='store_true', help='Set controller as read-only')
     p.add_argument("-p", "--packed_ring", action='store_true', help='Set controller as packed ring supported')
     p.add_argument("-l", "--packed_ring_recovery", action='store_true', help='Enable packed ring live recovery')
+    p.add_argument("-t", "--num-vq-threads", dest='num_vq_threads', type=int,
+                   help='Number of threads to spread the virtqueues of each session across (default: 1)')
     p.set_defaults(func=vhost_create_blk_controller)
 
     def vhost_get_controllers(args):
@@ -2884,6 +2923,34 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='name of the platform driver')
     p.set_defaults(func=accel_set_driver)
 
+    def accel_sw_set_options(args):
+        rpc.accel.accel_sw_set_options(args.client, num_workers=args.num_workers,
+                                       offload_min_size=args.offload_min_size,
+                                       cpumask=args.cpumask)
+
+    p = subparsers.add_parser('accel_sw_set_options', help='Set options of the software accel module')
+    p.add_argument('-n', '--num-workers', help='Number of worker threads executing CPU heavy ' +
+                   'operations (0 executes them in place)', type=int)
+    p.add_argument('-s', '--offload-min-size', help='Smallest operation (in bytes) handed over ' +
+                   'to the worker threads', type=int)
+    p.add_argument('-m', '--cpumask', help='Cores the worker threads can be scheduled on')
+    p.set_defaults(func=accel_sw_set_options)
+
+    def accel_enable_histogram(args):
+        rpc.accel.accel_enable_histogram(args.client, enable=args.enable)
+
+    p = subparsers.add_parser('accel_enable_histogram',
+                              help='Enable or disable latency histograms of accel operations')
+    p.add_argument('-e', '--enable', default=True, dest='enable', action='store_true', help='Enable histograms')
+    p.add_argument('-d', '--disable', dest='enable', action='store_false', help='Disable histograms')
+    p.set_defaults(func=accel_enable_histogram)
+
+    def accel_get_stats(args):
+        print_dict(rpc.accel.accel_get_stats(args.client))
+
+    p = subparsers.add_parser('accel_get_stats', help='Display statistics of accel operations')
+    p.set_defaults(func=accel_get_stats)
+
     # ioat
     def ioat_scan_accel_module(args):
         rpc.ioat.ioat_scan_accel_module(args.client)
@@ -536,6 +536,187 @@ test_spdk_accel_submit_xor(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+#define TEST_DIF_BLOCK_SIZE	520
+#define TEST_DIF_DATA_SIZE	512
+#define TEST_DIF_NUM_BLOCKS	4
+
+static void
+test_spdk_accel_submit_dif(void)
+{
+	uint8_t data[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t ext[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t out[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	struct iovec data_iov = { .iov_base = data, .iov_len = sizeof(data) };
+	struct iovec ext_iov = { .iov_base = ext, .iov_len = sizeof(ext) };
+	struct iovec out_iov = { .iov_base = out, .iov_len = sizeof(out) };
+	struct spdk_dif_ctx dif_ctx;
+	struct spdk_dif_error err_blk;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	uint32_t dif_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+			     SPDK_DIF_FLAGS_REFTAG_CHECK;
+	int rc;
+
+	memset(data, 0x5a, sizeof(data));
+	memset(out, 0, sizeof(out));
+	rc = spdk_dif_ctx_init(&dif_ctx, TEST_DIF_BLOCK_SIZE, TEST_DIF_BLOCK_SIZE - TEST_DIF_DATA_SIZE,
+			       true, false, SPDK_DIF_TYPE1, dif_flags, 10, 0xFFFF, 0x22, 0, 0);
+	CU_ASSERT(rc == 0);
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dif_generate_copy(g_ch, &ext_iov, 1, &data_iov, 1,
+			TEST_DIF_NUM_BLOCKS, &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	/* Invalid arguments */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dif_verify(g_ch, &ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx, NULL,
+					  NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Generate the protection information while copying the payload out. */
+	rc = spdk_accel_submit_dif_generate_copy(g_ch, &ext_iov, 1, &data_iov, 1,
+			TEST_DIF_NUM_BLOCKS, &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_GENERATE_COPY);
+	CU_ASSERT(task.s.iovs == &data_iov);
+	CU_ASSERT(task.d.iovs == &ext_iov);
+	CU_ASSERT(task.dif.ctx == &dif_ctx);
+	CU_ASSERT(task.dif.num_blocks == TEST_DIF_NUM_BLOCKS);
+	CU_ASSERT(task.status == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(spdk_dif_verify(&ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx, &err_blk) == 0);
+
+	/* Verify it in place */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dif_verify(g_ch, &ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx,
+					  &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_VERIFY);
+	CU_ASSERT(task.dif.err == &err_blk);
+	CU_ASSERT(task.status == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	/* Strip it while copying the payload back */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dif_verify_copy(g_ch, &out_iov, 1, &ext_iov, 1,
+					       TEST_DIF_NUM_BLOCKS, &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_VERIFY_COPY);
+	CU_ASSERT(task.status == 0);
+	CU_ASSERT(memcmp(data, out, sizeof(data)) == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	/* Corrupt the guard of the last block and check that verification catches it */
+	ext[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS - 8] ^= 0xff;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dif_verify(g_ch, &ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx,
+					  &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.status != 0);
+	CU_ASSERT(err_blk.err_type == SPDK_DIF_GUARD_ERROR);
+	CU_ASSERT(err_blk.err_offset == TEST_DIF_NUM_BLOCKS - 1);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	/* In place generation */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dif_generate(g_ch, &ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx,
+					    NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_GENERATE);
+	CU_ASSERT(task.status == 0);
+	CU_ASSERT(spdk_dif_verify(&ext_iov, 1, TEST_DIF_NUM_BLOCKS, &dif_ctx, &err_blk) == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+}
+
+static void
+test_spdk_accel_submit_dix(void)
+{
+	uint8_t data[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	uint8_t md[(TEST_DIF_BLOCK_SIZE - TEST_DIF_DATA_SIZE) * TEST_DIF_NUM_BLOCKS];
+	struct iovec data_iov = { .iov_base = data, .iov_len = sizeof(data) };
+	struct iovec md_iov = { .iov_base = md, .iov_len = sizeof(md) };
+	struct spdk_dif_ctx dif_ctx;
+	struct spdk_dif_error err_blk;
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	uint32_t dif_flags = SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_APPTAG_CHECK |
+			     SPDK_DIF_FLAGS_REFTAG_CHECK;
+	int rc;
+
+	memset(data, 0x5a, sizeof(data));
+	memset(md, 0, sizeof(md));
+	rc = spdk_dif_ctx_init(&dif_ctx, TEST_DIF_DATA_SIZE, TEST_DIF_BLOCK_SIZE - TEST_DIF_DATA_SIZE,
+			       false, false, SPDK_DIF_TYPE1, dif_flags, 10, 0xFFFF, 0x22, 0, 0);
+	CU_ASSERT(rc == 0);
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dix_generate(g_ch, &data_iov, 1, &md_iov, TEST_DIF_NUM_BLOCKS,
+					    &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	/* Invalid arguments */
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dix_generate(g_ch, &data_iov, 1, NULL, TEST_DIF_NUM_BLOCKS,
+					    &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_accel_submit_dix_verify(g_ch, &data_iov, 1, &md_iov, TEST_DIF_NUM_BLOCKS,
+					  &dif_ctx, NULL, NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Generate the protection information into the separate metadata buffer */
+	rc = spdk_accel_submit_dix_generate(g_ch, &data_iov, 1, &md_iov, TEST_DIF_NUM_BLOCKS,
+					    &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIX_GENERATE);
+	CU_ASSERT(task.s.iovs == &data_iov);
+	CU_ASSERT(task.dif.md_iov == &md_iov);
+	CU_ASSERT(task.dif.ctx == &dif_ctx);
+	CU_ASSERT(task.dif.num_blocks == TEST_DIF_NUM_BLOCKS);
+	CU_ASSERT(task.status == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dix_verify(g_ch, &data_iov, 1, &md_iov, TEST_DIF_NUM_BLOCKS,
+					  &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIX_VERIFY);
+	CU_ASSERT(task.dif.err == &err_blk);
+	CU_ASSERT(task.status == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+
+	/* Corrupt the data of the second block and check that verification catches it */
+	data[TEST_DIF_DATA_SIZE + 1] ^= 0xff;
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+	rc = spdk_accel_submit_dix_verify(g_ch, &data_iov, 1, &md_iov, TEST_DIF_NUM_BLOCKS,
+					  &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.status != 0);
+	CU_ASSERT(err_blk.err_type == SPDK_DIF_GUARD_ERROR);
+	CU_ASSERT(err_blk.err_offset == 1);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+}
+
 static void
 test_spdk_accel_module_find_by_name(void)
 {
@@ -3738,6 +3919,533 @@ test_sequence_same_iovs(void)
 	poll_threads();
 }
 
+static int
+ut_submit_copy_crc32c(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	_sw_accel_copy_crc32cv(task->crc_dst, task->d.iovs, task->d.iovcnt,
+			       task->s.iovs, task->s.iovcnt, task->seed);
+	spdk_accel_task_complete(task, 0);
+
+	return 0;
+}
+
+static void
+test_sequence_crc32c(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct iovec src_iovs[2], dst_iovs[2];
+	char buf[4096], tmp[2][4096], expected[4096];
+	struct accel_module modules[ACCEL_OPC_LAST];
+	uint32_t crc, expected_crc;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].submit = ut_submit_copy_crc32c;
+
+	/* Check that a CRC-32C of the destination of a copy is calculated while copying */
+	for (i = 0; i < (int)sizeof(expected); ++i) {
+		expected[i] = (char)i;
+	}
+	expected_crc = spdk_crc32c_update(expected, sizeof(expected), ~0x1234u);
+	memcpy(tmp[0], expected, sizeof(expected));
+	memset(buf, 0, sizeof(buf));
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = tmp[0];
+	src_iovs[0].iov_len = sizeof(tmp[0]);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &dst_iovs[0], 1, NULL, NULL, 0x1234,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, expected_crc);
+
+	/* Check the same when the CRC-32C of the source is calculated before the copy */
+	memset(buf, 0, sizeof(buf));
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].count = 0;
+
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[0], 1, NULL, NULL, 0x1234,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, expected_crc);
+
+	/* Check that an appended copy + CRC-32C absorbs the following copy */
+	memset(buf, 0, sizeof(buf));
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].count = 0;
+
+	dst_iovs[1].iov_base = tmp[1];
+	dst_iovs[1].iov_len = sizeof(tmp[1]);
+	rc = spdk_accel_append_copy_crc32c(&seq, ioch, &crc, &dst_iovs[1], 1, NULL, NULL,
+					   &src_iovs[0], 1, NULL, NULL, 0x1234, 0,
+					   ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = tmp[1];
+	src_iovs[1].iov_len = sizeof(tmp[1]);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[1], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(buf)), 0);
+	CU_ASSERT_EQUAL(crc, expected_crc);
+
+	/* Check that a CRC-32C of a different buffer is not merged with the copy */
+	seq = NULL;
+	completed = 0;
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].count = 0;
+
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 0);
+
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+static void
+test_sequence_dif_copy_alignment(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct iovec data_iov, tmp_iov, ext_iovs[2];
+	char data[TEST_DIF_DATA_SIZE * TEST_DIF_NUM_BLOCKS];
+	char tmp[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	char ext[TEST_DIF_BLOCK_SIZE * TEST_DIF_NUM_BLOCKS];
+	struct accel_module modules[ACCEL_OPC_LAST];
+	struct spdk_dif_ctx dif_ctx;
+	struct spdk_dif_error err_blk;
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	rc = spdk_dif_ctx_init(&dif_ctx, TEST_DIF_BLOCK_SIZE, TEST_DIF_BLOCK_SIZE - TEST_DIF_DATA_SIZE,
+			       true, false, SPDK_DIF_TYPE1, SPDK_DIF_FLAGS_GUARD_CHECK, 0, 0, 0, 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+
+	data_iov.iov_base = data;
+	data_iov.iov_len = sizeof(data);
+	tmp_iov.iov_base = tmp;
+	tmp_iov.iov_len = sizeof(tmp);
+
+	/* A copy of the generated payload into block-aligned buffers is absorbed */
+	ext_iovs[0].iov_base = ext;
+	ext_iovs[0].iov_len = TEST_DIF_BLOCK_SIZE;
+	ext_iovs[1].iov_base = &ext[TEST_DIF_BLOCK_SIZE];
+	ext_iovs[1].iov_len = sizeof(ext) - TEST_DIF_BLOCK_SIZE;
+	seq = NULL;
+	completed = 0;
+
+	rc = spdk_accel_append_dif_generate_copy(&seq, ioch, &tmp_iov, 1, NULL, NULL,
+			&data_iov, 1, NULL, NULL, TEST_DIF_NUM_BLOCKS,
+			&dif_ctx, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_copy(&seq, ioch, ext_iovs, 2, NULL, NULL, &tmp_iov, 1, NULL, NULL,
+				    0, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_DIF_GENERATE_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	ut_clear_operations();
+
+	/* A block split across two elements must stay a separate copy */
+	ext_iovs[0].iov_len = TEST_DIF_BLOCK_SIZE / 2;
+	ext_iovs[1].iov_base = &ext[TEST_DIF_BLOCK_SIZE / 2];
+	ext_iovs[1].iov_len = sizeof(ext) - TEST_DIF_BLOCK_SIZE / 2;
+	seq = NULL;
+	completed = 0;
+
+	rc = spdk_accel_append_dif_generate_copy(&seq, ioch, &tmp_iov, 1, NULL, NULL,
+			&data_iov, 1, NULL, NULL, TEST_DIF_NUM_BLOCKS,
+			&dif_ctx, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_copy(&seq, ioch, ext_iovs, 2, NULL, NULL, &tmp_iov, 1, NULL, NULL,
+				    0, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_DIF_GENERATE_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 1);
+	ut_clear_operations();
+
+	/* The same applies to a copy feeding a verify + copy */
+	seq = NULL;
+	completed = 0;
+
+	rc = spdk_accel_append_copy(&seq, ioch, &tmp_iov, 1, NULL, NULL, ext_iovs, 2, NULL, NULL,
+				    0, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_dif_verify_copy(&seq, ioch, &data_iov, 1, NULL, NULL,
+					       &tmp_iov, 1, NULL, NULL, TEST_DIF_NUM_BLOCKS,
+					       &dif_ctx, &err_blk, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_DIF_VERIFY_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 1);
+	ut_clear_operations();
+
+	ext_iovs[0].iov_len = TEST_DIF_BLOCK_SIZE;
+	ext_iovs[1].iov_base = &ext[TEST_DIF_BLOCK_SIZE];
+	ext_iovs[1].iov_len = sizeof(ext) - TEST_DIF_BLOCK_SIZE;
+	seq = NULL;
+	completed = 0;
+
+	rc = spdk_accel_append_copy(&seq, ioch, &tmp_iov, 1, NULL, NULL, ext_iovs, 2, NULL, NULL,
+				    0, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_dif_verify_copy(&seq, ioch, &data_iov, 1, NULL, NULL,
+					       &tmp_iov, 1, NULL, NULL, TEST_DIF_NUM_BLOCKS,
+					       &dif_ctx, &err_blk, ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_DIF_VERIFY_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
+struct ut_accel_stats {
+	struct spdk_accel_opcode_stats	stats[ACCEL_OPC_LAST];
+	uint64_t			tallied[ACCEL_OPC_LAST];
+	bool				done;
+};
+
+static void
+ut_histogram_total_cb(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		      uint64_t total, uint64_t so_far)
+{
+	uint64_t *tallied = ctx;
+
+	*tallied = total;
+}
+
+static void
+ut_get_stats_cb(struct spdk_accel_opcode_stats *stats, void *cb_arg, int status)
+{
+	struct ut_accel_stats *ut_stats = cb_arg;
+	int i;
+
+	CU_ASSERT_EQUAL(status, 0);
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		ut_stats->stats[i] = stats[i];
+		/* The histograms are released once this callback returns */
+		ut_stats->stats[i].histogram = NULL;
+		ut_stats->tallied[i] = 0;
+		if (stats[i].histogram != NULL) {
+			spdk_histogram_data_iterate(stats[i].histogram, ut_histogram_total_cb,
+						    &ut_stats->tallied[i]);
+		}
+	}
+	ut_stats->done = true;
+}
+
+static void
+ut_histogram_status_cb(void *cb_arg, int status)
+{
+	int *rc = cb_arg;
+
+	*rc = status;
+}
+
+static void
+ut_accel_get_stats(struct ut_accel_stats *ut_stats)
+{
+	int rc;
+
+	ut_stats->done = false;
+	rc = spdk_accel_get_stats(ut_get_stats_cb, ut_stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT(ut_stats->done);
+}
+
+static void
+test_sequence_stats(void)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct spdk_io_channel *ioch;
+	struct ut_sequence ut_seq;
+	struct ut_accel_stats before, after;
+	struct iovec src_iovs, dst_iovs;
+	char buf[4096], tmp[4096], pattern[2048];
+	struct accel_module modules[ACCEL_OPC_LAST];
+	int i, rc, completed;
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Override the submit_tasks function */
+	g_module_if.submit_tasks = ut_sequnce_submit_tasks;
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		modules[i] = g_modules_opc[i];
+		g_modules_opc[i] = g_module;
+	}
+
+	/* Check that executed operations and failures are counted per opcode */
+	ut_accel_get_stats(&before);
+
+	seq = NULL;
+	completed = 0;
+	dst_iovs.iov_base = buf;
+	dst_iovs.iov_len = sizeof(buf);
+	src_iovs.iov_base = tmp;
+	src_iovs.iov_len = sizeof(tmp);
+	rc = spdk_accel_append_fill(&seq, ioch, pattern, sizeof(pattern), NULL, NULL, 0xa5, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs, 1, NULL, NULL,
+				    &src_iovs, 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+
+	seq = NULL;
+	completed = 0;
+	g_seq_operations[ACCEL_OPC_COPY].complete_status = -EIO;
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs, 1, NULL, NULL,
+				    &src_iovs, 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	poll_threads();
+
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, -EIO);
+	g_seq_operations[ACCEL_OPC_COPY].complete_status = 0;
+
+	ut_accel_get_stats(&after);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_FILL].executed - before.stats[ACCEL_OPC_FILL].executed, 1);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_FILL].failed - before.stats[ACCEL_OPC_FILL].failed, 0);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].executed - before.stats[ACCEL_OPC_COPY].executed, 2);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].failed - before.stats[ACCEL_OPC_COPY].failed, 1);
+	/* Bytes of successful operations are counted even though histograms are disabled */
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_FILL].num_bytes - before.stats[ACCEL_OPC_FILL].num_bytes,
+			sizeof(pattern));
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].num_bytes - before.stats[ACCEL_OPC_COPY].num_bytes,
+			sizeof(buf));
+	CU_ASSERT_EQUAL(after.tallied[ACCEL_OPC_COPY], 0);
+
+	/* Enable the histograms and check that successful operations are recorded */
+	rc = -1;
+	spdk_accel_enable_histogram(true, ut_histogram_status_cb, &rc);
+	poll_threads();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Make sure operations are timestamped (the timestamp is zero by default) */
+	MOCK_SET(spdk_get_ticks, 1000);
+	for (i = 0; i < 3; ++i) {
+		seq = NULL;
+		completed = 0;
+		rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs, 1, NULL, NULL,
+					    &src_iovs, 1, NULL, NULL, 0,
+					    ut_sequence_step_cb, &completed);
+		CU_ASSERT_EQUAL(rc, 0);
+
+		ut_seq.complete = false;
+		rc = spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+		CU_ASSERT_EQUAL(rc, 0);
+
+		poll_threads();
+
+		CU_ASSERT(ut_seq.complete);
+		CU_ASSERT_EQUAL(ut_seq.status, 0);
+	}
+	MOCK_CLEAR(spdk_get_ticks);
+
+	ut_accel_get_stats(&after);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].executed - before.stats[ACCEL_OPC_COPY].executed, 5);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].num_bytes - before.stats[ACCEL_OPC_COPY].num_bytes,
+			4 * sizeof(buf));
+	CU_ASSERT_EQUAL(after.tallied[ACCEL_OPC_COPY], 3);
+	CU_ASSERT_EQUAL(after.tallied[ACCEL_OPC_FILL], 0);
+
+	/* Check that the statistics outlive the channel they were collected on */
+	spdk_put_io_channel(ioch);
+	poll_threads();
+
+	ut_accel_get_stats(&after);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].executed - before.stats[ACCEL_OPC_COPY].executed, 5);
+	CU_ASSERT_EQUAL(after.stats[ACCEL_OPC_COPY].num_bytes - before.stats[ACCEL_OPC_COPY].num_bytes,
+			4 * sizeof(buf));
+	CU_ASSERT_EQUAL(after.tallied[ACCEL_OPC_COPY], 3);
+
+	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
+		g_modules_opc[i] = modules[i];
+	}
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	/* Enabling the histograms again while they're being enabled should fail */
+	rc = -1;
+	spdk_accel_enable_histogram(false, ut_histogram_status_cb, &rc);
+	i = -1;
+	spdk_accel_enable_histogram(true, ut_histogram_status_cb, &i);
+	CU_ASSERT_EQUAL(i, -EAGAIN);
+	poll_threads();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_accel_get_stats(&after);
+	CU_ASSERT_EQUAL(after.tallied[ACCEL_OPC_COPY], 0);
+
+	ut_clear_operations();
+	spdk_put_io_channel(ioch);
+	poll_threads();
+}
+
 static int
 test_sequence_setup(void)
 {
@@ -3793,6 +4501,161 @@ test_sequence_cleanup(void)
 	return 0;
 }
 
+static int
+test_sw_workers_setup(void)
+{
+	int rc;
+
+	allocate_cores(1);
+	allocate_threads(2);
+	set_thread(0);
+
+	rc = spdk_iobuf_initialize();
+	if (rc != 0) {
+		CU_ASSERT(false);
+		return -1;
+	}
+
+	rc = spdk_accel_initialize();
+	if (rc != 0) {
+		CU_ASSERT(false);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+ut_sw_worker_cb(void *cb_arg, int status)
+{
+	int *result = cb_arg;
+
+	*result = status;
+}
+
+static void
+test_sw_workers(void)
+{
+	struct spdk_io_channel *ioch;
+	struct accel_io_channel *accel_ch;
+	struct sw_accel_io_channel *sw_ch;
+	struct sw_accel_worker worker = {};
+	struct spdk_io_channel *worker_ch;
+	uint8_t dst[4096], src1[4096], src2[4096], expected[4096];
+	void *sources[] = { src1, src2 };
+	uint32_t offload_min_size = g_sw_opts.offload_min_size;
+	int i, rc, status;
+
+	for (i = 0; i < (int)sizeof(src1); ++i) {
+		src1[i] = (uint8_t)i;
+		src2[i] = (uint8_t)(i * 7);
+		expected[i] = src1[i] ^ src2[i];
+	}
+
+	/* The worker gets its own channel on the second thread */
+	set_thread(1);
+	worker.thread = spdk_get_thread();
+	worker_ch = spdk_get_io_channel(&g_sw_module);
+	SPDK_CU_ASSERT_FATAL(worker_ch != NULL);
+	worker.ch = worker_ch;
+	set_thread(0);
+
+	g_sw_workers = &worker;
+	g_sw_num_workers = 1;
+	g_sw_opts.offload_min_size = sizeof(dst);
+
+	ioch = spdk_accel_get_io_channel();
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+	accel_ch = spdk_io_channel_get_ctx(ioch);
+	sw_ch = spdk_io_channel_get_ctx(accel_ch->module_ch[ACCEL_OPC_XOR]);
+	CU_ASSERT_PTR_NOT_NULL(sw_ch->worker_completions);
+
+	/* Large enough operations are executed by the worker and completed on the submitter */
+	memset(dst, 0, sizeof(dst));
+	status = 1;
+	rc = spdk_accel_submit_xor(ioch, dst, sources, SPDK_COUNTOF(sources), sizeof(dst),
+				   ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 1);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 1);
+	poll_thread(1);
+	CU_ASSERT_EQUAL(status, 1);
+	CU_ASSERT_EQUAL(memcmp(dst, expected, sizeof(dst)), 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 0);
+
+	/* Smaller operations are executed in place */
+	memset(dst, 0, sizeof(dst));
+	status = 1;
+	rc = spdk_accel_submit_xor(ioch, dst, sources, SPDK_COUNTOF(sources), sizeof(dst) / 2,
+				   ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 0);
+	CU_ASSERT_EQUAL(memcmp(dst, expected, sizeof(dst) / 2), 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 0);
+
+	/* So are operations which are never offloaded */
+	memset(dst, 0, sizeof(dst));
+	status = 1;
+	rc = spdk_accel_submit_copy(ioch, dst, src1, sizeof(dst), 0, ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 0);
+	CU_ASSERT_EQUAL(memcmp(dst, src1, sizeof(dst)), 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 0);
+
+	/* Once the completion ring could overflow, the operations are executed in place */
+	sw_ch->num_offloaded = ACCEL_SW_WORKER_RING_SIZE;
+	memset(dst, 0, sizeof(dst));
+	status = 1;
+	rc = spdk_accel_submit_xor(ioch, dst, sources, SPDK_COUNTOF(sources), sizeof(dst),
+				   ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, ACCEL_SW_WORKER_RING_SIZE);
+	CU_ASSERT_EQUAL(memcmp(dst, expected, sizeof(dst)), 0);
+	sw_ch->num_offloaded = 0;
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 0);
+
+	/* A worker which failed to get a channel completes the task with an error */
+	worker.ch = NULL;
+	status = 1;
+	rc = spdk_accel_submit_xor(ioch, dst, sources, SPDK_COUNTOF(sources), sizeof(dst),
+				   ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_thread(1);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, -ENOMEM);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 0);
+	worker.ch = worker_ch;
+
+	/* Channels created without a completion ring execute everything in place */
+	spdk_ring_free(sw_ch->worker_completions);
+	sw_ch->worker_completions = NULL;
+	memset(dst, 0, sizeof(dst));
+	status = 1;
+	rc = spdk_accel_submit_xor(ioch, dst, sources, SPDK_COUNTOF(sources), sizeof(dst),
+				   ut_sw_worker_cb, &status);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(sw_ch->num_offloaded, 0);
+	CU_ASSERT_EQUAL(memcmp(dst, expected, sizeof(dst)), 0);
+	poll_thread(0);
+	CU_ASSERT_EQUAL(status, 0);
+
+	g_sw_workers = NULL;
+	g_sw_num_workers = 0;
+	g_sw_opts.offload_min_size = offload_min_size;
+
+	spdk_put_io_channel(ioch);
+	set_thread(1);
+	spdk_put_io_channel(worker_ch);
+	set_thread(0);
+	poll_threads();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -3824,6 +4687,12 @@ main(int argc, char **argv)
 #endif
 	CU_ADD_TEST(seq_suite, test_sequence_driver);
 	CU_ADD_TEST(seq_suite, test_sequence_same_iovs);
+	CU_ADD_TEST(seq_suite, test_sequence_crc32c);
+	CU_ADD_TEST(seq_suite, test_sequence_dif_copy_alignment);
+	CU_ADD_TEST(seq_suite, test_sequence_stats);
+
+	suite = CU_add_suite("accel_sw_workers", test_sw_workers_setup, test_sequence_cleanup);
+	CU_ADD_TEST(suite, test_sw_workers);
 
 	suite = CU_add_suite("accel", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_spdk_accel_task_complete);
@@ -3836,6 +4705,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dif);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dix);
 	CU_ADD_TEST(suite, test_spdk_accel_module_find_by_name);
 	CU_ADD_TEST(suite, test_spdk_accel_module_register);
 
@@ -1277,6 +1277,220 @@ bdev_io_wait_test(void)
 	ut_fini_bdev();
 }
 
+static void
+bdev_io_cache_adaptive(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *channel;
+	struct spdk_bdev_mgmt_channel *mgmt_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	int rc, i;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	bdev_opts.bdev_io_pool_size = 16;
+	bdev_opts.bdev_io_cache_size = 2;
+	ut_init_bdev(&bdev_opts);
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	channel = spdk_io_channel_get_ctx(io_ch);
+	mgmt_ch = channel->shared_resource->mgmt_ch;
+
+	CU_ASSERT(mgmt_ch->bdev_io_cache_size == 2);
+	CU_ASSERT(mgmt_ch->per_thread_cache_count == 2);
+
+	/* The first two I/Os hit the cache, the other four grow it. */
+	for (i = 0; i < 6; i++) {
+		rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(mgmt_ch->cache_hits == 2);
+	CU_ASSERT(mgmt_ch->cache_misses == 4);
+	CU_ASSERT(mgmt_ch->bdev_io_cache_size == 6);
+
+	/* All of the freed bdev_ios are kept on this thread. */
+	stub_complete_io(6);
+	CU_ASSERT(mgmt_ch->per_thread_cache_count == 6);
+	CU_ASSERT(spdk_mempool_count(g_bdev_mgr.bdev_io_pool) == 10);
+
+	/* The cache was emptied during the first period, so nothing is released yet. */
+	spdk_delay_us(SPDK_BDEV_IO_CACHE_REBALANCE_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(mgmt_ch->bdev_io_cache_size == 6);
+	CU_ASSERT(mgmt_ch->per_thread_cache_count == 6);
+
+	/* Idle bdev_ios are given back gradually, never going below the configured size. */
+	spdk_delay_us(SPDK_BDEV_IO_CACHE_REBALANCE_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(mgmt_ch->bdev_io_cache_size == 4);
+	CU_ASSERT(mgmt_ch->per_thread_cache_count == 4);
+	CU_ASSERT(spdk_mempool_count(g_bdev_mgr.bdev_io_pool) == 12);
+
+	for (i = 0; i < 4; i++) {
+		spdk_delay_us(SPDK_BDEV_IO_CACHE_REBALANCE_PERIOD_US);
+		poll_threads();
+	}
+	CU_ASSERT(mgmt_ch->bdev_io_cache_size == 2);
+	CU_ASSERT(mgmt_ch->per_thread_cache_count == 2);
+	CU_ASSERT(spdk_mempool_count(g_bdev_mgr.bdev_io_pool) == 14);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+merge_limits_cb(void *cb_arg, int status)
+{
+	*(int *)cb_arg = status;
+}
+
+static void
+merge_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	CU_ASSERT(success);
+	(*(int *)cb_arg)++;
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+bdev_io_merge(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *channel;
+	struct spdk_bdev_merge_limits limits = {};
+	struct spdk_bdev_io_stat stat = {};
+	struct ut_expected_io *expected_io;
+	char buf[4][512];
+	int rc, status = -1, num_done = 0;
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	channel = spdk_io_channel_get_ctx(io_ch);
+
+	/* max_ios must allow at least two I/Os to be merged */
+	limits.max_bytes = 4 * 512;
+	limits.max_ios = 1;
+	limits.window_us = 100;
+	spdk_bdev_set_merge_limits(bdev, &limits, merge_limits_cb, &status);
+	CU_ASSERT(status == -EINVAL);
+
+	limits.max_ios = 3;
+	spdk_bdev_set_merge_limits(bdev, &limits, merge_limits_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+	SPDK_CU_ASSERT_FATAL(channel->merge != NULL);
+
+	/* Contiguous writes are held back and submitted as one I/O once max_ios is reached. */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 3, 3);
+	ut_expected_io_set_iov(expected_io, 0, buf[0], 512);
+	ut_expected_io_set_iov(expected_io, 1, buf[1], 512);
+	ut_expected_io_set_iov(expected_io, 2, buf[2], 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[0], 0, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[1], 1, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[2], 2, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	stub_complete_io(1);
+	CU_ASSERT(num_done == 3);
+
+	/* A single I/O is submitted on its own when the merge window expires. */
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf[0], 8, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	stub_complete_io(1);
+	CU_ASSERT(num_done == 4);
+
+	/* A write that is not adjacent to the queued one (or a read) flushes the queue. */
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[0], 16, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[1], 20, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf[2], 21, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	stub_complete_io(3);
+	CU_ASSERT(num_done == 7);
+
+	/* The merged I/O is limited to max_bytes. */
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[0], 32, 3, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[1], 35, 2, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	stub_complete_io(2);
+	CU_ASSERT(num_done == 9);
+
+	/* If the merged I/O fails, the original I/Os are retried one by one. */
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[0], 40, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[1], 41, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[2], 42, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_FAILED;
+	stub_complete_io(1);
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	CU_ASSERT(num_done == 9);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	stub_complete_io(3);
+	CU_ASSERT(num_done == 12);
+
+	spdk_bdev_get_io_stat(bdev, io_ch, &stat);
+	CU_ASSERT(stat.num_merge_ops == 2);
+	CU_ASSERT(stat.num_merged_ops == 6);
+	/* Each of the merged I/Os is accounted on its own. */
+	CU_ASSERT(stat.num_write_ops == 10);
+	CU_ASSERT(stat.bytes_written == 13 * 512);
+	CU_ASSERT(stat.num_read_ops == 2);
+
+	limits.max_bytes = 0;
+	spdk_bdev_set_merge_limits(bdev, &limits, merge_limits_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+	CU_ASSERT(channel->merge == NULL);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 bdev_io_spans_split_test(void)
 {
@@ -3563,6 +3777,120 @@ bdev_histograms(void)
 	ut_fini_bdev();
 }
 
+static void
+io_type_histograms_cb(void *cb_arg, int status,
+		      const struct spdk_bdev_io_type_histograms *histograms)
+{
+	int type, size_class;
+
+	g_status = status;
+	g_count = 0;
+	if (status != 0) {
+		return;
+	}
+
+	/* Only the expected (I/O type, size class) pairs may hold histograms */
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (size_class = 0; size_class < SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES; size_class++) {
+			if (histograms->histogram[type][size_class] == NULL) {
+				continue;
+			}
+			if ((type == SPDK_BDEV_IO_TYPE_READ && size_class == 0) ||
+			    (type == SPDK_BDEV_IO_TYPE_WRITE && size_class == 4) ||
+			    (type == SPDK_BDEV_IO_TYPE_UNMAP && size_class == 7)) {
+				spdk_histogram_data_iterate(histograms->histogram[type][size_class],
+							    histogram_io_count, NULL);
+			} else {
+				CU_ASSERT(false);
+			}
+		}
+	}
+}
+
+static void
+bdev_io_type_histograms(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	void *buf;
+	int rc;
+
+	CU_ASSERT(spdk_bdev_histogram_get_size_class_max(0) == 4096);
+	CU_ASSERT(spdk_bdev_histogram_get_size_class_max(4) == 65536);
+	CU_ASSERT(spdk_bdev_histogram_get_size_class_max(SPDK_BDEV_HISTOGRAM_NUM_SIZE_CLASSES - 1) ==
+		  UINT64_MAX);
+
+	ut_init_bdev(NULL);
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	buf = calloc(1, 0x10000);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	/* Histograms are disabled */
+	spdk_bdev_io_type_histograms_get(bdev, io_type_histograms_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == -EFAULT);
+
+	g_status = -1;
+	spdk_bdev_histogram_enable(bdev, histogram_status_cb, NULL, true);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	/* No I/O done yet, so no histogram has been allocated */
+	spdk_bdev_io_type_histograms_get(bdev, io_type_histograms_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(g_count == 0);
+
+	/* 4KiB read, 64KiB write and 512KiB unmap */
+	rc = spdk_bdev_read_blocks(desc, ch, buf, 0, 8, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, ch, buf, 0, 128, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_unmap_blocks(desc, ch, 0, 1024, io_done, NULL);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(10);
+	stub_complete_io(3);
+	poll_threads();
+
+	rc = spdk_bdev_read_blocks(desc, ch, buf, 8, 8, io_done, NULL);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(10);
+	stub_complete_io(1);
+	poll_threads();
+
+	spdk_bdev_io_type_histograms_get(bdev, io_type_histograms_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(g_count == 4);
+
+	g_status = -1;
+	spdk_bdev_histogram_enable(bdev, histogram_status_cb, NULL, false);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+
+	spdk_bdev_io_type_histograms_get(bdev, io_type_histograms_cb, NULL);
+	poll_threads();
+	CU_ASSERT(g_status == -EFAULT);
+
+	free(buf);
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 _bdev_compare(bool emulated)
 {
@@ -4856,6 +5184,83 @@ lock_lba_range_with_io_outstanding(void)
 	ut_fini_bdev();
 }
 
+static void
+bdev_io_merge_with_lock(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *channel;
+	struct spdk_bdev_merge_limits limits = {};
+	struct spdk_bdev_io_stat stat = {};
+	char buf[2][512];
+	int rc, status = -1, num_done = 0, ctx1;
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	channel = spdk_io_channel_get_ctx(io_ch);
+
+	limits.max_bytes = 4 * 512;
+	limits.max_ios = 3;
+	limits.window_us = 100;
+	spdk_bdev_set_merge_limits(bdev, &limits, merge_limits_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+	SPDK_CU_ASSERT_FATAL(channel->merge != NULL);
+
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[0], 20, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf[1], 21, 1, merge_io_done, &num_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	/* The queued writes keep the lock pending, so they must not be merged into an I/O
+	 * which would then wait for the lock.
+	 */
+	g_lock_lba_range_done = false;
+	rc = bdev_lock_lba_range(desc, io_ch, 20, 10, lock_lba_range_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_lock_lba_range_done == false);
+	CU_ASSERT(!TAILQ_EMPTY(&channel->locked_ranges));
+
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(TAILQ_EMPTY(&channel->io_locked));
+
+	stub_complete_io(2);
+	CU_ASSERT(num_done == 2);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(g_lock_lba_range_done == true);
+
+	rc = bdev_unlock_lba_range(desc, io_ch, 20, 10, unlock_lba_range_done, &ctx1);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+
+	spdk_bdev_get_io_stat(bdev, io_ch, &stat);
+	CU_ASSERT(stat.num_merge_ops == 0);
+	CU_ASSERT(stat.num_write_ops == 2);
+
+	limits.max_bytes = 0;
+	spdk_bdev_set_merge_limits(bdev, &limits, merge_limits_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 lock_lba_range_overlapped(void)
 {
@@ -7055,6 +7460,9 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, get_device_stat_test);
 	CU_ADD_TEST(suite, bdev_io_types_test);
 	CU_ADD_TEST(suite, bdev_io_wait_test);
+	CU_ADD_TEST(suite, bdev_io_cache_adaptive);
+	CU_ADD_TEST(suite, bdev_io_merge);
+	CU_ADD_TEST(suite, bdev_io_merge_with_lock);
 	CU_ADD_TEST(suite, bdev_io_spans_split_test);
 	CU_ADD_TEST(suite, bdev_io_boundary_split_test);
 	CU_ADD_TEST(suite, bdev_io_max_size_and_segment_split_test);
@@ -7064,6 +7472,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, bdev_io_alignment_with_boundary);
 	CU_ADD_TEST(suite, bdev_io_alignment);
 	CU_ADD_TEST(suite, bdev_histograms);
+	CU_ADD_TEST(suite, bdev_io_type_histograms);
 	CU_ADD_TEST(suite, bdev_write_zeroes);
 	CU_ADD_TEST(suite, bdev_compare_and_write);
 	CU_ADD_TEST(suite, bdev_compare);
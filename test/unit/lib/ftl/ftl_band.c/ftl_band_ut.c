@@ -93,7 +93,6 @@ DEFINE_STUB(ftl_mngt_unmap, int, (struct spdk_ftl_dev *dev, uint64_t lba, uint64
 DEFINE_STUB_V(ftl_p2l_ckpt_release, (struct spdk_ftl_dev *dev, struct ftl_p2l_ckpt *ckpt));
 
 DEFINE_STUB_V(ftl_l2p_process, (struct spdk_ftl_dev *dev));
-DEFINE_STUB_V(ftl_nv_cache_process, (struct spdk_ftl_dev *dev));
 DEFINE_STUB(ftl_nv_cache_is_halted, bool, (struct ftl_nv_cache *nvc), true);
 DEFINE_STUB(ftl_nv_cache_chunks_busy, int, (struct ftl_nv_cache *nvc), true);
 DEFINE_STUB(ftl_nv_cache_full, bool, (struct ftl_nv_cache *nvc), true);
@@ -147,6 +146,33 @@ DEFINE_STUB_V(spdk_bdev_io_get_nvme_status, (const struct spdk_bdev_io *bdev_io,
 		int *sct, int *sc));
 DEFINE_STUB(ftl_nv_cache_throttle, bool, (struct spdk_ftl_dev *dev), true);
 
+static uint64_t g_nv_cache_io_activity;
+static bool g_nv_cache_io_activity_remote;
+
+static void *
+add_io_activity_remote(void *arg)
+{
+	ftl_add_io_activity_blocks(arg, g_nv_cache_io_activity);
+	return NULL;
+}
+
+void
+ftl_nv_cache_process(struct spdk_ftl_dev *dev)
+{
+	pthread_t thread;
+	int rc;
+
+	if (!g_nv_cache_io_activity_remote) {
+		ftl_add_io_activity_blocks(dev, g_nv_cache_io_activity);
+		return;
+	}
+
+	/* Simulate IO submitted on another core while the poller is running */
+	rc = pthread_create(&thread, NULL, add_io_activity_remote, dev);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	pthread_join(thread, NULL);
+}
+
 static void
 adjust_bitmap(struct ftl_bitmap **bitmap, uint64_t *bit)
 {
@@ -371,6 +397,35 @@ test_next_xfer_addr(void)
 	cleanup_band();
 }
 
+static void
+test_poller_io_activity(void)
+{
+	uint64_t io_activity_total;
+
+	setup_band();
+	io_activity_total = g_dev->stats.io_activity_total;
+
+	/* No IO submitted, the poller is idle */
+	g_nv_cache_io_activity = 0;
+	g_nv_cache_io_activity_remote = false;
+	CU_ASSERT_EQUAL(ftl_compaction_poller(g_dev), SPDK_POLLER_IDLE);
+	CU_ASSERT_EQUAL(g_dev->stats.io_activity_total, io_activity_total);
+
+	/* IO submitted by the poller makes it busy */
+	g_nv_cache_io_activity = 4;
+	CU_ASSERT_EQUAL(ftl_compaction_poller(g_dev), SPDK_POLLER_BUSY);
+	CU_ASSERT_EQUAL(g_dev->stats.io_activity_total, io_activity_total + 4);
+
+	/* IO on another core is counted in the device stats, but doesn't make the poller busy */
+	g_nv_cache_io_activity_remote = true;
+	CU_ASSERT_EQUAL(ftl_compaction_poller(g_dev), SPDK_POLLER_IDLE);
+	CU_ASSERT_EQUAL(g_dev->stats.io_activity_total, io_activity_total + 8);
+
+	g_nv_cache_io_activity = 0;
+	g_nv_cache_io_activity_remote = false;
+	cleanup_band();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -389,6 +444,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_band_set_addr);
 	CU_ADD_TEST(suite, test_invalidate_addr);
 	CU_ADD_TEST(suite, test_next_xfer_addr);
+	CU_ADD_TEST(suite, test_poller_io_activity);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
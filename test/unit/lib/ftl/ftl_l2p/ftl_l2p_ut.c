@@ -8,12 +8,77 @@
 #include "spdk_cunit.h"
 #include "common/lib/test_env.c"
 
-#include "ftl/ftl_core.h"
+#include "ftl/ftl_l2p_cache.c"
+#include "ftl/utils/ftl_bitmap.c"
+
+#include "spdk_internal/mock.h"
 
 #define L2P_TABLE_SIZE 1024
 
 static struct spdk_ftl_dev *g_dev;
 
+void *g_ftl_read_buf;
+void *g_ftl_write_buf;
+__thread uint64_t g_ftl_thread_io_activity;
+
+DEFINE_STUB_V(ftl_invalidate_addr, (struct spdk_ftl_dev *dev, ftl_addr addr));
+DEFINE_STUB_V(ftl_md_clear, (struct ftl_md *md, int pattern, union ftl_md_vss *vss_pattern));
+DEFINE_STUB(ftl_md_create, struct ftl_md *, (struct spdk_ftl_dev *dev, uint64_t blocks,
+		uint64_t vss_blksz, const char *name, int flags, const struct ftl_layout_region *region), NULL);
+DEFINE_STUB(ftl_md_create_shm_flags, int, (struct spdk_ftl_dev *dev), 0);
+DEFINE_STUB_V(ftl_md_destroy, (struct ftl_md *md, int flags));
+DEFINE_STUB(ftl_md_destroy_shm_flags, int, (struct spdk_ftl_dev *dev), 0);
+DEFINE_STUB(ftl_md_get_buffer, void *, (struct ftl_md *md), NULL);
+DEFINE_STUB(ftl_md_get_buffer_size, uint64_t, (struct ftl_md *md), 0);
+DEFINE_STUB(ftl_mempool_create, struct ftl_mempool *, (size_t count, size_t size,
+		size_t alignment, int socket_id), NULL);
+DEFINE_STUB(ftl_mempool_create_ext, struct ftl_mempool *, (void *buffer, size_t count,
+		size_t size, size_t alignment), NULL);
+DEFINE_STUB(ftl_mempool_claim_df, void *, (struct ftl_mempool *mpool, ftl_df_obj_id df_obj_id),
+	    NULL);
+DEFINE_STUB_V(ftl_mempool_release_df, (struct ftl_mempool *mpool, ftl_df_obj_id df_obj_id));
+DEFINE_STUB_V(ftl_mempool_destroy, (struct ftl_mempool *mpool));
+DEFINE_STUB_V(ftl_mempool_destroy_ext, (struct ftl_mempool *mpool));
+DEFINE_STUB_V(ftl_mempool_initialize_ext, (struct ftl_mempool *mpool));
+DEFINE_STUB_V(ftl_stats_bdev_io_completed, (struct spdk_ftl_dev *dev, enum ftl_stats_type type,
+		struct spdk_bdev_io *bdev_io));
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB(ftl_mempool_get, void *, (struct ftl_mempool *mpool), NULL);
+DEFINE_STUB_V(ftl_mempool_put, (struct ftl_mempool *mpool, void *element));
+DEFINE_STUB(ftl_mempool_get_df_obj_id, ftl_df_obj_id, (struct ftl_mempool *mpool,
+		void *df_obj_ptr), 0);
+DEFINE_STUB(ftl_mempool_get_df_obj_index, size_t, (struct ftl_mempool *mpool,
+		void *df_obj_ptr), 0);
+DEFINE_STUB(spdk_bdev_desc_get_bdev, struct spdk_bdev *, (struct spdk_bdev_desc *desc), NULL);
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB(spdk_bdev_read_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+
+/* L2P pages of the tests are addressed directly by their object IDs */
+void *
+ftl_mempool_get_df_ptr(struct ftl_mempool *mpool, ftl_df_obj_id df_obj_id)
+{
+	return (void *)(uintptr_t)df_obj_id;
+}
+
+static bool g_unpin_on_pin_complete;
+static int g_pin_complete_cnt;
+
+void
+ftl_l2p_pin_complete(struct spdk_ftl_dev *dev, int status, struct ftl_l2p_pin_ctx *pin_ctx)
+{
+	g_pin_complete_cnt++;
+	if (g_unpin_on_pin_complete) {
+		/* Like ftl_l2p_lazy_unmap_process_cb(), release the pages right away */
+		ftl_l2p_cache_unpin(dev, pin_ctx->lba, pin_ctx->count);
+	}
+}
+
 static struct spdk_ftl_dev *
 test_alloc_dev(size_t size)
 {
@@ -101,10 +166,144 @@ test_addr_cached(void)
 	clean_l2p();
 }
 
+#define L2P_CACHE_NUM_PAGES 4
+
+static struct ftl_l2p_cache g_cache;
+static struct ftl_l2p_l1_map_entry g_l2_mapping[L2P_CACHE_NUM_PAGES];
+static struct ftl_l2p_page g_pages[L2P_CACHE_NUM_PAGES];
+
+static int
+setup_l2p_cache(void)
+{
+	size_t i;
+
+	g_dev = calloc(1, sizeof(*g_dev));
+	if (!g_dev) {
+		return -1;
+	}
+	g_dev->l2p = &g_cache;
+
+	g_cache.dev = g_dev;
+	g_cache.l2_mapping = g_l2_mapping;
+	g_cache.lbas_in_page = 1024;
+	g_cache.num_pages = L2P_CACHE_NUM_PAGES;
+	g_cache.l2_pgs_resident_max = L2P_CACHE_NUM_PAGES;
+	g_cache.lru_probation_min = 1;
+	TAILQ_INIT(&g_cache.lru_list);
+	TAILQ_INIT(&g_cache.lru_protected_list);
+	TAILQ_INIT(&g_cache.deferred_page_set_list);
+
+	for (i = 0; i < L2P_CACHE_NUM_PAGES; i++) {
+		g_l2_mapping[i].page_obj_id = (ftl_df_obj_id)(uintptr_t)&g_pages[i];
+	}
+
+	return 0;
+}
+
+static int
+cleanup_l2p_cache(void)
+{
+	free(g_dev);
+	g_dev = NULL;
+	return 0;
+}
+
+/* Set up a page being paged in, as page_in() leaves it */
+static struct ftl_l2p_page *
+test_page_in_start(uint64_t page_no, bool prefetched)
+{
+	struct ftl_l2p_page *page = &g_pages[page_no];
+
+	memset(page, 0, sizeof(*page));
+	page->page_no = page_no;
+	page->state = L2P_CACHE_PAGE_INIT;
+	page->prefetched = prefetched;
+	TAILQ_INIT(&page->ppe_list);
+	g_cache.ios_in_flight++;
+
+	return page;
+}
+
+/* Make the page set wait for the page being paged in */
+static void
+test_page_set_wait(struct ftl_l2p_page_set *page_set, struct ftl_l2p_pin_ctx *pin_ctx,
+		   struct ftl_l2p_page *page)
+{
+	memset(page_set, 0, sizeof(*page_set));
+	pin_ctx->lba = page->page_no * g_cache.lbas_in_page;
+	pin_ctx->count = 1;
+	page_set->pin_ctx = pin_ctx;
+	page_set->to_pin_cnt = 1;
+	page_set->entry[0].parent = page_set;
+	page_set->entry[0].pg_no = page->page_no;
+	page_set->entry[0].pg_pin_issued = true;
+	TAILQ_INSERT_TAIL(&page->ppe_list, &page_set->entry[0], list_entry);
+}
+
+static void
+test_page_in_complete(void)
+{
+	struct ftl_l2p_page_set page_set;
+	struct ftl_l2p_pin_ctx pin_ctx;
+	struct ftl_l2p_page *page;
+
+	g_pin_complete_cnt = 0;
+
+	/* Read ahead page nobody waited for goes to the LRU list */
+	page = test_page_in_start(0, true);
+	page_in_io_complete(g_dev, &g_cache, page, true);
+	CU_ASSERT(page->state == L2P_CACHE_PAGE_READY);
+	CU_ASSERT(page->pin_ref_cnt == 0);
+	CU_ASSERT(page->on_lru_list);
+	CU_ASSERT(g_cache.lru_cnt == 1);
+	CU_ASSERT(TAILQ_FIRST(&g_cache.lru_list) == page);
+	CU_ASSERT(g_cache.ios_in_flight == 0);
+
+	/* Read ahead page whose waiter unpins it from the completion callback is
+	 * put on the LRU list by the unpin, and only once.
+	 */
+	g_unpin_on_pin_complete = true;
+	page = test_page_in_start(1, true);
+	test_page_set_wait(&page_set, &pin_ctx, page);
+	page_in_io_complete(g_dev, &g_cache, page, true);
+	CU_ASSERT(g_pin_complete_cnt == 1);
+	CU_ASSERT(page->pin_ref_cnt == 0);
+	CU_ASSERT(page->on_lru_list);
+	CU_ASSERT(g_cache.lru_cnt == 2);
+	CU_ASSERT(TAILQ_FIRST(&g_cache.lru_list) == page);
+	CU_ASSERT(TAILQ_NEXT(page, list_entry) == &g_pages[0]);
+	CU_ASSERT(TAILQ_NEXT(&g_pages[0], list_entry) == NULL);
+
+	/* Same for a page paged in on demand */
+	page = test_page_in_start(2, false);
+	test_page_set_wait(&page_set, &pin_ctx, page);
+	page_in_io_complete(g_dev, &g_cache, page, true);
+	CU_ASSERT(g_pin_complete_cnt == 2);
+	CU_ASSERT(page->on_lru_list);
+	CU_ASSERT(g_cache.lru_cnt == 3);
+	CU_ASSERT(TAILQ_FIRST(&g_cache.lru_list) == page);
+	g_unpin_on_pin_complete = false;
+
+	/* A page still pinned by its waiter stays off the LRU list until unpinned */
+	page = test_page_in_start(3, false);
+	test_page_set_wait(&page_set, &pin_ctx, page);
+	page_in_io_complete(g_dev, &g_cache, page, true);
+	CU_ASSERT(g_pin_complete_cnt == 3);
+	CU_ASSERT(page->pin_ref_cnt == 1);
+	CU_ASSERT(!page->on_lru_list);
+	CU_ASSERT(g_cache.lru_cnt == 3);
+
+	ftl_l2p_cache_unpin(g_dev, pin_ctx.lba, pin_ctx.count);
+	CU_ASSERT(page->on_lru_list);
+	CU_ASSERT(g_cache.lru_cnt == 4);
+	CU_ASSERT(g_cache.ios_in_flight == 0);
+}
+
 int
 main(int argc, char **argv)
 {
 	CU_pSuite suite64 = NULL;
+	CU_pSuite suite_cache = NULL;
 	unsigned int num_failures;
 
 	CU_set_error_action(CUEA_ABORT);
@@ -114,6 +313,10 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite64, test_addr_cached);
 
+	suite_cache = CU_add_suite("ftl_l2p_cache_suite", setup_l2p_cache, cleanup_l2p_cache);
+
+	CU_ADD_TEST(suite_cache, test_page_in_complete);
+
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
 	num_failures = CU_get_number_of_failures();
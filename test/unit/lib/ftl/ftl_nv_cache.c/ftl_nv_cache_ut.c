@@ -0,0 +1,284 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+#include "common/lib/test_env.c"
+
+#include "ftl/ftl_nv_cache.c"
+#include "ftl/utils/ftl_bitmap.c"
+
+#include "spdk_internal/mock.h"
+
+#define TEST_NUM_BLOCKS 256
+
+void *g_ftl_read_buf;
+void *g_ftl_write_buf;
+__thread uint64_t g_ftl_thread_io_activity;
+
+DEFINE_STUB(ftl_band_next_addr, ftl_addr, (struct ftl_band *band, ftl_addr addr, size_t offset),
+	    0);
+DEFINE_STUB_V(ftl_io_complete, (struct ftl_io *io));
+DEFINE_STUB(ftl_io_get_lba, uint64_t, (const struct ftl_io *io, size_t offset), 0);
+DEFINE_STUB(ftl_io_iovec_addr, void *, (struct ftl_io *io), NULL);
+DEFINE_STUB(ftl_l2p_get, ftl_addr, (struct spdk_ftl_dev *dev, uint64_t lba), 0);
+DEFINE_STUB_V(ftl_l2p_pin, (struct spdk_ftl_dev *dev, uint64_t lba, uint64_t count,
+			    ftl_l2p_pin_cb cb, void *cb_ctx, struct ftl_l2p_pin_ctx *pin_ctx));
+DEFINE_STUB_V(ftl_l2p_pin_skip, (struct spdk_ftl_dev *dev, ftl_l2p_pin_cb cb, void *cb_ctx,
+				 struct ftl_l2p_pin_ctx *pin_ctx));
+DEFINE_STUB_V(ftl_l2p_unpin, (struct spdk_ftl_dev *dev, uint64_t lba, uint64_t count));
+DEFINE_STUB_V(ftl_l2p_update_base, (struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr,
+				    ftl_addr old_addr));
+DEFINE_STUB_V(ftl_l2p_update_cache, (struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr new_addr,
+				     ftl_addr old_addr));
+DEFINE_STUB(ftl_md_get_buffer, void *, (struct ftl_md *md), NULL);
+DEFINE_STUB(ftl_md_get_buffer_size, uint64_t, (struct ftl_md *md), 0);
+DEFINE_STUB_V(ftl_md_persist_entry, (struct ftl_md *md, uint64_t start_entry, void *buffer,
+				     void *vss_buffer, ftl_md_io_entry_cb cb, void *cb_arg,
+				     struct ftl_md_io_entry_ctx *ctx));
+DEFINE_STUB_V(ftl_md_restore, (struct ftl_md *md));
+DEFINE_STUB(ftl_mempool_create, struct ftl_mempool *, (size_t count, size_t size,
+		size_t alignment, int socket_id), NULL);
+DEFINE_STUB_V(ftl_mempool_destroy, (struct ftl_mempool *mpool));
+DEFINE_STUB(ftl_mempool_get, void *, (struct ftl_mempool *mpool), NULL);
+DEFINE_STUB_V(ftl_mempool_put, (struct ftl_mempool *mpool, void *element));
+DEFINE_STUB(ftl_mngt_alloc_step_ctx, int, (struct ftl_mngt_process *mngt, size_t size), 0);
+DEFINE_STUB_V(ftl_mngt_continue_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB_V(ftl_mngt_fail_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB(ftl_mngt_get_dev, struct spdk_ftl_dev *, (struct ftl_mngt_process *mngt), NULL);
+DEFINE_STUB(ftl_mngt_get_step_ctx, void *, (struct ftl_mngt_process *mngt), NULL);
+DEFINE_STUB_V(ftl_mngt_next_step, (struct ftl_mngt_process *mngt));
+DEFINE_STUB_V(ftl_rq_del, (struct ftl_rq *rq));
+DEFINE_STUB(ftl_rq_new, struct ftl_rq *, (struct spdk_ftl_dev *dev, uint32_t io_md_size), NULL);
+DEFINE_STUB_V(ftl_rq_unpin, (struct ftl_rq *rq));
+DEFINE_STUB_V(ftl_stats_bdev_io_completed, (struct spdk_ftl_dev *dev, enum ftl_stats_type type,
+		struct spdk_bdev_io *bdev_io));
+DEFINE_STUB(spdk_bdev_desc_get_bdev, struct spdk_bdev *, (struct spdk_bdev_desc *desc), NULL);
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB(spdk_bdev_read_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_readv_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, struct iovec *iov, int iovcnt, void *md,
+		uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_writev_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, struct iovec *iov, int iovcnt, void *md,
+		uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		void *cb_arg), 0);
+
+static struct spdk_ftl_dev *g_dev;
+static void *g_valid_map_buf;
+
+static int
+setup_nv_cache(void)
+{
+	uint64_t size = ftl_bitmap_bits_to_size(TEST_NUM_BLOCKS);
+
+	g_dev = calloc(1, sizeof(*g_dev));
+	if (!g_dev) {
+		return -1;
+	}
+
+	g_valid_map_buf = aligned_alloc(ftl_bitmap_buffer_alignment, size);
+	if (!g_valid_map_buf) {
+		return -1;
+	}
+	memset(g_valid_map_buf, 0, size);
+
+	g_dev->valid_map = ftl_bitmap_create(g_valid_map_buf, size);
+	if (!g_dev->valid_map) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+cleanup_nv_cache(void)
+{
+	ftl_bitmap_destroy(g_dev->valid_map);
+	free(g_valid_map_buf);
+	free(g_dev);
+	g_dev = NULL;
+	return 0;
+}
+
+static void
+set_valid(uint64_t begin, uint64_t end)
+{
+	for (; begin < end; begin++) {
+		ftl_bitmap_set(g_dev->valid_map, begin);
+	}
+}
+
+static void
+clear_valid(void)
+{
+	uint64_t i;
+
+	for (i = 0; i < TEST_NUM_BLOCKS; i++) {
+		ftl_bitmap_clear(g_dev->valid_map, i);
+	}
+}
+
+static void
+test_compaction_read_range(void)
+{
+	clear_valid();
+
+	/* All valid, the read stops at the limit */
+	set_valid(0, 32);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 16), 16);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 32), 32);
+
+	/* Trailing invalid blocks aren't read */
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 64), 32);
+
+	/* Short gaps of invalid blocks are read over */
+	set_valid(32 + FTL_NV_CACHE_COMPACTION_MAX_GAP, 48);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 64), 48);
+	set_valid(48 + 1, 56);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 64), 56);
+
+	/* Longer gaps end the read */
+	set_valid(56 + FTL_NV_CACHE_COMPACTION_MAX_GAP + 1, 80);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 128), 56);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 56 + FTL_NV_CACHE_COMPACTION_MAX_GAP + 1, 128),
+			80);
+
+	/* A gap is only read over if the next valid block is within the limit */
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 36), 32);
+	CU_ASSERT_EQUAL(compaction_read_range_end(g_dev, 0, 42), 42);
+
+	clear_valid();
+}
+
+static void
+test_compaction_sort_wr(void)
+{
+	struct ftl_nv_cache_compactor compactor = {};
+	const uint64_t lbas[] = { 7, 3, FTL_LBA_INVALID, 5, 0, FTL_LBA_INVALID, 6, 1 };
+	const uint64_t num_blocks = SPDK_COUNTOF(lbas);
+	char payload[SPDK_COUNTOF(lbas)];
+	struct ftl_rq_entry *entry;
+	struct ftl_rq *wr;
+	uint64_t i;
+
+	wr = calloc(1, sizeof(*wr) + num_blocks * sizeof(wr->entries[0]));
+	SPDK_CU_ASSERT_FATAL(wr != NULL);
+	wr->io_vec = calloc(num_blocks, sizeof(*wr->io_vec));
+	SPDK_CU_ASSERT_FATAL(wr->io_vec != NULL);
+	compactor.sort_buf = calloc(num_blocks, sizeof(*compactor.sort_buf));
+	SPDK_CU_ASSERT_FATAL(compactor.sort_buf != NULL);
+	compactor.wr = wr;
+	wr->num_blocks = num_blocks;
+
+	for (i = 0; i < num_blocks; i++) {
+		entry = &wr->entries[i];
+		entry->lba = lbas[i];
+		entry->addr = 100 + lbas[i];
+		entry->seq_id = 200 + lbas[i];
+		entry->owner.priv = &payload[i];
+		entry->io_payload = &payload[i];
+		wr->io_vec[i].iov_base = &payload[i];
+		wr->io_vec[i].iov_len = 1;
+	}
+
+	compaction_sort_wr(&compactor);
+
+	/* Blocks are ordered by LBA, padding goes last, and each block keeps its own data */
+	for (i = 0; i < num_blocks; i++) {
+		entry = &wr->entries[i];
+		if (i > 0) {
+			CU_ASSERT(wr->entries[i - 1].lba <= entry->lba);
+		}
+		if (i < num_blocks - 2) {
+			CU_ASSERT(entry->lba != FTL_LBA_INVALID);
+		} else {
+			CU_ASSERT_EQUAL(entry->lba, FTL_LBA_INVALID);
+		}
+		CU_ASSERT_EQUAL(entry->addr, 100 + entry->lba);
+		CU_ASSERT_EQUAL(entry->seq_id, 200 + entry->lba);
+		CU_ASSERT(entry->owner.priv == entry->io_payload);
+		CU_ASSERT(wr->io_vec[i].iov_base == entry->io_payload);
+		if (entry->lba != FTL_LBA_INVALID) {
+			CU_ASSERT_EQUAL(lbas[(char *)entry->io_payload - payload], entry->lba);
+		}
+	}
+
+	free(compactor.sort_buf);
+	free(wr->io_vec);
+	free(wr);
+}
+
+static void
+test_compaction_target_update(void)
+{
+	struct ftl_nv_cache nv_cache = {};
+	int i;
+
+	nv_cache.compaction_active_target = FTL_NV_CACHE_NUM_COMPACTORS;
+	nv_cache.chunk_free_target = 10;
+	nv_cache.throttle.blocks_submitted_limit = 100;
+
+	/* Compaction is ahead of user writes, fewer compactors are allowed */
+	nv_cache.chunk_free_count = 20;
+	for (i = 0; i < FTL_NV_CACHE_NUM_COMPACTORS; i++) {
+		ftl_nv_cache_compaction_target_update(&nv_cache);
+		CU_ASSERT(nv_cache.compaction_active_target >= FTL_NV_CACHE_COMPACTORS_MIN);
+	}
+	CU_ASSERT_EQUAL(nv_cache.compaction_active_target, FTL_NV_CACHE_COMPACTORS_MIN);
+
+	/* Free chunks are on target, the number of compactors is kept */
+	nv_cache.chunk_free_count = 10;
+	nv_cache.throttle.blocks_submitted = 100;
+	ftl_nv_cache_compaction_target_update(&nv_cache);
+	CU_ASSERT_EQUAL(nv_cache.compaction_active_target, FTL_NV_CACHE_COMPACTORS_MIN);
+
+	/* Free chunks are below target but user writes weren't throttled */
+	nv_cache.chunk_free_count = 5;
+	nv_cache.throttle.blocks_submitted = 50;
+	ftl_nv_cache_compaction_target_update(&nv_cache);
+	CU_ASSERT_EQUAL(nv_cache.compaction_active_target, FTL_NV_CACHE_COMPACTORS_MIN);
+
+	/* User writes are throttled, more compactors are allowed, up to all of them */
+	nv_cache.throttle.blocks_submitted = 100;
+	ftl_nv_cache_compaction_target_update(&nv_cache);
+	CU_ASSERT_EQUAL(nv_cache.compaction_active_target, FTL_NV_CACHE_COMPACTORS_MIN + 1);
+	for (i = 0; i < FTL_NV_CACHE_NUM_COMPACTORS; i++) {
+		ftl_nv_cache_compaction_target_update(&nv_cache);
+	}
+	CU_ASSERT_EQUAL(nv_cache.compaction_active_target, FTL_NV_CACHE_NUM_COMPACTORS);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("ftl_nv_cache_suite", setup_nv_cache, cleanup_nv_cache);
+
+	CU_ADD_TEST(suite, test_compaction_read_range);
+	CU_ADD_TEST(suite, test_compaction_sort_wr);
+	CU_ADD_TEST(suite, test_compaction_target_update);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -12,6 +12,7 @@
 #include "iscsi/conn.c"
 
 #include "spdk_internal/mock.h"
+#include "spdk/crc32.h"
 
 #include "unit/lib/json_mock.c"
 
@@ -22,8 +23,20 @@ DEFINE_STUB(iscsi_get_pdu, struct spdk_iscsi_pdu *,
 DEFINE_STUB(iscsi_param_eq_val, int,
 	    (struct iscsi_param *params, const char *key, const char *val), 0);
 DEFINE_STUB(iscsi_pdu_calc_data_digest, uint32_t, (struct spdk_iscsi_pdu *pdu), 0);
-DEFINE_STUB_V(spdk_sock_writev_async,
-	      (struct spdk_sock *sock, struct spdk_sock_request *req));
+
+static struct spdk_iscsi_pdu *g_written_pdus[4];
+static int g_written_pdu_cnt;
+
+void
+spdk_sock_writev_async(struct spdk_sock *sock, struct spdk_sock_request *req)
+{
+	struct spdk_iscsi_pdu *pdu = SPDK_CONTAINEROF(req, struct spdk_iscsi_pdu, sock_req);
+
+	if (g_written_pdu_cnt < (int)SPDK_COUNTOF(g_written_pdus)) {
+		g_written_pdus[g_written_pdu_cnt] = pdu;
+	}
+	g_written_pdu_cnt++;
+}
 
 struct spdk_scsi_lun {
 	uint8_t reserved;
@@ -55,8 +68,33 @@ spdk_sock_close(struct spdk_sock **sock)
 DEFINE_STUB(spdk_sock_recv, ssize_t,
 	    (struct spdk_sock *sock, void *buf, size_t len), 0);
 
-DEFINE_STUB(spdk_sock_readv, ssize_t,
-	    (struct spdk_sock *sock, struct iovec *iov, int iovcnt), 0);
+static uint8_t *g_sock_readv_data;
+static size_t g_sock_readv_len;
+static int g_sock_readv_calls;
+
+ssize_t
+spdk_sock_readv(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
+{
+	size_t bytes = 0, len;
+	int i;
+
+	g_sock_readv_calls++;
+
+	for (i = 0; i < iovcnt && g_sock_readv_len > 0; i++) {
+		len = spdk_min(iov[i].iov_len, g_sock_readv_len);
+		memcpy(iov[i].iov_base, g_sock_readv_data, len);
+		g_sock_readv_data += len;
+		g_sock_readv_len -= len;
+		bytes += len;
+	}
+
+	if (bytes == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	return bytes;
+}
 
 ssize_t
 spdk_sock_writev(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
@@ -68,6 +106,25 @@ DEFINE_STUB(spdk_sock_set_recvlowat, int, (struct spdk_sock *s, int nbytes), 0);
 
 DEFINE_STUB(spdk_sock_set_recvbuf, int, (struct spdk_sock *sock, int sz), 0);
 
+static spdk_accel_completion_cb g_accel_cb_fn;
+static void *g_accel_cb_arg;
+static int g_accel_submit_cnt;
+
+DEFINE_RETURN_MOCK(spdk_accel_submit_crc32cv, int);
+int
+spdk_accel_submit_crc32cv(struct spdk_io_channel *ch, uint32_t *crc_dst, struct iovec *iov,
+			  uint32_t iov_cnt, uint32_t seed, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	HANDLE_RETURN_MOCK(spdk_accel_submit_crc32cv);
+
+	*crc_dst = spdk_crc32c_iov_update(iov, iov_cnt, ~seed);
+	g_accel_cb_fn = cb_fn;
+	g_accel_cb_arg = cb_arg;
+	g_accel_submit_cnt++;
+
+	return 0;
+}
+
 DEFINE_STUB(spdk_sock_set_sendbuf, int, (struct spdk_sock *sock, int sz), 0);
 
 DEFINE_STUB(spdk_sock_group_add_sock, int,
@@ -891,6 +948,225 @@ abort_queued_datain_tasks_test(void)
 	g_new_task = NULL;
 }
 
+static void
+read_data_through_recv_ring(void)
+{
+	struct spdk_iscsi_conn conn = {};
+	uint8_t stream[ISCSI_BHS_LEN * 3 + 4096];
+	uint8_t buf[4096];
+	size_t i;
+	int rc;
+
+	for (i = 0; i < sizeof(stream); i++) {
+		stream[i] = (uint8_t)i;
+	}
+
+	conn.recv_buf = malloc(ISCSI_CONN_RECV_BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(conn.recv_buf != NULL);
+	conn.recv_pipe = spdk_pipe_create(conn.recv_buf, ISCSI_CONN_RECV_BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(conn.recv_pipe != NULL);
+
+	/* Nothing is buffered yet. */
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == false);
+
+	/* Three headers arrive back-to-back. A single socket read fills the ring
+	 * and the following headers are served from it.
+	 */
+	g_sock_readv_data = stream;
+	g_sock_readv_len = ISCSI_BHS_LEN * 3;
+	g_sock_readv_calls = 0;
+
+	for (i = 0; i < 3; i++) {
+		rc = iscsi_conn_read_data(&conn, ISCSI_BHS_LEN, buf);
+		CU_ASSERT(rc == ISCSI_BHS_LEN);
+		CU_ASSERT(memcmp(buf, &stream[i * ISCSI_BHS_LEN], ISCSI_BHS_LEN) == 0);
+		CU_ASSERT(g_sock_readv_calls == 1);
+	}
+	CU_ASSERT(spdk_pipe_reader_bytes_available(conn.recv_pipe) == 0);
+
+	/* Socket has nothing more to offer. */
+	rc = iscsi_conn_read_data(&conn, ISCSI_BHS_LEN, buf);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_sock_readv_calls == 2);
+
+	/* A short read is buffered along with the beginning of a large data
+	 * segment. The rest of the data segment is read directly.
+	 */
+	g_sock_readv_data = &stream[ISCSI_BHS_LEN * 3];
+	g_sock_readv_len = 512;
+	g_sock_readv_calls = 0;
+
+	rc = iscsi_conn_read_data(&conn, 256, buf);
+	CU_ASSERT(rc == 256);
+	CU_ASSERT(memcmp(buf, &stream[ISCSI_BHS_LEN * 3], 256) == 0);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(conn.recv_pipe) == 256);
+
+	/* Buffered data that can't be processed yet doesn't keep the poller busy. */
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == false);
+	MOCK_SET(iscsi_handle_incoming_pdus, 1);
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == true);
+	MOCK_SET(iscsi_handle_incoming_pdus, -1);
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == true);
+	CU_ASSERT(conn.state == ISCSI_CONN_STATE_EXITING);
+	MOCK_CLEAR(iscsi_handle_incoming_pdus);
+	conn.state = ISCSI_CONN_STATE_INVALID;
+
+	g_sock_readv_len = 4096 - 512;
+	rc = iscsi_conn_read_data(&conn, 4096 - 256, buf);
+	CU_ASSERT(rc == 4096 - 256);
+	CU_ASSERT(memcmp(buf, &stream[ISCSI_BHS_LEN * 3 + 256], 4096 - 256) == 0);
+	CU_ASSERT(g_sock_readv_calls == 2);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(conn.recv_pipe) == 0);
+
+	spdk_pipe_destroy(conn.recv_pipe);
+	free(conn.recv_buf);
+}
+
+static void
+handle_buffered_pdus_of_exiting_conn(void)
+{
+	struct spdk_iscsi_conn conn = {};
+	uint8_t stream[ISCSI_BHS_LEN * 2];
+	uint8_t buf[ISCSI_BHS_LEN];
+	int rc;
+
+	memset(stream, 0x5A, sizeof(stream));
+
+	conn.recv_buf = malloc(ISCSI_CONN_RECV_BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(conn.recv_buf != NULL);
+	conn.recv_pipe = spdk_pipe_create(conn.recv_buf, ISCSI_CONN_RECV_BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(conn.recv_pipe != NULL);
+
+	/* The second header stays buffered in the ring. */
+	g_sock_readv_data = stream;
+	g_sock_readv_len = sizeof(stream);
+	g_sock_readv_calls = 0;
+	rc = iscsi_conn_read_data(&conn, ISCSI_BHS_LEN, buf);
+	CU_ASSERT(rc == ISCSI_BHS_LEN);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(conn.recv_pipe) == ISCSI_BHS_LEN);
+
+	/* Buffered PDUs of an exiting or exited connection are not handled, as
+	 * the connection may already have been destructed.
+	 */
+	MOCK_SET(iscsi_handle_incoming_pdus, 1);
+	conn.state = ISCSI_CONN_STATE_EXITING;
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == false);
+	conn.state = ISCSI_CONN_STATE_EXITED;
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == false);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(conn.recv_pipe) == ISCSI_BHS_LEN);
+
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+	CU_ASSERT(iscsi_conn_handle_buffered_pdus(&conn) == true);
+	MOCK_CLEAR(iscsi_handle_incoming_pdus);
+
+	spdk_pipe_destroy(conn.recv_pipe);
+	free(conn.recv_buf);
+}
+
+static void
+ut_init_data_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu, uint8_t opcode,
+		 void *data, uint32_t data_len)
+{
+	memset(pdu, 0, sizeof(*pdu));
+	pdu->conn = conn;
+	pdu->bhs.opcode = opcode;
+	pdu->data = data;
+	DSET24(pdu->bhs.data_segment_len, data_len);
+}
+
+static void
+write_pdu_data_digest_offload(void)
+{
+	struct spdk_iscsi_poll_group pg = {};
+	struct spdk_iscsi_conn conn = {};
+	struct spdk_iscsi_pdu pdu1, pdu2, pdu3;
+	uint8_t data[SPDK_ISCSI_DATA_DIGEST_OFFLOAD_MIN_LEN];
+	uint8_t digest[ISCSI_DIGEST_LEN];
+	struct iovec iov = { .iov_base = data, .iov_len = sizeof(data) };
+	int rc;
+
+	TAILQ_INIT(&conn.write_pdu_list);
+	TAILQ_INIT(&conn.snack_pdu_list);
+	TAILQ_INIT(&conn.queued_write_pdu_list);
+	TAILQ_INIT(&conn.queued_datain_tasks);
+	pg.accel_channel = (struct spdk_io_channel *)0xDEADBEEF;
+	conn.pg = &pg;
+	conn.data_digest = true;
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+
+	memset(data, 0xA5, sizeof(data));
+	MAKE_DIGEST_WORD(digest, spdk_crc32c_iov_update(&iov, 1, SPDK_CRC32C_INITIAL) ^ SPDK_CRC32C_XOR);
+	g_accel_submit_cnt = 0;
+	g_written_pdu_cnt = 0;
+
+	/* The digest of a large data segment is computed by accel. */
+	ut_init_data_pdu(&conn, &pdu1, ISCSI_OP_SCSI_DATAIN, data, sizeof(data));
+	iscsi_conn_write_pdu(&conn, &pdu1, iscsi_conn_pdu_dummy_complete, NULL);
+	CU_ASSERT(g_accel_submit_cnt == 1);
+	CU_ASSERT(pdu1.data_digest_pending == true);
+	CU_ASSERT(conn.data_digest_cnt == 1);
+	CU_ASSERT(g_written_pdu_cnt == 0);
+
+	/* A short data segment is digested inline, and neither it nor a PDU
+	 * without data may overtake the PDU whose digest is pending.
+	 */
+	ut_init_data_pdu(&conn, &pdu2, ISCSI_OP_SCSI_DATAIN, data, 512);
+	iscsi_conn_write_pdu(&conn, &pdu2, iscsi_conn_pdu_dummy_complete, NULL);
+	CU_ASSERT(g_accel_submit_cnt == 1);
+	CU_ASSERT(pdu2.data_digest_pending == false);
+	ut_init_data_pdu(&conn, &pdu3, ISCSI_OP_SCSI_RSP, NULL, 0);
+	iscsi_conn_write_pdu(&conn, &pdu3, iscsi_conn_pdu_dummy_complete, NULL);
+	CU_ASSERT(g_written_pdu_cnt == 0);
+
+	/* Completing the digest sends all of them, in order. */
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(pdu1.data_digest_pending == false);
+	CU_ASSERT(memcmp(pdu1.data_digest, digest, ISCSI_DIGEST_LEN) == 0);
+	CU_ASSERT(g_written_pdu_cnt == 3);
+	CU_ASSERT(g_written_pdus[0] == &pdu1);
+	CU_ASSERT(g_written_pdus[1] == &pdu2);
+	CU_ASSERT(g_written_pdus[2] == &pdu3);
+	CU_ASSERT(TAILQ_EMPTY(&conn.queued_write_pdu_list));
+
+	/* The digest is computed inline if it can't be submitted to accel. */
+	TAILQ_INIT(&conn.write_pdu_list);
+	g_written_pdu_cnt = 0;
+	MOCK_SET(spdk_accel_submit_crc32cv, -ENOMEM);
+	ut_init_data_pdu(&conn, &pdu1, ISCSI_OP_SCSI_DATAIN, data, sizeof(data));
+	iscsi_conn_write_pdu(&conn, &pdu1, iscsi_conn_pdu_dummy_complete, NULL);
+	MOCK_CLEAR(spdk_accel_submit_crc32cv);
+	CU_ASSERT(pdu1.data_digest_pending == false);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(g_written_pdu_cnt == 1);
+
+	/* Teardown waits for the digests still being computed by accel, and
+	 * doesn't send the PDU once the digest is done.
+	 */
+	TAILQ_INIT(&conn.write_pdu_list);
+	g_written_pdu_cnt = 0;
+	ut_init_data_pdu(&conn, &pdu1, ISCSI_OP_SCSI_DATAIN, data, sizeof(data));
+	iscsi_conn_write_pdu(&conn, &pdu1, iscsi_conn_pdu_dummy_complete, NULL);
+	ut_init_data_pdu(&conn, &pdu2, ISCSI_OP_SCSI_RSP, NULL, 0);
+	iscsi_conn_write_pdu(&conn, &pdu2, iscsi_conn_pdu_dummy_complete, NULL);
+	CU_ASSERT(conn.data_digest_cnt == 1);
+
+	conn.state = ISCSI_CONN_STATE_EXITING;
+	rc = iscsi_conn_free_tasks(&conn);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(TAILQ_FIRST(&conn.write_pdu_list) == &pdu1);
+	CU_ASSERT(TAILQ_NEXT(&pdu1, tailq) == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&conn.queued_write_pdu_list));
+
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(g_written_pdu_cnt == 0);
+
+	rc = iscsi_conn_free_tasks(&conn);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&conn.write_pdu_list));
+}
+
 int
 main(int argc, char **argv)
 {
@@ -910,6 +1186,9 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, free_tasks_with_queued_datain);
 	CU_ADD_TEST(suite, abort_queued_datain_task_test);
 	CU_ADD_TEST(suite, abort_queued_datain_tasks_test);
+	CU_ADD_TEST(suite, read_data_through_recv_ring);
+	CU_ADD_TEST(suite, handle_buffered_pdus_of_exiting_conn);
+	CU_ADD_TEST(suite, write_pdu_data_digest_offload);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -91,6 +91,23 @@ DEFINE_STUB(iscsi_chap_get_authinfo, int,
 
 DEFINE_STUB(spdk_sock_set_recvbuf, int, (struct spdk_sock *sock, int sz), 0);
 
+static spdk_accel_completion_cb g_accel_cb_fn;
+static void *g_accel_cb_arg;
+
+DEFINE_RETURN_MOCK(spdk_accel_submit_crc32cv, int);
+int
+spdk_accel_submit_crc32cv(struct spdk_io_channel *ch, uint32_t *crc_dst, struct iovec *iov,
+			  uint32_t iov_cnt, uint32_t seed, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	HANDLE_RETURN_MOCK(spdk_accel_submit_crc32cv);
+
+	*crc_dst = spdk_crc32c_iov_update(iov, iov_cnt, ~seed);
+	g_accel_cb_fn = cb_fn;
+	g_accel_cb_arg = cb_arg;
+
+	return 0;
+}
+
 int
 spdk_scsi_lun_get_id(const struct spdk_scsi_lun *lun)
 {
@@ -2149,6 +2166,145 @@ pdu_payload_read_test(void)
 	free(mobj2.buf);
 }
 
+static struct spdk_iscsi_pdu *
+ut_data_digest_pdu(struct spdk_iscsi_conn *conn, struct spdk_mobj *mobj, uint32_t data_len)
+{
+	struct spdk_iscsi_pdu *pdu;
+
+	pdu = iscsi_get_pdu(conn);
+	SPDK_CU_ASSERT_FATAL(pdu != NULL);
+
+	/* The whole data segment has been received, only the data digest is left. */
+	pdu->crc32c = SPDK_CRC32C_INITIAL;
+	pdu->data = mobj->buf;
+	pdu->data_from_mempool = true;
+	pdu->data_segment_len = data_len;
+	pdu->data_valid_bytes = data_len;
+	pdu->mobj[0] = mobj;
+	mobj->data_len = data_len;
+	/* Skip the payload handling, only the reception of the PDU is tested. */
+	pdu->is_rejected = true;
+
+	conn->pdu_in_progress = pdu;
+	conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+
+	return pdu;
+}
+
+static void
+pdu_payload_read_data_digest_offload_test(void)
+{
+	struct spdk_iscsi_poll_group pg = {};
+	struct spdk_iscsi_conn conn = {};
+	struct spdk_iscsi_pdu *pdu;
+	struct spdk_mobj mobj = {};
+	uint32_t data_len = SPDK_ISCSI_MAX_RECV_DATA_SEGMENT_LENGTH;
+	uint32_t crc32c;
+	int rc;
+
+	alloc_mock_mobj(&mobj, data_len);
+	memset(mobj.buf, 0x5A, data_len);
+	crc32c = spdk_crc32c_update(mobj.buf, data_len, SPDK_CRC32C_INITIAL) ^ SPDK_CRC32C_XOR;
+
+	pg.accel_channel = (struct spdk_io_channel *)0xDEADBEEF;
+	conn.pg = &pg;
+	conn.data_digest = true;
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+	g_conn_read_data_digest = true;
+
+	/* Case 1: the digest is verified by accel, then the PDU is handled and
+	 * reading resumes with the next PDU.
+	 */
+	pdu = ut_data_digest_pdu(&conn, &mobj, data_len);
+	g_data_digest = crc32c;
+	g_accel_cb_fn = NULL;
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+	CU_ASSERT(conn.data_digest_cnt == 1);
+	CU_ASSERT(pdu->ref == 2);
+	SPDK_CU_ASSERT_FATAL(g_accel_cb_fn != NULL);
+
+	/* Nothing more is read from the connection while the digest is pending. */
+	rc = iscsi_handle_incoming_pdus(&conn);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(conn.pdu_in_progress == pdu);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(conn.state == ISCSI_CONN_STATE_RUNNING);
+	/* The next PDU got the first bytes of its header. */
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_PDU_HDR);
+	SPDK_CU_ASSERT_FATAL(conn.pdu_in_progress != NULL);
+	CU_ASSERT(conn.pdu_in_progress->bhs_valid_bytes == ISCSI_DIGEST_LEN);
+	iscsi_put_pdu(conn.pdu_in_progress);
+
+	/* Case 2: a digest mismatch fails the connection. */
+	pdu = ut_data_digest_pdu(&conn, &mobj, data_len);
+	g_data_digest = ~crc32c;
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_ERROR);
+	CU_ASSERT(conn.state == ISCSI_CONN_STATE_EXITING);
+	CU_ASSERT(conn.pdu_in_progress == pdu);
+	CU_ASSERT(pdu->ref == 1);
+	iscsi_put_pdu(pdu);
+
+	/* Case 3: an accel failure fails the connection as well. */
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+	pdu = ut_data_digest_pdu(&conn, &mobj, data_len);
+	g_data_digest = crc32c;
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 0);
+	g_accel_cb_fn(g_accel_cb_arg, -EIO);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_ERROR);
+	CU_ASSERT(conn.state == ISCSI_CONN_STATE_EXITING);
+	iscsi_put_pdu(pdu);
+
+	/* Case 4: the connection is torn down while the digest is pending. The
+	 * PDU stays valid until accel completes and is freed then.
+	 */
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+	pdu = ut_data_digest_pdu(&conn, &mobj, data_len);
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(conn.data_digest_cnt == 1);
+	conn.state = ISCSI_CONN_STATE_EXITING;
+	iscsi_put_pdu(pdu);
+	CU_ASSERT(pdu->ref == 1);
+
+	g_accel_cb_fn(g_accel_cb_arg, 0);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_DATA_DIGEST);
+
+	/* Case 5: short data segments are verified inline. */
+	conn.state = ISCSI_CONN_STATE_RUNNING;
+	data_len = SPDK_ISCSI_DATA_DIGEST_OFFLOAD_MIN_LEN - ISCSI_ALIGNMENT;
+	pdu = ut_data_digest_pdu(&conn, &mobj, data_len);
+	g_data_digest = spdk_crc32c_update(mobj.buf, data_len, SPDK_CRC32C_INITIAL) ^ SPDK_CRC32C_XOR;
+	g_accel_cb_fn = NULL;
+
+	rc = iscsi_read_pdu(&conn);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(g_accel_cb_fn == NULL);
+	CU_ASSERT(conn.data_digest_cnt == 0);
+	CU_ASSERT(conn.pdu_in_progress == NULL);
+	CU_ASSERT(conn.pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY);
+
+	g_conn_read_data_digest = false;
+	g_conn_read_len = 0;
+	free(mobj.buf);
+}
+
 static void
 check_pdu_hdr_handle(struct spdk_iscsi_pdu *pdu, struct spdk_mobj *mobj, uint32_t offset,
 		     struct spdk_iscsi_task *primary)
@@ -2617,6 +2773,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, pdu_hdr_op_data_test);
 	CU_ADD_TEST(suite, empty_text_with_cbit_test);
 	CU_ADD_TEST(suite, pdu_payload_read_test);
+	CU_ADD_TEST(suite, pdu_payload_read_data_digest_offload_test);
 	CU_ADD_TEST(suite, data_out_pdu_sequence_test);
 	CU_ADD_TEST(suite, immediate_data_and_data_out_pdu_sequence_test);
 
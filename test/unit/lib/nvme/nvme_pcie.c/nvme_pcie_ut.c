@@ -143,6 +143,10 @@ test_prp_list_append(void)
 	struct nvme_request req;
 	struct nvme_tracker tr;
 	struct spdk_nvme_ctrlr ctrlr = {};
+	struct spdk_nvme_qpair qpair = {};
+	struct spdk_nvme_ns_cmd_ext_io_opts opts = {};
+	struct nvme_buf_region region = {};
+	uint64_t region_phys = 0x800000;
 	uint32_t prp_index;
 
 	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
@@ -278,6 +282,26 @@ test_prp_list_append(void)
 	prp_list_prep(&tr, &req, &prp_index);
 	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x100800,
 					    (NVME_MAX_PRP_LIST_ENTRIES + 1) * 0x1000, 0x1000) == -EFAULT);
+
+	/* Buffer within a registered region is translated without the memory map */
+	qpair.buf_regions = &region;
+	qpair.num_buf_regions = 1;
+	region.vaddr = 0x100000;
+	region.len = 0x2000;
+	region.phys = &region_phys;
+	opts.size = sizeof(opts);
+	opts.buf_handle = 1;
+	MOCK_SET(spdk_vtophys, 0x700000);
+	prp_list_prep(&tr, &req, &prp_index);
+	req.qpair = &qpair;
+	req.payload.opts = &opts;
+	CU_ASSERT(nvme_pcie_prp_list_append(&ctrlr, &tr, &prp_index, (void *)0x101000, 0x2000,
+					    0x1000) == 0);
+	CU_ASSERT(prp_index == 2);
+	CU_ASSERT(req.cmd.dptr.prp.prp1 == 0x901000);
+	/* The part outside of the region falls back to the memory map */
+	CU_ASSERT(req.cmd.dptr.prp.prp2 == 0x700000);
+	MOCK_CLEAR(spdk_vtophys);
 }
 
 struct spdk_event_entry {
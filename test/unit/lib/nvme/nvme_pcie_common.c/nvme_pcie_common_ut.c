@@ -579,6 +579,96 @@ test_nvme_pcie_poll_group_get_stats(void)
 	CU_ASSERT(rc == 0);
 }
 
+static void
+ut_disconnected_qpair_cb(struct spdk_nvme_qpair *qpair, void *poll_group_ctx)
+{
+}
+
+static void
+test_nvme_pcie_poll_group_doorbells(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair = {};
+	struct nvme_pcie_poll_group *pgroup;
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct spdk_nvme_poll_group group = {};
+	struct spdk_nvme_cmd cmd[8] = {};
+	struct nvme_request req = {};
+	struct nvme_tracker tr = {};
+	uint32_t sq_tdbl = 0, cq_hdbl = 0;
+	int64_t rc;
+
+	tgroup = nvme_pcie_poll_group_create();
+	SPDK_CU_ASSERT_FATAL(tgroup != NULL);
+	pgroup = SPDK_CONTAINEROF(tgroup, struct nvme_pcie_poll_group, group);
+	STAILQ_INIT(&tgroup->connected_qpairs);
+	STAILQ_INIT(&tgroup->disconnected_qpairs);
+	tgroup->group = &group;
+
+	pqpair.qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair.qpair.poll_group = tgroup;
+	pqpair.stat = &pgroup->stats;
+	pqpair.cmd = cmd;
+	pqpair.num_entries = SPDK_COUNTOF(cmd);
+	pqpair.sq_tdbl = &sq_tdbl;
+	pqpair.cq_hdbl = &cq_hdbl;
+	pqpair.qpair.poll_group_tailq_head = &tgroup->connected_qpairs;
+	STAILQ_INSERT_TAIL(&tgroup->connected_qpairs, &pqpair.qpair, poll_group_stailq);
+	tr.req = &req;
+
+	/* Outside of the poll group's completion processing, the doorbell is rung right away */
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(sq_tdbl == 1);
+	CU_ASSERT(pqpair.last_sq_tail == 1);
+	CU_ASSERT(pgroup->stats.sq_mmio_doorbell_updates == 1);
+	CU_ASSERT(STAILQ_EMPTY(&pgroup->doorbell_qpairs));
+
+	/* While the group is processing completions, the doorbell writes are deferred */
+	pgroup->batch_doorbells = true;
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(sq_tdbl == 1);
+	CU_ASSERT(pqpair.sq_tail == 3);
+	CU_ASSERT(pqpair.flags.doorbell_pending == 1);
+	CU_ASSERT(STAILQ_FIRST(&pgroup->doorbell_qpairs) == &pqpair);
+	CU_ASSERT(STAILQ_NEXT(&pqpair, doorbell_stailq) == NULL);
+
+	/* Both doorbells are written once at the end of the poll */
+	pqpair.cq_head = 2;
+	pqpair.flags.cq_doorbell_pending = 1;
+	rc = nvme_pcie_poll_group_process_completions(tgroup, 0, ut_disconnected_qpair_cb);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pgroup->batch_doorbells == false);
+	CU_ASSERT(sq_tdbl == 3);
+	CU_ASSERT(cq_hdbl == 2);
+	CU_ASSERT(pgroup->stats.sq_mmio_doorbell_updates == 2);
+	CU_ASSERT(pgroup->stats.cq_mmio_doorbell_updates == 1);
+	CU_ASSERT(pqpair.flags.doorbell_pending == 0);
+	CU_ASSERT(pqpair.flags.cq_doorbell_pending == 0);
+	CU_ASSERT(STAILQ_EMPTY(&pgroup->doorbell_qpairs));
+
+	/* Nothing is written if there's nothing new to report */
+	rc = nvme_pcie_poll_group_process_completions(tgroup, 0, ut_disconnected_qpair_cb);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pgroup->stats.sq_mmio_doorbell_updates == 2);
+	CU_ASSERT(pgroup->stats.cq_mmio_doorbell_updates == 1);
+
+	/* Deferred doorbells of a disconnected qpair are dropped */
+	pgroup->batch_doorbells = true;
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(pqpair.flags.doorbell_pending == 1);
+	rc = nvme_pcie_poll_group_disconnect_qpair(&pqpair.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pqpair.flags.doorbell_pending == 0);
+	CU_ASSERT(STAILQ_EMPTY(&pgroup->doorbell_qpairs));
+	pgroup->batch_doorbells = false;
+	CU_ASSERT(sq_tdbl == 3);
+
+	STAILQ_REMOVE(&tgroup->connected_qpairs, &pqpair.qpair, spdk_nvme_qpair, poll_group_stailq);
+	rc = nvme_pcie_poll_group_destroy(tgroup);
+	CU_ASSERT(rc == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -595,6 +685,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_construct_admin_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_poll_group_get_stats);
+	CU_ADD_TEST(suite, test_nvme_pcie_poll_group_doorbells);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -744,6 +744,93 @@ test_nvme_qpair_init_deinit(void)
 	CU_ASSERT(qpair.num_outstanding_reqs == 0);
 }
 
+static void
+test_nvme_qpair_register_buffer(void)
+{
+	struct spdk_nvme_qpair qpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct nvme_request req = {};
+	struct spdk_nvme_ns_cmd_ext_io_opts opts = {};
+	const struct nvme_buf_region *region;
+	void *buf = (void *)(0x200000 + 0x1000);
+	uint32_t handle, handle2;
+	uint64_t phys_addr, size;
+	int rc;
+
+	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	rc = nvme_qpair_init(&qpair, 1, &ctrlr, SPDK_NVME_QPRIO_HIGH, 1, false);
+	CU_ASSERT(rc == 0);
+
+	/* A region spanning two 2MB pages */
+	rc = spdk_nvme_qpair_register_buffer(&qpair, buf, 0x300000, &handle);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(handle == 1);
+	SPDK_CU_ASSERT_FATAL(qpair.num_buf_regions == 1);
+	CU_ASSERT(qpair.buf_regions[0].phys[0] == 0x200000);
+	CU_ASSERT(qpair.buf_regions[0].phys[1] == 0x400000);
+
+	/* The region is only used if the request refers to it */
+	req.qpair = &qpair;
+	CU_ASSERT(nvme_request_get_buf_region(&req) == NULL);
+	req.payload.opts = &opts;
+	opts.size = offsetof(struct spdk_nvme_ns_cmd_ext_io_opts, buf_handle);
+	opts.buf_handle = handle;
+	CU_ASSERT(nvme_request_get_buf_region(&req) == NULL);
+	opts.size = sizeof(opts);
+	region = nvme_request_get_buf_region(&req);
+	CU_ASSERT(region == &qpair.buf_regions[0]);
+	opts.buf_handle = 2;
+	CU_ASSERT(nvme_request_get_buf_region(&req) == NULL);
+
+	/* Physically contiguous pages are merged, the length is limited to the region */
+	size = 0x2000;
+	phys_addr = nvme_buf_region_translate(region, (void *)0x3ff000, &size);
+	CU_ASSERT(phys_addr == 0x3ff000);
+	CU_ASSERT(size == 0x2000);
+	size = 0x200000;
+	phys_addr = nvme_buf_region_translate(region, (void *)0x4ff000, &size);
+	CU_ASSERT(phys_addr == 0x4ff000);
+	CU_ASSERT(size == 0x2000);
+	CU_ASSERT(nvme_buf_region_translate(region, (void *)0x200000, NULL) == SPDK_VTOPHYS_ERROR);
+	CU_ASSERT(nvme_buf_region_translate(region, (void *)0x501000, NULL) == SPDK_VTOPHYS_ERROR);
+
+	/* Non-contiguous pages aren't */
+	qpair.buf_regions[0].phys[1] = 0x800000;
+	size = 0x2000;
+	phys_addr = nvme_buf_region_translate(region, (void *)0x3ff000, &size);
+	CU_ASSERT(phys_addr == 0x3ff000);
+	CU_ASSERT(size == 0x1000);
+	phys_addr = nvme_buf_region_translate(region, (void *)0x400800, &size);
+	CU_ASSERT(phys_addr == 0x800800);
+
+	/* Slots of unregistered regions are reused */
+	rc = spdk_nvme_qpair_register_buffer(&qpair, buf, 0x1000, &handle2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(handle2 == 2);
+	rc = spdk_nvme_qpair_unregister_buffer(&qpair, handle);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvme_qpair_unregister_buffer(&qpair, handle);
+	CU_ASSERT(rc == -ENOENT);
+	rc = spdk_nvme_qpair_unregister_buffer(&qpair, 3);
+	CU_ASSERT(rc == -ENOENT);
+	opts.buf_handle = handle;
+	CU_ASSERT(nvme_request_get_buf_region(&req) == NULL);
+	rc = spdk_nvme_qpair_register_buffer(&qpair, buf, 0x1000, &handle);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(handle == 1);
+	CU_ASSERT(qpair.num_buf_regions == 2);
+
+	/* Memory that can't be translated can't be registered */
+	MOCK_SET(spdk_vtophys, SPDK_VTOPHYS_ERROR);
+	rc = spdk_nvme_qpair_register_buffer(&qpair, buf, 0x1000, &handle);
+	CU_ASSERT(rc == -EINVAL);
+	MOCK_CLEAR(spdk_vtophys);
+
+	nvme_qpair_deinit(&qpair);
+	CU_ASSERT(qpair.buf_regions == NULL);
+	CU_ASSERT(qpair.num_buf_regions == 0);
+}
+
 static void
 test_nvme_get_sgl_print_info(void)
 {
@@ -809,6 +896,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_qpair_manual_complete_request);
 	CU_ADD_TEST(suite, test_nvme_qpair_init_deinit);
 	CU_ADD_TEST(suite, test_nvme_get_sgl_print_info);
+	CU_ADD_TEST(suite, test_nvme_qpair_register_buffer);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -1455,6 +1455,7 @@ test_reservation_write_exclusive(void)
 	/* Host A holds reservation with type SPDK_NVME_RESERVE_WRITE_EXCLUSIVE */
 	ut_reservation_init(SPDK_NVME_RESERVE_WRITE_EXCLUSIVE);
 	g_ns_info.holder_id = g_ctrlr1_A.hostid;
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Issue a Read command from Host A and Host B */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
@@ -1484,6 +1485,7 @@ test_reservation_write_exclusive(void)
 
 	/* Unregister Host C */
 	memset(&g_ns_info.reg_hostid[2], 0, sizeof(struct spdk_uuid));
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Read and Write commands from non-registrant Host C */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
@@ -1509,6 +1511,7 @@ test_reservation_exclusive_access(void)
 	/* Host A holds reservation with type SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS */
 	ut_reservation_init(SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS);
 	g_ns_info.holder_id = g_ctrlr1_A.hostid;
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Issue a Read command from Host B */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
@@ -1536,6 +1539,7 @@ _test_reservation_write_exclusive_regs_only_and_all_regs(enum spdk_nvme_reservat
 	/* SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_REG_ONLY and SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_ALL_REGS */
 	ut_reservation_init(rtype);
 	g_ns_info.holder_id = g_ctrlr1_A.hostid;
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Issue a Read command from Host A and Host C */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
@@ -1553,6 +1557,7 @@ _test_reservation_write_exclusive_regs_only_and_all_regs(enum spdk_nvme_reservat
 
 	/* Unregister Host C */
 	memset(&g_ns_info.reg_hostid[2], 0, sizeof(struct spdk_uuid));
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Read and Write commands from non-registrant Host C */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
@@ -1587,6 +1592,7 @@ _test_reservation_exclusive_access_regs_only_and_all_regs(enum spdk_nvme_reserva
 	/* SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_REG_ONLY and SPDK_NVME_RESERVE_EXCLUSIVE_ACCESS_ALL_REGS */
 	ut_reservation_init(rtype);
 	g_ns_info.holder_id = g_ctrlr1_A.hostid;
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Issue a Write command from Host B */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
@@ -1595,6 +1601,7 @@ _test_reservation_exclusive_access_regs_only_and_all_regs(enum spdk_nvme_reserva
 
 	/* Unregister Host B */
 	memset(&g_ns_info.reg_hostid[1], 0, sizeof(struct spdk_uuid));
+	nvmf_ns_info_update_reservation_access(&g_ns_info);
 
 	/* Test Case: Issue a Read command from Host B */
 	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
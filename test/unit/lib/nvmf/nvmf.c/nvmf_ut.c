@@ -22,6 +22,8 @@ DEFINE_STUB(nvmf_transport_poll_group_create, struct spdk_nvmf_transport_poll_gr
 DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *, (struct spdk_bdev_desc *desc),
 	    NULL);
 DEFINE_STUB(nvmf_ctrlr_async_event_ns_notice, int, (struct spdk_nvmf_ctrlr *ctrlr), 0);
+DEFINE_STUB_V(nvmf_ns_info_update_reservation_access,
+	      (struct spdk_nvmf_subsystem_pg_ns_info *ns_info));
 DEFINE_STUB(nvmf_ctrlr_async_event_ana_change_notice, int,
 	    (struct spdk_nvmf_ctrlr *ctrlr), 0);
 DEFINE_STUB(nvmf_transport_poll_group_remove, int, (struct spdk_nvmf_transport_poll_group *group,
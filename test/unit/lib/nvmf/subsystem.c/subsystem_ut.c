@@ -69,6 +69,8 @@ DEFINE_STUB(nvmf_ctrlr_async_event_ana_change_notice,
 	    int,
 	    (struct spdk_nvmf_ctrlr *ctrlr), 0);
 
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
+
 DEFINE_STUB(spdk_nvme_transport_id_trtype_str,
 	    const char *,
 	    (enum spdk_nvme_transport_type trtype), NULL);
@@ -558,6 +560,29 @@ ut_reservation_init(void)
 	TAILQ_INSERT_TAIL(&g_subsystem.ctrlrs, &g_ctrlr_C, link);
 }
 
+static void
+ut_reservation_persist_done(void *cb_arg, int status)
+{
+	int *rc = cb_arg;
+
+	*rc = status;
+}
+
+/* Save g_ns reservation information to its PTPL file and wait for the write */
+static void
+ut_reservation_persist(void)
+{
+	int status = 1;
+	int rc;
+
+	rc = nvmf_ns_update_reservation_info(&g_ns, ut_reservation_persist_done, &status);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	while (status == 1) {
+		poll_threads();
+	}
+	SPDK_CU_ASSERT_FATAL(status == 0);
+}
+
 static void
 ut_reservation_deinit(void)
 {
@@ -565,6 +590,7 @@ ut_reservation_deinit(void)
 	struct spdk_nvmf_reservation_log *log, *log_tmp;
 	struct spdk_nvmf_ctrlr *ctrlr, *ctrlr_tmp;
 
+	nvmf_ns_ptpl_queue_release(&g_ns);
 	TAILQ_FOREACH_SAFE(reg, &g_ns.registrants, link, tmp) {
 		TAILQ_REMOVE(&g_ns.registrants, reg, link);
 		free(reg);
@@ -868,6 +894,7 @@ test_reservation_register_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
 	/* Load reservation information from configuration file */
+	ut_reservation_persist();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -881,6 +908,7 @@ test_reservation_register_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
 	SPDK_CU_ASSERT_FATAL(g_ns.ptpl_activated == false);
+	ut_reservation_persist();
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc < 0);
 	unlink(g_ns.ptpl_file);
@@ -989,6 +1017,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
 	/* Load reservation information from configuration file */
+	ut_reservation_persist();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -1001,6 +1030,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_acquire(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	ut_reservation_persist();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -1017,6 +1047,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_release(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	ut_reservation_persist();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
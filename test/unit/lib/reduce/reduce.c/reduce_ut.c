@@ -16,8 +16,6 @@
 
 static struct spdk_reduce_vol *g_vol;
 static int g_reduce_errno;
-static char *g_volatile_pm_buf;
-static size_t g_volatile_pm_buf_len;
 static char *g_persistent_pm_buf;
 static size_t g_persistent_pm_buf_len;
 static char *g_backing_dev_buf;
@@ -66,6 +64,11 @@ static TAILQ_HEAD(, ut_reduce_bdev_io) g_pending_bdev_io =
 	TAILQ_HEAD_INITIALIZER(g_pending_bdev_io);
 static uint32_t g_pending_bdev_io_count = 0;
 
+/* Persistent memory file volumes can only be tested when libreduce is built with libpmem. */
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
+static char *g_volatile_pm_buf;
+static size_t g_volatile_pm_buf_len;
+
 static void
 sync_pm_buf(const void *addr, size_t length)
 {
@@ -86,6 +89,7 @@ pmem_persist(const void *addr, size_t len)
 {
 	sync_pm_buf(addr, len);
 }
+#endif
 
 static void
 get_pm_file_size(void)
@@ -125,6 +129,7 @@ get_vol_size(void)
 	CU_ASSERT(_get_vol_size(chunk_size, backing_dev_size) < backing_dev_size);
 }
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 void *
 pmem_map_file(const char *path, size_t len, int flags, mode_t mode,
 	      size_t *mapped_lenp, int *is_pmemp)
@@ -159,6 +164,7 @@ pmem_unmap(void *addr, size_t len)
 
 	return 0;
 }
+#endif
 
 static void
 persistent_pm_buf_destroy(void)
@@ -340,6 +346,7 @@ backing_dev_unmap(struct spdk_reduce_backing_dev *backing_dev,
 	backing_dev_insert_io(UT_REDUCE_IO_UNMAP, backing_dev, NULL, 0, lba, lba_count, args);
 }
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 static void
 backing_dev_io_execute(uint32_t count)
 {
@@ -377,6 +384,7 @@ backing_dev_io_execute(uint32_t count)
 		done++;
 	}
 }
+#endif
 
 static int
 ut_compress(char *outbuf, uint32_t *compressed_len, char *inbuf, uint32_t inbuflen)
@@ -548,6 +556,7 @@ backing_dev_init(struct spdk_reduce_backing_dev *backing_dev, struct spdk_reduce
 	SPDK_CU_ASSERT_FATAL(g_backing_dev_buf != NULL);
 }
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 static void
 init_md(void)
 {
@@ -705,6 +714,7 @@ _vol_get_chunk_map_index(struct spdk_reduce_vol *vol, uint64_t offset)
 
 	return vol->pm_logical_map[logical_map_index];
 }
+#endif
 
 static void
 write_cb(void *arg, int reduce_errno)
@@ -718,6 +728,7 @@ read_cb(void *arg, int reduce_errno)
 	g_reduce_errno = reduce_errno;
 }
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 static void
 _write_maps(uint32_t backing_blocklen)
 {
@@ -1015,6 +1026,7 @@ readv_writev(void)
 	_readv_writev(512);
 	_readv_writev(4096);
 }
+#endif
 
 static void
 destroy_cb(void *ctx, int reduce_errno)
@@ -1022,6 +1034,7 @@ destroy_cb(void *ctx, int reduce_errno)
 	g_reduce_errno = reduce_errno;
 }
 
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 static void
 destroy(void)
 {
@@ -1067,11 +1080,392 @@ destroy(void)
 
 	backing_dev_destroy(&backing_dev);
 }
+#endif
+
+static void
+_backing_md_write_chunk(uint64_t offset, uint8_t pattern)
+{
+	struct iovec iov;
+	char buf[16 * 1024];
+
+	memset(buf, pattern, sizeof(buf));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, offset, sizeof(buf) / 512, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+}
+
+static void
+_backing_md_check_chunk(uint64_t offset, uint8_t pattern)
+{
+	struct iovec iov;
+	char buf[16 * 1024];
+	char compare_buf[16 * 1024];
+
+	memset(buf, 0xFF, sizeof(buf));
+	memset(compare_buf, pattern, sizeof(compare_buf));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, offset, sizeof(buf) / 512, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, sizeof(buf)) == 0);
+}
+
+static void
+_backing_md(uint32_t backing_blocklen)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	char *backing_dev_snapshot;
+	uint64_t backing_dev_size = 4 * 1024 * 1024;
+	uint32_t i;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, backing_blocklen);
+
+	/* No pm file directory - metadata is kept on the backing device. */
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, NULL, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_persistent_pm_buf == NULL);
+	CU_ASSERT(g_vol->backing_md.enabled == true);
+	CU_ASSERT(g_vol->params.vol_size + _get_backing_md_size(&g_vol->params) < backing_dev_size);
+	/* An empty path is persisted, followed by the metadata image. */
+	CU_ASSERT(g_backing_dev_buf[REDUCE_BACKING_DEV_PATH_OFFSET] == '\0');
+	CU_ASSERT(memcmp(g_backing_dev_buf + REDUCE_BACKING_DEV_MD_OFFSET,
+			 SPDK_REDUCE_SIGNATURE, 8) == 0);
+	/* The metadata io units must never be handed out for data. */
+	for (i = 0; i < _get_backing_md_size(&g_vol->params) / params.backing_io_unit_size; i++) {
+		CU_ASSERT(spdk_bit_array_get(g_vol->allocated_backing_io_units, i) == true);
+	}
+
+	/* Overwrite the first chunk enough times to wrap the journal, which forces a
+	 *  write-back of the metadata image.
+	 */
+	for (i = 0; i < REDUCE_MD_JOURNAL_NUM_BLOCKS + 10; i++) {
+		_backing_md_write_chunk(0, (uint8_t)i);
+	}
+	CU_ASSERT(g_vol->backing_md.next_seq == 10);
+	_backing_md_write_chunk(32, 0xBB);
+	_backing_md_check_chunk(0, (uint8_t)(i - 1));
+	_backing_md_check_chunk(32, 0xBB);
+
+	/* Simulate a crash: load from a copy of the backing device taken without unloading,
+	 *  the journal needs to be replayed.
+	 */
+	backing_dev_snapshot = malloc(backing_dev_size);
+	SPDK_CU_ASSERT_FATAL(backing_dev_snapshot != NULL);
+	memcpy(backing_dev_snapshot, g_backing_dev_buf, backing_dev_size);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	memcpy(g_backing_dev_buf, backing_dev_snapshot, backing_dev_size);
+	free(backing_dev_snapshot);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->backing_md.next_seq == 11);
+	CU_ASSERT(g_vol->params.vol_size == params.vol_size);
+	_backing_md_check_chunk(0, (uint8_t)(i - 1));
+	_backing_md_check_chunk(32, 0xBB);
+
+	/* A clean unload writes back the metadata and leaves nothing to replay. */
+	_backing_md_write_chunk(64, 0xCC);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->backing_md.next_seq == 0);
+	_backing_md_check_chunk(0, (uint8_t)(i - 1));
+	_backing_md_check_chunk(32, 0xBB);
+	_backing_md_check_chunk(64, 0xCC);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	/* There is no pm file to unlink on destroy. */
+	g_reduce_errno = -1;
+	spdk_reduce_vol_destroy(&backing_dev, destroy_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_persistent_pm_buf == NULL);
+
+	g_reduce_errno = 0;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == -EILSEQ);
+
+	backing_dev_destroy(&backing_dev);
+}
+
+static void
+backing_md(void)
+{
+	_backing_md(512);
+	_backing_md(4096);
+}
+
+static void
+backing_md_io_buf(void)
+{
+	struct spdk_reduce_vol *vol;
+	struct spdk_reduce_backing_md *md;
+	uint32_t i;
+
+	vol = calloc(1, sizeof(*vol));
+	SPDK_CU_ASSERT_FATAL(vol != NULL);
+	md = &vol->backing_md;
+	vol->params.chunk_size = 16 * 1024;
+	vol->params.backing_io_unit_size = 4096;
+	vol->params.logical_block_size = 512;
+	vol->backing_io_units_per_chunk = vol->params.chunk_size / vol->params.backing_io_unit_size;
+
+	/* A small image is staged through a buffer of its own size, by a single writer. */
+	vol->params.vol_size = 100 * vol->params.chunk_size;
+	CU_ASSERT(_allocate_backing_md(vol) == 0);
+	CU_ASSERT(md->image_size < REDUCE_MD_IO_BUF_MAX_SIZE);
+	CU_ASSERT(md->io_buf_size == md->image_size);
+	CU_ASSERT(md->writer_max_pages == md->image_size / REDUCE_MD_PAGE_SIZE);
+	CU_ASSERT(md->num_writers == 1);
+	CU_ASSERT(md->writers[0].buf == md->io_buf);
+	_free_backing_md(vol);
+
+	/* The bounce buffer of a large image only covers the pages written back at once. */
+	vol->params.vol_size = 256ULL * 1024 * vol->params.chunk_size;
+	CU_ASSERT(_allocate_backing_md(vol) == 0);
+	CU_ASSERT(md->image_size > REDUCE_MD_IO_BUF_MAX_SIZE);
+	CU_ASSERT(md->io_buf_size == REDUCE_MD_IO_BUF_MAX_SIZE);
+	CU_ASSERT(md->writer_max_pages == REDUCE_MD_WRITEBACK_MAX_PAGES);
+	CU_ASSERT(md->num_writers == REDUCE_MD_WRITEBACK_QD);
+	for (i = 0; i < md->num_writers; i++) {
+		CU_ASSERT(md->writers[i].buf + md->writer_max_pages * REDUCE_MD_PAGE_SIZE <=
+			  md->io_buf + md->io_buf_size);
+	}
+	_free_backing_md(vol);
+
+	free(vol);
+}
+
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
+static void
+_packed_layout_write_buf(uint64_t chunk, uint8_t *buf, uint32_t len)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, chunk * 32, len / 512, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+}
+
+static void
+_packed_layout_check_buf(uint64_t chunk, uint8_t *compare_buf, uint32_t len)
+{
+	struct iovec iov;
+	uint8_t buf[16 * 1024];
+
+	memset(buf, 0xFF, sizeof(buf));
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, chunk * 32, len / 512, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, len) == 0);
+}
+
+static void
+packed_layout(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct spdk_reduce_chunk_map *chunk;
+	uint8_t multi_piece_buf[16 * 1024], uncompressed_buf[16 * 1024];
+	uint64_t used_blocks, sparse_io_units;
+	uint32_t i, first_block;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	params.chunk_layout = SPDK_REDUCE_CHUNK_LAYOUT_PACKED;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->params.chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED);
+	first_block = g_vol->pack.alloc_cursor;
+	CU_ASSERT(first_block % g_vol->backing_lba_per_io_unit == 0);
+	used_blocks = spdk_bit_array_count_set(g_vol->allocated_backing_io_units);
+	CU_ASSERT(used_blocks == first_block);
+
+	/* Each of these chunks compresses into a single 512B block, 8 of them share one
+	 *  io unit instead of taking one io unit each.
+	 */
+	for (i = 0; i < 8; i++) {
+		_backing_md_write_chunk(i * 32, (uint8_t)i);
+	}
+	CU_ASSERT(spdk_bit_array_count_set(g_vol->allocated_backing_io_units) == used_blocks + 8);
+	CU_ASSERT(g_vol->pack.io_unit_used_blocks[first_block / g_vol->backing_lba_per_io_unit] == 8);
+	CU_ASSERT(g_vol->pack.sparse_io_units == 0);
+
+	/* 8KiB compressed: two pieces, adjacent on the backing device. */
+	ut_build_data_buffer(multi_piece_buf, sizeof(multi_piece_buf), 0x10, 4);
+	_packed_layout_write_buf(8, multi_piece_buf, sizeof(multi_piece_buf));
+	chunk = _reduce_vol_get_chunk_map(g_vol, g_vol->pm_logical_map[8]);
+	CU_ASSERT(chunk->compressed_size == 8192);
+	CU_ASSERT(chunk->io_unit_index[1] == chunk->io_unit_index[0] + 8);
+	CU_ASSERT(chunk->io_unit_index[2] == REDUCE_EMPTY_MAP_ENTRY);
+
+	/* Data that does not compress is stored as is. */
+	ut_build_data_buffer(uncompressed_buf, sizeof(uncompressed_buf), 0x20, 1);
+	_packed_layout_write_buf(9, uncompressed_buf, sizeof(uncompressed_buf));
+	chunk = _reduce_vol_get_chunk_map(g_vol, g_vol->pm_logical_map[9]);
+	CU_ASSERT(chunk->compressed_size == params.chunk_size);
+	CU_ASSERT(chunk->io_unit_index[3] != REDUCE_EMPTY_MAP_ENTRY);
+	used_blocks = spdk_bit_array_count_set(g_vol->allocated_backing_io_units);
+
+	for (i = 0; i < 8; i++) {
+		_backing_md_check_chunk(i * 32, (uint8_t)i);
+	}
+	_packed_layout_check_buf(8, multi_piece_buf, sizeof(multi_piece_buf));
+	_packed_layout_check_buf(9, uncompressed_buf, sizeof(uncompressed_buf));
+
+	/* The block allocation is rebuilt from the chunk maps on load. */
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->params.chunk_layout == SPDK_REDUCE_CHUNK_LAYOUT_PACKED);
+	CU_ASSERT(spdk_bit_array_count_set(g_vol->allocated_backing_io_units) == used_blocks);
+	CU_ASSERT(g_vol->pack.io_unit_used_blocks[first_block / g_vol->backing_lba_per_io_unit] == 8);
+	for (i = 0; i < 8; i++) {
+		_backing_md_check_chunk(i * 32, (uint8_t)i);
+	}
+	_packed_layout_check_buf(8, multi_piece_buf, sizeof(multi_piece_buf));
+	_packed_layout_check_buf(9, uncompressed_buf, sizeof(uncompressed_buf));
+
+	/* Fill io units with single block chunks, then overwrite most of the chunks in each io
+	 *  unit.  The io units left behind become sparse and get compacted.
+	 */
+	for (i = 0; i < 128; i++) {
+		_backing_md_write_chunk(i * 32, (uint8_t)i);
+	}
+	CU_ASSERT(g_vol->pack.compacted_chunks == 0);
+	for (i = 0; i < 128; i++) {
+		if (i % 8 < 5) {
+			_backing_md_write_chunk(i * 32, (uint8_t)(i + 0x80));
+		}
+	}
+	CU_ASSERT(g_vol->pack.compacted_chunks > 0);
+	CU_ASSERT(g_vol->pack.compact_in_progress == false);
+	CU_ASSERT(g_vol->pack.sparse_io_units < REDUCE_COMPACT_SPARSE_IO_UNITS);
+	CU_ASSERT(TAILQ_EMPTY(&g_vol->executing_requests));
+	for (i = 0; i < 128; i++) {
+		_backing_md_check_chunk(i * 32, (uint8_t)(i % 8 < 5 ? i + 0x80 : i));
+	}
+
+	used_blocks = spdk_bit_array_count_set(g_vol->allocated_backing_io_units);
+	sparse_io_units = g_vol->pack.sparse_io_units;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(spdk_bit_array_count_set(g_vol->allocated_backing_io_units) == used_blocks);
+	CU_ASSERT(g_vol->pack.sparse_io_units == sparse_io_units);
+	for (i = 0; i < 128; i++) {
+		_backing_md_check_chunk(i * 32, (uint8_t)(i % 8 < 5 ? i + 0x80 : i));
+	}
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+#endif
 
 /* This test primarily checks that the reduce unit test infrastructure for asynchronous
  * backing device I/O operations is working correctly.
  */
 static void
+packed_layout_size_limit(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	uint64_t max_chunks;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	params.chunk_layout = SPDK_REDUCE_CHUNK_LAYOUT_PACKED;
+
+	/* 32 backing blocks of 512B per chunk, the last volume size that fits in 32-bit
+	 *  block indices and the first one that does not.
+	 */
+	max_chunks = UINT32_MAX / 32;
+	params.vol_size = (max_chunks - REDUCE_NUM_EXTRA_CHUNKS) * params.chunk_size;
+	CU_ASSERT(_check_backing_bit_count(&params, 512, false) == 0);
+	params.vol_size += params.chunk_size;
+	CU_ASSERT(_check_backing_bit_count(&params, 512, false) == -EINVAL);
+
+	/* The same volume tracks 8 times fewer io units without packing */
+	params.chunk_layout = SPDK_REDUCE_CHUNK_LAYOUT_IO_UNIT;
+	CU_ASSERT(_check_backing_bit_count(&params, 512, false) == 0);
+
+	/* Larger backing blocks move the limit up */
+	params.chunk_layout = SPDK_REDUCE_CHUNK_LAYOUT_PACKED;
+	CU_ASSERT(_check_backing_bit_count(&params, 4096, false) == 0);
+
+	/* A 4TiB backing device with 512B blocks is rejected before anything is allocated. */
+	params.vol_size = 0;
+	spdk_uuid_generate(&params.uuid);
+	backing_dev.blocklen = 512;
+	backing_dev.blockcnt = (4ULL << 40) / backing_dev.blocklen;
+	backing_dev.readv = backing_dev_readv;
+	backing_dev.writev = backing_dev_writev;
+	backing_dev.unmap = backing_dev_unmap;
+
+	g_vol = NULL;
+	g_reduce_errno = 0;
+	spdk_reduce_vol_init(&params, &backing_dev, "", init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == -EINVAL);
+	CU_ASSERT(g_vol == NULL);
+}
+
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
+static void
 defer_bdev_io(void)
 {
 	struct spdk_reduce_vol_params params = {};
@@ -1201,6 +1595,7 @@ overlapped(void)
 	persistent_pm_buf_destroy();
 	backing_dev_destroy(&backing_dev);
 }
+#endif
 
 #define BUFSIZE 4096
 
@@ -1832,6 +2227,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, get_pm_file_size);
 	CU_ADD_TEST(suite, get_vol_size);
 	CU_ADD_TEST(suite, init_failure);
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 	CU_ADD_TEST(suite, init_md);
 	CU_ADD_TEST(suite, init_backing_dev);
 	CU_ADD_TEST(suite, load);
@@ -1839,8 +2235,17 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, read_write);
 	CU_ADD_TEST(suite, readv_writev);
 	CU_ADD_TEST(suite, destroy);
+#endif
+	CU_ADD_TEST(suite, backing_md);
+	CU_ADD_TEST(suite, backing_md_io_buf);
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
+	CU_ADD_TEST(suite, packed_layout);
+#endif
+	CU_ADD_TEST(suite, packed_layout_size_limit);
+#ifdef SPDK_CONFIG_HAVE_LIBPMEM
 	CU_ADD_TEST(suite, defer_bdev_io);
 	CU_ADD_TEST(suite, overlapped);
+#endif
 	CU_ADD_TEST(suite, compress_algorithm);
 	CU_ADD_TEST(suite, test_prepare_compress_chunk);
 	CU_ADD_TEST(suite, test_reduce_decompress_chunk);
@@ -12,6 +12,8 @@
 
 #include "spdk_internal/mock.h"
 
+#include "common/lib/ut_multithread.c"
+
 SPDK_LOG_REGISTER_COMPONENT(scsi)
 
 void
@@ -67,6 +69,7 @@ ut_lun_deinit(void)
 	g_lun.reservation.crkey = 0;
 	g_lun.reservation.holder = NULL;
 	g_lun.pr_generation = 0;
+	scsi_pr_free_access(&g_lun);
 }
 
 static void
@@ -623,6 +626,161 @@ test_pr_with_scsi2_reserve_release(void)
 	ut_deinit_reservation_test();
 }
 
+/* Enough registrants to grow the access table of the LUN several times */
+#define UT_NUM_REGISTRANTS	40
+
+static void
+test_reservation_check_many_registrants(void)
+{
+	struct spdk_scsi_port i_ports[UT_NUM_REGISTRANTS + 1] = {};
+	struct spdk_scsi_task task = {0};
+	uint8_t cdb[32] = {};
+	char name[64];
+	int i, rc;
+
+	task.lun = &g_lun;
+	task.target_port = &g_t_port_0;
+	task.cdb = cdb;
+
+	ut_init_reservation_test();
+
+	for (i = 0; i <= UT_NUM_REGISTRANTS; i++) {
+		snprintf(name, sizeof(name), "iqn.2016-06.io.spdk:host%d,i,0x%x", i, i);
+		rc = scsi_port_construct(&i_ports[i], 0x100 + i, 0, name);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+	}
+
+	/* The last initiator port stays unregistered */
+	for (i = 0; i < UT_NUM_REGISTRANTS; i++) {
+		task.initiator_port = &i_ports[i];
+		rc = scsi_pr_out_register(&task, SPDK_SCSI_PR_OUT_REGISTER,
+					  0x0, 0x100 + i, 0, 0, 0);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+	}
+	SPDK_CU_ASSERT_FATAL(g_lun.pr_access != NULL);
+	SPDK_CU_ASSERT_FATAL(g_lun.pr_access->mask + 1 >= UT_NUM_REGISTRANTS * 2);
+	SPDK_CU_ASSERT_FATAL(g_lun.pr_access->max_probes >= 1);
+	SPDK_CU_ASSERT_FATAL(g_lun.pr_access->max_probes <= g_lun.pr_access->mask + 1);
+	/* Replaced tables are freed right away when nobody can be looking at them */
+	SPDK_CU_ASSERT_FATAL(g_lun.pr_access_retired == NULL);
+
+	task.initiator_port = &i_ports[0];
+	rc = scsi_pr_out_reserve(&task, SPDK_SCSI_PR_WRITE_EXCLUSIVE_REGS_ONLY,
+				 0x100, 0, 0, 0);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	/* Test Case: all registrants may write, the unregistered I_T nexus may only read */
+	for (i = 0; i <= UT_NUM_REGISTRANTS; i++) {
+		task.initiator_port = &i_ports[i];
+		task.cdb[0] = SPDK_SBC_READ_10;
+		task.status = 0;
+		rc = scsi_pr_check(&task);
+		CU_ASSERT(rc == 0);
+		task.cdb[0] = SPDK_SBC_WRITE_10;
+		rc = scsi_pr_check(&task);
+		if (i < UT_NUM_REGISTRANTS) {
+			CU_ASSERT(rc == 0);
+		} else {
+			CU_ASSERT(rc < 0);
+			CU_ASSERT(task.status == SPDK_SCSI_STATUS_RESERVATION_CONFLICT);
+		}
+	}
+
+	/* Test Case: the holder preempts everyone else with Exclusive Access */
+	task.initiator_port = &i_ports[0];
+	for (i = 1; i < UT_NUM_REGISTRANTS; i++) {
+		rc = scsi_pr_out_preempt(&task, SPDK_SCSI_PR_OUT_PREEMPT,
+					 SPDK_SCSI_PR_EXCLUSIVE_ACCESS, 0x100, 0x100 + i);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+	}
+	rc = scsi_pr_out_preempt(&task, SPDK_SCSI_PR_OUT_PREEMPT,
+				 SPDK_SCSI_PR_EXCLUSIVE_ACCESS, 0x100, 0x100);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	for (i = 0; i <= UT_NUM_REGISTRANTS; i++) {
+		task.initiator_port = &i_ports[i];
+		task.cdb[0] = SPDK_SBC_READ_10;
+		task.status = 0;
+		rc = scsi_pr_check(&task);
+		CU_ASSERT(i == 0 ? rc == 0 : rc < 0);
+	}
+
+	ut_deinit_reservation_test();
+}
+
+static int
+ut_lun_channel_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_lun_channel_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+ut_reserve_release_many(struct spdk_scsi_task *task, int count)
+{
+	int i, rc;
+
+	for (i = 0; i < count; i++) {
+		rc = scsi_pr_out_reserve(task, SPDK_SCSI_PR_WRITE_EXCLUSIVE, 0xa, 0, 0, 0);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+		rc = scsi_pr_out_release(task, SPDK_SCSI_PR_WRITE_EXCLUSIVE, 0xa);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+	}
+}
+
+/* Enough PERSISTENT RESERVE OUT commands to notice access tables piling up */
+#define UT_NUM_PR_OUT_CMDS	1000
+
+static void
+test_reservation_access_table_reclaim(void)
+{
+	struct spdk_scsi_task task = {0};
+	uint8_t cdb[32] = {};
+	int io_device;
+
+	task.lun = &g_lun;
+	task.target_port = &g_t_port_0;
+	task.initiator_port = &g_i_port_a;
+	task.cdb = cdb;
+
+	ut_init_reservation_test();
+	test_build_registrants();
+
+	/* Test Case: without an I/O channel no lookup can be using a replaced table */
+	ut_reserve_release_many(&task, UT_NUM_PR_OUT_CMDS);
+	CU_ASSERT(g_lun.pr_access != NULL);
+	CU_ASSERT(g_lun.pr_access_retired == NULL);
+
+	/* Test Case: replaced tables are freed by a message to the I/O channel's thread */
+	allocate_threads(1);
+	set_thread(0);
+	spdk_io_device_register(&io_device, ut_lun_channel_create, ut_lun_channel_destroy, 0, NULL);
+	g_lun.io_channel = spdk_get_io_channel(&io_device);
+	SPDK_CU_ASSERT_FATAL(g_lun.io_channel != NULL);
+
+	ut_reserve_release_many(&task, UT_NUM_PR_OUT_CMDS);
+	CU_ASSERT(g_lun.pr_access_retired == NULL);
+	poll_threads();
+	CU_ASSERT(g_lun.pr_access != NULL);
+	CU_ASSERT(g_lun.pr_access_retired == NULL);
+
+	/* Reads are still checked against the latest table */
+	task.cdb[0] = SPDK_SBC_READ_10;
+	CU_ASSERT(scsi_pr_check(&task) == 0);
+
+	spdk_put_io_channel(g_lun.io_channel);
+	g_lun.io_channel = NULL;
+	spdk_io_device_unregister(&io_device, NULL);
+	poll_threads();
+	free_threads();
+
+	ut_deinit_reservation_test();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -640,6 +798,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_reservation_cmds_conflict);
 	CU_ADD_TEST(suite, test_scsi2_reserve_release);
 	CU_ADD_TEST(suite, test_pr_with_scsi2_reserve_release);
+	CU_ADD_TEST(suite, test_reservation_check_many_registrants);
+	CU_ADD_TEST(suite, test_reservation_access_table_reclaim);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -114,7 +114,6 @@ DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
 DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 		struct spdk_bdev_io_wait_entry *entry), 0);
 DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
-DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *, (struct spdk_bdev_desc *desc), 0);
 DEFINE_STUB(spdk_bdev_readv, int,
 	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	     struct iovec *iov, int iovcnt, uint64_t offset, uint64_t nbytes,
@@ -134,10 +133,19 @@ DEFINE_STUB(rte_vhost_backend_config_change, int, (int vid, bool need_reply), 0)
 DEFINE_STUB(rte_vhost_slave_config_change, int, (int vid, bool need_reply), 0);
 #endif
 DEFINE_STUB(spdk_json_decode_bool, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_decode_uint32, int, (const struct spdk_json_val *val, void *out), 0);
 DEFINE_STUB(spdk_json_decode_object_relaxed, int,
 	    (const struct spdk_json_val *values, const struct spdk_json_object_decoder *decoders,
 	     size_t num_decoders, void *out), 0);
 
+static int g_ut_bdev_io_device;
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(&g_ut_bdev_io_device);
+}
+
 void *
 spdk_call_unaffinitized(void *cb(void *arg), void *arg)
 {
@@ -158,7 +166,7 @@ static int
 test_setup(void)
 {
 	allocate_cores(1);
-	allocate_threads(1);
+	allocate_threads(3);
 	set_thread(0);
 
 	g_init_fail = true;
@@ -661,6 +669,266 @@ vq_packed_ring_test(void)
 	CU_ASSERT(guest_avail_phase == guest_used_phase);
 }
 
+static void
+vq_adaptive_coalescing_test(void)
+{
+	struct spdk_vhost_session vs = {};
+	struct spdk_vhost_virtqueue vq = {};
+
+	vs.coalescing_latency_target = 1000;
+	vs.stats_check_interval = 100;
+	/* 10 requests per stats check interval */
+	vs.coalescing_io_rate_threshold = 10;
+	vq.next_event_time = UINT64_MAX;
+
+	/* Nothing happens before the stats check interval elapses */
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 50);
+	CU_ASSERT(vq.coalescing.lat_cnt == 20);
+	CU_ASSERT(vq.coalescing.last_check_time == 0);
+	CU_ASSERT(vq.irq_delay_time == 0);
+
+	/* Below the target the delay grows by a quarter of the remaining budget */
+	check_vq_adaptive_coalescing(&vs, &vq, 100);
+	CU_ASSERT(vq.coalescing.avg_lat == 200);
+	CU_ASSERT(vq.coalescing.lat_cnt == 0);
+	CU_ASSERT(vq.coalescing.lat_sum == 0);
+	CU_ASSERT(vq.coalescing.last_check_time == 100);
+	CU_ASSERT(vq.irq_delay_time == 200);
+	CU_ASSERT(vq.next_event_time == 300);
+	CU_ASSERT(vq.coalescing.delay_increases == 1);
+
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 200);
+	CU_ASSERT(vq.irq_delay_time == 350);
+	CU_ASSERT(vq.next_event_time == 300);
+	CU_ASSERT(vq.coalescing.delay_increases == 2);
+
+	/* Once the latency gets close to the target the delay shrinks at once */
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 900;
+	check_vq_adaptive_coalescing(&vs, &vq, 300);
+	CU_ASSERT(vq.coalescing.avg_lat == 900);
+	CU_ASSERT(vq.irq_delay_time == 100);
+	CU_ASSERT(vq.coalescing.delay_decreases == 1);
+
+	/* Latency above the target disables the delay */
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 1200;
+	check_vq_adaptive_coalescing(&vs, &vq, 400);
+	CU_ASSERT(vq.irq_delay_time == 0);
+	CU_ASSERT(vq.coalescing.delay_decreases == 2);
+
+	/* Build the delay up again */
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 500);
+	CU_ASSERT(vq.irq_delay_time == 200);
+	CU_ASSERT(vq.coalescing.delay_increases == 3);
+
+	/* Below the IOPS threshold interrupts aren't delayed, even with low latency */
+	vq.coalescing.lat_cnt = 5;
+	vq.coalescing.lat_sum = 5 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 600);
+	CU_ASSERT(vq.irq_delay_time == 0);
+	CU_ASSERT(vq.coalescing.delay_decreases == 3);
+
+	/* The threshold scales with the time elapsed since the last check */
+	vq.coalescing.lat_cnt = 15;
+	vq.coalescing.lat_sum = 15 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 800);
+	CU_ASSERT(vq.irq_delay_time == 0);
+	CU_ASSERT(vq.coalescing.delay_increases == 3);
+	CU_ASSERT(vq.coalescing.delay_decreases == 3);
+	CU_ASSERT(vq.coalescing.last_check_time == 800);
+
+	vq.coalescing.lat_cnt = 20;
+	vq.coalescing.lat_sum = 20 * 200;
+	check_vq_adaptive_coalescing(&vs, &vq, 1000);
+	CU_ASSERT(vq.irq_delay_time == 200);
+	CU_ASSERT(vq.coalescing.delay_increases == 4);
+}
+
+static int
+ut_bdev_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+ut_bdev_remove_cpl(struct spdk_vhost_dev *vdev, void *ctx)
+{
+	*(bool *)ctx = true;
+}
+
+/* The no-bdev workers always report busy, so poll_threads() would never return */
+static void
+poll_threads_times(uint32_t max_polls)
+{
+	uint32_t i;
+
+	for (i = 0; i < g_ut_num_threads; i++) {
+		poll_thread_times(i, max_polls);
+	}
+}
+
+static void
+blk_poll_groups_test(void)
+{
+	struct spdk_vhost_blk_dev *bvdev = NULL;
+	struct spdk_vhost_user_dev *user_dev;
+	struct spdk_vhost_blk_session *bvsession = NULL;
+	struct spdk_vhost_session *vsession;
+	struct vhost_blk_poll_group *pg;
+	struct vring_desc descs[4] = {};
+	struct vring_avail *avail;
+	bool remove_done = false;
+	int i, rc;
+
+	spdk_io_device_register(&g_ut_bdev_io_device, ut_bdev_ch_create_cb, ut_bdev_ch_destroy_cb,
+				0, "ut_bdev");
+
+	rc = posix_memalign((void **)&bvdev, 64, sizeof(*bvdev));
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	memset(bvdev, 0, sizeof(*bvdev));
+	user_dev = calloc(1, sizeof(*user_dev));
+	SPDK_CU_ASSERT_FATAL(user_dev != NULL);
+	pthread_mutex_init(&user_dev->lock, NULL);
+	TAILQ_INIT(&user_dev->vsessions);
+	user_dev->vdev = &bvdev->vdev;
+	bvdev->vdev.name = "vdev_blk";
+	bvdev->vdev.backend = &vhost_blk_device_backend;
+	bvdev->vdev.thread = g_ut_threads[0].thread;
+	bvdev->vdev.ctxt = user_dev;
+	bvdev->bdev = (struct spdk_bdev *)0xDEADBEEF;
+	bvdev->bdev_desc = (struct spdk_bdev_desc *)0xDEADBEEF;
+	bvdev->num_vq_threads = 3;
+	for (i = 0; i < 3; i++) {
+		bvdev->vq_threads[i] = g_ut_threads[i].thread;
+	}
+
+	avail = calloc(1, sizeof(*avail) + 4 * sizeof(uint16_t));
+	SPDK_CU_ASSERT_FATAL(avail != NULL);
+	rc = posix_memalign((void **)&bvsession, 64, sizeof(*bvsession));
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	memset(bvsession, 0, sizeof(*bvsession));
+	vsession = &bvsession->vsession;
+	vsession->vdev = &bvdev->vdev;
+	vsession->name = "vdev_blk_s0";
+	vsession->started = true;
+	vsession->max_queues = 4;
+	for (i = 0; i < vsession->max_queues; i++) {
+		vsession->virtqueue[i].vring.desc = descs;
+		vsession->virtqueue[i].vring.avail = avail;
+		vsession->virtqueue[i].vring.size = 4;
+		vsession->virtqueue[i].vring_idx = i;
+		vsession->virtqueue[i].vsession = vsession;
+	}
+	TAILQ_INSERT_TAIL(&user_dev->vsessions, vsession, tailq);
+
+	/* Virtqueues are spread round-robin over one poll group per thread */
+	set_thread(0);
+	rc = vhost_blk_start(&bvdev->vdev, vsession, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(bvsession->num_poll_groups == 3);
+	CU_ASSERT(bvsession->active_poll_groups == 2);
+	for (i = 0; i < 3; i++) {
+		pg = &bvsession->poll_groups[i];
+		CU_ASSERT(pg->thread == g_ut_threads[i].thread);
+		CU_ASSERT(pg->requestq_poller != NULL);
+		CU_ASSERT(pg->io_channel != NULL);
+	}
+	CU_ASSERT(bvsession->poll_groups[0].task_cnt == &vsession->task_cnt);
+	CU_ASSERT(blk_vq_get_poll_group(bvsession, &vsession->virtqueue[3]) ==
+		  &bvsession->poll_groups[0]);
+	CU_ASSERT(blk_vq_get_poll_group(bvsession, &vsession->virtqueue[2]) ==
+		  &bvsession->poll_groups[2]);
+
+	/* Stopping waits for the requests in flight on every poll group */
+	bvsession->poll_groups[1].local_task_cnt = 1;
+	rc = vhost_blk_stop(&bvdev->vdev, vsession, NULL);
+	CU_ASSERT(rc == 0);
+	for (i = 0; i < 3; i++) {
+		spdk_delay_us(1000);
+		poll_threads();
+	}
+	CU_ASSERT(bvsession->active_poll_groups == 1);
+	CU_ASSERT(bvsession->poll_groups[1].io_channel != NULL);
+	CU_ASSERT(bvsession->poll_groups[2].io_channel == NULL);
+	CU_ASSERT(bvsession->stop_poller != NULL);
+	CU_ASSERT(vsession->started == true);
+
+	bvsession->poll_groups[1].local_task_cnt = 0;
+	for (i = 0; i < 3; i++) {
+		spdk_delay_us(1000);
+		poll_threads();
+	}
+	CU_ASSERT(bvsession->active_poll_groups == 0);
+	CU_ASSERT(bvsession->stop_poller == NULL);
+	CU_ASSERT(vsession->started == false);
+	CU_ASSERT(g_dpdk_response == 0);
+	CU_ASSERT(sem_trywait(&g_dpdk_sem) == 0);
+	for (i = 0; i < 3; i++) {
+		pg = &bvsession->poll_groups[i];
+		CU_ASSERT(pg->requestq_poller == NULL);
+		CU_ASSERT(pg->stop_poller == NULL);
+		CU_ASSERT(pg->io_channel == NULL);
+	}
+
+	/* Hot-remove completes only once every poll group stopped using the bdev */
+	vsession->started = true;
+	rc = vhost_blk_start(&bvdev->vdev, vsession, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+
+	vhost_user_bdev_remove_cb(&bvdev->vdev, ut_bdev_remove_cpl, &remove_done);
+	poll_thread_times(0, 10);
+	CU_ASSERT(remove_done == false);
+	CU_ASSERT(bvdev->remove_pending == 2);
+	CU_ASSERT(bvsession->poll_groups[0].io_channel == NULL);
+	CU_ASSERT(bvsession->poll_groups[1].io_channel != NULL);
+	CU_ASSERT(bvsession->poll_groups[2].io_channel != NULL);
+
+	poll_threads_times(10);
+	poll_thread_times(0, 10);
+	CU_ASSERT(remove_done == true);
+	CU_ASSERT(bvdev->remove_pending == 0);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(bvsession->poll_groups[i].io_channel == NULL);
+	}
+	bvdev->bdev = NULL;
+	bvdev->bdev_desc = NULL;
+
+	/* Stop the session while its poll groups run the no-bdev worker */
+	rc = vhost_blk_stop(&bvdev->vdev, vsession, NULL);
+	CU_ASSERT(rc == 0);
+	for (i = 0; i < 5; i++) {
+		spdk_delay_us(1000);
+		poll_threads_times(10);
+	}
+	CU_ASSERT(bvsession->active_poll_groups == 0);
+	CU_ASSERT(vsession->started == false);
+	CU_ASSERT(sem_trywait(&g_dpdk_sem) == 0);
+	poll_threads();
+
+	TAILQ_REMOVE(&user_dev->vsessions, vsession, tailq);
+	free(bvsession);
+	free(avail);
+	pthread_mutex_destroy(&user_dev->lock);
+	free(user_dev);
+	free(bvdev);
+	spdk_io_device_unregister(&g_ut_bdev_io_device, NULL);
+	poll_threads();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -678,6 +946,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, remove_controller_test);
 	CU_ADD_TEST(suite, vq_avail_ring_get_test);
 	CU_ADD_TEST(suite, vq_packed_ring_test);
+	CU_ADD_TEST(suite, vq_adaptive_coalescing_test);
+	CU_ADD_TEST(suite, blk_poll_groups_test);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
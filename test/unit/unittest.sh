@@ -59,6 +59,7 @@ function unittest_ftl() {
 	$valgrind $testdir/lib/ftl/ftl_l2p/ftl_l2p_ut
 	$valgrind $testdir/lib/ftl/ftl_sb/ftl_sb_ut
 	$valgrind $testdir/lib/ftl/ftl_layout_upgrade/ftl_layout_upgrade_ut
+	$valgrind $testdir/lib/ftl/ftl_nv_cache.c/ftl_nv_cache_ut
 }
 
 function unittest_iscsi() {